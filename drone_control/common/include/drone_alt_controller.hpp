@@ -29,6 +29,35 @@ struct DroneAltOutputType {
     DroneAltOutputType(double thrust_val) : thrust(thrust_val) {}
 };
 
+struct DroneAltParamType {
+    double delta_time;
+    double control_cycle;
+    double max_power;
+    double max_spd;
+    double throttle_gain;
+    double mass;
+    double gravity;
+    DronePidGainType pos;
+    DronePidGainType spd;
+    void load(const HakoControllerParamLoader& loader) {
+        delta_time = loader.getParameter("SIMULATION_DELTA_TIME");
+        control_cycle = loader.getParameter("PID_ALT_CONTROL_CYCLE");
+        max_power = loader.getParameter("PID_ALT_MAX_POWER");
+        max_spd = loader.getParameter("PID_ALT_MAX_SPD");
+        throttle_gain = loader.getParameter("PID_ALT_THROTTLE_GAIN");
+        mass = loader.getParameter("MASS");
+        gravity = loader.getParameter("GRAVITY");
+        pos = DronePidGainType(
+            loader.getParameter("PID_ALT_Kp"), 
+            loader.getParameter("PID_ALT_Ki"), 
+            loader.getParameter("PID_ALT_Kd"));
+        spd = DronePidGainType(
+            loader.getParameter("PID_ALT_SPD_Kp"), 
+            loader.getParameter("PID_ALT_SPD_Ki"), 
+            loader.getParameter("PID_ALT_SPD_Kd"));
+    }
+};
+
 class DroneAltController {
 private:
     std::unique_ptr<DronePidControl> pos_control;
@@ -66,23 +95,9 @@ private:
     }
     const HakoControllerParamLoader* my_loader;
     void loadParameters(const HakoControllerParamLoader& loader) {
-        delta_time = loader.getParameter("SIMULATION_DELTA_TIME");
-        control_cycle = loader.getParameter("PID_ALT_CONTROL_CYCLE");
-        max_power = loader.getParameter("PID_ALT_MAX_POWER");
-        max_spd = loader.getParameter("PID_ALT_MAX_SPD");
-        throttle_gain = loader.getParameter("PID_ALT_THROTTLE_GAIN");
-        mass = loader.getParameter("MASS");
-        gravity = loader.getParameter("GRAVITY");
-        pos_control = std::make_unique<DronePidControl>(
-            loader.getParameter("PID_ALT_Kp"), 
-            loader.getParameter("PID_ALT_Ki"), 
-            loader.getParameter("PID_ALT_Kd"), 
-            0, delta_time);
-        spd_control = std::make_unique<DronePidControl>(
-            loader.getParameter("PID_ALT_SPD_Kp"), 
-            loader.getParameter("PID_ALT_SPD_Ki"), 
-            loader.getParameter("PID_ALT_SPD_Kd"), 
-            0, delta_time);
+        DroneAltParamType param;
+        param.load(loader);
+        applyParameters(param);
     }
 
 public:
@@ -91,6 +106,26 @@ public:
         this->loadParameters(loader);
     }
     ~DroneAltController() {}
+    /*
+     * パラメータの差し替え(制御周期の途中状態と積分値は保持する)
+     */
+    void applyParameters(const DroneAltParamType& param) {
+        delta_time = param.delta_time;
+        control_cycle = param.control_cycle;
+        max_power = param.max_power;
+        max_spd = param.max_spd;
+        throttle_gain = param.throttle_gain;
+        mass = param.mass;
+        gravity = param.gravity;
+        if (pos_control == nullptr) {
+            pos_control = std::make_unique<DronePidControl>(param.pos, 0, delta_time);
+            spd_control = std::make_unique<DronePidControl>(param.spd, 0, delta_time);
+        }
+        else {
+            pos_control->set_gain(param.pos, delta_time);
+            spd_control->set_gain(param.spd, delta_time);
+        }
+    }
     DroneAltOutputType run_spd(DroneAltSpdInputType &in)
     {
         DroneAltOutputType out = spd_prev_out;
@@ -116,10 +151,22 @@ public:
         spd_simulation_time += delta_time;
         return out;
     }
+    /*
+     * 状態の保存・復元用(flight_controller_state.hpp)
+     */
+    template <typename Visitor>
+    void visit_state(Visitor& v) {
+        pos_control->visit_state(v);
+        spd_control->visit_state(v);
+        v(pos_simulation_time);
+        v(spd_simulation_time);
+        v(pos_prev_out);
+        v(spd_prev_out);
+    }
     void reset() {
         this->loadParameters(*my_loader);
-        pos_control->reset_integral();
-        spd_control->reset_integral();
+        pos_control->reset();
+        spd_control->reset();
         pos_simulation_time = 0;
         spd_simulation_time = 0;
     }
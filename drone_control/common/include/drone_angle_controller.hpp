@@ -41,13 +41,66 @@ struct DroneAngleRateInputType {
         : target_roll_rate(roll_rate_val), target_pitch_rate(pitch_rate_val), target_yaw_rate(yaw_rate_val) {}
 };
 
+struct DroneAngleParamType {
+    double delta_time;
+    double angular_control_cycle;
+    double roll_rate_max;
+    double pitch_rate_max;
+    DronePidGainType roll;
+    DronePidGainType pitch;
+    double angular_rate_control_cycle;
+    double roll_torque_max;
+    double pitch_torque_max;
+    double yaw_torque_max;
+    DronePidGainType roll_rate;
+    DronePidGainType pitch_rate;
+    DronePidGainType yaw_rate;
+    void load(const HakoControllerParamLoader& loader) {
+        delta_time = loader.getParameter("SIMULATION_DELTA_TIME");
+        /*
+         * angle control
+         */
+        angular_control_cycle = loader.getParameter("ANGULAR_CONTROL_CYCLE");
+        roll_rate_max = RPM2EULER_RATE(loader.getParameter("PID_ROLL_RPM_MAX"));
+        pitch_rate_max = RPM2EULER_RATE(loader.getParameter("PID_PITCH_RPM_MAX"));
+        roll = DronePidGainType(
+            loader.getParameter("PID_ROLL_Kp"), 
+            loader.getParameter("PID_ROLL_Ki"), 
+            loader.getParameter("PID_ROLL_Kd"));
+        pitch = DronePidGainType(
+            loader.getParameter("PID_PITCH_Kp"), 
+            loader.getParameter("PID_PITCH_Ki"), 
+            loader.getParameter("PID_PITCH_Kd"));
+
+        /*
+         * rate control
+         */
+        angular_rate_control_cycle = loader.getParameter("ANGULAR_RATE_CONTROL_CYCLE");
+        roll_torque_max = loader.getParameter("PID_ROLL_TORQUE_MAX");
+        pitch_torque_max = loader.getParameter("PID_PITCH_TORQUE_MAX");
+        yaw_torque_max = loader.getParameter("PID_YAW_TORQUE_MAX");
+        roll_rate = DronePidGainType(
+            loader.getParameter("PID_ROLL_RATE_Kp"), 
+            loader.getParameter("PID_ROLL_RATE_Ki"), 
+            loader.getParameter("PID_ROLL_RATE_Kd"));
+        pitch_rate = DronePidGainType(
+            loader.getParameter("PID_PITCH_RATE_Kp"), 
+            loader.getParameter("PID_PITCH_RATE_Ki"), 
+            loader.getParameter("PID_PITCH_RATE_Kd"));
+        yaw_rate = DronePidGainType(
+            loader.getParameter("PID_YAW_RATE_Kp"), 
+            loader.getParameter("PID_YAW_RATE_Ki"), 
+            loader.getParameter("PID_YAW_RATE_Kd"));
+    }
+};
+
 class DroneAngleController {
 private:
     double delta_time;
     /*
      * angle control
      */
-    double angular_simulation_time;
+    double angular_simulation_time = 0;
     double angular_control_cycle;
     double roll_rate_max;
     double pitch_rate_max;
@@ -92,47 +145,9 @@ private:
     }
     const HakoControllerParamLoader* my_loader;
     void loadParameters(const HakoControllerParamLoader& loader) {
-        //load parameters
-        delta_time = loader.getParameter("SIMULATION_DELTA_TIME");
-        /*
-         * angle control
-         */
-        angular_control_cycle = loader.getParameter("ANGULAR_CONTROL_CYCLE");
-        roll_rate_max = RPM2EULER_RATE(loader.getParameter("PID_ROLL_RPM_MAX"));
-        pitch_rate_max = RPM2EULER_RATE(loader.getParameter("PID_PITCH_RPM_MAX"));
-        roll_control = std::make_unique<DronePidControl>(
-            loader.getParameter("PID_ROLL_Kp"), 
-            loader.getParameter("PID_ROLL_Ki"), 
-            loader.getParameter("PID_ROLL_Kd"), 
-            0, delta_time);
-        pitch_control = std::make_unique<DronePidControl>(
-            loader.getParameter("PID_PITCH_Kp"), 
-            loader.getParameter("PID_PITCH_Ki"), 
-            loader.getParameter("PID_PITCH_Kd"), 
-            0, delta_time);
-
-        /*
-         * rate control
-         */
-        angular_rate_control_cycle = loader.getParameter("ANGULAR_RATE_CONTROL_CYCLE");
-        roll_torque_max = loader.getParameter("PID_ROLL_TORQUE_MAX");
-        pitch_torque_max = loader.getParameter("PID_PITCH_TORQUE_MAX");
-        yaw_torque_max = loader.getParameter("PID_YAW_TORQUE_MAX");
-        roll_rate_control = std::make_unique<DronePidControl>(
-            loader.getParameter("PID_ROLL_RATE_Kp"), 
-            loader.getParameter("PID_ROLL_RATE_Ki"), 
-            loader.getParameter("PID_ROLL_RATE_Kd"), 
-            0, delta_time);
-        pitch_rate_control = std::make_unique<DronePidControl>(
-            loader.getParameter("PID_PITCH_RATE_Kp"), 
-            loader.getParameter("PID_PITCH_RATE_Ki"), 
-            loader.getParameter("PID_PITCH_RATE_Kd"), 
-            0, delta_time);
-        yaw_rate_control = std::make_unique<DronePidControl>(
-            loader.getParameter("PID_YAW_RATE_Kp"), 
-            loader.getParameter("PID_YAW_RATE_Ki"), 
-            loader.getParameter("PID_YAW_RATE_Kd"), 
-            0, delta_time);
+        DroneAngleParamType param;
+        param.load(loader);
+        applyParameters(param);
     }
 
 public:
@@ -142,6 +157,33 @@ public:
     }
 
     virtual ~DroneAngleController() {}
+    /*
+     * パラメータの差し替え(制御周期の途中状態と積分値は保持する)
+     */
+    void applyParameters(const DroneAngleParamType& param) {
+        delta_time = param.delta_time;
+        angular_control_cycle = param.angular_control_cycle;
+        roll_rate_max = param.roll_rate_max;
+        pitch_rate_max = param.pitch_rate_max;
+        angular_rate_control_cycle = param.angular_rate_control_cycle;
+        roll_torque_max = param.roll_torque_max;
+        pitch_torque_max = param.pitch_torque_max;
+        yaw_torque_max = param.yaw_torque_max;
+        if (roll_control == nullptr) {
+            roll_control = std::make_unique<DronePidControl>(param.roll, 0, delta_time);
+            pitch_control = std::make_unique<DronePidControl>(param.pitch, 0, delta_time);
+            roll_rate_control = std::make_unique<DronePidControl>(param.roll_rate, 0, delta_time);
+            pitch_rate_control = std::make_unique<DronePidControl>(param.pitch_rate, 0, delta_time);
+            yaw_rate_control = std::make_unique<DronePidControl>(param.yaw_rate, 0, delta_time);
+        }
+        else {
+            roll_control->set_gain(param.roll, delta_time);
+            pitch_control->set_gain(param.pitch, delta_time);
+            roll_rate_control->set_gain(param.roll_rate, delta_time);
+            pitch_rate_control->set_gain(param.pitch_rate, delta_time);
+            yaw_rate_control->set_gain(param.yaw_rate, delta_time);
+        }
+    }
     DroneAngleOutputType run(DroneAngleInputType& in)
     {
         DroneAngleRateInputType vel = run_angle(in);
@@ -168,13 +210,28 @@ public:
         this->angular_rate_simulation_time += this->delta_time;
         return out;
     }
+    /*
+     * 状態の保存・復元用(flight_controller_state.hpp)
+     */
+    template <typename Visitor>
+    void visit_state(Visitor& v) {
+        roll_control->visit_state(v);
+        pitch_control->visit_state(v);
+        roll_rate_control->visit_state(v);
+        pitch_rate_control->visit_state(v);
+        yaw_rate_control->visit_state(v);
+        v(angular_simulation_time);
+        v(angle_prev_out);
+        v(angular_rate_simulation_time);
+        v(rate_prev_out);
+    }
     void reset() {
         this->loadParameters(*my_loader);
-        roll_control->reset_integral();
-        pitch_control->reset_integral();
-        roll_rate_control->reset_integral();
-        pitch_rate_control->reset_integral();
-        yaw_rate_control->reset_integral();
+        roll_control->reset();
+        pitch_control->reset();
+        roll_rate_control->reset();
+        pitch_rate_control->reset();
+        yaw_rate_control->reset();
     }
 };
 #endif /* _DRONE_ANGLE_CONTROLLER_HPP_ */
\ No newline at end of file
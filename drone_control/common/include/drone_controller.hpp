@@ -1,23 +1,29 @@
 #ifndef _DRONE_CONTROLLER_HPP_
 #define _DRONE_CONTROLLER_HPP_
 
-#include "drone_alt_controller.hpp"
-#include "drone_pos_controller.hpp"
-#include "drone_heading_controller.hpp"
-#include "drone_angle_controller.hpp"
+#include "drone_controller_bank.hpp"
+#include "drone_controller_param.hpp"
 #include "hako_controller_param_loader.hpp"
+#include "hako_controller_param_watcher.hpp"
 #include <stdexcept>
 #include <memory>
 
+/*
+ * 1機体分のコントローラ
+ * PID の状態はモジュール内で共有する DroneControllerBank 上の index 番目に置く
+ */
 class DroneController {
+private:
+    std::shared_ptr<HakoControllerParamWatcher<DroneControllerParamType>> watcher;
+    HakoControllerParamWatcherCursor watcher_cursor = {};
+    DroneControllerParamType next_param = {};
+    DroneControllerBank& bank;
+    int index;
 public:
-    std::unique_ptr<DroneAltController> alt;
-    std::unique_ptr<DronePosController> pos;
-    std::unique_ptr<DroneHeadingController> head;
-    std::unique_ptr<DroneAngleController> angle;
     HakoControllerParamLoader loader;
     
     DroneController() : 
+        bank(drone_controller_bank()),
         loader() 
     {
         if (HakoControllerParamLoader::is_exist_envpath()) {
@@ -25,17 +31,53 @@ public:
         } else {
             throw std::runtime_error("Parameter file is not found on HAKO_CONTROLLER_PARAM_FILE");
         }
-        alt = std::make_unique<DroneAltController>(loader);
-        pos = std::make_unique<DronePosController>(loader);
-        head = std::make_unique<DroneHeadingController>(loader);
-        angle = std::make_unique<DroneAngleController>(loader);
+        DroneControllerParamType param;
+        param.load(loader);
+        index = bank.add_vehicle(param);
+        if (HakoControllerParamLoader::is_watch_enabled()) {
+            watcher = HakoControllerParamWatcher<DroneControllerParamType>::acquire(loader.getFilename());
+            watcher_cursor = watcher->cursor();
+        }
+    }
+    ~DroneController() {
+        bank.remove_vehicle(index);
+    }
+    int get_index() const {
+        return index;
+    }
+    /*
+     * ステップ間で呼ぶ: 再読み込み済みのパラメータがあれば差し替える
+     */
+    void update_parameters() {
+        if ((watcher != nullptr) && watcher->fetch(watcher_cursor, next_param)) {
+            bank.set_parameters(index, next_param);
+        }
+    }
+    void request_reload() {
+        if (watcher != nullptr) {
+            watcher->request_reload();
+        }
     }
     void reset() {
         this->loader.reload();
-        alt->reset();
-        pos->reset();
-        head->reset();
-        angle->reset();
+        DroneControllerParamType param;
+        param.load(loader);
+        bank.set_parameters(index, param);
+        bank.reset(index);
+    }
+    size_t get_state_size() const {
+        return bank.get_state_size();
+    }
+    void save_state(void* buf) const {
+        bank.save_state(index, buf);
+    }
+    void restore_state(const void* buf) {
+        bank.restore_state(index, buf);
+    }
+    FlightControllerOutputType run(const DroneControllerBankInputType& in) {
+        FlightControllerOutputType out;
+        bank.run(index, index + 1, &in, &out);
+        return out;
     }
 };
 
@@ -0,0 +1,297 @@
+#ifndef _DRONE_CONTROLLER_BANK_HPP_
+#define _DRONE_CONTROLLER_BANK_HPP_
+
+/*
+ * 全機体分のカスケード PID(高度・機首方向・水平位置/速度・姿勢角/角速度)を
+ * DronePidBank 上で計算するコントローラ
+ *
+ * DroneAltController / DronePosController / DroneHeadingController /
+ * DroneAngleController と同じ制御則を、制御段(レートグループ)ごとに
+ * 機体 [v_begin, v_end) をまとめて計算する。
+ * 制御周期 > 0 の場合の入力の保持も従来のコントローラに合わせる
+ * (水平速度制御・姿勢角速度制御の入力は、前段が計算したステップでのみ更新する)。
+ */
+#include "drone_pid_bank.hpp"
+#include "drone_controller_param.hpp"
+#include "flight_controller_types.hpp"
+#include "frame_convertor.hpp"
+#include <vector>
+
+struct DroneControllerBankInputType {
+    FlightControllerInputEulerType euler;
+    FlightControllerInputPositionType pos;      /* z は上向き正 */
+    FlightControllerInputVelocityType velocity; /* w は上向き正 */
+    FlightControllerInputAngularRateType angular_rate;
+    double target_x;
+    double target_y;
+    double target_z;                            /* 上向き正 */
+    double target_velocity;
+    double target_yaw_deg;
+};
+
+class DroneControllerBank {
+private:
+    DronePidBank bank;
+    int alt_pos_group;
+    int alt_spd_group;
+    int head_group;
+    int pos_group;
+    int spd_group;
+    int angle_group;
+    int rate_group;
+    std::vector<DroneControllerParamType> params;
+    std::vector<int> free_index;
+    std::mutex setup_mutex;
+
+    static double normalize_angle(double angle)
+    {
+        // Normalize angle to be within the range [0, 360)
+        angle = std::fmod(angle, 360.0);
+        if (angle < 0) {
+            angle += 360.0;
+        }
+        return angle;
+    }
+    static double shortest_angle(double current, double target)
+    {
+        double diff = normalize_angle(target - current);
+        if (diff > 180.0) {
+            diff -= 360.0;
+        } else if (diff < -180.0) {
+            diff += 360.0;
+        }
+        return diff;
+    }
+
+public:
+    DroneControllerBank() : bank(0)
+    {
+        alt_pos_group = bank.add_group(1, 0);
+        alt_spd_group = bank.add_group(1, 0);
+        head_group    = bank.add_group(1, 0);
+        pos_group     = bank.add_group(2, 0);   /* x, y */
+        spd_group     = bank.add_group(2, 0);   /* roll(vy), pitch(vx) */
+        angle_group   = bank.add_group(2, 0);   /* roll, pitch */
+        rate_group    = bank.add_group(3, 0);   /* p, q, r */
+    }
+    DroneControllerBank(const DroneControllerBank&) = delete;
+    DroneControllerBank& operator=(const DroneControllerBank&) = delete;
+
+    /*
+     * remove_vehicle() で空いた index があれば再利用する
+     */
+    int add_vehicle(const DroneControllerParamType& param)
+    {
+        std::lock_guard<std::mutex> lock(setup_mutex);
+        int index;
+        if (!free_index.empty()) {
+            index = free_index.back();
+            free_index.pop_back();
+            bank.reset(index);
+        }
+        else {
+            index = bank.add_vehicle();
+            params.resize(bank.get_vehicle_num());
+        }
+        set_parameters(index, param);
+        return index;
+    }
+    void remove_vehicle(int index)
+    {
+        std::lock_guard<std::mutex> lock(setup_mutex);
+        free_index.push_back(index);
+    }
+    int get_vehicle_num() const
+    {
+        return bank.get_vehicle_num();
+    }
+    /*
+     * パラメータの差し替え(積分値等の状態は保持する)
+     * 制御周期・刻み幅も機体ごとに持ち、他の機体には影響しない
+     */
+    void set_parameters(int vehicle, const DroneControllerParamType& p)
+    {
+        params[vehicle] = p;
+        const double tau = p.d_filter_tau;
+        const bool aw = p.anti_windup;
+        bank.set_delta_time(vehicle, p.alt.delta_time);
+        bank.set_cycle(alt_pos_group, vehicle, p.alt.control_cycle);
+        bank.set_cycle(alt_spd_group, vehicle, p.alt.control_cycle);
+        bank.set_cycle(head_group, vehicle, p.head.head_control_cycle);
+        bank.set_cycle(pos_group, vehicle, p.pos.pos_control_cycle);
+        bank.set_cycle(spd_group, vehicle, p.pos.spd_control_cycle);
+        bank.set_cycle(angle_group, vehicle, p.angle.angular_control_cycle);
+        bank.set_cycle(rate_group, vehicle, p.angle.angular_rate_control_cycle);
+        bank.set_param(alt_pos_group, vehicle, 0, DronePidBankParamType(p.alt.pos, p.alt.max_spd, tau, aw));
+        bank.set_param(alt_spd_group, vehicle, 0, DronePidBankParamType(p.alt.spd, p.alt.max_power, tau, aw));
+        bank.set_param(head_group, vehicle, 0, DronePidBankParamType(p.head.heading, p.head.yaw_rate_max, tau, aw));
+        bank.set_param(pos_group, vehicle, 0, DronePidBankParamType(p.pos.pos_x, p.pos.max_spd, tau, aw));
+        bank.set_param(pos_group, vehicle, 1, DronePidBankParamType(p.pos.pos_y, p.pos.max_spd, tau, aw));
+        bank.set_param(spd_group, vehicle, 0, DronePidBankParamType(p.pos.spd_y, p.pos.max_roll_deg, tau, aw));
+        bank.set_param(spd_group, vehicle, 1, DronePidBankParamType(p.pos.spd_x, p.pos.max_pitch_deg, tau, aw));
+        /*
+         * DroneAngleController と同じく、ピッチ角には roll のゲインを、
+         * ヨー角速度には roll rate のゲインを使う。
+         * ただしチャネルの状態(積分値・前回偏差)は軸ごとに独立で、同じ PID を
+         * 共有していた DroneAngleController とは Ki, Kd が 0 でない場合に結果が異なる。
+         */
+        bank.set_param(angle_group, vehicle, 0, DronePidBankParamType(p.angle.roll, p.angle.roll_rate_max, tau, aw));
+        bank.set_param(angle_group, vehicle, 1, DronePidBankParamType(p.angle.roll, p.angle.pitch_rate_max, tau, aw));
+        bank.set_param(rate_group, vehicle, 0, DronePidBankParamType(p.angle.roll_rate, p.angle.roll_torque_max, tau, aw));
+        bank.set_param(rate_group, vehicle, 1, DronePidBankParamType(p.angle.pitch_rate, p.angle.pitch_torque_max, tau, aw));
+        bank.set_param(rate_group, vehicle, 2, DronePidBankParamType(p.angle.roll_rate, p.angle.yaw_torque_max, tau, aw));
+    }
+    void reset(int vehicle)
+    {
+        bank.reset(vehicle);
+    }
+    /*
+     * 状態の保存・復元(パラメータは含めない)
+     */
+    size_t get_state_size() const
+    {
+        return bank.get_state_size();
+    }
+    void save_state(int vehicle, void* buf) const
+    {
+        bank.save_state(vehicle, buf);
+    }
+    void restore_state(int vehicle, const void* buf)
+    {
+        bank.restore_state(vehicle, buf);
+    }
+
+    /*
+     * 機体 [v_begin, v_end) の制御を段ごとに一括計算する
+     * in, out は v_begin からの相対インデックス
+     */
+    void run(int v_begin, int v_end, const DroneControllerBankInputType* in, FlightControllerOutputType* out)
+    {
+        const int n = v_end - v_begin;
+        /*
+         * 高度制御(位置 -> 速度)
+         */
+        for (int k = 0; k < n; k++) {
+            bank.target(alt_pos_group, v_begin + k)[0] = in[k].target_z;
+            bank.current(alt_pos_group, v_begin + k)[0] = in[k].pos.z;
+        }
+        bank.run(alt_pos_group, v_begin, v_end);
+        for (int k = 0; k < n; k++) {
+            //機体座標系の速度を地上座標系に変換
+            //(従来の DroneAltInputType は姿勢角を受け取らず 0 のまま変換していた)
+            EulerType  e = {0, 0, 0};
+            VectorType v = {in[k].velocity.u, in[k].velocity.v, in[k].velocity.w};
+            VectorType g_v = ground_vector_from_body(v, e);
+            bank.target(alt_spd_group, v_begin + k)[0] = bank.output(alt_pos_group, v_begin + k)[0];
+            bank.current(alt_spd_group, v_begin + k)[0] = g_v.z;
+        }
+        bank.run(alt_spd_group, v_begin, v_end);
+
+        /*
+         * 機首方向制御
+         */
+        for (int k = 0; k < n; k++) {
+            double current_angle = normalize_angle(RADIAN2DEGREE(in[k].euler.z));
+            double target_angle = normalize_angle(in[k].target_yaw_deg);
+            bank.target(head_group, v_begin + k)[0] = current_angle + shortest_angle(current_angle, target_angle);
+            bank.current(head_group, v_begin + k)[0] = current_angle;
+        }
+        bank.run(head_group, v_begin, v_end);
+
+        /*
+         * 水平制御(位置 -> 速度 -> 姿勢角)
+         */
+        for (int k = 0; k < n; k++) {
+            double* t = bank.target(pos_group, v_begin + k);
+            double* c = bank.current(pos_group, v_begin + k);
+            t[0] = in[k].target_x;
+            t[1] = in[k].target_y;
+            c[0] = in[k].pos.x;
+            c[1] = in[k].pos.y;
+        }
+        bank.run(pos_group, v_begin, v_end);
+        for (int k = 0; k < n; k++) {
+            if (!bank.is_updated(pos_group, v_begin + k)) {
+                continue;
+            }
+            const double* o = bank.output(pos_group, v_begin + k);
+            // convert ground frame to body frame
+            VectorType val = body_vector_from_ground({ o[0], o[1], 0 }, { 0, 0, in[k].euler.z });
+            // Normalize val.x and val.y with target_velocity
+            double magnitude = sqrt(val.x * val.x + val.y * val.y);
+            if (magnitude > in[k].target_velocity) {
+                val.x = (val.x / magnitude) * in[k].target_velocity;
+                val.y = (val.y / magnitude) * in[k].target_velocity;
+            }
+            double* t = bank.target(spd_group, v_begin + k);
+            double* c = bank.current(spd_group, v_begin + k);
+            t[0] = val.y;
+            c[0] = in[k].velocity.v;
+            t[1] = val.x;
+            c[1] = in[k].velocity.u;
+        }
+        bank.run(spd_group, v_begin, v_end);
+
+        /*
+         * 姿勢角度制御
+         */
+        for (int k = 0; k < n; k++) {
+            const double* o = bank.output(spd_group, v_begin + k);
+            double* t = bank.target(angle_group, v_begin + k);
+            double* c = bank.current(angle_group, v_begin + k);
+            //前後の場合は、ピッチ角の回転方向は逆にする必要がある
+            t[0] = DEGREE2RADIAN(o[0]);
+            t[1] = DEGREE2RADIAN(-o[1]);
+            c[0] = NORMALIZE_RADIAN(in[k].euler.x);
+            c[1] = NORMALIZE_RADIAN(in[k].euler.y);
+        }
+        bank.run(angle_group, v_begin, v_end);
+
+        /*
+         * 姿勢角速度制御
+         */
+        for (int k = 0; k < n; k++) {
+            if (!bank.is_updated(angle_group, v_begin + k)) {
+                continue;
+            }
+            const double* o = bank.output(angle_group, v_begin + k);
+            double* t = bank.target(rate_group, v_begin + k);
+            double* c = bank.current(rate_group, v_begin + k);
+            t[0] = o[0];
+            t[1] = o[1];
+            t[2] = bank.output(head_group, v_begin + k)[0];
+            c[0] = NORMALIZE_RADIAN(in[k].angular_rate.p);
+            c[1] = NORMALIZE_RADIAN(in[k].angular_rate.q);
+            c[2] = NORMALIZE_RADIAN(in[k].angular_rate.r);
+        }
+        bank.run(rate_group, v_begin, v_end);
+
+        /*
+         * 出力
+         */
+        for (int k = 0; k < n; k++) {
+            const DroneAltParamType& alt = params[v_begin + k].alt;
+            const double* rate = bank.output(rate_group, v_begin + k);
+            if (bank.is_started(alt_spd_group, v_begin + k)) {
+                out[k].thrust = (alt.mass * alt.gravity) + (alt.throttle_gain * bank.output(alt_spd_group, v_begin + k)[0]);
+            }
+            else {
+                out[k].thrust = 0;
+            }
+            out[k].torque_x = rate[0];
+            out[k].torque_y = rate[1];
+            out[k].torque_z = rate[2];
+        }
+    }
+};
+
+/*
+ * モジュール内の全機体で共有するバンク
+ */
+inline DroneControllerBank& drone_controller_bank()
+{
+    static DroneControllerBank instance;
+    return instance;
+}
+
+#endif /* _DRONE_CONTROLLER_BANK_HPP_ */
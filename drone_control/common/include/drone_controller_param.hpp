@@ -0,0 +1,30 @@
+#ifndef _DRONE_CONTROLLER_PARAM_HPP_
+#define _DRONE_CONTROLLER_PARAM_HPP_
+
+#include "drone_alt_controller.hpp"
+#include "drone_pos_controller.hpp"
+#include "drone_heading_controller.hpp"
+#include "drone_angle_controller.hpp"
+#include "hako_controller_param_loader.hpp"
+
+/*
+ * 全コントローラのパラメータ(ホットリロードで一括して差し替える単位)
+ */
+struct DroneControllerParamType {
+    DroneAltParamType alt;
+    DronePosParamType pos;
+    DroneHeadingParamType head;
+    DroneAngleParamType angle;
+    double d_filter_tau;    /* 微分フィルタの時定数(省略時 0: フィルタなし) */
+    bool anti_windup;       /* 出力制限中の積分停止(省略時 0: しない) */
+    void load(const HakoControllerParamLoader& loader) {
+        alt.load(loader);
+        pos.load(loader);
+        head.load(loader);
+        angle.load(loader);
+        d_filter_tau = loader.getParameter("PID_D_FILTER_TAU", 0.0);
+        anti_windup = (loader.getParameter("PID_ANTI_WINDUP", 0.0) != 0.0);
+    }
+};
+
+#endif /* _DRONE_CONTROLLER_PARAM_HPP_ */
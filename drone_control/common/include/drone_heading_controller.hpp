@@ -18,6 +18,22 @@ struct DroneHeadingControlOutputType {
     DroneHeadingControlOutputType(double angular_rate_r_val) : target_yaw_rate(angular_rate_r_val) {}
 };
 
+struct DroneHeadingParamType {
+    double delta_time;
+    double head_control_cycle;
+    double yaw_rate_max;
+    DronePidGainType heading;
+    void load(const HakoControllerParamLoader& loader) {
+        delta_time = loader.getParameter("SIMULATION_DELTA_TIME");
+        head_control_cycle = loader.getParameter("HEAD_CONTROL_CYCLE");
+        yaw_rate_max = RPM2EULER_RATE(loader.getParameter("PID_YAW_RPM_MAX"));
+        heading = DronePidGainType(
+            loader.getParameter("PID_YAW_Kp"), 
+            loader.getParameter("PID_YAW_Ki"), 
+            loader.getParameter("PID_YAW_Kd"));
+    }
+};
+
 class DroneHeadingController {
 private:
     double delta_time;
@@ -46,14 +62,9 @@ private:
     }
     const HakoControllerParamLoader* my_loader;
     void loadParameters(const HakoControllerParamLoader& loader) {
-        delta_time = loader.getParameter("SIMULATION_DELTA_TIME");
-        head_control_cycle = loader.getParameter("HEAD_CONTROL_CYCLE");
-        yaw_rate_max = RPM2EULER_RATE(loader.getParameter("PID_YAW_RPM_MAX"));
-        heading_control = std::make_unique<DronePidControl>(
-            loader.getParameter("PID_YAW_Kp"), 
-            loader.getParameter("PID_YAW_Ki"), 
-            loader.getParameter("PID_YAW_Kd"), 
-            0, delta_time);
+        DroneHeadingParamType param;
+        param.load(loader);
+        applyParameters(param);
     }
 public:
     double head_control_cycle;
@@ -64,6 +75,20 @@ public:
     }
 
     virtual ~DroneHeadingController() {}
+    /*
+     * パラメータの差し替え(制御周期の途中状態と積分値は保持する)
+     */
+    void applyParameters(const DroneHeadingParamType& param) {
+        delta_time = param.delta_time;
+        head_control_cycle = param.head_control_cycle;
+        yaw_rate_max = param.yaw_rate_max;
+        if (heading_control == nullptr) {
+            heading_control = std::make_unique<DronePidControl>(param.heading, 0, delta_time);
+        }
+        else {
+            heading_control->set_gain(param.heading, delta_time);
+        }
+    }
 
     DroneHeadingControlOutputType run(DroneHeadingControlInputType& in) {
         DroneHeadingControlOutputType out = prev_out;
@@ -81,10 +106,19 @@ public:
         simulation_time += delta_time;
         return out;
     }
+    /*
+     * 状態の保存・復元用(flight_controller_state.hpp)
+     */
+    template <typename Visitor>
+    void visit_state(Visitor& v) {
+        heading_control->visit_state(v);
+        v(prev_out);
+        v(simulation_time);
+    }
     void reset() {
         loadParameters(*my_loader);
         prev_out = {};
-        heading_control->reset_integral();
+        heading_control->reset();
         simulation_time = 0;
     }
 };
@@ -0,0 +1,252 @@
+#ifndef _DRONE_PID_BANK_HPP_
+#define _DRONE_PID_BANK_HPP_
+
+/*
+ * 全機体・全軸の PID をまとめて保持・計算する PID バンク
+ *
+ * 制御周期(レートグループ)ごとに、ゲインと内部状態を 機体 x 軸 の順で
+ * 連続配置(SoA)し、run() で指定範囲の機体を1回のループで計算する。
+ * 機体の追加(add_vehicle)はセットアップ時のみ配列を伸ばし、制御中はメモリ
+ * 確保を行わない。
+ *
+ * 各チャネルは DronePidControl と同じ式(P + I + D)と、従来のコントローラと
+ * 同じ制御周期の判定(経過時間 >= 制御周期 で計算し、積分・微分の刻みは
+ * delta_time)・出力制限(±out_max)を行う。加えて、以下は指定した場合のみ行う。
+ *  - 微分項の一次遅れフィルタ(d_filter_tau > 0)
+ *  - 出力制限時の積分停止による anti-windup(anti_windup = true)
+ * 制御周期と delta_time は機体ごとに持つ(機体ごとにパラメータファイルが異なってよい)。
+ */
+#include "drone_pid_control.hpp"
+#include "flight_controller_types.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+struct DronePidBankParamType {
+    DronePidGainType gain;
+    double out_max;         /* 出力の上下限(±out_max) */
+    double d_filter_tau;    /* 微分フィルタの時定数[sec], 0 はフィルタなし */
+    bool anti_windup;       /* 出力制限中は飽和方向への積分を止める */
+    DronePidBankParamType() : gain(), out_max(0), d_filter_tau(0), anti_windup(false) {}
+    DronePidBankParamType(const DronePidGainType& g, double o_max, double tau, bool aw)
+        : gain(g), out_max(o_max), d_filter_tau(tau), anti_windup(aw) {}
+};
+
+class DronePidBank {
+private:
+    struct Group {
+        int axis_num;
+        double default_cycle;
+        /* 機体ごと */
+        std::vector<double> cycle;
+        std::vector<double> elapsed;
+        std::vector<uint8_t> first_time;
+        std::vector<uint8_t> updated;   /* 直前の run() で計算したか */
+        /* 機体 x 軸 ごと */
+        std::vector<double> kp;
+        std::vector<double> ki;
+        std::vector<double> kd;
+        std::vector<double> out_max;
+        std::vector<double> d_filter_tau;
+        std::vector<uint8_t> anti_windup;
+        std::vector<double> integral;
+        std::vector<double> prev_error;
+        std::vector<double> derivative;
+        std::vector<double> target;
+        std::vector<double> current;
+        std::vector<double> output;
+    };
+    double default_delta_time;
+    std::vector<double> delta_time;     /* 機体ごと */
+    int vehicle_num = 0;
+    std::vector<Group> groups;
+    std::mutex setup_mutex;
+
+    static void resize(Group& g, int vehicle_num)
+    {
+        size_t n = static_cast<size_t>(vehicle_num) * g.axis_num;
+        g.cycle.resize(vehicle_num, g.default_cycle);
+        g.elapsed.resize(vehicle_num, 0);
+        g.first_time.resize(vehicle_num, 1);
+        g.updated.resize(vehicle_num, 0);
+        g.anti_windup.resize(n, 0);
+        for (auto* v : { &g.kp, &g.ki, &g.kd, &g.out_max, &g.d_filter_tau,
+                         &g.integral, &g.prev_error, &g.derivative,
+                         &g.target, &g.current, &g.output }) {
+            v->resize(n, 0);
+        }
+    }
+
+public:
+    DronePidBank(double dt) : default_delta_time(dt) {}
+    DronePidBank(const DronePidBank&) = delete;
+    DronePidBank& operator=(const DronePidBank&) = delete;
+
+    /*
+     * セットアップ: レートグループを定義してから機体を追加する
+     * cycle, dt は追加した機体の初期値
+     */
+    int add_group(int axis_num, double cycle)
+    {
+        std::lock_guard<std::mutex> lock(setup_mutex);
+        Group g = {};
+        g.axis_num = axis_num;
+        g.default_cycle = cycle;
+        resize(g, vehicle_num);
+        groups.push_back(std::move(g));
+        return static_cast<int>(groups.size()) - 1;
+    }
+    int add_vehicle()
+    {
+        std::lock_guard<std::mutex> lock(setup_mutex);
+        int index = vehicle_num++;
+        delta_time.resize(vehicle_num, default_delta_time);
+        for (auto& g : groups) {
+            resize(g, vehicle_num);
+        }
+        return index;
+    }
+    int get_vehicle_num() const { return vehicle_num; }
+    int get_axis_num(int group) const { return groups[group].axis_num; }
+
+    /*
+     * パラメータの設定(状態は保持する)
+     */
+    void set_delta_time(int vehicle, double dt) { delta_time[vehicle] = dt; }
+    void set_cycle(int group, int vehicle, double cycle) { groups[group].cycle[vehicle] = cycle; }
+    void set_param(int group, int vehicle, int axis, const DronePidBankParamType& param)
+    {
+        Group& g = groups[group];
+        size_t i = static_cast<size_t>(vehicle) * g.axis_num + axis;
+        g.kp[i] = param.gain.Kp;
+        g.ki[i] = param.gain.Ki;
+        g.kd[i] = param.gain.Kd;
+        g.out_max[i] = param.out_max;
+        g.d_filter_tau[i] = param.d_filter_tau;
+        g.anti_windup[i] = param.anti_windup ? 1 : 0;
+    }
+    void reset(int vehicle)
+    {
+        for (auto& g : groups) {
+            g.elapsed[vehicle] = 0;
+            g.first_time[vehicle] = 1;
+            g.updated[vehicle] = 0;
+            size_t b = static_cast<size_t>(vehicle) * g.axis_num;
+            for (size_t i = b; i < b + g.axis_num; i++) {
+                g.integral[i] = 0;
+                g.prev_error[i] = 0;
+                g.derivative[i] = 0;
+                g.target[i] = 0;
+                g.current[i] = 0;
+                g.output[i] = 0;
+            }
+        }
+    }
+
+    /*
+     * 1機体分の内部状態(経過時間, 初回フラグ, 積分値, 前回偏差, 微分値, 入出力)の
+     * 保存・復元。ゲイン等のパラメータは含めない。
+     */
+    size_t get_state_size() const
+    {
+        size_t size = 0;
+        for (const auto& g : groups) {
+            size += sizeof(double) + sizeof(uint8_t) + (sizeof(double) * 6 * g.axis_num);
+        }
+        return size;
+    }
+    void save_state(int vehicle, void* buf) const
+    {
+        uint8_t* p = static_cast<uint8_t*>(buf);
+        for (const auto& g : groups) {
+            const size_t b = static_cast<size_t>(vehicle) * g.axis_num;
+            const size_t n = sizeof(double) * g.axis_num;
+            std::memcpy(p, &g.elapsed[vehicle], sizeof(double));
+            p += sizeof(double);
+            std::memcpy(p, &g.first_time[vehicle], sizeof(uint8_t));
+            p += sizeof(uint8_t);
+            for (const auto* v : { &g.integral, &g.prev_error, &g.derivative, &g.target, &g.current, &g.output }) {
+                std::memcpy(p, &(*v)[b], n);
+                p += n;
+            }
+        }
+    }
+    void restore_state(int vehicle, const void* buf)
+    {
+        const uint8_t* p = static_cast<const uint8_t*>(buf);
+        for (auto& g : groups) {
+            const size_t b = static_cast<size_t>(vehicle) * g.axis_num;
+            const size_t n = sizeof(double) * g.axis_num;
+            std::memcpy(&g.elapsed[vehicle], p, sizeof(double));
+            p += sizeof(double);
+            std::memcpy(&g.first_time[vehicle], p, sizeof(uint8_t));
+            p += sizeof(uint8_t);
+            for (auto* v : { &g.integral, &g.prev_error, &g.derivative, &g.target, &g.current, &g.output }) {
+                std::memcpy(&(*v)[b], p, n);
+                p += n;
+            }
+        }
+    }
+
+    /*
+     * 入出力(機体 x 軸 の連続配列)
+     */
+    double* target(int group, int vehicle = 0) { return &groups[group].target[static_cast<size_t>(vehicle) * groups[group].axis_num]; }
+    double* current(int group, int vehicle = 0) { return &groups[group].current[static_cast<size_t>(vehicle) * groups[group].axis_num]; }
+    const double* output(int group, int vehicle = 0) const { return &groups[group].output[static_cast<size_t>(vehicle) * groups[group].axis_num]; }
+    /* 直前の run() で計算したか / 一度でも計算したか */
+    bool is_updated(int group, int vehicle) const { return groups[group].updated[vehicle] != 0; }
+    bool is_started(int group, int vehicle) const { return groups[group].first_time[vehicle] == 0; }
+
+    /*
+     * 機体 [v_begin, v_end) のうち制御周期に達したものを一括で計算する。
+     * 周期に達していない機体は前回の出力を保持する。
+     * 周期の判定と刻み幅は DroneAltController 等と同じ(初回は必ず計算し、
+     * 以後は経過時間が制御周期以上になったステップで計算。積分・微分は
+     * 制御周期ではなく delta_time で行う)。
+     */
+    void run(int group, int v_begin, int v_end)
+    {
+        Group& g = groups[group];
+        const int axis_num = g.axis_num;
+        for (int v = v_begin; v < v_end; v++) {
+            const double dt = delta_time[v];
+            if (g.elapsed[v] < g.cycle[v]) {
+                g.elapsed[v] += dt;
+                g.updated[v] = 0;
+                continue;
+            }
+            g.elapsed[v] = 0;
+            g.updated[v] = 1;
+            const bool first = (g.first_time[v] != 0);
+            g.first_time[v] = 0;
+            const size_t b = static_cast<size_t>(v) * axis_num;
+            for (size_t i = b; i < b + axis_num; i++) {
+                double error = g.target[i] - g.current[i];
+                double d = first ? 0.0 : (error - g.prev_error[i]) / dt;
+                if (!first && (g.d_filter_tau[i] > 0)) {
+                    double alpha = dt / (g.d_filter_tau[i] + dt);
+                    d = g.derivative[i] + alpha * (d - g.derivative[i]);
+                }
+                double integral = g.integral[i] + error * dt;
+                double u = g.kp[i] * error + g.ki[i] * integral + g.kd[i] * d;
+                double limit = g.out_max[i];
+                /* anti-windup: 飽和方向へ積分を進める場合は積分しない */
+                if (g.anti_windup[i] && ((u > limit && error > 0) || (u < -limit && error < 0))) {
+                    integral = g.integral[i];
+                    u = g.kp[i] * error + g.ki[i] * integral + g.kd[i] * d;
+                }
+                u = flight_controller_get_limit_value(u, 0, -limit, limit);
+                g.integral[i] = integral;
+                g.prev_error[i] = error;
+                g.derivative[i] = d;
+                g.output[i] = u;
+            }
+            g.elapsed[v] += dt;
+        }
+    }
+};
+
+#endif /* _DRONE_PID_BANK_HPP_ */
@@ -1,9 +1,18 @@
 #ifndef _PID_CONTROL_HPP_
 #define _PID_CONTROL_HPP_
 
+#include "flight_controller_state.hpp"
 #include <vector>
 #include <iostream>
 
+struct DronePidGainType {
+    double Kp;
+    double Ki;
+    double Kd;
+    DronePidGainType() : Kp(0), Ki(0), Kd(0) {}
+    DronePidGainType(double p, double i, double d) : Kp(p), Ki(i), Kd(d) {}
+};
+
 class DronePidControl {
 private:
     double Kp;
@@ -21,8 +30,22 @@ public:
         : Kp(Kp), Ki(Ki), Kd(Kd), target(sp), integral(0.0), prev_error(0.0), first_time(true), delta_time(dt)
     {
     }
+    DronePidControl(const DronePidGainType& gain, double sp, double dt)
+        : DronePidControl(gain.Kp, gain.Ki, gain.Kd, sp, dt)
+    {
+    }
     ~DronePidControl() {}
 
+    /*
+     * ゲインの差し替え(積分値・前回偏差は保持する)
+     */
+    void set_gain(const DronePidGainType& gain, double dt) {
+        Kp = gain.Kp;
+        Ki = gain.Ki;
+        Kd = gain.Kd;
+        delta_time = dt;
+    }
+
     double calculate(double sp, double input) {
         target = sp;
         double error = target - input;
@@ -37,6 +60,24 @@ public:
     void reset_integral() {
         integral = 0.0;
     }
+    /*
+     * 生成直後と同じ状態に戻す(コントローラの reset() は以前 PID を作り直していた)
+     */
+    void reset() {
+        integral = 0.0;
+        prev_error = 0.0;
+        first_time = true;
+    }
+    /*
+     * 状態(目標値, 積分値, 前回偏差, 初回フラグ)の保存・復元用
+     */
+    template <typename Visitor>
+    void visit_state(Visitor& v) {
+        v(target);
+        v(integral);
+        v(prev_error);
+        v(first_time);
+    }
 };
 
 #endif /* _PID_CONTROL_HPP_ */
\ No newline at end of file
@@ -36,6 +36,50 @@ struct DroneVelInputType {
 };
 
 
+struct DronePosParamType {
+    double delta_time;
+    double pos_control_cycle;
+    double max_spd;
+    DronePidGainType pos_x;
+    DronePidGainType pos_y;
+    double spd_control_cycle;
+    double max_roll_deg;
+    double max_pitch_deg;
+    DronePidGainType spd_x;
+    DronePidGainType spd_y;
+    void load(const HakoControllerParamLoader& loader) {
+        delta_time = loader.getParameter("SIMULATION_DELTA_TIME");
+        /*
+         * position control
+         */
+        pos_control_cycle = loader.getParameter("POS_CONTROL_CYCLE");
+        max_spd = loader.getParameter("PID_POS_MAX_SPD");
+        pos_x = DronePidGainType(
+            loader.getParameter("PID_POS_X_Kp"), 
+            loader.getParameter("PID_POS_X_Ki"), 
+            loader.getParameter("PID_POS_X_Kd"));
+        pos_y = DronePidGainType(
+            loader.getParameter("PID_POS_Y_Kp"), 
+            loader.getParameter("PID_POS_Y_Ki"), 
+            loader.getParameter("PID_POS_Y_Kd"));
+
+        /*
+         * speed control
+         */
+        spd_control_cycle = loader.getParameter("SPD_CONTROL_CYCLE");
+        max_roll_deg = loader.getParameter("PID_POS_MAX_ROLL");
+        max_pitch_deg = loader.getParameter("PID_POS_MAX_PITCH");
+        spd_x = DronePidGainType(
+            loader.getParameter("PID_POS_VX_Kp"), 
+            loader.getParameter("PID_POS_VX_Ki"), 
+            loader.getParameter("PID_POS_VX_Kd"));
+        spd_y = DronePidGainType(
+            loader.getParameter("PID_POS_VY_Kp"), 
+            loader.getParameter("PID_POS_VY_Ki"), 
+            loader.getParameter("PID_POS_VY_Kd"));
+    }
+};
+
 class DronePosController {
 private:
     double delta_time;
@@ -89,39 +133,9 @@ private:
 
     const HakoControllerParamLoader* my_loader;
     void loadParameters(const HakoControllerParamLoader& loader) {
-        delta_time = loader.getParameter("SIMULATION_DELTA_TIME");
-        /*
-         * position control
-         */
-        pos_control_cycle = loader.getParameter("POS_CONTROL_CYCLE");
-        max_spd = loader.getParameter("PID_POS_MAX_SPD");
-        position_control_vx = std::make_unique<DronePidControl>(
-            loader.getParameter("PID_POS_X_Kp"), 
-            loader.getParameter("PID_POS_X_Ki"), 
-            loader.getParameter("PID_POS_X_Kd"), 
-            0, delta_time);
-        position_control_vy = std::make_unique<DronePidControl>(
-            loader.getParameter("PID_POS_Y_Kp"), 
-            loader.getParameter("PID_POS_Y_Ki"), 
-            loader.getParameter("PID_POS_Y_Kd"), 
-            0, delta_time);
-
-        /*
-         * speed control
-         */
-        spd_control_cycle = loader.getParameter("SPD_CONTROL_CYCLE");
-        max_roll_deg = loader.getParameter("PID_POS_MAX_ROLL");
-        max_pitch_deg = loader.getParameter("PID_POS_MAX_PITCH");
-        speed_control_vx = std::make_unique<DronePidControl>(
-            loader.getParameter("PID_POS_VX_Kp"), 
-            loader.getParameter("PID_POS_VX_Ki"), 
-            loader.getParameter("PID_POS_VX_Kd"), 
-            0, delta_time);
-        speed_control_vy = std::make_unique<DronePidControl>(
-            loader.getParameter("PID_POS_VY_Kp"), 
-            loader.getParameter("PID_POS_VY_Ki"), 
-            loader.getParameter("PID_POS_VY_Kd"), 
-            0, delta_time);
+        DronePosParamType param;
+        param.load(loader);
+        applyParameters(param);
     }
 public:
     DronePosController(const HakoControllerParamLoader& loader) {
@@ -130,6 +144,29 @@ public:
     }
 
     virtual ~DronePosController() {}
+    /*
+     * パラメータの差し替え(制御周期の途中状態と積分値は保持する)
+     */
+    void applyParameters(const DronePosParamType& param) {
+        delta_time = param.delta_time;
+        pos_control_cycle = param.pos_control_cycle;
+        max_spd = param.max_spd;
+        spd_control_cycle = param.spd_control_cycle;
+        max_roll_deg = param.max_roll_deg;
+        max_pitch_deg = param.max_pitch_deg;
+        if (position_control_vx == nullptr) {
+            position_control_vx = std::make_unique<DronePidControl>(param.pos_x, 0, delta_time);
+            position_control_vy = std::make_unique<DronePidControl>(param.pos_y, 0, delta_time);
+            speed_control_vx = std::make_unique<DronePidControl>(param.spd_x, 0, delta_time);
+            speed_control_vy = std::make_unique<DronePidControl>(param.spd_y, 0, delta_time);
+        }
+        else {
+            position_control_vx->set_gain(param.pos_x, delta_time);
+            position_control_vy->set_gain(param.pos_y, delta_time);
+            speed_control_vx->set_gain(param.spd_x, delta_time);
+            speed_control_vy->set_gain(param.spd_y, delta_time);
+        }
+    }
     DronePosOutputType run_spd(DroneVelInputType& in) {
         DronePosOutputType out = pos_prev_out;
         if (spd_simulation_time >= spd_control_cycle) {
@@ -150,14 +187,28 @@ public:
         DroneVelInputType vel = run_pos(in);
         return run_spd(vel); 
     }
+    /*
+     * 状態の保存・復元用(flight_controller_state.hpp)
+     */
+    template <typename Visitor>
+    void visit_state(Visitor& v) {
+        position_control_vx->visit_state(v);
+        position_control_vy->visit_state(v);
+        speed_control_vx->visit_state(v);
+        speed_control_vy->visit_state(v);
+        v(pos_prev_out);
+        v(pos_simulation_time);
+        v(spd_prev_out);
+        v(spd_simulation_time);
+    }
     void reset() {
         loadParameters(*my_loader);
         pos_prev_out = {};
         spd_prev_out = {};
-        position_control_vx->reset_integral();
-        position_control_vy->reset_integral();
-        speed_control_vx->reset_integral();
-        speed_control_vy->reset_integral();
+        position_control_vx->reset();
+        position_control_vy->reset();
+        speed_control_vx->reset();
+        speed_control_vy->reset();
         pos_simulation_time = 0;
         spd_simulation_time = 0;
     }
@@ -5,10 +5,41 @@
 #include "drone_pos_controller.hpp"
 #include "drone_heading_controller.hpp"
 #include "drone_angle_controller.hpp"
+#include "drone_controller_param.hpp"
+#include "flight_controller_state.hpp"
 #include "hako_controller_param_loader.hpp"
+#include "hako_controller_param_watcher.hpp"
 #include <stdexcept>
 #include <memory>
 
+struct DroneRadioParamType {
+    DroneControllerParamType ctrl;
+    double delta_time;
+    double alt_control_cycle;
+    double head_control_cycle;
+    double pos_control_cycle;
+    double alt_delta_value_m;
+    double yaw_delta_value_deg;
+    double max_roll_deg;
+    double max_pitch_deg;
+    double pos_max_spd;
+    bool   angle_control_enable;
+    void load(const HakoControllerParamLoader& loader) {
+        ctrl.load(loader);
+        delta_time = loader.getParameter("SIMULATION_DELTA_TIME");
+        head_control_cycle = loader.getParameter("HEAD_CONTROL_CYCLE");
+        alt_control_cycle = loader.getParameter("PID_ALT_CONTROL_CYCLE");
+        pos_control_cycle = loader.getParameter("POS_CONTROL_CYCLE");
+        max_roll_deg = loader.getParameter("PID_POS_MAX_ROLL");
+        max_pitch_deg = loader.getParameter("PID_POS_MAX_PITCH");
+        int a_ctrl_enable = loader.getParameter("ANGLE_CONTROL_ENABLE");
+        angle_control_enable = (a_ctrl_enable == 1);
+        alt_delta_value_m = loader.getParameter("ALT_DELTA_VALUE_M");
+        yaw_delta_value_deg = loader.getParameter("YAW_DELTA_VALUE_DEG");
+        pos_max_spd = loader.getParameter("PID_POS_MAX_SPD");
+    }
+};
+
 class DroneRadioController {
 private:
     //parameters
@@ -31,25 +62,32 @@ private:
     //yaw control
     double yaw_time = 0;
     double r_yaw = 0;
+    std::shared_ptr<HakoControllerParamWatcher<DroneRadioParamType>> watcher;
+    HakoControllerParamWatcherCursor watcher_cursor = {};
+    DroneRadioParamType next_param = {};
+    void applyParameters(const DroneRadioParamType& param) {
+        delta_time = param.delta_time;
+        head_control_cycle = param.head_control_cycle;
+        alt_control_cycle = param.alt_control_cycle;
+        pos_control_cycle = param.pos_control_cycle;
+        max_roll_deg = param.max_roll_deg;
+        max_pitch_deg = param.max_pitch_deg;
+        angle_control_enable = param.angle_control_enable;
+        alt_delta_value_m = param.alt_delta_value_m;
+        yaw_delta_value_deg = param.yaw_delta_value_deg;
+        pos_max_spd = param.pos_max_spd;
+    }
     void loadParameters() {
         //load parameters
-        delta_time = loader.getParameter("SIMULATION_DELTA_TIME");
-        head_control_cycle = loader.getParameter("HEAD_CONTROL_CYCLE");
-        alt_control_cycle = loader.getParameter("PID_ALT_CONTROL_CYCLE");
-        pos_control_cycle = loader.getParameter("POS_CONTROL_CYCLE");
-        max_roll_deg = loader.getParameter("PID_POS_MAX_ROLL");
-        max_pitch_deg = loader.getParameter("PID_POS_MAX_PITCH");
-        int a_ctrl_enable = loader.getParameter("ANGLE_CONTROL_ENABLE");
-        if (a_ctrl_enable == 1) {
+        DroneRadioParamType param;
+        param.load(loader);
+        applyParameters(param);
+        if (angle_control_enable) {
             std::cout << "Angle control is enabled" << std::endl;
-            angle_control_enable = true;
         }
         else {
             std::cout << "Angle control is disabled" << std::endl;
         }
-        alt_delta_value_m = loader.getParameter("ALT_DELTA_VALUE_M");
-        yaw_delta_value_deg = loader.getParameter("YAW_DELTA_VALUE_DEG");
-        pos_max_spd = loader.getParameter("PID_POS_MAX_SPD");
     }
 public:
     std::unique_ptr<DroneAltController> alt;
@@ -72,6 +110,28 @@ public:
         angle = std::make_unique<DroneAngleController>(loader);
         //params
         this->loadParameters();
+        if (HakoControllerParamLoader::is_watch_enabled()) {
+            watcher = HakoControllerParamWatcher<DroneRadioParamType>::acquire(loader.getFilename());
+            watcher_cursor = watcher->cursor();
+        }
+    }
+    ~DroneRadioController() {}
+    /*
+     * ステップ間で呼ぶ: 再読み込み済みのパラメータがあれば差し替える
+     */
+    void update_parameters() {
+        if ((watcher != nullptr) && watcher->fetch(watcher_cursor, next_param)) {
+            applyParameters(next_param);
+            alt->applyParameters(next_param.ctrl.alt);
+            pos->applyParameters(next_param.ctrl.pos);
+            head->applyParameters(next_param.ctrl.head);
+            angle->applyParameters(next_param.ctrl.angle);
+        }
+    }
+    void request_reload() {
+        if (watcher != nullptr) {
+            watcher->request_reload();
+        }
     }
     void reset() {
         this->loader.reload();
@@ -86,6 +146,35 @@ public:
         head->reset();
         angle->reset();
     }
+    /*
+     * 状態(目標高度・目標方位とその更新周期の経過時間、各制御器の PID)の保存・復元
+     * パラメータは含めない
+     */
+    template <typename Visitor>
+    void visit_state(Visitor& v) {
+        v(r_altitude_initialized);
+        v(r_altitude);
+        v(alt_time);
+        v(yaw_time);
+        v(r_yaw);
+        alt->visit_state(v);
+        pos->visit_state(v);
+        head->visit_state(v);
+        angle->visit_state(v);
+    }
+    size_t get_state_size() {
+        FlightControllerStateSize size;
+        visit_state(size);
+        return size.size;
+    }
+    void save_state(void* buf) {
+        FlightControllerStateSave save = { static_cast<uint8_t*>(buf) };
+        visit_state(save);
+    }
+    void restore_state(const void* buf) {
+        FlightControllerStateRestore restore = { static_cast<const uint8_t*>(buf) };
+        visit_state(restore);
+    }
     double get_pos_max_spd()
     {
         return pos_max_spd;
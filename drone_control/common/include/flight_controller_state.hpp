@@ -0,0 +1,47 @@
+#ifndef _FLIGHT_CONTROLLER_STATE_HPP_
+#define _FLIGHT_CONTROLLER_STATE_HPP_
+
+/*
+ * 制御器の内部状態(積分値・制御周期の経過時間・前回の出力等)の保存・復元
+ *
+ * 各制御器は visit_state(v) で状態のメンバを決まった順に v(メンバ) へ渡す。
+ * ゲインや制御周期等のパラメータは含めない。
+ *   FlightControllerStateSize    : バイト数を数える
+ *   FlightControllerStateSave    : バイト列に書く
+ *   FlightControllerStateRestore : バイト列から戻す
+ */
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+struct FlightControllerStateSize {
+    size_t size = 0;
+    template <typename T>
+    void operator()(const T&) {
+        static_assert(std::is_trivially_copyable<T>::value, "state must be trivially copyable");
+        size += sizeof(T);
+    }
+};
+
+struct FlightControllerStateSave {
+    uint8_t* p;
+    template <typename T>
+    void operator()(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "state must be trivially copyable");
+        std::memcpy(p, &value, sizeof(T));
+        p += sizeof(T);
+    }
+};
+
+struct FlightControllerStateRestore {
+    const uint8_t* p;
+    template <typename T>
+    void operator()(T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "state must be trivially copyable");
+        std::memcpy(&value, p, sizeof(T));
+        p += sizeof(T);
+    }
+};
+
+#endif /* _FLIGHT_CONTROLLER_STATE_HPP_ */
@@ -16,6 +16,14 @@ public:
         const char* env_p = std::getenv("HAKO_CONTROLLER_PARAM_FILE");
         return env_p != nullptr && env_p[0] != '\0';
     }
+    /*
+     * HAKO_CONTROLLER_PARAM_WATCH=1 の場合、パラメータファイルの更新を監視して
+     * シミュレーションを止めずにゲインを差し替える(hako_controller_param_watcher.hpp)
+     */
+    static bool is_watch_enabled() {
+        const char* env_p = std::getenv("HAKO_CONTROLLER_PARAM_WATCH");
+        return env_p != nullptr && std::string(env_p) == "1";
+    }
 
     HakoControllerParamLoader() {
         const char* env_p = std::getenv("HAKO_CONTROLLER_PARAM_FILE");
@@ -66,13 +74,27 @@ public:
     double getParameter(const std::string& paramName) const {
         auto it = parameters.find(paramName);
         if (it != parameters.end()) {
-            std::cout << paramName << ": " << it->second << std::endl;
             return it->second;
         } else {
             throw std::runtime_error("Parameter not found: " + paramName);
         }
     }
 
+    double getParameter(const std::string& paramName, double defaultValue) const {
+        auto it = parameters.find(paramName);
+        return (it != parameters.end()) ? it->second : defaultValue;
+    }
+
+    const std::string& getFilename() const {
+        return filename;
+    }
+
+    void dump(std::ostream& os) const {
+        for (const auto& entry : parameters) {
+            os << entry.first << ": " << entry.second << std::endl;
+        }
+    }
+
 private:
     std::string filename;
     std::unordered_map<std::string, double> parameters;
@@ -0,0 +1,262 @@
+#ifndef _HAKO_CONTROLLER_PARAM_WATCHER_HPP_
+#define _HAKO_CONTROLLER_PARAM_WATCHER_HPP_
+
+/*
+ * コントローラパラメータのホットリロード
+ *
+ * 監視スレッドがパラメータファイルの更新(Linux は inotify, それ以外は mtime の
+ * ポーリング)または request_reload() を契機にファイルを読み直し、型付きの
+ * パラメータ(ParamType)を作って公開する。制御側は各ステップの先頭で fetch() を
+ * 呼び、新しいパラメータがあれば差し替える。fetch() はメモリ確保もブロックも
+ * しない(監視スレッドが書き込み中なら次のステップに持ち越す)。
+ *
+ * 同じファイルを使う機体は acquire() で1つの監視スレッドを共有し、
+ * 反映済みの世代(HakoControllerParamWatcherCursor)だけを機体ごとに持つ。
+ *
+ * ParamType は void load(const HakoControllerParamLoader&) を持つこと。
+ * パラメータ不足などで読み込みに失敗した場合は前のパラメータのまま動作を続ける。
+ */
+#include "hako_controller_param_loader.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#define HAKO_CONTROLLER_PARAM_WATCH_INTERVAL_MSEC   100
+
+/*
+ * 機体ごとの反映済みの世代(制御側のみが触る)
+ */
+typedef struct {
+    uint32_t applied_seq;
+} HakoControllerParamWatcherCursor;
+
+template <typename ParamType>
+class HakoControllerParamWatcher {
+private:
+    std::string filename;
+    std::thread thread;
+    std::atomic<bool> running { false };
+    std::atomic<bool> reload_requested { false };
+
+    ParamType pending = {};
+    std::atomic<uint32_t> pending_seq { 0 };
+
+    int inotify_fd = -1;
+    int inotify_wd = -1;
+    struct timespec last_mtime = {};
+
+    static bool get_mtime(const std::string& path, struct timespec& mtime)
+    {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) {
+            return false;
+        }
+#ifdef __APPLE__
+        mtime = st.st_mtimespec;
+#else
+        mtime = st.st_mtim;
+#endif
+        return true;
+    }
+    std::string get_dirname() const
+    {
+        auto pos = filename.find_last_of('/');
+        return (pos == std::string::npos) ? std::string(".") : filename.substr(0, pos + 1);
+    }
+    std::string get_basename() const
+    {
+        auto pos = filename.find_last_of('/');
+        return (pos == std::string::npos) ? filename : filename.substr(pos + 1);
+    }
+    void open_notifier()
+    {
+#ifdef __linux__
+        /*
+         * エディタは一時ファイルを rename して保存することが多いので、
+         * ファイルそのものではなくディレクトリを監視する
+         */
+        inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify_fd >= 0) {
+            inotify_wd = inotify_add_watch(inotify_fd, get_dirname().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+            if (inotify_wd < 0) {
+                ::close(inotify_fd);
+                inotify_fd = -1;
+            }
+        }
+        if (inotify_fd < 0) {
+            std::cerr << "WARNING: inotify is not available, polling " << filename << std::endl;
+        }
+#endif
+        (void)get_mtime(filename, last_mtime);
+    }
+    void close_notifier()
+    {
+#ifdef __linux__
+        if (inotify_fd >= 0) {
+            ::close(inotify_fd);
+        }
+#endif
+        inotify_fd = -1;
+        inotify_wd = -1;
+    }
+    /*
+     * ファイルの更新を最大 HAKO_CONTROLLER_PARAM_WATCH_INTERVAL_MSEC 待つ
+     */
+    bool wait_for_change()
+    {
+#ifdef __linux__
+        if (inotify_fd >= 0) {
+            struct pollfd pfd = { inotify_fd, POLLIN, 0 };
+            if (poll(&pfd, 1, HAKO_CONTROLLER_PARAM_WATCH_INTERVAL_MSEC) <= 0) {
+                return false;
+            }
+            alignas(struct inotify_event) char buf[4096];
+            const std::string base = get_basename();
+            bool changed = false;
+            ssize_t len;
+            while ((len = read(inotify_fd, buf, sizeof(buf))) > 0) {
+                for (char* p = buf; p < buf + len; ) {
+                    struct inotify_event* ev = reinterpret_cast<struct inotify_event*>(p);
+                    if ((ev->len > 0) && (base == ev->name)) {
+                        changed = true;
+                    }
+                    p += sizeof(struct inotify_event) + ev->len;
+                }
+            }
+            return changed;
+        }
+#endif
+        std::this_thread::sleep_for(std::chrono::milliseconds(HAKO_CONTROLLER_PARAM_WATCH_INTERVAL_MSEC));
+        struct timespec mtime;
+        if (!get_mtime(filename, mtime)) {
+            return false;
+        }
+        if ((mtime.tv_sec == last_mtime.tv_sec) && (mtime.tv_nsec == last_mtime.tv_nsec)) {
+            return false;
+        }
+        last_mtime = mtime;
+        return true;
+    }
+    void reload()
+    {
+        try {
+            HakoControllerParamLoader loader(filename);
+            ParamType param = {};
+            param.load(loader);
+            {
+                std::unique_lock<std::shared_mutex> lock(pending_mutex);
+                pending = param;
+                pending_seq.fetch_add(1, std::memory_order_release);
+            }
+            std::cout << "INFO: controller parameters are reloaded from " << filename << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "ERROR: failed to reload controller parameters: " << e.what() << std::endl;
+        }
+    }
+    void watch_loop()
+    {
+        open_notifier();
+        while (running.load(std::memory_order_acquire)) {
+            bool changed = wait_for_change();
+            if (reload_requested.exchange(false, std::memory_order_acq_rel)) {
+                changed = true;
+            }
+            if (changed) {
+                reload();
+            }
+        }
+        close_notifier();
+    }
+
+protected:
+    /* 監視スレッドが書き込み中は、制御側の fetch() は待たずに諦める */
+    std::shared_mutex pending_mutex;
+
+public:
+    HakoControllerParamWatcher(const std::string& path) : filename(path) {}
+    HakoControllerParamWatcher(const HakoControllerParamWatcher&) = delete;
+    HakoControllerParamWatcher& operator=(const HakoControllerParamWatcher&) = delete;
+    ~HakoControllerParamWatcher()
+    {
+        stop();
+    }
+
+    void start()
+    {
+        if (running.exchange(true)) {
+            return;
+        }
+        thread = std::thread(&HakoControllerParamWatcher::watch_loop, this);
+        std::cout << "INFO: watching controller parameters: " << filename << std::endl;
+    }
+    void stop()
+    {
+        running.store(false, std::memory_order_release);
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    /*
+     * ファイル更新以外(PDU のコマンド等)からの再読み込み要求
+     */
+    void request_reload()
+    {
+        reload_requested.store(true, std::memory_order_release);
+    }
+    /*
+     * 同じファイルの監視スレッドを共有する(最後の利用者が手放すと止まる).
+     * 監視はファイル名の文字列単位で、ParamType(モジュール)ごとに別になる。
+     */
+    static std::shared_ptr<HakoControllerParamWatcher> acquire(const std::string& path)
+    {
+        static std::mutex registry_mutex;
+        static std::map<std::string, std::weak_ptr<HakoControllerParamWatcher>> registry;
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        auto watcher = registry[path].lock();
+        if (watcher == nullptr) {
+            watcher = std::make_shared<HakoControllerParamWatcher>(path);
+            watcher->start();
+            registry[path] = watcher;
+        }
+        return watcher;
+    }
+    /*
+     * 制御側: 利用開始時点の世代. これより後に読み直したものだけ fetch() で返す
+     */
+    HakoControllerParamWatcherCursor cursor() const
+    {
+        return { pending_seq.load(std::memory_order_acquire) };
+    }
+    /*
+     * 制御側: 新しいパラメータがあれば param にコピーして true を返す
+     */
+    bool fetch(HakoControllerParamWatcherCursor& cursor, ParamType& param)
+    {
+        uint32_t seq = pending_seq.load(std::memory_order_acquire);
+        if (seq == cursor.applied_seq) {
+            return false;
+        }
+        std::shared_lock<std::shared_mutex> lock(pending_mutex, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return false;
+        }
+        param = pending;
+        cursor.applied_seq = pending_seq.load(std::memory_order_relaxed);
+        return true;
+    }
+};
+
+#endif /* _HAKO_CONTROLLER_PARAM_WATCHER_HPP_ */
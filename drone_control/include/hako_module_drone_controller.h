@@ -1,6 +1,8 @@
 #ifndef _HAKO_MODULE_CONTROLLER_H_
 #define _HAKO_MODULE_CONTROLLER_H_
 
+#include <stddef.h>
+
 typedef struct {
     double roll;
     double pitch;
@@ -103,4 +105,54 @@ typedef struct {
     mi_drone_control_out_t (*run) (mi_drone_control_in_t *in);
 } HakoModuleDroneControllerType;
 
+/*
+ * HakoModuleHeaderType.version == HAKO_MODULE_VERSION_2 のモジュールは
+ * HAKO_MODULE_DRONE_CONTROLLER_SYMBOLE_NAME をこの型で公開する。
+ * run_batch は n 機体分の入力(ins[i].context で機体を識別)をまとめて計算し、
+ * outs[i] に結果を書く。NULL の場合、呼び出し側は run を機体ごとに呼ぶ。
+ * 異なる機体の組であれば、複数のスレッドから同時に呼んでもよい。
+ */
+typedef struct {
+    void* (*create_context) (void* arguments);
+    int (*is_operation_doing) (void* context);
+    int (*init) (void* context);
+    mi_drone_control_out_t (*run) (mi_drone_control_in_t *in);
+    void (*run_batch) (const mi_drone_control_in_t *ins, mi_drone_control_out_t *outs, int n);
+} HakoModuleDroneControllerV2Type;
+
+/*
+ * HakoModuleHeaderType.version == HAKO_MODULE_VERSION_3 のモジュールはこの型で公開する。
+ * コンテキストの内部状態(PID の積分値等)を get_state_size() バイトのバイト列として
+ * 保存・復元する(機体の状態のスナップショットに含める)。
+ * バイト列は同じモジュール・同じパラメータの間でのみ有効。
+ */
+typedef struct {
+    void* (*create_context) (void* arguments);
+    int (*is_operation_doing) (void* context);
+    int (*init) (void* context);
+    mi_drone_control_out_t (*run) (mi_drone_control_in_t *in);
+    void (*run_batch) (const mi_drone_control_in_t *ins, mi_drone_control_out_t *outs, int n);
+    size_t (*get_state_size) (void* context);
+    void (*save_state) (void* context, void* buf);
+    void (*restore_state) (void* context, const void* buf);
+} HakoModuleDroneControllerV3Type;
+
+/*
+ * HakoModuleHeaderType.version == HAKO_MODULE_VERSION_4 のモジュールはこの型で公開する。
+ * destroy_context は create_context で作ったコンテキストを破棄する。
+ * 破棄したコンテキストは以後どのエントリにも渡さない。
+ * v3 以前のモジュールのコンテキストは破棄せず、プロセス終了まで残る。
+ */
+typedef struct {
+    void* (*create_context) (void* arguments);
+    int (*is_operation_doing) (void* context);
+    int (*init) (void* context);
+    mi_drone_control_out_t (*run) (mi_drone_control_in_t *in);
+    void (*run_batch) (const mi_drone_control_in_t *ins, mi_drone_control_out_t *outs, int n);
+    size_t (*get_state_size) (void* context);
+    void (*save_state) (void* context, void* buf);
+    void (*restore_state) (void* context, const void* buf);
+    void (*destroy_context) (void* context);
+} HakoModuleDroneControllerV4Type;
+
 #endif /* _HAKO_MODULE_CONTROLLER_H_ */
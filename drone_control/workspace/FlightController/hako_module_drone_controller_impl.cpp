@@ -2,6 +2,7 @@
 #include "drone_controller.hpp"
 #include <algorithm>
 #include <iostream>
+#include <vector>
 
 const char* hako_module_drone_controller_impl_get_name(void)
 {
@@ -28,57 +29,115 @@ int hako_module_drone_controller_impl_init(void* context)
     }
     return 0;
 }
-mi_drone_control_out_t hako_module_drone_controller_impl_run(mi_drone_control_in_t *in)
+static void drone_controller_set_input(const mi_drone_control_in_t *in, DroneControllerBankInputType& ctrl_in)
 {
-    DroneController* ctrl = (DroneController*)in->context;
-    mi_drone_control_out_t out = {};
     /*
      * 入力
      * 補足：z軸は、わかりやすさを重視しして符号を反転する。
      */
-    FlightControllerInputEulerType euler = {in->euler_x, in->euler_y, in->euler_z};
-    FlightControllerInputPositionType pos = {in->pos_x, in->pos_y, -in->pos_z};
-    FlightControllerInputVelocityType velocity = {in->u, in->v, -in->w};
-    FlightControllerInputAngularRateType angular_rate = {in->p, in->q, in->r};
+    ctrl_in.euler = {in->euler_x, in->euler_y, in->euler_z};
+    ctrl_in.pos = {in->pos_x, in->pos_y, -in->pos_z};
+    ctrl_in.velocity = {in->u, in->v, -in->w};
+    ctrl_in.angular_rate = {in->p, in->q, in->r};
 
     /*
      * 目標値は、NED座標系で入る。
      * Z軸だけ、わかりやすさのため符号を反転している
      */
-    double target_pos_x    =  in->target_pos_x;
-    double target_pos_y    =  in->target_pos_y;
-    double target_pos_z    = -in->target_pos_z;
-    double target_velocity =  in->target_velocity;
-    double target_angle    =  in->target_yaw_deg;
+    ctrl_in.target_x        =  in->target_pos_x;
+    ctrl_in.target_y        =  in->target_pos_y;
+    ctrl_in.target_z        = -in->target_pos_z;
+    ctrl_in.target_velocity =  in->target_velocity;
+    ctrl_in.target_yaw_deg  =  in->target_yaw_deg;
+}
+static void drone_controller_set_output(const FlightControllerOutputType& ctrl_out, mi_drone_control_out_t& out)
+{
+    out = {};
+    out.thrust = ctrl_out.thrust;
+    out.torque_x = ctrl_out.torque_x;
+    out.torque_y = ctrl_out.torque_y;
+    out.torque_z = ctrl_out.torque_z;
+}
 
+mi_drone_control_out_t hako_module_drone_controller_impl_run(mi_drone_control_in_t *in)
+{
+    DroneController* ctrl = (DroneController*)in->context;
+    mi_drone_control_out_t out = {};
     /*
-     * 高度制御
-     */
-    DroneAltInputType alt_in(pos, velocity, target_pos_z);
-    DroneAltOutputType alt_out = ctrl->alt->run(alt_in);
-    /*
-     * 機首方向制御
-     */
-    DroneHeadingControlInputType head_in(euler, target_angle);
-    DroneHeadingControlOutputType head_out = ctrl->head->run(head_in);
-    /*
-     * 水平制御
+     * ホットリロードされたパラメータの反映(ステップ間)
      */
-    DronePosInputType pos_in(pos, velocity, euler, target_pos_x, target_pos_y, target_velocity);
-    DronePosOutputType pos_out = ctrl->pos->run(pos_in);
+    ctrl->update_parameters();
+
+    DroneControllerBankInputType ctrl_in;
+    drone_controller_set_input(in, ctrl_in);
     /*
-     * 姿勢角度制御
+     * 高度・機首方向・水平・姿勢角度制御
      */
-    DroneAngleInputType angle_in(euler, angular_rate, pos_out.target_roll, pos_out.target_pitch, head_out.target_yaw_rate);
-    DroneAngleOutputType angle_out = ctrl->angle->run(angle_in);
+    FlightControllerOutputType ctrl_out = ctrl->run(ctrl_in);
     /*
      * 出力
      */
-    out.thrust = alt_out.thrust;
-    out.torque_x = angle_out.p;
-    out.torque_y = angle_out.q;
-    out.torque_z = angle_out.r;
+    drone_controller_set_output(ctrl_out, out);
     return out;
 }
 
+void hako_module_drone_controller_impl_run_batch(const mi_drone_control_in_t *ins, mi_drone_control_out_t *outs, int n)
+{
+    /*
+     * 作業領域は呼び出し元のスレッドごとに持ち、機体数が増えたときだけ伸ばす
+     * (別スレッドの run_batch と同時に呼ばれても共有しない)
+     */
+    thread_local std::vector<DroneControllerBankInputType> ctrl_ins;
+    thread_local std::vector<FlightControllerOutputType> ctrl_outs;
+    if (n <= 0) {
+        return;
+    }
+    if (ctrl_ins.size() < static_cast<size_t>(n)) {
+        ctrl_ins.resize(n);
+        ctrl_outs.resize(n);
+    }
+    int first = ((DroneController*)ins[0].context)->get_index();
+    bool contiguous = true;
+    for (int i = 0; i < n; i++) {
+        DroneController* ctrl = (DroneController*)ins[i].context;
+        ctrl->update_parameters();
+        drone_controller_set_input(&ins[i], ctrl_ins[i]);
+        if (ctrl->get_index() != first + i) {
+            contiguous = false;
+        }
+    }
+    if (contiguous) {
+        /*
+         * バンク上で連続している機体は各制御段を1回のループで計算する
+         */
+        drone_controller_bank().run(first, first + n, ctrl_ins.data(), ctrl_outs.data());
+    }
+    else {
+        for (int i = 0; i < n; i++) {
+            ctrl_outs[i] = ((DroneController*)ins[i].context)->run(ctrl_ins[i]);
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        drone_controller_set_output(ctrl_outs[i], outs[i]);
+    }
+}
+
+size_t hako_module_drone_controller_impl_get_state_size(void* context)
+{
+    return ((DroneController*)context)->get_state_size();
+}
+
+void hako_module_drone_controller_impl_save_state(void* context, void* buf)
+{
+    ((DroneController*)context)->save_state(buf);
+}
 
+void hako_module_drone_controller_impl_restore_state(void* context, const void* buf)
+{
+    ((DroneController*)context)->restore_state(buf);
+}
+
+void hako_module_drone_controller_impl_destroy_context(void* context)
+{
+    delete (DroneController*)context;
+}
@@ -32,6 +32,10 @@ mi_drone_control_out_t hako_module_drone_controller_impl_run(mi_drone_control_in
 {
     DroneRadioController* ctrl = (DroneRadioController*)in->context;
     mi_drone_control_out_t out = {};
+    /*
+     * ホットリロードされたパラメータの反映(ステップ間)
+     */
+    ctrl->update_parameters();
     /*
      * 入力
      * 補足：z軸は、わかりやすさを重視しして符号を反転する。
@@ -97,4 +101,33 @@ mi_drone_control_out_t hako_module_drone_controller_impl_run(mi_drone_control_in
     return out;
 }
 
+void hako_module_drone_controller_impl_run_batch(const mi_drone_control_in_t *ins, mi_drone_control_out_t *outs, int n)
+{
+    /*
+     * ラジオコントロールは機体ごとにモード判定があるため、1機ずつ計算する
+     */
+    for (int i = 0; i < n; i++) {
+        mi_drone_control_in_t in = ins[i];
+        outs[i] = hako_module_drone_controller_impl_run(&in);
+    }
+}
+
+size_t hako_module_drone_controller_impl_get_state_size(void* context)
+{
+    return ((DroneRadioController*)context)->get_state_size();
+}
+
+void hako_module_drone_controller_impl_save_state(void* context, void* buf)
+{
+    ((DroneRadioController*)context)->save_state(buf);
+}
 
+void hako_module_drone_controller_impl_restore_state(void* context, const void* buf)
+{
+    ((DroneRadioController*)context)->restore_state(buf);
+}
+
+void hako_module_drone_controller_impl_destroy_context(void* context)
+{
+    delete (DroneRadioController*)context;
+}
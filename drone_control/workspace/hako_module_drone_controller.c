@@ -14,18 +14,38 @@ extern "C" {
 #define HAKO_MODULE_EXPORT
 #endif
 
+#if defined(HAKO_MODULE_DRONE_CONTROLLER_IMPL_STATE) && defined(HAKO_MODULE_DRONE_CONTROLLER_IMPL_DESTROY)
+#define HAKO_MODULE_DRONE_CONTROLLER_IMPL_VERSION   HAKO_MODULE_VERSION_4
+    typedef HakoModuleDroneControllerV4Type HakoModuleDroneControllerImplType;
+#elif defined(HAKO_MODULE_DRONE_CONTROLLER_IMPL_STATE)
+#define HAKO_MODULE_DRONE_CONTROLLER_IMPL_VERSION   HAKO_MODULE_VERSION_3
+    typedef HakoModuleDroneControllerV3Type HakoModuleDroneControllerImplType;
+#else
+#define HAKO_MODULE_DRONE_CONTROLLER_IMPL_VERSION   HAKO_MODULE_VERSION_2
+    typedef HakoModuleDroneControllerV2Type HakoModuleDroneControllerImplType;
+#endif
+
     HAKO_MODULE_EXPORT HakoModuleHeaderType hako_module_header = {
         .magicno = HAKO_MODULE_MAGICNO,
-        .version = HAKO_MODULE_VERSION,
+        .version = HAKO_MODULE_DRONE_CONTROLLER_IMPL_VERSION,
         .get_type = hako_module_drone_controller_impl_get_type,
         .get_name = hako_module_drone_controller_impl_get_name
     };
 
-    HAKO_MODULE_EXPORT HakoModuleDroneControllerType hako_module_drone_controller = {
+    HAKO_MODULE_EXPORT HakoModuleDroneControllerImplType hako_module_drone_controller = {
         .create_context = hako_module_drone_controller_impl_create_context,
         .is_operation_doing = hako_module_drone_controller_impl_is_operation_doing,
         .init = hako_module_drone_controller_impl_init,
         .run = hako_module_drone_controller_impl_run,
+        .run_batch = hako_module_drone_controller_impl_run_batch,
+#ifdef HAKO_MODULE_DRONE_CONTROLLER_IMPL_STATE
+        .get_state_size = hako_module_drone_controller_impl_get_state_size,
+        .save_state = hako_module_drone_controller_impl_save_state,
+        .restore_state = hako_module_drone_controller_impl_restore_state,
+#endif
+#if defined(HAKO_MODULE_DRONE_CONTROLLER_IMPL_STATE) && defined(HAKO_MODULE_DRONE_CONTROLLER_IMPL_DESTROY)
+        .destroy_context = hako_module_drone_controller_impl_destroy_context,
+#endif
     };
 
     static const char* hako_module_drone_controller_impl_get_type(void)
@@ -13,6 +13,18 @@ extern void* hako_module_drone_controller_impl_create_context(void* arguments);
 extern int hako_module_drone_controller_impl_is_operation_doing(void* context);
 extern int hako_module_drone_controller_impl_init(void* context);
 extern mi_drone_control_out_t hako_module_drone_controller_impl_run(mi_drone_control_in_t *in);
+extern void hako_module_drone_controller_impl_run_batch(const mi_drone_control_in_t *ins, mi_drone_control_out_t *outs, int n);
+/*
+ * HAKO_MODULE_DRONE_CONTROLLER_IMPL_STATE を定義したモジュールのみ(version 3 で公開する)
+ */
+extern size_t hako_module_drone_controller_impl_get_state_size(void* context);
+extern void hako_module_drone_controller_impl_save_state(void* context, void* buf);
+extern void hako_module_drone_controller_impl_restore_state(void* context, const void* buf);
+/*
+ * HAKO_MODULE_DRONE_CONTROLLER_IMPL_STATE と HAKO_MODULE_DRONE_CONTROLLER_IMPL_DESTROY の
+ * 両方を定義したモジュールのみ(version 4 で公開する)
+ */
+extern void hako_module_drone_controller_impl_destroy_context(void* context);
 
 #ifdef __cplusplus
 }
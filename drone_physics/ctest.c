@@ -77,11 +77,122 @@ static void test_body_angular_acceleration()
 }
 
 
+#define VN 3
+#define VK 50
+#define VDT 0.001
+
+/* batch stepping is the same as the single functions integrated one by one */
+static void test_vehicles_step()
+{
+    dp_vehicles_t* vehicles = dp_vehicles_create(VN, VDT);
+    assert(vehicles && dp_vehicles_num(vehicles) == VN);
+    for (int i = 0; i < VN; i++) {
+        dp_vehicle_params_t params = {1.0 + i, 2, 5, 8, 9.81, 0.1 * i};
+        assert(dp_vehicles_set_params(vehicles, i, &params) == 0);
+    }
+    double init[12][VN];
+    for (int i = 0; i < VN; i++) {
+        for (int j = 0; j < 12; j++) init[j][i] = 0.01 * (j + 1) * (i + 1);
+        init[2][i] = -10.0; /* z: in the air */
+    }
+    dp_vehicles_state_t state = {init[0], init[1], init[2], init[3], init[4], init[5],
+        init[6], init[7], init[8], init[9], init[10], init[11], 1, 0};
+    assert(dp_vehicles_set_state(vehicles, &state) == 0);
+
+    double thrust[VK][VN], tx[VK][VN], ty[VK][VN], tz[VK][VN];
+    for (int k = 0; k < VK; k++) {
+        for (int i = 0; i < VN; i++) {
+            thrust[k][i] = 9.0 + 0.1 * k + i; tx[k][i] = 0.1 * i; ty[k][i] = 0.01 * k; tz[k][i] = -0.1;
+        }
+    }
+    static double traj[12][VK][VN];
+    dp_vehicles_input_t input = {&thrust[0][0], &tx[0][0], &ty[0][0], &tz[0][0], 1, VN};
+    dp_vehicles_state_t trajectory = {&traj[0][0][0], &traj[1][0][0], &traj[2][0][0], &traj[3][0][0],
+        &traj[4][0][0], &traj[5][0][0], &traj[6][0][0], &traj[7][0][0], &traj[8][0][0],
+        &traj[9][0][0], &traj[10][0][0], &traj[11][0][0], 1, VN};
+    assert(dp_vehicles_step(vehicles, VK, &input, &trajectory) == 0);
+
+    for (int i = 0; i < VN; i++) {
+        dp_vehicle_params_t params = {1.0 + i, 2, 5, 8, 9.81, 0.1 * i};
+        dp_vector_t pos = {init[0][i], init[1][i], init[2][i]};
+        dp_euler_t angle = {init[3][i], init[4][i], init[5][i]};
+        dp_velocity_t vel = {init[6][i], init[7][i], init[8][i]};
+        dp_angular_velocity_t ang_vel = {init[9][i], init[10][i], init[11][i]};
+        for (int k = 0; k < VK; k++) {
+            dp_torque_t torque = {tx[k][i], ty[k][i], tz[k][i]};
+            dp_acceleration_t acc = dp_acceleration_in_body_frame(&vel, &angle, &ang_vel,
+                thrust[k][i], params.mass, params.gravity, params.drag);
+            dp_angular_acceleration_t ang_acc = dp_angular_acceleration_in_body_frame(&ang_vel, &torque,
+                params.I_xx, params.I_yy, params.I_zz);
+            vel.x += acc.x * VDT; vel.y += acc.y * VDT; vel.z += acc.z * VDT;
+            ang_vel.x += ang_acc.x * VDT; ang_vel.y += ang_acc.y * VDT; ang_vel.z += ang_acc.z * VDT;
+            dp_velocity_t ground_vel = dp_ground_vector_from_body(&vel, &angle);
+            dp_euler_rate_t rate = dp_euler_rate_from_body_angular_velocity(&ang_vel, &angle);
+            angle.phi += rate.phi * VDT; angle.theta += rate.theta * VDT; angle.psi += rate.psi * VDT;
+            pos.x += ground_vel.x * VDT; pos.y += ground_vel.y * VDT; pos.z += ground_vel.z * VDT;
+
+            dp_vector_t b_pos = {traj[0][k][i], traj[1][k][i], traj[2][k][i]};
+            dp_vector_t b_angle = {traj[3][k][i], traj[4][k][i], traj[5][k][i]};
+            dp_vector_t e_angle = {angle.phi, angle.theta, angle.psi};
+            dp_vector_t b_vel = {traj[6][k][i], traj[7][k][i], traj[8][k][i]};
+            dp_vector_t b_ang_vel = {traj[9][k][i], traj[10][k][i], traj[11][k][i]};
+            assert_almost_equal(b_pos, pos);
+            assert_almost_equal(b_angle, e_angle);
+            assert_almost_equal(b_vel, vel);
+            assert_almost_equal(b_ang_vel, ang_vel);
+        }
+    }
+    dp_vehicles_destroy(vehicles);
+}
+
+/* interleaved actions[N][4] held for K steps, and the ground */
+static void test_vehicles_interleaved()
+{
+    dp_vehicles_t* a = dp_vehicles_create(VN, VDT);
+    dp_vehicles_t* b = dp_vehicles_create(VN, VDT);
+    double actions[VN][4] = {{20, 0.1, 0, 0}, {0, 0, 0, 0}, {9.81, 0, 0.2, -0.1}};
+    dp_vehicles_input_t input = {&actions[0][0], &actions[0][1], &actions[0][2], &actions[0][3], 4, 0};
+    double s[VN][12];
+    dp_vehicles_state_t last = {&s[0][0], &s[0][1], &s[0][2], &s[0][3], &s[0][4], &s[0][5],
+        &s[0][6], &s[0][7], &s[0][8], &s[0][9], &s[0][10], &s[0][11], 12, 0};
+    double s2[VN][12];
+    dp_vehicles_state_t last2 = {&s2[0][0], &s2[0][1], &s2[0][2], &s2[0][3], &s2[0][4], &s2[0][5],
+        &s2[0][6], &s2[0][7], &s2[0][8], &s2[0][9], &s2[0][10], &s2[0][11], 12, 0};
+
+    assert(dp_vehicles_step(a, VK, &input, &last) == 0);
+    for (int k = 0; k < VK; k++) {
+        assert(dp_vehicles_step(b, 1, &input, NULL) == 0);
+    }
+    assert(dp_vehicles_get_state(b, &last2) == 0);
+    for (int i = 0; i < VN; i++) {
+        for (int j = 0; j < 12; j += 3) {
+            dp_vector_t v1 = {s[i][j], s[i][j + 1], s[i][j + 2]};
+            dp_vector_t v2 = {s2[i][j], s2[i][j + 1], s2[i][j + 2]};
+            assert_almost_equal(v1, v2);
+        }
+    }
+    assert(s[0][2] < 0);    /* climbs */
+    assert(s[1][2] == 0);   /* stays on the ground */
+    assert(s[1][8] == 0);
+
+    dp_vehicle_params_t bad = {0, 1, 1, 1, 9.81, 0};
+    assert(dp_vehicles_set_params(a, 0, &bad) == -1);
+    assert(dp_vehicles_set_params(a, VN, &bad) == -1);
+    input.stride = 0;
+    assert(dp_vehicles_step(a, 1, &input, NULL) == -1);
+    assert(dp_vehicles_create(0, VDT) == NULL);
+    assert(dp_vehicles_create(1, 0) == NULL);
+    dp_vehicles_destroy(a);
+    dp_vehicles_destroy(b);
+}
+
 int main() {
     T(test_frame_all_unit_vectors_with_some_angles);
     T(test_frame_roundtrip);
     T(test_body_acceleration);
     T(test_body_angular_acceleration);
+    T(test_vehicles_step);
+    T(test_vehicles_interleaved);
     END_TEST();
     return 0;
 }
\ No newline at end of file
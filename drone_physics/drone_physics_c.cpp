@@ -1,6 +1,8 @@
 #include "drone_physics_c.h"
 #include "drone_physics.hpp"
 #include <cassert>
+#include <new>
+#include <vector>
 
 static hako::drone_physics::VectorType to_Vector(const dp_vector_t* v)
 {
@@ -19,11 +21,10 @@ static dp_vector_t to_dp_vector(const hako::drone_physics::VectorType& v)
     return dp_vector_t{v.x, v.y, v.z};
 }
 
-/* not used for now
 static dp_euler_t to_dp_euler(const hako::drone_physics::EulerType& e)
 {
     return dp_euler_t{e.phi, e.theta, e.psi};
-}*/
+}
 
 extern "C" {
 
@@ -58,6 +59,38 @@ dp_vector_t dp_body_vector_from_ground(
         );
 }
 
+dp_euler_rate_t dp_euler_rate_from_body_angular_velocity(
+    const dp_angular_velocity_t* angular_rate_body_frame, /* non-null */
+    const dp_euler_t* angle /* non-null */)
+{
+    assert(angular_rate_body_frame);
+    assert(angle);
+
+    return to_dp_euler(
+        hako::drone_physics::euler_rate_from_body_angular_velocity(
+            to_Vector(angular_rate_body_frame),
+            to_Euler(angle)
+            )
+        );
+}
+
+dp_angular_velocity_t dp_body_angular_velocity_from_euler_rate(
+    const dp_vector_t* angular_rate_ground_frame, /* non-null, (phi, theta, psi) rates as (x, y, z) */
+    const dp_euler_t* angle /* non-null */)
+{
+    assert(angular_rate_ground_frame);
+    assert(angle);
+
+    const hako::drone_physics::EulerRateType rate = {
+        angular_rate_ground_frame->x, angular_rate_ground_frame->y, angular_rate_ground_frame->z};
+    return to_dp_vector(
+        hako::drone_physics::body_angular_velocity_from_euler_rate(
+            rate,
+            to_Euler(angle)
+            )
+        );
+}
+
 dp_acceleration_t dp_acceleration_in_body_frame(
     const dp_vector_t* body_velocity,
     const dp_euler_t* angle,
@@ -97,5 +130,164 @@ dp_angular_acceleration_t dp_angular_acceleration_in_body_frame(
 }
 
 
+} // extern "C"
+
+/* state and parameters of N vehicles, one array per variable(SoA) */
+struct dp_vehicles {
+    int n;
+    double delta_t;
+    std::vector<double> x, y, z;
+    std::vector<double> phi, theta, psi;
+    std::vector<double> u, v, w;
+    std::vector<double> p, q, r;
+    std::vector<dp_vehicle_params_t> params;
+
+    dp_vehicles(int n_, double delta_t_) : n(n_), delta_t(delta_t_),
+        x(n_), y(n_), z(n_), phi(n_), theta(n_), psi(n_),
+        u(n_), v(n_), w(n_), p(n_), q(n_), r(n_),
+        params(n_, dp_vehicle_params_t{1, 1, 1, 1, 9.81, 0}) {}
+
+    /* the same integration as DroneDynamicsBodyFrame::run() in hakoniwa */
+    void step(int i, double thrust, const hako::drone_physics::TorqueType& torque)
+    {
+        using namespace hako::drone_physics;
+        const dp_vehicle_params_t& param = params[i];
+        const EulerType angle = {phi[i], theta[i], psi[i]};
+        VelocityType velocity = {u[i], v[i], w[i]};
+        AngularVelocityType angular_velocity = {p[i], q[i], r[i]};
+
+        AccelerationType acc = acceleration_in_body_frame(
+            velocity, angle, angular_velocity, thrust, param.mass, param.gravity, param.drag);
+        AngularAccelerationType angular_acc = angular_acceleration_in_body_frame(
+            angular_velocity, torque, param.I_xx, param.I_yy, param.I_zz);
+        velocity += acc * delta_t;
+        angular_velocity += angular_acc * delta_t;
+
+        VelocityType ground_velocity = ground_vector_from_body(velocity, angle);
+        EulerRateType rate = euler_rate_from_body_angular_velocity(angular_velocity, angle);
+        phi[i] += rate.phi * delta_t;
+        theta[i] += rate.theta * delta_t;
+        psi[i] += rate.psi * delta_t;
+        x[i] += ground_velocity.x * delta_t;
+        y[i] += ground_velocity.y * delta_t;
+        z[i] += ground_velocity.z * delta_t;
+
+        /* ground(z is down) */
+        if (z[i] > 0) {
+            z[i] = 0;
+            velocity = {0, 0, 0};
+            angular_velocity.z = 0;
+        }
+        u[i] = velocity.x; v[i] = velocity.y; w[i] = velocity.z;
+        p[i] = angular_velocity.x; q[i] = angular_velocity.y; r[i] = angular_velocity.z;
+    }
+    void copy_to(const dp_vehicles_state_t* s, size_t offset) const
+    {
+        for (int i = 0; i < n; i++) {
+            size_t j = offset + static_cast<size_t>(i) * s->stride;
+            s->x[j] = x[i]; s->y[j] = y[i]; s->z[j] = z[i];
+            s->phi[j] = phi[i]; s->theta[j] = theta[i]; s->psi[j] = psi[i];
+            s->u[j] = u[i]; s->v[j] = v[i]; s->w[j] = w[i];
+            s->p[j] = p[i]; s->q[j] = q[i]; s->r[j] = r[i];
+        }
+    }
+};
+
+static bool is_valid_state(const dp_vehicles_state_t* s)
+{
+    return s && s->x && s->y && s->z && s->phi && s->theta && s->psi
+        && s->u && s->v && s->w && s->p && s->q && s->r
+        && s->stride > 0 && s->step_stride >= 0;
+}
+
+static bool is_valid_input(const dp_vehicles_input_t* in)
+{
+    return in && in->thrust && in->torque_x && in->torque_y && in->torque_z
+        && in->stride > 0 && in->step_stride >= 0;
+}
+
+extern "C" {
+
+dp_vehicles_t* dp_vehicles_create(int n, double delta_t)
+{
+    if (n <= 0 || !(delta_t > 0)) {
+        return nullptr;
+    }
+    return new (std::nothrow) dp_vehicles(n, delta_t);
+}
+
+void dp_vehicles_destroy(dp_vehicles_t* vehicles)
+{
+    delete vehicles;
+}
+
+int dp_vehicles_num(const dp_vehicles_t* vehicles)
+{
+    assert(vehicles);
+    return vehicles->n;
+}
+
+int dp_vehicles_set_params(dp_vehicles_t* vehicles, int index, const dp_vehicle_params_t* params)
+{
+    assert(vehicles);
+    if (params == nullptr || index < 0 || index >= vehicles->n) {
+        return -1;
+    }
+    if (params->mass == 0 || params->I_xx == 0 || params->I_yy == 0 || params->I_zz == 0) {
+        return -1;
+    }
+    vehicles->params[index] = *params;
+    return 0;
+}
+
+int dp_vehicles_set_state(dp_vehicles_t* vehicles, const dp_vehicles_state_t* state)
+{
+    assert(vehicles);
+    if (!is_valid_state(state)) {
+        return -1;
+    }
+    for (int i = 0; i < vehicles->n; i++) {
+        size_t j = static_cast<size_t>(i) * state->stride;
+        vehicles->x[i] = state->x[j]; vehicles->y[i] = state->y[j]; vehicles->z[i] = state->z[j];
+        vehicles->phi[i] = state->phi[j]; vehicles->theta[i] = state->theta[j]; vehicles->psi[i] = state->psi[j];
+        vehicles->u[i] = state->u[j]; vehicles->v[i] = state->v[j]; vehicles->w[i] = state->w[j];
+        vehicles->p[i] = state->p[j]; vehicles->q[i] = state->q[j]; vehicles->r[i] = state->r[j];
+    }
+    return 0;
+}
+
+int dp_vehicles_get_state(const dp_vehicles_t* vehicles, const dp_vehicles_state_t* state)
+{
+    assert(vehicles);
+    if (!is_valid_state(state)) {
+        return -1;
+    }
+    vehicles->copy_to(state, 0);
+    return 0;
+}
+
+int dp_vehicles_step(dp_vehicles_t* vehicles, int k,
+    const dp_vehicles_input_t* input,
+    const dp_vehicles_state_t* trajectory)
+{
+    assert(vehicles);
+    if (k < 0 || !is_valid_input(input) || (trajectory && !is_valid_state(trajectory))) {
+        return -1;
+    }
+    for (int step = 0; step < k; step++) {
+        size_t offset = static_cast<size_t>(step) * input->step_stride;
+        for (int i = 0; i < vehicles->n; i++) {
+            size_t j = offset + static_cast<size_t>(i) * input->stride;
+            vehicles->step(i, input->thrust[j], {input->torque_x[j], input->torque_y[j], input->torque_z[j]});
+        }
+        if (trajectory && trajectory->step_stride > 0) {
+            vehicles->copy_to(trajectory, static_cast<size_t>(step) * trajectory->step_stride);
+        }
+    }
+    if (trajectory && trajectory->step_stride == 0) {
+        vehicles->copy_to(trajectory, 0);
+    }
+    return 0;
+}
 
 } // extern "C"
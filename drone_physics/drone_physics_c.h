@@ -64,6 +64,76 @@ dp_angular_acceleration_t dp_angular_acceleration_in_body_frame(
     double I_yy, /* in body frame, 0 is not allowed */
     double I_zz /* in body frame, 0 is not allowed */);
 
+/**
+ * Batch body dynamics of N vehicles.
+ *
+ * Unlike the functions above, this has a state(owned by an opaque dp_vehicles_t).
+ * One call of dp_vehicles_step() integrates N vehicles for K steps,
+ * so that foreign callers(Python, MATLAB, ...) pay the call overhead only once.
+ * The integration is the same as the body frame dynamics of hakoniwa(Euler method),
+ * with the ground at z = 0 (NED, z is down).
+ *
+ * Inputs and states are exchanged through caller-provided SoA buffers(one array per variable).
+ * The element of vehicle i at step k is at [k * step_stride + i * stride] (in doubles),
+ * so both planar arrays(stride = 1) and interleaved rows(e.g. actions[N][4], stride = 4)
+ * are used without copying.
+ */
+typedef struct dp_vehicles dp_vehicles_t;
+
+typedef struct {
+    double mass;    /* 0 is not allowed */
+    double I_xx;    /* in body frame, 0 is not allowed */
+    double I_yy;    /* in body frame, 0 is not allowed */
+    double I_zz;    /* in body frame, 0 is not allowed */
+    double gravity;
+    double drag;
+} dp_vehicle_params_t;
+
+typedef struct {
+    const double* thrust;   /* in body frame, -z direction */
+    const double* torque_x; /* in body frame */
+    const double* torque_y;
+    const double* torque_z;
+    int stride;       /* between vehicles(> 0) */
+    int step_stride;  /* between steps(0 to hold the same input for all the steps) */
+} dp_vehicles_input_t;
+
+typedef struct {
+    double* x;     /* position in ground frame */
+    double* y;
+    double* z;
+    double* phi;   /* euler angles */
+    double* theta;
+    double* psi;
+    double* u;     /* velocity in body frame */
+    double* v;
+    double* w;
+    double* p;     /* angular velocity in body frame */
+    double* q;
+    double* r;
+    int stride;       /* between vehicles(> 0) */
+    int step_stride;  /* between steps(trajectory only, 0 to keep the last state only) */
+} dp_vehicles_state_t;
+
+/* all the vehicles start at rest at the origin, with mass = 1, I = 1, gravity = 9.81, drag = 0 */
+dp_vehicles_t* dp_vehicles_create(int n, double delta_t /* > 0 */); /* NULL on error */
+void dp_vehicles_destroy(dp_vehicles_t* vehicles);
+int dp_vehicles_num(const dp_vehicles_t* vehicles);
+
+/* return 0 on success, -1 on invalid arguments */
+int dp_vehicles_set_params(dp_vehicles_t* vehicles, int index, const dp_vehicle_params_t* params);
+int dp_vehicles_set_state(dp_vehicles_t* vehicles, const dp_vehicles_state_t* state); /* all N vehicles */
+int dp_vehicles_get_state(const dp_vehicles_t* vehicles, const dp_vehicles_state_t* state);
+
+/*
+ * Step all the vehicles for k steps.
+ * trajectory(nullable) receives the state after every step(step_stride > 0),
+ * or the state after the last step(step_stride = 0).
+ */
+int dp_vehicles_step(dp_vehicles_t* vehicles, int k,
+    const dp_vehicles_input_t* input,
+    const dp_vehicles_state_t* trajectory);
+
 #if defined(__cplusplus)
 }
 #endif
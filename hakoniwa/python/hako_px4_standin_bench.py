@@ -0,0 +1,169 @@
+"""
+hako_px4_standin_bench.py
+
+概要:
+PX4 を使わずに、1台の Linux マシンで hako-px4sim (sim モード, lockstep) が何機の PX4 を
+処理できるかを計測します。機体数 N ごとに以下を行います。
+
+- 基準の drone_config と custom.json から N 機分の設定を一時ディレクトリに生成
+- hako-px4sim を sim モードで起動し、hako-px4-standin (PX4 の代わり) を N 機分接続
+- hako-cmd start でシミュレーションを開始し、指定時間計測して停止
+
+結果として、ステップ数/秒、HIL_ACTUATOR_CONTROLS -> HIL_SENSOR の往復時間の p50/p99、
+hako-px4sim と hako-px4-standin の CPU 使用率を表示し、JSON Lines で保存します。
+
+使用方法:
+python hako_px4_standin_bench.py [--vehicles 1,2,4,8] [--duration 10] [--output result.jsonl]
+
+前提:
+- hakoniwa/cmake-build に hako-px4sim と hako-px4-standin がビルドされていること
+- 箱庭コア(hako-cmd)がインストールされていること
+- hakoniwa ディレクトリで実行すること
+
+例:
+python python/hako_px4_standin_bench.py --vehicles 1,4,16 --duration 20 --output standin.jsonl
+"""
+import argparse
+import copy
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+CLK_TCK = os.sysconf('SC_CLK_TCK')
+
+
+def cpu_sec(pid):
+    """utime + stime [sec] of the process"""
+    try:
+        with open(f'/proc/{pid}/stat') as f:
+            fields = f.read().rsplit(')', 1)[1].split()
+        return (int(fields[11]) + int(fields[12])) / CLK_TCK
+    except (OSError, IndexError, ValueError):
+        return 0.0
+
+
+def make_configs(args, num, workdir):
+    with open(args.drone_config) as f:
+        base = json.load(f)
+    with open(args.custom_json) as f:
+        custom = json.load(f)
+    template = next((r for r in custom['robots'] if r['name'] == base['name']), None)
+    if template is None:
+        raise RuntimeError(f"robot {base['name']} is not found in {args.custom_json}")
+    robots = []
+    for i in range(num):
+        name = f"{base['name']}{i}"
+        config = copy.deepcopy(base)
+        config['name'] = name
+        config['simulation']['lockstep'] = True
+        config['simulation']['logOutputDirectory'] = workdir
+        for group in config['simulation'].get('logOutput', {}).values():
+            for key in group:
+                group[key] = False
+        with open(os.path.join(workdir, f'drone_config_{i}.json'), 'w') as f:
+            json.dump(config, f, indent=4)
+        robot = json.loads(json.dumps(template).replace(base['name'], name))
+        robots.append(robot)
+    custom['robots'] = [r for r in custom['robots'] if r['name'] != base['name']] + robots
+    with open(os.path.join(workdir, 'custom.json'), 'w') as f:
+        json.dump(custom, f, indent=4)
+
+
+def run_one(args, num):
+    """
+    Returns the stand-in result, or None when the run failed.
+    The work directory is removed on success and kept (with px4sim.log) on failure.
+    """
+    workdir = tempfile.mkdtemp(prefix='hako_standin_')
+    log_path = os.path.join(workdir, 'px4sim.log')
+    result = None
+    try:
+        make_configs(args, num, workdir)
+        env = dict(os.environ)
+        env['DRONE_CONFIG_PATH'] = workdir
+        env['HAKO_CUSTOM_JSON_PATH'] = os.path.join(workdir, 'custom.json')
+        env['HAKO_COMM_TRANSPORT'] = 'tcp'
+        result_path = os.path.join(workdir, 'standin.json')
+        log = open(log_path, 'w')
+        sim = subprocess.Popen([args.px4sim, args.host, str(args.port), 'sim'],
+                               env=env, stdout=log, stderr=subprocess.STDOUT)
+        standin = None
+        try:
+            time.sleep(args.startup_wait)
+            standin = subprocess.Popen([args.standin, '-n', str(num), '--host', args.host,
+                                        '--port', str(args.port), '--rate', str(args.rate),
+                                        '--duration', str(args.duration), '--json', result_path])
+            time.sleep(args.startup_wait)
+            subprocess.run([args.hako_cmd, 'start'], check=False)
+            sim_cpu_start = cpu_sec(sim.pid)
+            start = time.monotonic()
+            try:
+                standin.wait(timeout=args.duration + 120)
+            except subprocess.TimeoutExpired:
+                print(f'ERROR: vehicles={num}: hako-px4-standin timed out', file=sys.stderr)
+                standin.kill()
+                standin.wait()
+            sim_cpu = cpu_sec(sim.pid) - sim_cpu_start
+            elapsed = time.monotonic() - start
+            subprocess.run([args.hako_cmd, 'stop'], check=False)
+            if standin.returncode != 0 or not os.path.exists(result_path):
+                print(f'ERROR: vehicles={num}: hako-px4-standin failed (see {log_path})', file=sys.stderr)
+                with open(log_path) as f:
+                    sys.stderr.write(f.read()[-4000:])
+                return None
+            with open(result_path) as f:
+                result = json.load(f)
+            result['px4sim_cpu_percent'] = 100.0 * sim_cpu / elapsed
+            return result
+        finally:
+            for proc in (standin, sim):
+                if proc is not None and proc.poll() is None:
+                    proc.kill()
+                    proc.wait()
+            log.close()
+    finally:
+        if result is not None:
+            shutil.rmtree(workdir, ignore_errors=True)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Measure hako-px4sim throughput with synthetic PX4 stand-ins.')
+    parser.add_argument('--vehicles', default='1,2,4,8', help='comma separated vehicle counts')
+    parser.add_argument('--duration', type=float, default=10.0, help='measurement time per run [sec]')
+    parser.add_argument('--rate', type=float, default=0.0, help='actuator rate [Hz] (0: reply to every HIL_SENSOR)')
+    parser.add_argument('--host', default='127.0.0.1')
+    parser.add_argument('--port', type=int, default=4560)
+    parser.add_argument('--drone-config', default='config/rc/drone_config_0.json')
+    parser.add_argument('--custom-json', default='config/custom.json')
+    parser.add_argument('--px4sim', default='cmake-build/src/hako-px4sim')
+    parser.add_argument('--standin', default='cmake-build/src/hako-px4-standin')
+    parser.add_argument('--hako-cmd', default='hako-cmd')
+    parser.add_argument('--startup-wait', type=float, default=2.0, help='wait after starting each process [sec]')
+    parser.add_argument('--output', help='append results as JSON Lines')
+    args = parser.parse_args()
+
+    print(f"{'vehicles':>8} {'steps/s':>10} {'min':>10} {'p50[us]':>10} {'p99[us]':>10} {'sim cpu%':>9} {'standin cpu%':>13}")
+    failed = []
+    for num in [int(v) for v in args.vehicles.split(',')]:
+        result = run_one(args, num)
+        if result is None:
+            print(f"{num:>8} {'FAILED':>10}")
+            failed.append(num)
+            continue
+        print(f"{num:>8} {result['steps_per_sec_mean']:>10.1f} {result['steps_per_sec_min']:>10.1f} "
+              f"{result['rtt_usec']['p50']:>10.1f} {result['rtt_usec']['p99']:>10.1f} "
+              f"{result['px4sim_cpu_percent']:>9.1f} {result['standin_cpu_percent']:>13.1f}")
+        if args.output:
+            with open(args.output, 'a') as f:
+                f.write(json.dumps(result) + '\n')
+    if failed:
+        print(f"ERROR: failed vehicle counts: {','.join(str(n) for n in failed)}", file=sys.stderr)
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
@@ -18,6 +18,10 @@
 #include "assets/drone/utils/sensor_noise.hpp"
 #include "config/drone_config.hpp"
 #include <math.h>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
 #include "utils/hako_module_loader.hpp"
 #include "hako_module_drone_sensor_gyro.h"
 
@@ -53,8 +57,62 @@ using hako::assets::drone::SensorNoise;
 
 #define LOGPATH(index, name)        drone_config.getSimLogFullPathFromIndex(index, name)
 
+/* センサノイズの乱数系列は、機体とセンサの組ごとに変える */
+enum {
+    NOISE_SEQUENCE_ACC = 0,
+    NOISE_SEQUENCE_GYRO,
+    NOISE_SEQUENCE_MAG,
+    NOISE_SEQUENCE_BARO,
+    NOISE_SEQUENCE_GPS,
+};
+
+/*
+ * 機体生成は並列に行われるので、標準出力へは1行ずつ機体番号を付けて出す
+ * (行の途中で他の機体の出力が混ざらないようにする)
+ */
+class AircraftLogBuf : public std::streambuf {
+private:
+    int index;
+    std::string line;
+    static std::mutex& output_mutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+    void flush_line()
+    {
+        std::lock_guard<std::mutex> lock(output_mutex());
+        std::cout << "[vehicle " << index << "] " << line << std::endl;
+        line.clear();
+    }
+protected:
+    int overflow(int ch) override
+    {
+        if (ch == traits_type::eof()) {
+            return traits_type::not_eof(ch);
+        }
+        if (ch == '\n') {
+            flush_line();
+        }
+        else {
+            line.push_back(static_cast<char>(ch));
+        }
+        return ch;
+    }
+public:
+    AircraftLogBuf(int index) : index(index) {}
+    ~AircraftLogBuf() override
+    {
+        if (!line.empty()) {
+            flush_line();
+        }
+    }
+};
+
 IAirCraft* hako::assets::drone::create_aircraft(int index, const DroneConfig& drone_config)
 {
+    AircraftLogBuf console_buf(index);
+    std::ostream console(&console_buf);
 
     auto drone = new AirCraft();
     HAKO_ASSERT(drone != nullptr);
@@ -64,25 +122,25 @@ IAirCraft* hako::assets::drone::create_aircraft(int index, const DroneConfig& dr
     //drone dynamics
     IDroneDynamics *drone_dynamics = nullptr;
     if (drone_config.getCompDroneDynamicsPhysicsEquation() == "BodyFrame") {
-        std::cout << "DroneDynamicType: BodyFrame" << std::endl;
+        console << "DroneDynamicType: BodyFrame" << std::endl;
         drone_dynamics = new DroneDynamicsBodyFrame(DELTA_TIME_SEC);
     }
     else if (drone_config.getCompDroneDynamicsPhysicsEquation() == "BodyFrameMatlab") {
-        std::cout << "DroneDynamicType: BodyFrameMatlab" << std::endl;
+        console << "DroneDynamicType: BodyFrameMatlab" << std::endl;
         drone_dynamics = new DroneDynamicsBodyFrameMatlab(DELTA_TIME_SEC);
     }
     else if (drone_config.getCompDroneDynamicsPhysicsEquation() == "BodyFrameRK4") {
-        std::cout << "DroneDynamicType: BodyFrameRK4" << std::endl;
+        console << "DroneDynamicType: BodyFrameRK4" << std::endl;
         drone_dynamics = new DroneDynamicsBodyFrameRK4(DELTA_TIME_SEC);
     }
     else {
-        std::cout << "DroneDynamicType: GroundFrame" << std::endl;
+        console << "DroneDynamicType: GroundFrame" << std::endl;
         drone_dynamics = new DroneDynamicsGroundFrame(DELTA_TIME_SEC);
     }
     //auto drone_dynamics = new DroneDynamicsGroundFrame(DELTA_TIME_SEC);
     HAKO_ASSERT(drone_dynamics != nullptr);
     drone_dynamics->set_use_quaternion(drone_config.getCompDroneDynamicsUseQuaternion());
-    std::cout << "INFO: use_quaternion: " << drone_config.getCompDroneDynamicsUseQuaternion() << std::endl;
+    console << "INFO: use_quaternion: " << drone_config.getCompDroneDynamicsUseQuaternion() << std::endl;
     auto drags = drone_config.getCompDroneDynamicsAirFrictionCoefficient();
     drone_dynamics->set_drag(drags[0], drags[1]);
     drone_dynamics->set_mass(drone_config.getCompDroneDynamicsMass());
@@ -107,7 +165,7 @@ IAirCraft* hako::assets::drone::create_aircraft(int index, const DroneConfig& dr
     auto out_of_bounds_reset = drone_config.getCompDroneDynamicsOutOfBoundsReset();
     drone_dynamics->set_out_of_bounds_reset(out_of_bounds_reset);
     drone->set_drone_dynamics(drone_dynamics);
-    std::cout << "INFO: logpath: " << LOGPATH(drone->get_index(), "drone_dynamics.csv") << std::endl;
+    console << "INFO: logpath: " << LOGPATH(drone->get_index(), "drone_dynamics.csv") << std::endl;
     drone->get_logger().add_entry(*drone_dynamics, LOGPATH(drone->get_index(), "drone_dynamics.csv"));
 
 
@@ -122,15 +180,23 @@ IAirCraft* hako::assets::drone::create_aircraft(int index, const DroneConfig& dr
         drone->get_logger().add_entry(*static_cast<BatteryDynamics*>(battery), LOGPATH(drone->get_index(), "log_battery.csv"));
     }
     else {
-        std::cout << "INFO: battery is not enabled." << std::endl;
+        console << "INFO: battery is not enabled." << std::endl;
     }
+    // rotor num: 機体形状(ロータ位置の数)で決まる
+    std::vector<RotorPosition> pos = drone_config.getCompThrusterRotorPositions();
+    const int rotor_num = static_cast<int>(pos.size());
+    if ((rotor_num < ROTOR_NUM) || (rotor_num > ROTOR_NUM_MAX)) {
+        std::cerr << "ERROR: [vehicle " << index << "] unsupported rotor num: " << rotor_num << " (" << ROTOR_NUM << " - " << ROTOR_NUM_MAX << ")" << std::endl;
+    }
+    HAKO_ASSERT((rotor_num >= ROTOR_NUM) && (rotor_num <= ROTOR_NUM_MAX));
+    console << "INFO: rotor num: " << rotor_num << std::endl;
     // calculate hovering rpm and maxrpm
-    double HoveringRadPerSec = sqrt(drone_dynamics->get_mass() * GRAVITY / (drone_config.getCompThrusterParameter("Ct") * ROTOR_NUM));
+    double HoveringRadPerSec = sqrt(drone_dynamics->get_mass() * GRAVITY / (drone_config.getCompThrusterParameter("Ct") * rotor_num));
     double RadPerSecMax = HoveringRadPerSec * 2.0;
     double HoveringRpm = HoveringRadPerSec * 60.0 / (2 * M_PI);
     HAKO_ASSERT(HoveringRpm != 0);
-    std::cout << "HoveringRadPerSec: " << HoveringRadPerSec << std::endl;
-    std::cout << "HoveringRpm: " << HoveringRpm << std::endl;
+    console << "HoveringRadPerSec: " << HoveringRadPerSec << std::endl;
+    console << "HoveringRpm: " << HoveringRpm << std::endl;
     //Tr=J*Rm/(Dm*Rm+K*K+2*Rm*Cq*ω_0)
     auto rotor_constants = drone_config.getCompDroneDynamicsRotorDynamicsConstants();
     double RotorTau = (
@@ -141,12 +207,12 @@ IAirCraft* hako::assets::drone::create_aircraft(int index, const DroneConfig& dr
                           + (2 * rotor_constants.R * rotor_constants.Cq * HoveringRadPerSec)
                         )
                     );
-    std::cout << "RotorTau: " << RotorTau << std::endl;
+    console << "RotorTau: " << RotorTau << std::endl;
     //rotor dynamics
-    IRotorDynamics* rotors[hako::assets::drone::ROTOR_NUM];
+    IRotorDynamics* rotors[hako::assets::drone::ROTOR_NUM_MAX];
     auto rotor_vendor = drone_config.getCompRotorVendor();
-    std::cout<< "Rotor vendor: " << rotor_vendor << std::endl;
-    for (int i = 0; i < hako::assets::drone::ROTOR_NUM; i++) {
+    console << "Rotor vendor: " << rotor_vendor << std::endl;
+    for (int i = 0; i < rotor_num; i++) {
         IRotorDynamics *rotor = nullptr;
         std::string logfilename= "log_rotor_" + std::to_string(i) + ".csv";
         if (rotor_vendor == "jmavsim") {
@@ -172,17 +238,17 @@ IAirCraft* hako::assets::drone::create_aircraft(int index, const DroneConfig& dr
         }
         rotors[i] = rotor;
     }
-    drone->set_rotor_dynamics(rotors);
+    drone->set_rotor_dynamics(rotors, rotor_num);
 
 
     //thrust dynamics
     IThrustDynamics *thrust = nullptr;
     auto thrust_vendor = drone_config.getCompThrusterVendor();
-    std::cout<< "Thruster vendor: " << thrust_vendor << std::endl;
+    console << "Thruster vendor: " << thrust_vendor << std::endl;
     double param_Ct = THRUST_PARAM_Ct;
     double param_Cq = rotor_constants.Cq;
-    std::cout << "param_Ct: " << param_Ct << std::endl;
-    std::cout << "param_Cq: " << param_Cq << std::endl;
+    console << "param_Ct: " << param_Ct << std::endl;
+    console << "param_Cq: " << param_Cq << std::endl;
     if (thrust_vendor == "linear") {
         thrust = new ThrustDynamicsLinear(DELTA_TIME_SEC);
         HAKO_ASSERT(thrust != nullptr);
@@ -195,15 +261,13 @@ IAirCraft* hako::assets::drone::create_aircraft(int index, const DroneConfig& dr
     else {
         thrust = new ThrustDynamicsNonLinear(DELTA_TIME_SEC);
         HAKO_ASSERT(thrust != nullptr);
-        std::cout << "param_J: " << rotor_constants.J << std::endl;
+        console << "param_J: " << rotor_constants.J << std::endl;
         static_cast<ThrustDynamicsNonLinear*>(thrust)->set_params(param_Ct, param_Cq, rotor_constants.J);
         drone->get_logger().add_entry(*static_cast<ThrustDynamicsNonLinear*>(thrust), LOGPATH(drone->get_index(), "log_thrust.csv"));
     }
     drone->set_thrus_dynamics(thrust);
 
-    RotorConfigType rotor_config[ROTOR_NUM];
-    std::vector<RotorPosition> pos = drone_config.getCompThrusterRotorPositions();
-    HAKO_ASSERT(pos.size() == ROTOR_NUM);
+    RotorConfigType rotor_config[ROTOR_NUM_MAX];
     for (size_t i = 0; i < pos.size(); ++i) {
         rotor_config[i].ccw = pos[i].rotationDirection;
         rotor_config[i].data.x = pos[i].position[0];
@@ -211,13 +275,13 @@ IAirCraft* hako::assets::drone::create_aircraft(int index, const DroneConfig& dr
         rotor_config[i].data.z = pos[i].position[2];
     }    
 
-    thrust->set_rotor_config(rotor_config);
+    thrust->set_rotor_config(rotor_config, rotor_num);
 
     // mixer
     DroneConfig::MixerInfo mixer_info;
     if (drone_config.getControllerMixerInfo(mixer_info)) {
-        std::cout << "INFO: mixer is enabled" << std::endl;
-        DroneMixer *mixer = new DroneMixer(RadPerSecMax, param_Ct, param_Cq, rotor_config);
+        console << "INFO: mixer is enabled" << std::endl;
+        DroneMixer *mixer = new DroneMixer(RadPerSecMax, param_Ct, param_Cq, rotor_config, rotor_num);
         HAKO_ASSERT(mixer != nullptr);
         bool inv_m = mixer->calculate_M_inv();
         HAKO_ASSERT(inv_m == true);
@@ -229,7 +293,7 @@ IAirCraft* hako::assets::drone::create_aircraft(int index, const DroneConfig& dr
         drone->set_mixer(mixer);
     }
     else {
-        std::cout << "INFO: mixer is not enabled" << std::endl;
+        console << "INFO: mixer is not enabled" << std::endl;
     }
     // rotor control
     if (drone_config.getControllerDirectRotorControl()) {
@@ -241,9 +305,10 @@ IAirCraft* hako::assets::drone::create_aircraft(int index, const DroneConfig& dr
     HAKO_ASSERT(acc != nullptr);
     double variance = drone_config.getCompSensorNoise("acc");
     if (variance > 0) {
-        auto noise = new SensorNoise(variance);
+        auto noise = new SensorNoise(variance, index, NOISE_SEQUENCE_ACC);
         HAKO_ASSERT(noise != nullptr);
         acc->set_noise(noise);
+        drone->attach(std::shared_ptr<void>(noise));
     }
     drone->set_acc(acc);
     drone->get_logger().add_entry(*acc, LOGPATH(drone->get_index(), "log_acc.csv"));
@@ -253,13 +318,17 @@ IAirCraft* hako::assets::drone::create_aircraft(int index, const DroneConfig& dr
     HAKO_ASSERT(gyro != nullptr);
     variance = drone_config.getCompSensorNoise("gyro");
     if (variance > 0) {
-        auto noise = new SensorNoise(variance);
+        auto noise = new SensorNoise(variance, index, NOISE_SEQUENCE_GYRO);
         HAKO_ASSERT(noise != nullptr);
         gyro->set_noise(noise);
+        drone->attach(std::shared_ptr<void>(noise));
     }
     auto module_path = drone_config.getCompSensorVendor("gyro");
     if (!module_path.empty()) {
-        std::cout << "INFO: now loading gyro vendor model " << module_path << std::endl;
+        /* 機体生成は並列に行われるが、vendor モジュールの init はスレッドセーフとは限らない */
+        static std::mutex vendor_mutex;
+        std::lock_guard<std::mutex> lock(vendor_mutex);
+        console << "INFO: now loading gyro vendor model " << module_path << std::endl;
         void *handle;
         HakoModuleHeaderType *header = nullptr;
         HakoModuleDroneSensorGyroType *gyro_model = nullptr;
@@ -268,9 +337,9 @@ IAirCraft* hako::assets::drone::create_aircraft(int index, const DroneConfig& dr
         gyro_model = (HakoModuleDroneSensorGyroType*)hako_module_load_symbol(handle, HAKO_MODULE_DRONE_SENSOR_GYRO_SYMBOLE_NAME);
         HAKO_ASSERT(gyro_model != nullptr);
         //std::cout << "gyro_model addr: " << gyro_model << std::endl;
-        std::cout << "SUCCESS: Loaded module name: " << header->get_name() << std::endl;
+        console << "SUCCESS: Loaded module name: " << header->get_name() << std::endl;
         std::string filepath = drone_config.getCompSensorContext("gyro", "file");
-        std::cout << "filepath:" << filepath <<std::endl;
+        console << "filepath:" << filepath <<std::endl;
         mi_drone_sensor_gyro_context_t* context = new mi_drone_sensor_gyro_context_t();
         HAKO_ASSERT(context != nullptr);
         if (filepath.empty()) {
@@ -279,8 +348,10 @@ IAirCraft* hako::assets::drone::create_aircraft(int index, const DroneConfig& dr
         else {
             context->filepath = new char[filepath.size() + 1];
             std::strcpy(context->filepath, filepath.c_str());
+            drone->attach(std::shared_ptr<void>(context->filepath, std::default_delete<char[]>()));
         }
-        std::cout << "gyro_model: index = " << index << std::endl;
+        drone->attach(std::shared_ptr<void>(context));
+        console << "gyro_model: index = " << index << std::endl;
         context->index = index;
         auto v = gyro_model->init(context);
         HAKO_ASSERT(v == 0);
@@ -294,9 +365,10 @@ IAirCraft* hako::assets::drone::create_aircraft(int index, const DroneConfig& dr
     HAKO_ASSERT(mag != nullptr);
     variance = drone_config.getCompSensorNoise("mag");
     if (variance > 0) {
-        auto noise = new SensorNoise(variance);
+        auto noise = new SensorNoise(variance, index, NOISE_SEQUENCE_MAG);
         HAKO_ASSERT(noise != nullptr);
         mag->set_noise(noise);
+        drone->attach(std::shared_ptr<void>(noise));
     }
     mag->set_params(PARAMS_MAG_F, PARAMS_MAG_I, PARAMS_MAG_D);
     drone->set_mag(mag);
@@ -308,9 +380,10 @@ IAirCraft* hako::assets::drone::create_aircraft(int index, const DroneConfig& dr
     baro->init_pos(REFERENCE_LATITUDE, REFERENCE_LONGTITUDE, REFERENCE_ALTITUDE);
     variance = drone_config.getCompSensorNoise("baro");
     if (variance > 0) {
-        auto noise = new SensorNoise(variance);
+        auto noise = new SensorNoise(variance, index, NOISE_SEQUENCE_BARO);
         HAKO_ASSERT(noise != nullptr);
         baro->set_noise(noise);
+        drone->attach(std::shared_ptr<void>(noise));
     }
     drone->set_baro(baro);
     drone->get_logger().add_entry(*baro, LOGPATH(drone->get_index(), "log_baro.csv"));
@@ -320,9 +393,10 @@ IAirCraft* hako::assets::drone::create_aircraft(int index, const DroneConfig& dr
     HAKO_ASSERT(gps != nullptr);
     variance = drone_config.getCompSensorNoise("gps");
     if (variance > 0) {
-        auto noise = new SensorNoise(variance);
+        auto noise = new SensorNoise(variance, index, NOISE_SEQUENCE_GPS);
         HAKO_ASSERT(noise != nullptr);
         gps->set_noise(noise);
+        drone->attach(std::shared_ptr<void>(noise));
     }
     gps->init_pos(REFERENCE_LATITUDE, REFERENCE_LONGTITUDE, REFERENCE_ALTITUDE);
     drone->set_gps(gps);
@@ -11,6 +11,7 @@
 #include "irotor_dynamics.hpp"
 #include "ithrust_dynamics.hpp"
 #include "config/drone_config.hpp"
+#include "utils/hako_parallel.hpp"
 
 namespace hako::assets::drone {
 
@@ -30,16 +31,20 @@ public:
      */
     void createAirCrafts(DroneConfigManager& configManager) {
         size_t configCount = configManager.getConfigCount();
+        std::vector<std::unique_ptr<IAirCraft>> created(configCount);
+        /* 機体ごとの生成(ログファイルのオープンなど)は独立しているので並列に行う */
+        hako_parallel_for(configCount, [&](size_t i) {
+            const DroneConfig* config = configManager.getConfigRef(i);
+            if (config != nullptr) {
+                created[i].reset(hako::assets::drone::create_aircraft(i, *config));
+            }
+        });
         for (size_t i = 0; i < configCount; ++i) {
-            DroneConfig config;
-            if (configManager.getConfig(i, config)) {
-                std::unique_ptr<IAirCraft> airCraft(hako::assets::drone::create_aircraft(i, config));
-                if (airCraft) {
-                    airCrafts.push_back(std::move(airCraft));
-                }
-                else {
-                    std::cerr << "ERROR: can not create airCraft: " << i << std::endl;
-                }
+            if (created[i]) {
+                airCrafts.push_back(std::move(created[i]));
+            }
+            else {
+                std::cerr << "ERROR: can not create airCraft: " << i << std::endl;
             }
         }
     }
@@ -52,10 +57,13 @@ public:
             std::cerr << "ERROR: can not create get config: 0" << std::endl;
             return false;
         }
+        std::vector<std::unique_ptr<IAirCraft>> created(create_num);
+        hako_parallel_for(create_num, [&](size_t i) {
+            created[i].reset(hako::assets::drone::create_aircraft(i, config));
+        });
         for (int i = 0; i < create_num; ++i) {
-            std::unique_ptr<IAirCraft> airCraft(hako::assets::drone::create_aircraft(i, config));
-            if (airCraft) {
-                airCrafts.push_back(std::move(airCraft));
+            if (created[i]) {
+                airCrafts.push_back(std::move(created[i]));
             }
             else {
                 std::cerr << "ERROR: can not create airCraft: " << i << std::endl;
@@ -3,6 +3,9 @@
 
 #include "iaircraft.hpp"
 #include "utils/csv_logger.hpp"
+#include "utils/hako_profiler.hpp"
+#include <memory>
+#include <vector>
 
 namespace hako::assets::drone {
 
@@ -10,10 +13,61 @@ class AirCraft : public hako::assets::drone::IAirCraft {
 private:
     CsvLogger logger;
     DroneMixer *mixer = nullptr;
+    HakoStateRegions state_regions;
+    bool state_regions_ready = false;
+    /*
+     * 部品が参照するだけで所有しないもの(センサのノイズ等)
+     */
+    std::vector<std::shared_ptr<void>> attachments;
+    /*
+     * 状態の領域は、構築が終わった後の最初の呼び出しで1回だけ集める
+     */
+    const HakoStateRegions& get_state_regions()
+    {
+        if (!state_regions_ready) {
+            drone_dynamics->add_state_regions(state_regions);
+            if (this->battery_dynamics != nullptr) {
+                battery_dynamics->add_state_regions(state_regions);
+            }
+            for (int i = 0; i < rotor_num; i++) {
+                rotor_dynamics[i]->add_state_regions(state_regions);
+            }
+            thrust_dynamis->add_state_regions(state_regions);
+            acc->add_state_regions(state_regions);
+            gyro->add_state_regions(state_regions);
+            gps->add_state_regions(state_regions);
+            mag->add_state_regions(state_regions);
+            baro->add_state_regions(state_regions);
+            state_regions_ready = true;
+        }
+        return state_regions;
+    }
 public:
+    /*
+     * set_xxx() で渡した部品は機体が所有し、ここで解放する
+     */
     virtual ~AirCraft() 
     {
         logger.close();
+        delete mixer;
+        delete acc;
+        delete baro;
+        delete gps;
+        delete gyro;
+        delete mag;
+        delete thrust_dynamis;
+        for (int i = 0; i < rotor_num; i++) {
+            delete rotor_dynamics[i];
+        }
+        delete battery_dynamics;
+        delete drone_dynamics;
+    }
+    /*
+     * 機体と同じ期間だけ生かしておき、機体と一緒に解放する
+     */
+    void attach(std::shared_ptr<void> obj)
+    {
+        attachments.push_back(std::move(obj));
     }
     void set_mixer(DroneMixer *obj)
     {
@@ -29,16 +83,30 @@ public:
         if (this->battery_dynamics != nullptr) {
             battery_dynamics->reset();
         }
-        for (int i = 0; i < ROTOR_NUM; i++) {
+        for (int i = 0; i < rotor_num; i++) {
             rotor_dynamics[i]->reset();
         }
         thrust_dynamis->reset();
         logger.reset();
     }
+    size_t get_state_size() override
+    {
+        return get_state_regions().size();
+    }
+    void save_state(void *buf) override
+    {
+        get_state_regions().save(buf);
+    }
+    void restore_state(const void *buf) override
+    {
+        get_state_regions().restore(buf);
+    }
     void run(DroneDynamicsInputType& input) override
     {
+        HAKO_PROF_SCOPE(HAKO_PROF_AIRCRAFT, index);
         double vbat = 0.0;
         if (this->battery_dynamics != nullptr) {
+            HAKO_PROF_SCOPE(HAKO_PROF_BATTERY, index);
             BatteryModelFactor factor = { input.disturbance.values.d_temp.value }; //温度
             this->battery_dynamics->set_current_factor(factor);
             this->battery_dynamics->run();
@@ -46,32 +114,55 @@ public:
         }
         //actuators
         if (input.no_use_actuator == false) {
-            DroneRotorSpeedType rotor_speed[ROTOR_NUM];
-            for (int i = 0; i < ROTOR_NUM; i++) {
-                if (rotor_dynamics[i]->has_battery_dynamics()) {
-                    rotor_dynamics[i]->run(input.controls[i], vbat);
+            DroneRotorSpeedType rotor_speed[ROTOR_NUM_MAX];
+            {
+                HAKO_PROF_SCOPE(HAKO_PROF_ROTOR, index);
+                for (int i = 0; i < rotor_num; i++) {
+                    if (rotor_dynamics[i]->has_battery_dynamics()) {
+                        rotor_dynamics[i]->run(input.controls[i], vbat);
+                    }
+                    else {
+                        rotor_dynamics[i]->run(input.controls[i]);
+                    }
+                    rotor_speed[i] = rotor_dynamics[i]->get_rotor_speed();
                 }
-                else {
-                    rotor_dynamics[i]->run(input.controls[i]);
-                }
-                rotor_speed[i] = rotor_dynamics[i]->get_rotor_speed();
             }
+            HAKO_PROF_SCOPE(HAKO_PROF_THRUST, index);
             thrust_dynamis->run(rotor_speed);
             input.thrust = thrust_dynamis->get_thrust();
             input.torque = thrust_dynamis->get_torque();
         }
-        drone_dynamics->run(input);
-        if (input.manual.control) {
-            drone_dynamics->set_angle(input.manual.angle);
+        {
+            HAKO_PROF_SCOPE(HAKO_PROF_DYNAMICS, index);
+            drone_dynamics->run(input);
+            if (input.manual.control) {
+                drone_dynamics->set_angle(input.manual.angle);
+            }
         }
 
         //sensors
-        acc->run(drone_dynamics->get_vel_body_frame());
-        gyro->run(drone_dynamics->get_angular_vel_body_frame(), input.disturbance);
-        gps->run(drone_dynamics->get_pos(), drone_dynamics->get_vel());
-        mag->run(drone_dynamics->get_angle());
-        baro->run(drone_dynamics->get_pos());
+        {
+            HAKO_PROF_SCOPE(HAKO_PROF_SENSOR_ACC, index);
+            acc->run(drone_dynamics->get_vel_body_frame());
+        }
+        {
+            HAKO_PROF_SCOPE(HAKO_PROF_SENSOR_GYRO, index);
+            gyro->run(drone_dynamics->get_angular_vel_body_frame(), input.disturbance);
+        }
+        {
+            HAKO_PROF_SCOPE(HAKO_PROF_SENSOR_GPS, index);
+            gps->run(drone_dynamics->get_pos(), drone_dynamics->get_vel());
+        }
+        {
+            HAKO_PROF_SCOPE(HAKO_PROF_SENSOR_MAG, index);
+            mag->run(drone_dynamics->get_angle());
+        }
+        {
+            HAKO_PROF_SCOPE(HAKO_PROF_SENSOR_BARO, index);
+            baro->run(drone_dynamics->get_pos());
+        }
 
+        HAKO_PROF_SCOPE(HAKO_PROF_LOGGER, index);
         logger.run();
     }
     CsvLogger& get_logger()
@@ -300,6 +300,13 @@ class DroneControlProxyManager {
 private:
     AirCraftModuleSimulator module_simulator;
     std::vector<DroneControlProxy> drone_control_proxies;
+    AirCraftControllerBatch controller_batch;
+    std::vector<mi_drone_control_out_t> control_out;
+    std::vector<bool> control_active;
+    std::vector<DroneMixer*> mixer_ptrs;
+    std::vector<DroneMixerInputType> mixer_in;
+    std::vector<PwmDuty> mixer_duty;
+
 public:
     void init(Hako_uint64 microseconds, Hako_uint64 dt_usec)
     {
@@ -311,6 +318,13 @@ public:
             proxy.in.drag = module.drone->get_drone_dynamics().get_drag();
             drone_control_proxies.push_back(proxy);
         }
+        size_t num = drone_control_proxies.size();
+        controller_batch.resize(num);
+        control_out.resize(num);
+        control_active.resize(num);
+        mixer_ptrs.resize(num);
+        mixer_in.resize(num);
+        mixer_duty.resize(num);
     }
     void reset()
     {
@@ -331,11 +345,14 @@ public:
     }
     void run()
     {
-        int index = 0;
-        for (auto& module : module_simulator.get_modules()) {
+        auto& modules = module_simulator.get_modules();
+        const int num = static_cast<int>(modules.size());
+        /*
+         * 制御入力
+         */
+        for (int index = 0; index < num; index++) {
+            auto& module = modules[index];
             DroneControlProxy& proxy = drone_control_proxies[index];
-            hako::assets::drone::DroneDynamicsInputType drone_input = {};
-            mi_drone_control_out_t out = {};
             DronePositionType pos = module.drone->get_drone_dynamics().get_pos();
             DroneEulerType angle = module.drone->get_drone_dynamics().get_angle();
             hako::assets::drone::DroneVelocityBodyFrameType velocity = module.drone->get_drone_dynamics().get_vel_body_frame();
@@ -355,9 +372,33 @@ public:
             proxy.in.q = angular_velocity.data.y;
             proxy.in.r = angular_velocity.data.z;
             proxy.in.radio_control = (proxy.radio_control_on == false) ? 0 : 1;
-
-            if ((proxy.get_status() != MAIN_STATUS_LANDED) || proxy.radio_control_on) {
-                out = module.control_module.controller->run(&proxy.in);
+            control_out[index] = {};
+            control_active[index] = (proxy.get_status() != MAIN_STATUS_LANDED) || proxy.radio_control_on;
+        }
+        /*
+         * 制御
+         */
+        controller_batch.run(modules, control_active, [&](int index) -> mi_drone_control_in_t& {
+            return drone_control_proxies[index].in;
+        }, control_out);
+        /*
+         * ミキサー(全機体分をまとめて計算する)
+         */
+        for (int index = 0; index < num; index++) {
+            const mi_drone_control_out_t& out = control_out[index];
+            mixer_ptrs[index] = modules[index].drone->get_mixer();
+            mixer_in[index] = { drone_control_proxies[index].in.mass, out.thrust, out.torque_x, out.torque_y, out.torque_z };
+        }
+        DroneMixer::run_batch(mixer_ptrs.data(), mixer_in.data(), mixer_duty.data(), num);
+        /*
+         * 機体への反映
+         */
+        for (int index = 0; index < num; index++) {
+            auto& module = modules[index];
+            DroneControlProxy& proxy = drone_control_proxies[index];
+            hako::assets::drone::DroneDynamicsInputType drone_input = {};
+            const mi_drone_control_out_t& out = control_out[index];
+            if (control_active[index]) {
                 proxy.do_control();
             }
 
@@ -368,11 +409,10 @@ public:
             torque.data.y = out.torque_y;
             torque.data.z = out.torque_z;
 
-            auto mixer = module.drone->get_mixer();
+            auto mixer = mixer_ptrs[index];
             if (mixer != nullptr) {
-                PwmDuty duty = {};
-                duty = mixer->run(proxy.in.mass, thrust.data, torque.data.x, torque.data.y, torque.data.z);
-                for (int i = 0; i < ROTOR_NUM; i++) {
+                const PwmDuty& duty = mixer_duty[index];
+                for (int i = 0; i < module.drone->get_rotor_num(); i++) {
                     drone_input.controls[i] = duty.d[i];
                     module.controls[i] = duty.d[i];
                 }
@@ -380,7 +420,7 @@ public:
             }
             else {
                 if (module.drone->is_rotor_control_enabled()) {
-                    for (int i = 0; i < ROTOR_NUM; i++) {
+                    for (int i = 0; i < module.drone->get_rotor_num(); i++) {
                         drone_input.controls[i] = out.rotor.controls[i];
                         module.controls[i] = out.rotor.controls[i];
                     }
@@ -406,11 +446,9 @@ public:
             }
             do_io_write_battery_status(module.drone);
             do_io_write(module.drone, module.controls);
-            index++;
         }
     }
 };
-
 }
 
 #endif /* _DRONE_CONTROL_PROXY_HPP_ */
\ No newline at end of file
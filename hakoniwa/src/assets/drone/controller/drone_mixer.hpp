@@ -3,177 +3,400 @@
 #include "drone_primitive_types.hpp"
 #include "config/drone_config.hpp"
 #include "ithrust_dynamics.hpp"
+#include "utils/hako_utils.hpp"
+#include <algorithm>
 #include <vector>
-#include <glm/glm.hpp>
-#include <glm/gtc/matrix_inverse.hpp>
 #include <iostream>
 #include <cmath>
 
 namespace hako::assets::drone {
+    #define DRONE_MIXER_MAX_ROTOR_NUM   ROTOR_NUM_MAX
+
     struct PwmDuty {
-        double d[ROTOR_NUM];
+        double d[DRONE_MIXER_MAX_ROTOR_NUM];
+    };
+    /*
+     * 制御入力 U = (thrust, torque_x, torque_y, torque_z)
+     */
+    struct DroneMixerInputType {
+        double mass;
+        double thrust;
+        double torque_x;
+        double torque_y;
+        double torque_z;
     };
+    enum DroneMixerModeType {
+        DRONE_MIXER_MODE_DISABLED = 0,
+        DRONE_MIXER_MODE_DEFAULT,   /* Omega^2 = P * U */
+        DRONE_MIXER_MODE_LINEAR,    /* ホバリング点まわりの線形化 */
+    };
+
+    /*
+     * ロータ数 N の機体の制御配分(ミキサー)
+     *
+     * 制御効率行列 B(4 x N, U = B * Omega^2)とその擬似逆行列 P(N x 4)は生成時に
+     * 一度だけ計算し、run() では P の積とロータ回転数の上下限を考慮した配分のみを
+     * 行う。飽和する場合は姿勢(トルク)を優先し、推力を調整して範囲内に収める。
+     * それでも収まらない場合はトルクを同じ比率で縮小する。
+     *
+     * ロータ回転数の上限は duty = 1 となる回転数(omega_max)で、duty は 1 を超えない。
+     * (以前は負の Omega^2 を 0 にするだけで、上限は制限していなかった)
+     *
+     * P は入力ごとにロータ方向へ連続した配列(4 x DRONE_MIXER_MAX_ROTOR_NUM, 未使用は 0)で持ち、
+     * 積は固定長のループで計算する(コンパイラがベクトル化できる形にしている)。
+     */
     class DroneMixer {
     private:
         double param_Kr;
         double param_A;
         double param_B;
-        glm::dmat4 M;
-        glm::dmat4 M_inv;
-        glm::dmat4 A;
-        glm::dmat4 A_inv;
-        glm::dmat4 MA_inv;
+        int rotor_num;
+        double B[4][DRONE_MIXER_MAX_ROTOR_NUM];     /* 制御効率行列 */
+        double P[4][DRONE_MIXER_MAX_ROTOR_NUM];     /* 配分行列(B の擬似逆行列)の転置 */
         DroneConfig::MixerInfo mixer_info {};
+        DroneMixerModeType mode = DRONE_MIXER_MODE_DISABLED;
+        double omega_max = 0;   /* duty = 1 となる回転数 [rad/s] */
 
-        double get_duty(double omega) {
+        double get_duty(double omega) const {
             //e = K * w + (Cq * R / K ) w ^2
             double e = mixer_info.K * omega + (mixer_info.Cq * mixer_info.R / mixer_info.K) * omega * omega;
             //d = e / V_bat
             double d = e / mixer_info.V_bat;
             return d;
         }
-    public: 
+        /*
+         * duty = 1 となる回転数(get_duty の逆関数)
+         */
+        double calculate_omega_max() const {
+            if (mixer_info.K <= 0 || mixer_info.V_bat <= 0) {
+                return param_Kr;
+            }
+            double a = mixer_info.Cq * mixer_info.R / mixer_info.K;
+            if (a <= 0) {
+                return mixer_info.V_bat / mixer_info.K;
+            }
+            return (-mixer_info.K + std::sqrt(mixer_info.K * mixer_info.K + 4.0 * a * mixer_info.V_bat)) / (2.0 * a);
+        }
+        /*
+         * 4x4 行列の逆行列と行列式(Gauss-Jordan, 部分ピボット)
+         */
+        static bool invert4(const double in[4][4], double out[4][4], double& det) {
+            double m[4][8];
+            det = 1.0;
+            for (int i = 0; i < 4; i++) {
+                for (int j = 0; j < 4; j++) {
+                    m[i][j] = in[i][j];
+                    m[i][j + 4] = (i == j) ? 1.0 : 0.0;
+                }
+            }
+            for (int c = 0; c < 4; c++) {
+                int pivot = c;
+                for (int r = c + 1; r < 4; r++) {
+                    if (std::fabs(m[r][c]) > std::fabs(m[pivot][c])) {
+                        pivot = r;
+                    }
+                }
+                if (std::fabs(m[pivot][c]) < 1e-300) {
+                    det = 0;
+                    return false;
+                }
+                if (pivot != c) {
+                    for (int j = 0; j < 8; j++) {
+                        std::swap(m[c][j], m[pivot][j]);
+                    }
+                    det = -det;
+                }
+                det *= m[c][c];
+                double inv = 1.0 / m[c][c];
+                for (int j = 0; j < 8; j++) {
+                    m[c][j] *= inv;
+                }
+                for (int r = 0; r < 4; r++) {
+                    if (r != c && m[r][c] != 0) {
+                        double f = m[r][c];
+                        for (int j = 0; j < 8; j++) {
+                            m[r][j] -= f * m[c][j];
+                        }
+                    }
+                }
+            }
+            for (int i = 0; i < 4; i++) {
+                for (int j = 0; j < 4; j++) {
+                    out[i][j] = m[i][j + 4];
+                }
+            }
+            return true;
+        }
+        /*
+         * y = s * p + lambda * a を各ロータで [lo, hi] に収める。
+         * 飽和しなければ s = s_ref, lambda = 1(通常の配分)。
+         * 飽和する場合は lambda = 1 のまま s(推力)を動かして収め、それでも収まら
+         * ない場合のみ lambda(トルク)を縮める。
+         * return: 飽和したかどうか
+         */
+        bool allocate(const double* p, const double* a, double s_ref, double lo, double hi, double* y) const {
+            bool saturated = false;
+            for (int i = 0; i < rotor_num; i++) {
+                y[i] = s_ref * p[i] + a[i];
+                if (y[i] < lo || y[i] > hi) {
+                    saturated = true;
+                }
+            }
+            if (!saturated) {
+                return false;
+            }
+            for (int i = 0; i < rotor_num; i++) {
+                if (p[i] <= 0) {
+                    /* 推力方向に寄与しないロータがある場合は単純に制限する */
+                    for (int k = 0; k < rotor_num; k++) {
+                        y[k] = std::max(lo, std::min(hi, y[k]));
+                    }
+                    return true;
+                }
+            }
+            double lambda = 1.0;
+            for (int i = 0; i < rotor_num; i++) {
+                for (int j = 0; j < rotor_num; j++) {
+                    double d = a[j] / p[j] - a[i] / p[i];
+                    if (d > 0) {
+                        lambda = std::min(lambda, (hi / p[j] - lo / p[i]) / d);
+                    }
+                }
+            }
+            lambda = std::max(lambda, 0.0);
+            double s_lo = -INFINITY;
+            double s_hi = INFINITY;
+            for (int i = 0; i < rotor_num; i++) {
+                s_lo = std::max(s_lo, (lo - lambda * a[i]) / p[i]);
+                s_hi = std::min(s_hi, (hi - lambda * a[i]) / p[i]);
+            }
+            double s = (s_lo <= s_hi) ? std::max(s_lo, std::min(s_hi, s_ref)) : 0.5 * (s_lo + s_hi);
+            for (int i = 0; i < rotor_num; i++) {
+                y[i] = std::max(lo, std::min(hi, s * p[i] + lambda * a[i]));
+            }
+            return true;
+        }
+        /*
+         * a = scale * P[1..3] * (torque_x, torque_y, torque_z)
+         * 未使用のロータは P が 0 のため a = 0
+         */
+        void mix_torque(const DroneMixerInputType& in, double scale, double* a) const {
+            const double tx = scale * in.torque_x;
+            const double ty = scale * in.torque_y;
+            const double tz = scale * in.torque_z;
+            for (int i = 0; i < DRONE_MIXER_MAX_ROTOR_NUM; i++) {
+                a[i] = P[1][i] * tx + P[2][i] * ty + P[3][i] * tz;
+            }
+        }
+        void log_saturation(const DroneMixerInputType& in) const {
+            if (mixer_info.enableErrorLog) {
+                std::cout << "ERROR: thrust:" << in.thrust << " tx: " << in.torque_x << " ty: " << in.torque_y << " tz: " << in.torque_z << std::endl;
+                std::cout << "ERROR: rotor speed is saturated, thrust/torque is limited..." << std::endl;
+            }
+        }
+    public:
         virtual ~DroneMixer() {}
-        DroneMixer(double Kr, double a, double b, RotorConfigType rotor[ROTOR_NUM])
+        DroneMixer(double Kr, double a, double b, const RotorConfigType* rotor, int num)
         {
             this->param_Kr = Kr;
             this->param_A = a;
             this->param_B = b;
-            this->M = glm::dmat4(1.0f);
-            this->M[0] = glm::dvec4(1, 1, 1, 1);
-            this->M[1] = glm::dvec4(-rotor[0].data.y, -rotor[1].data.y, -rotor[2].data.y, -rotor[3].data.y);
-            this->M[2] = glm::dvec4(rotor[0].data.x, rotor[1].data.x, rotor[2].data.x, rotor[3].data.x);
-            this->M[3] = glm::dvec4(rotor[0].ccw, rotor[1].ccw, rotor[2].ccw, rotor[3].ccw);
-            this->M = glm::transpose(this->M);
-            
-            this->A = glm::dmat4(1.0f);
-            this->A[0] = glm::dvec4( (a ), 0, 0, 0);
-            this->A[1] = glm::dvec4( 0, (a ), 0, 0);
-            this->A[2] = glm::dvec4( 0, 0, (a ), 0);
-            this->A[3] = glm::dvec4( 0, 0, 0, (b ));
-            this->A = glm::transpose(this->A);
-            this->A_inv = glm::inverse(A);
+            HAKO_ASSERT(num > 0 && num <= DRONE_MIXER_MAX_ROTOR_NUM);
+            this->rotor_num = num;
+            for (int i = 0; i < num; i++) {
+                B[0][i] = a;
+                B[1][i] = a * (-rotor[i].data.y);
+                B[2][i] = a * rotor[i].data.x;
+                B[3][i] = b * rotor[i].ccw;
+            }
+            for (int j = 0; j < 4; j++) {
+                for (int i = 0; i < DRONE_MIXER_MAX_ROTOR_NUM; i++) {
+                    P[j][i] = 0;
+                }
+            }
+        }
+        DroneMixer(double Kr, double a, double b, RotorConfigType rotor[ROTOR_NUM])
+            : DroneMixer(Kr, a, b, rotor, ROTOR_NUM)
+        {
         }
         void setMixerInfo(DroneConfig::MixerInfo& info)
         {
             mixer_info = info;
-        }
-        static void printMatrix(const glm::dmat4& mat) {
-            for (int i = 0; i < 4; i++) { 
-                for (int j = 0; j < 4; j++) {
-                    std::cout << mat[j][i] << " ";
-                }
-                std::cout << std::endl;
+            /*
+             * モードはここで一度だけ決める
+             */
+            if (!mixer_info.enable) {
+                mode = DRONE_MIXER_MODE_DISABLED;
+            }
+            else if (mixer_info.vendor == "linear") {
+                mode = DRONE_MIXER_MODE_LINEAR;
+            }
+            else {
+                mode = DRONE_MIXER_MODE_DEFAULT;
             }
+            omega_max = (mode == DRONE_MIXER_MODE_LINEAR) ? param_Kr : calculate_omega_max();
         }
+        DroneMixerModeType get_mode() const
+        {
+            return mode;
+        }
+        int get_rotor_num() const
+        {
+            return rotor_num;
+        }
+        /*
+         * P = B^T (B B^T)^-1 (N = 4 の場合は B^-1 と一致する)
+         */
         bool calculate_M_inv()
         {
-            float det = glm::determinant(this->M);
-            if (std::abs(det) < 0.0001) {
+            double G[4][4];
+            double G_inv[4][4];
+            double geometry[4][4];
+            for (int r = 0; r < 4; r++) {
+                for (int c = 0; c < 4; c++) {
+                    double g = 0;
+                    double m = 0;
+                    for (int i = 0; i < rotor_num; i++) {
+                        g += B[r][i] * B[c][i];
+                        m += (B[r][i] / (r == 3 ? param_B : param_A)) * (B[c][i] / (c == 3 ? param_B : param_A));
+                    }
+                    G[r][c] = g;
+                    geometry[r][c] = m;
+                }
+            }
+            /*
+             * 特異判定は機体形状(A, B を除いた行列)の Gram 行列で行う
+             * (N = 4 の場合 det(M M^T) = det(M)^2)
+             */
+            double geometry_inv[4][4];
+            double geometry_det = 0;
+            double G_det = 0;
+            bool ok = (rotor_num >= 4) && invert4(geometry, geometry_inv, geometry_det) && invert4(G, G_inv, G_det);
+            if (!ok || std::fabs(geometry_det) < 0.0001 * 0.0001) {
                 std::cout << "The matrix is singular and does not have an inverse." << std::endl;
                 return false;
             }
-            this->M_inv = glm::inverse(M);
-            this->MA_inv= M_inv * A_inv;
+            for (int i = 0; i < rotor_num; i++) {
+                for (int c = 0; c < 4; c++) {
+                    double v = 0;
+                    for (int r = 0; r < 4; r++) {
+                        v += B[r][i] * G_inv[r][c];
+                    }
+                    P[c][i] = v;
+                }
+            }
             return true;
         }
         PwmDuty run(double mass, double thrust, double torque_x, double torque_y, double torque_z)
         {
+            DroneMixerInputType in = { mass, thrust, torque_x, torque_y, torque_z };
             PwmDuty duty = {};
-            if (mixer_info.enable) {
-                if (mixer_info.vendor == "linear") {
-                    return run_linear(mass, thrust, torque_x, torque_y, torque_z);
+            run(in, duty);
+            return duty;
+        }
+        void run(const DroneMixerInputType& in, PwmDuty& duty)
+        {
+            duty = {};
+            switch (mode) {
+            case DRONE_MIXER_MODE_DEFAULT:
+                run_default(in, duty);
+                break;
+            case DRONE_MIXER_MODE_LINEAR:
+                run_linear(in, duty);
+                break;
+            default:
+                break;
+            }
+        }
+        /*
+         * 複数機体をまとめて計算する(mixers[i] が nullptr の機体は duty = 0)
+         * 機体ごとに P・モード・上限が異なるため、機体単位で run() を呼ぶ。
+         */
+        static void run_batch(DroneMixer* const* mixers, const DroneMixerInputType* in, PwmDuty* out, int n)
+        {
+            for (int i = 0; i < n; i++) {
+                if (mixers[i] != nullptr) {
+                    mixers[i]->run(in[i], out[i]);
                 }
                 else {
-                    return run_default(mass, thrust, torque_x, torque_y, torque_z);
+                    out[i] = {};
                 }
             }
-            return duty;
         }
         PwmDuty run_default(double mass, double thrust, double torque_x, double torque_y, double torque_z)
         {
-            (void)mass;
-            glm::dvec4 U = glm::dvec4(thrust, torque_x, torque_y, torque_z);
-            
-            glm::dvec4 Omega2 = MA_inv * U;
+            DroneMixerInputType in = { mass, thrust, torque_x, torque_y, torque_z };
             PwmDuty duty = {};
-            for (int i = 0; i < ROTOR_NUM; i++) {
-                if (Omega2[i] < 0) {
-                    if (mixer_info.enableErrorLog) {
-                        std::cout << "ERROR: thrust:" << thrust << " tx: " << torque_x << " ty: " << torque_y << " tz: " << torque_z << std::endl;
-                        std::cout << "ERROR: Invalid caluculation of Omega to duty because of omega^2("<< i << ") is minus value(" << Omega2[i] << ")..." << std::endl;
-                    }
-                    Omega2[i] = 0;
-                }
-                else {
-                    //duty.d[i] = std::sqrt(Omega2[i]) / this->param_Kr;
-                    duty.d[i] = get_duty(std::sqrt(Omega2[i]));
-                }
+            run_default(in, duty);
+            return duty;
+        }
+        void run_default(const DroneMixerInputType& in, PwmDuty& duty)
+        {
+            double a[DRONE_MIXER_MAX_ROTOR_NUM];
+            double Omega2[DRONE_MIXER_MAX_ROTOR_NUM];
+            mix_torque(in, 1.0, a);
+            if (allocate(P[0], a, in.thrust, 0.0, omega_max * omega_max, Omega2)) {
+                log_saturation(in);
+            }
+            for (int i = 0; i < rotor_num; i++) {
+                duty.d[i] = get_duty(std::sqrt(Omega2[i]));
                 if (mixer_info.enableDebugLog) {
                     std::cout << "Motor " << i << ": Omega^2 = " << Omega2[i] << ", PWM Duty = " << duty.d[i] << std::endl;
-                }                
+                }
             }
-            return duty;
         }
         // linearized version
         PwmDuty run_linear(double mass, double thrust, double torque_x, double torque_y, double torque_z)
         {
-            const double m = mass; // pass through mass from caller
-            const int N = ROTOR_NUM;
+            DroneMixerInputType in = { mass, thrust, torque_x, torque_y, torque_z };
+            PwmDuty duty = {};
+            run_linear(in, duty);
+            return duty;
+        }
+        void run_linear(const DroneMixerInputType& in, PwmDuty& duty)
+        {
+            const double m = in.mass; // pass through mass from caller
+            const int N = rotor_num;
             const double g = GRAVITY;
             const double A = param_A;
             const double T0 = m*g; // equibilium
             const double omega0 = std::sqrt(T0/(N*A)); // equibilium
-            const double delta_T = thrust - T0;
+            const double delta_T = in.thrust - T0;
             const double Kr = param_Kr;
-            
-            glm::dvec4 delta_U = glm::dvec4(delta_T, torque_x, torque_y, torque_z);
-            glm::dvec4 delta_omega_times_omega0 = 0.5 * MA_inv * delta_U;
-            glm::dvec4 delta_omega = delta_omega_times_omega0/omega0;
+            const double c = 0.5 / omega0;
 
-#if 0
-            for (int i = 0; i < ROTOR_NUM; i++) {
-                double ratio = delta_omega[i]/omega0; 
-                if (std::fabs(ratio) >  0.8) {
-                    if (debugEnabled) {
-                            std::cout << "WARNING: thrust:" << thrust << " tx: " << torque_x << " ty: " << torque_y << " tz: " << torque_z << std::endl;
-                            std::cout << "WARNING: delta_omega("<< i << ") is too big(" << delta_omega[i]/omega0 << "%)...limited to 80%." << std::endl;
-                    }
-                    delta_omega[i] = delta_omega[i]/ratio  * 0.8; // keep the sign and make omega0 * 0.8
-                }
+            // omega = omega0 + 0.5 * P * delta_U / omega0
+            double p[DRONE_MIXER_MAX_ROTOR_NUM];
+            double a[DRONE_MIXER_MAX_ROTOR_NUM];
+            double delta_omega[DRONE_MIXER_MAX_ROTOR_NUM];
+            for (int i = 0; i < DRONE_MIXER_MAX_ROTOR_NUM; i++) {
+                p[i] = c * P[0][i];
             }
-#endif
-            glm::dvec4 omega = omega0 + delta_omega;
-
-            PwmDuty duty = {};
-            for (int i = 0; i < ROTOR_NUM; i++) {
-                if (omega[i] < 0) {
-                    if (mixer_info.enableErrorLog) {
-                        std::cout << "ERROR: thrust:" << thrust << " tx: " << torque_x << " ty: " << torque_y << " tz: " << torque_z << std::endl;
-                        std::cout << "ERROR: Invalid caluculation of Omega to duty because of omega("<< i << ") is minus value(" << omega[i] << ")..." << std::endl;
-                    }
-                    omega[i] = 0.0;
-                }
-                else {
-                    duty.d[i] = omega[i] / Kr;
-                }
+            mix_torque(in, c, a);
+            if (allocate(p, a, delta_T, -omega0, omega_max - omega0, delta_omega)) {
+                log_saturation(in);
+            }
+            for (int i = 0; i < N; i++) {
+                double omega = omega0 + delta_omega[i];
+                duty.d[i] = omega / Kr;
                 if (mixer_info.enableDebugLog) {
-                    std::cout << "Motor " << i << ": Omega = " << omega[i] << ", PWM Duty = " << duty.d[i] << std::endl;
-                }                
+                    std::cout << "Motor " << i << ": Omega = " << omega << ", PWM Duty = " << duty.d[i] << std::endl;
+                }
             }
-            return duty;
         }
-        glm::vec4 reconstructControlInput(const PwmDuty& duty) {
-            glm::dvec4 Omega2;
-            for (int i = 0; i < ROTOR_NUM; i++) {
-                Omega2[i] = std::pow(duty.d[i] * param_Kr, 2);
+        void reconstructControlInput(const PwmDuty& duty, double U[4]) const {
+            for (int r = 0; r < 4; r++) {
+                U[r] = 0;
+                for (int i = 0; i < rotor_num; i++) {
+                    U[r] += B[r][i] * std::pow(duty.d[i] * param_Kr, 2);
+                }
             }
-            return A * M * Omega2;
         }
         bool testReconstruction(double thrust, double torque_x, double torque_y, double torque_z) {
-            glm::dvec4 U_original = glm::dvec4(thrust, torque_x, torque_y, torque_z);
+            double U_original[4] = { thrust, torque_x, torque_y, torque_z };
+            double U_reconstructed[4];
             PwmDuty duty = run_default(0, thrust, torque_x, torque_y, torque_z);
-            glm::dvec4 U_reconstructed = reconstructControlInput(duty);
+            reconstructControlInput(duty, U_reconstructed);
 
             const double epsilon = 1e-5;
             for (int i = 0; i < 4; i++) {
@@ -60,3 +60,12 @@ mi_drone_control_out_t hako::assets::drone::SampleController::run(mi_drone_contr
 
     return out;
 }
+
+void hako::assets::drone::SampleController::add_state_regions(HakoStateRegions& regions)
+{
+    for (auto* pid : { pid_pos_x, pid_pos_y, pid_pos_z, pid_euler_x, pid_euler_y, pid_euler_z }) {
+        if (pid != nullptr) {
+            pid->add_state_regions(regions);
+        }
+    }
+}
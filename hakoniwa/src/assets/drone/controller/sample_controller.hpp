@@ -8,12 +8,12 @@ namespace hako::assets::drone {
 
 class SampleController: public IController {
 private:
-    PID *pid_pos_x;
-    PID *pid_pos_y;
-    PID *pid_pos_z;
-    PID *pid_euler_x;
-    PID *pid_euler_y;
-    PID *pid_euler_z;
+    PID *pid_pos_x = nullptr;
+    PID *pid_pos_y = nullptr;
+    PID *pid_pos_z = nullptr;
+    PID *pid_euler_x = nullptr;
+    PID *pid_euler_y = nullptr;
+    PID *pid_euler_z = nullptr;
     double hovering_thrust;
     double hovering_thrust_range;
     double get_limit_value(double input_value, double base_value, double min_value, double max_value)
@@ -26,6 +26,7 @@ public:
     SampleController(int index);
     virtual ~SampleController() {}
     virtual mi_drone_control_out_t run(mi_drone_control_in_t &in) override;
+    virtual void add_state_regions(HakoStateRegions& regions) override;
 };
 }
 
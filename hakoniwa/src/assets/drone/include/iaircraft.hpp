@@ -17,16 +17,17 @@ namespace hako::assets::drone {
 class IAirCraft {
 protected:
     bool            enable_disturbance = false;
-    IDroneDynamics *drone_dynamics;
-    IRotorDynamics *rotor_dynamics[ROTOR_NUM];
-    IThrustDynamics *thrust_dynamis;
-    IBatteryDynamics *battery_dynamics;
+    IDroneDynamics *drone_dynamics = nullptr;
+    int rotor_num = ROTOR_NUM;
+    IRotorDynamics *rotor_dynamics[ROTOR_NUM_MAX] = {};
+    IThrustDynamics *thrust_dynamis = nullptr;
+    IBatteryDynamics *battery_dynamics = nullptr;
 
-    ISensorAcceleration *acc;
-    ISensorBaro *baro;
-    ISensorGps *gps;
-    ISensorGyro *gyro;
-    ISensorMag *mag;
+    ISensorAcceleration *acc = nullptr;
+    ISensorBaro *baro = nullptr;
+    ISensorGps *gps = nullptr;
+    ISensorGyro *gyro = nullptr;
+    ISensorMag *mag = nullptr;
     std::string robo_name;
     int index = 0;
     bool enable_rotor_control = false;
@@ -38,6 +39,14 @@ public:
     virtual void run(DroneDynamicsInputType& input) = 0;
     virtual DroneMixer* get_mixer() = 0;
     virtual void reset() = 0;
+    /*
+     * 状態のスナップショット(機体力学, ロータ, 推力, バッテリー, センサの移動平均と乱数)
+     * 保存・復元は memcpy のみで、reset() と違い CSV ログには触れない。
+     * buf には get_state_size() バイト以上の領域を渡すこと。
+     */
+    virtual size_t get_state_size() = 0;
+    virtual void save_state(void *buf) = 0;
+    virtual void restore_state(const void *buf) = 0;
     void enable_disturb()
     {
         this->enable_disturbance = true;
@@ -79,12 +88,17 @@ public:
     {
         return *drone_dynamics;
     }
-    void set_rotor_dynamics(IRotorDynamics *src[ROTOR_NUM])
+    void set_rotor_dynamics(IRotorDynamics *src[], int num = ROTOR_NUM)
     {
-        for (int i = 0; i < ROTOR_NUM; i++) {
+        this->rotor_num = num;
+        for (int i = 0; i < num; i++) {
             this->rotor_dynamics[i] = src[i];
         }
     }
+    int get_rotor_num() const
+    {
+        return this->rotor_num;
+    }
     void set_battery_dynamics(IBatteryDynamics *src)
     {
         this->battery_dynamics = src;
@@ -95,7 +109,7 @@ public:
     }
     double get_rpm_max(int rotor_index)
     {
-        if (rotor_index < ROTOR_NUM) {
+        if (rotor_index < rotor_num) {
             return radPerSecToRPM(this->rotor_dynamics[rotor_index]->get_rad_per_sec_max());
         }
         else {
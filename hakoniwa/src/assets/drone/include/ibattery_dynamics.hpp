@@ -4,6 +4,7 @@
 #include "icurrent_dynamics.hpp"
 #include "config/drone_config_types.hpp"
 #include "utils/hako_utils.hpp"
+#include "utils/hako_state_snapshot.hpp"
 #include <vector>
 #include <iostream>
 
@@ -27,7 +28,7 @@ typedef struct {
     double discharge_capacity_sec;
 } DischargeDynamicsType;
 
-class IBatteryDynamics {
+class IBatteryDynamics : public IStateSnapshot {
 protected:
     void *vendor_model;
     void *context;
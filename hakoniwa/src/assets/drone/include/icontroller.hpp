@@ -3,11 +3,12 @@
 
 
 #include "hako_module_drone_controller.h"
+#include "utils/hako_state_snapshot.hpp"
 
 namespace hako::assets::drone {
 
 
-class IController {
+class IController : public IStateSnapshot {
 protected:
     int index = 0;
 public:
@@ -3,6 +3,7 @@
 
 #include "drone_primitive_types.hpp"
 #include "utils/icsv_log.hpp"
+#include "utils/hako_state_snapshot.hpp"
 #include "hako_module_drone_sensor.h"
 #include "config/drone_config_types.hpp"
 
@@ -41,7 +42,7 @@ typedef struct {
 } DroneDynamicsInputType;
 
 
-class IDroneDynamics: public ICsvLog {
+class IDroneDynamics: public ICsvLog, public IStateSnapshot {
 protected:
     DronePhysCalcCacheType cache;
     bool use_quaternion = false;
@@ -3,11 +3,12 @@
 
 #include "drone_primitive_types.hpp"
 #include "config/drone_config_types.hpp"
+#include "utils/hako_state_snapshot.hpp"
 
 namespace hako::assets::drone {
 
 
-class IRotorDynamics {
+class IRotorDynamics : public IStateSnapshot {
 public:
     virtual ~IRotorDynamics() {}
 
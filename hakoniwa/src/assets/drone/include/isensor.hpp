@@ -6,14 +6,21 @@
 
 #include "isensor_noise.hpp"
 #include "isensor_data_assembler.hpp"
+#include "utils/hako_state_snapshot.hpp"
 
 namespace hako::assets::drone {
 
-class ISensor {
+class ISensor : public IStateSnapshot {
 protected:
-    ISensorNoise *noise;
-    void *vendor_model;
-    void *context;
+    ISensorNoise *noise = nullptr;
+    void *vendor_model = nullptr;
+    void *context = nullptr;
+    void add_noise_state_regions(HakoStateRegions& regions)
+    {
+        if (this->noise != nullptr) {
+            this->noise->add_state_regions(regions);
+        }
+    }
 public:
     virtual ~ISensor() {}
     virtual void set_vendor(void *vendor, void *context)
@@ -2,23 +2,31 @@
 #define _ITHRUST_DYNAMICS_HPP_
 
 #include "drone_primitive_types.hpp"
+#include "utils/hako_state_snapshot.hpp"
 
 namespace hako::assets::drone {
 
+/*
+ * ROTOR_NUM は既定の機体(クアッド)のロータ数.
+ * 機体ごとのロータ数は getCompThrusterRotorPositions() の要素数で決まり、
+ * ROTOR_NUM_MAX まで扱える。
+ */
 const int ROTOR_NUM = 4;
+const int ROTOR_NUM_MAX = 8;
 
-class IThrustDynamics {
+class IThrustDynamics : public IStateSnapshot {
 public:
     virtual ~IThrustDynamics() {}
 
-    virtual void set_rotor_config(const RotorConfigType rotor_config[ROTOR_NUM]) = 0;
+    virtual void set_rotor_config(const RotorConfigType rotor_config[], int rotor_num = ROTOR_NUM) = 0;
+    virtual int get_rotor_num() const = 0;
     virtual void set_thrust(const DroneThrustType &thrust) = 0;
     virtual void set_torque(const DroneTorqueType &torque) = 0;
 
     virtual DroneThrustType get_thrust() const = 0;
     virtual DroneTorqueType get_torque() const = 0;
 
-    virtual void run(const DroneRotorSpeedType rotor_speed[ROTOR_NUM]) = 0;
+    virtual void run(const DroneRotorSpeedType rotor_speed[]) = 0;
     virtual void reset() = 0;
 
     virtual void print() = 0;
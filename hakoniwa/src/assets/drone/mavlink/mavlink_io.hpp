@@ -63,11 +63,11 @@ private:
 public:
     virtual ~MavlinkIO() {}
 
-    bool read_actuator_data(IAirCraft& drone, double controls[hako::assets::drone::ROTOR_NUM], Hako_uint64& time_usec)
+    bool read_actuator_data(IAirCraft& drone, double controls[], Hako_uint64& time_usec)
     {
         Hako_HakoHilActuatorControls hil_actuator_controls;
         if (hako_read_hil_actuator_controls(drone.get_index(), hil_actuator_controls)) {
-            for (int i = 0; i < hako::assets::drone::ROTOR_NUM; i++) {
+            for (int i = 0; i < drone.get_rotor_num(); i++) {
                 controls[i] = hil_actuator_controls.controls[i];
             }
             time_usec = hil_actuator_controls.time_usec;
@@ -0,0 +1,276 @@
+#ifndef _BATTERY_DISCHARGE_TABLE_HPP_
+#define _BATTERY_DISCHARGE_TABLE_HPP_
+
+/*
+ * バッテリー放電特性の2次元テーブル(温度 x 放電容量)
+ *
+ * CSV の放電特性(温度ごとの 放電容量 -> 電圧 の折れ線)を、読み込み時に
+ * 等間隔の格子に展開しておき、ステップ毎の電圧は双線形補間で求める。
+ * 格子が等間隔のため、セルの位置は割り算なしの計算で決まり、探索は不要。
+ * 温度はほとんど変わらないため、直前の温度で求めた行と重みをヒントとして保持し、
+ * 温度が同じ間は再計算しない。
+ *
+ * 格子の各点の値は、CSV の折れ線の線形補間(範囲外は端の2点による外挿)で求める。
+ * 格子の刻み幅は、CSV の点の最小間隔の 1/HAKO_BATTERY_TABLE_SUBDIV とする。
+ *
+ * CSV の点(温度・放電容量)が格子上にあれば、元の折れ線の補間と一致する。
+ * 格子上にない点では折れ線の角が格子のセル内で丸められるため、誤差が出る。
+ * 格子の範囲内での誤差の上限は、刻み幅 h のセルの中にある角での傾きの変化の合計 S から
+ * h * S / 4 (放電容量方向と温度方向の和)で、build() で求めて get_error_bound() で返す。
+ */
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#define HAKO_BATTERY_TABLE_SUBDIV           4
+#define HAKO_BATTERY_TABLE_CAPACITY_NUM_MAX 4096
+#define HAKO_BATTERY_TABLE_TEMP_NUM_MAX     256
+
+namespace hako::assets::drone {
+
+struct DischargeData {
+    double capacity; /* 放電容量 (Ah) */
+    double voltage;  /* 電圧レベル(V) */
+};
+
+/* 1つの温度の放電特性(容量でソート済み) */
+struct DischargeCurve {
+    double temperature;
+    const std::vector<DischargeData>* data;
+};
+
+class BatteryDischargeTable {
+private:
+    double temp_min = 0;
+    double temp_inv_step = 0;
+    int temp_num = 0;
+    double capacity_min = 0;
+    double capacity_inv_step = 0;
+    int capacity_num = 0;
+    /* voltage[temp_index * capacity_num + capacity_index] */
+    std::vector<double> voltage;
+    double error_bound = 0;
+
+    /* 温度のヒント */
+    double hint_temperature = std::numeric_limits<double>::quiet_NaN();
+    const double* hint_row0 = nullptr;
+    const double* hint_row1 = nullptr;
+    double hint_weight = 0;
+
+    static double min_gap(std::vector<double> values)
+    {
+        std::sort(values.begin(), values.end());
+        double gap = std::numeric_limits<double>::infinity();
+        for (size_t i = 1; i < values.size(); i++) {
+            double d = values[i] - values[i - 1];
+            if (d > 0) {
+                gap = std::min(gap, d);
+            }
+        }
+        return gap;
+    }
+    /* 範囲 [lo, hi] を最小間隔 gap の 1/HAKO_BATTERY_TABLE_SUBDIV で区切った点の数 */
+    static int grid_num(double lo, double hi, double gap, int num_max)
+    {
+        if (!(hi > lo) || !std::isfinite(gap)) {
+            return 1;
+        }
+        double cells = std::ceil((hi - lo) / (gap / HAKO_BATTERY_TABLE_SUBDIV) - 1e-9);
+        return static_cast<int>(std::min(cells, static_cast<double>(num_max - 1))) + 1;
+    }
+    /*
+     * 格子(lo から刻み幅 step)のセルの中にある点での傾きの変化(絶対値)の、
+     * 幅 step の区間ごとの合計の最大値。格子上の点の角は補間で丸められないので数えない
+     * x, y は x の昇順
+     */
+    static double max_slope_change(const std::vector<double>& x, const std::vector<double>& y, double lo, double step)
+    {
+        std::vector<double> change(x.size(), 0.0);
+        for (size_t i = 1; i + 1 < x.size(); i++) {
+            if (!(x[i] > x[i - 1]) || !(x[i + 1] > x[i])) {
+                continue;
+            }
+            double cell = (x[i] - lo) / step;
+            if (std::abs(cell - std::round(cell)) < 1e-9) {
+                continue;
+            }
+            double s0 = (y[i] - y[i - 1]) / (x[i] - x[i - 1]);
+            double s1 = (y[i + 1] - y[i]) / (x[i + 1] - x[i]);
+            change[i] = std::abs(s1 - s0);
+        }
+        double result = 0;
+        for (size_t i = 0; i < x.size(); i++) {
+            double sum = 0;
+            for (size_t j = i; j < x.size() && x[j] <= x[i] + step; j++) {
+                sum += change[j];
+            }
+            result = std::max(result, sum);
+        }
+        return result;
+    }
+    void update_hint(double temperature)
+    {
+        double x = (temperature - temp_min) * temp_inv_step;
+        x = std::min(std::max(x, 0.0), static_cast<double>(temp_num - 1));
+        int i = std::min(static_cast<int>(x), std::max(temp_num - 2, 0));
+        hint_temperature = temperature;
+        hint_row0 = &voltage[i * capacity_num];
+        hint_row1 = (temp_num > 1) ? &voltage[(i + 1) * capacity_num] : hint_row0;
+        hint_weight = (temp_num > 1) ? (x - i) : 0.0;
+    }
+
+public:
+    /*
+     * 1つの折れ線の線形補間(CSV の点をそのまま使う)
+     * 範囲外は端の2点で外挿する
+     */
+    static double interpolate_curve(const std::vector<DischargeData>& data, double capacity)
+    {
+        auto it = std::lower_bound(data.begin(), data.end(), capacity, [](const DischargeData& a, double b) {
+            return a.capacity < b;
+        });
+        if (it == data.begin()) {
+            it = data.begin() + 1;
+        }
+        else if (it == data.end()) {
+            it = data.end() - 1;
+        }
+        const DischargeData& lower = *(it - 1);
+        const DischargeData& upper = *it;
+        double slope = (upper.voltage - lower.voltage) / (upper.capacity - lower.capacity);
+        return lower.voltage + slope * (capacity - lower.capacity);
+    }
+
+    /*
+     * curves: 温度ごとの放電特性(各2点以上、容量でソート済み)
+     * capacity_lo, capacity_hi: 格子に含める放電容量の範囲(CSV の範囲に追加で広げる)
+     */
+    bool build(std::vector<DischargeCurve> curves, double capacity_lo, double capacity_hi)
+    {
+        voltage.clear();
+        temp_num = 0;
+        capacity_num = 0;
+        hint_temperature = std::numeric_limits<double>::quiet_NaN();
+        if (curves.empty()) {
+            std::cerr << "ERROR: battery table: no discharge data" << std::endl;
+            return false;
+        }
+        std::sort(curves.begin(), curves.end(), [](const DischargeCurve& a, const DischargeCurve& b) {
+            return a.temperature < b.temperature;
+        });
+        std::vector<double> temperatures;
+        std::vector<double> capacities;
+        for (const auto& curve : curves) {
+            if (curve.data == nullptr || curve.data->size() < 2) {
+                std::cerr << "ERROR: battery table: insufficient data at temperature " << curve.temperature << std::endl;
+                return false;
+            }
+            temperatures.push_back(curve.temperature);
+            capacity_lo = std::min(capacity_lo, curve.data->front().capacity);
+            capacity_hi = std::max(capacity_hi, curve.data->back().capacity);
+            for (const auto& d : *curve.data) {
+                capacities.push_back(d.capacity);
+            }
+        }
+        temp_min = temperatures.front();
+        temp_num = grid_num(temp_min, temperatures.back(), min_gap(temperatures), HAKO_BATTERY_TABLE_TEMP_NUM_MAX);
+        double temp_step = (temp_num > 1) ? (temperatures.back() - temp_min) / (temp_num - 1) : 0.0;
+        temp_inv_step = (temp_num > 1) ? 1.0 / temp_step : 0.0;
+        capacity_min = capacity_lo;
+        capacity_num = grid_num(capacity_lo, capacity_hi, min_gap(capacities), HAKO_BATTERY_TABLE_CAPACITY_NUM_MAX);
+        double capacity_step = (capacity_num > 1) ? (capacity_hi - capacity_lo) / (capacity_num - 1) : 0.0;
+        capacity_inv_step = (capacity_num > 1) ? 1.0 / capacity_step : 0.0;
+
+        voltage.resize(static_cast<size_t>(temp_num) * capacity_num);
+        size_t upper = 0;
+        for (int t = 0; t < temp_num; t++) {
+            /* 格子の温度を挟む CSV の温度 */
+            double temperature = (t == temp_num - 1) ? temperatures.back() : temp_min + t * temp_step;
+            while (upper + 1 < curves.size() && curves[upper].temperature < temperature) {
+                upper++;
+            }
+            size_t lower = (upper > 0 && curves[upper].temperature > temperature) ? upper - 1 : upper;
+            double w = (upper == lower) ? 0.0 :
+                (temperature - curves[lower].temperature) / (curves[upper].temperature - curves[lower].temperature);
+            for (int c = 0; c < capacity_num; c++) {
+                double capacity = (c == capacity_num - 1) ? capacity_hi : capacity_lo + c * capacity_step;
+                double v0 = interpolate_curve(*curves[lower].data, capacity);
+                double v1 = interpolate_curve(*curves[upper].data, capacity);
+                voltage[t * capacity_num + c] = v0 + w * (v1 - v0);
+            }
+        }
+        /*
+         * 誤差の上限
+         * 放電容量方向: 格子の行は前後の CSV の折れ線の重み付き和なので、各折れ線の値で抑えられる
+         * 温度方向: 容量を固定すると温度に対して折れ線になり、その角は CSV の温度にある。
+         *           傾きの変化は容量について折れ線なので、CSV の容量と範囲の両端で調べればよい
+         */
+        double capacity_change = 0;
+        for (const auto& curve : curves) {
+            std::vector<double> x, y;
+            for (const auto& d : *curve.data) {
+                x.push_back(d.capacity);
+                y.push_back(d.voltage);
+            }
+            capacity_change = std::max(capacity_change, max_slope_change(x, y, capacity_lo, capacity_step));
+        }
+        double temp_change = 0;
+        capacities.push_back(capacity_lo);
+        capacities.push_back(capacity_hi);
+        for (double capacity : capacities) {
+            std::vector<double> y;
+            for (const auto& curve : curves) {
+                y.push_back(interpolate_curve(*curve.data, capacity));
+            }
+            temp_change = std::max(temp_change, max_slope_change(temperatures, y, temp_min, temp_step));
+        }
+        error_bound = capacity_step * capacity_change / 4 + temp_step * temp_change / 4;
+        std::cout << "INFO: battery table: temperature " << temp_num << " x capacity " << capacity_num
+                  << " (" << capacity_lo << " - " << capacity_hi << " Ah), error bound " << error_bound << " V" << std::endl;
+        return true;
+    }
+    bool is_ready() const
+    {
+        return !voltage.empty();
+    }
+    int get_temperature_num() const
+    {
+        return temp_num;
+    }
+    int get_capacity_num() const
+    {
+        return capacity_num;
+    }
+    /*
+     * 格子の範囲内で、CSV の折れ線の補間(温度方向も線形補間)との差の上限(V)
+     */
+    double get_error_bound() const
+    {
+        return error_bound;
+    }
+
+    /*
+     * 電圧(V)
+     * 温度・放電容量は格子の範囲に丸める
+     */
+    double lookup(double temperature, double capacity)
+    {
+        if (temperature != hint_temperature) {
+            update_hint(temperature);
+        }
+        double x = (capacity - capacity_min) * capacity_inv_step;
+        x = std::min(std::max(x, 0.0), static_cast<double>(capacity_num - 1));
+        int i = std::min(static_cast<int>(x), std::max(capacity_num - 2, 0));
+        int j = std::min(i + 1, capacity_num - 1);
+        double u = x - i;
+        double v0 = hint_row0[i] + u * (hint_row0[j] - hint_row0[i]);
+        double v1 = hint_row1[i] + u * (hint_row1[j] - hint_row1[i]);
+        return v0 + hint_weight * (v1 - v0);
+    }
+};
+
+}
+
+#endif /* _BATTERY_DISCHARGE_TABLE_HPP_ */
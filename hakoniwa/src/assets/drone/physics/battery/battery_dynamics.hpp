@@ -5,6 +5,8 @@
 #include "ibattery_dynamics.hpp"
 #include "icurrent_dynamics.hpp"
 #include "utils/icsv_log.hpp"
+#include "utils/csv_logger.hpp"
+#include "battery_discharge_table.hpp"
 #include <math.h>
 #include <iostream>
 #include <fstream>
@@ -12,14 +14,10 @@
 #include <algorithm>
 #include <sstream>
 #include <map>
+#include <filesystem>
 
 namespace hako::assets::drone {
 
-struct DischargeData {
-    double capacity; /* 放電容量 (Ah) */
-    double voltage;  /* 電圧レベル(V) */
-};
-
 class BatteryDynamics : public hako::assets::drone::IBatteryDynamics, public ICsvLog {
 private:
     double current_charge_voltage;
@@ -29,11 +27,23 @@ private:
     double delta_time_sec;
     bool is_battery_model_enabled;
     bool is_battery_mode_constant;
+    bool is_battery_mode_thevenin;
+    /*
+     * thevenin モデルの状態
+     * 分極電圧 V1 は、1ステップの間の電流を一定として厳密に離散化する
+     *   V1[k+1] = rc_decay * V1[k] + rc_gain * I[k]
+     *   rc_decay = exp(-dt / (R1 * C1)), rc_gain = R1 * (1 - rc_decay)
+     */
+    double polarization_voltage;
+    double rc_decay;
+    double rc_gain;
     /* バッテリーの放電特性を決める要因データ */
     /* インデックス番号は、要因IDとして扱う */
     std::vector<BatteryModelFactor> discharge_factors;
     /* 要因IDと放電データのマップ */
     std::map<int, std::vector<DischargeData>> battery_model_map;
+    /* 放電データを展開した (温度, 放電容量) -> 電圧 のテーブル */
+    BatteryDischargeTable discharge_table;
 
 
     /* 1段階目：要因データを読み込み、要因IDを確定する関数 */
@@ -121,21 +131,6 @@ private:
         return discharge_factors.size() - 1;
     }
 
-    /* current_factorの温度に最も近い要因IDを検索する関数 */
-    int findClosestFactorID() {
-        int closest_id = 0;
-        double min_difference = std::abs(current_factor.temperature - discharge_factors[0].temperature);
-
-        for (uint64_t i = 1; i < discharge_factors.size(); ++i) {
-            double difference = std::abs(current_factor.temperature - discharge_factors[i].temperature);
-            if (difference < min_difference) {
-                closest_id = i;
-                min_difference = difference;
-            }
-        }
-        /* std::cout << "INFO: closest factor ID = " << closest_id << " temp: " << discharge_factors[closest_id].temperature << std::endl; */
-        return closest_id;
-    }
     void run_discharged_capacity()
     {
         double discharge_capacity_sec = 0;
@@ -154,57 +149,33 @@ private:
         /* std::cout << "INFO: discharge_capacity_hour = " << this->discharge_capacity_hour << " Ah" << std::endl; */
     }
 
-    /* 2分探索で指定した容量に近い前後のデータを取得する関数（境界条件を考慮） */
-    std::pair<DischargeData, DischargeData> findSurroundingData(double targetCapacity) 
-    {
-        int closest_factor_id = findClosestFactorID();
-        const auto& data = battery_model_map.at(closest_factor_id);        
-        if (data.size() < 2) {
-            throw std::runtime_error("Insufficient data in battery model.");
+    /* 放電データをテーブルに展開する */
+    bool buildDischargeTable() {
+        std::vector<DischargeCurve> curves;
+        for (const auto& [factor_id, data] : battery_model_map) {
+            curves.push_back({ discharge_factors[factor_id].temperature, &data });
         }
-        auto it = std::lower_bound(data.begin(), data.end(), targetCapacity, [&](const DischargeData& a, double b) {
-            return a.capacity < b;
-        });
-
-        /* 境界条件の処理 */
-        if (it == data.begin()) {
-            return { *it, *(it + 1) };
-        } else if (it == data.end()) {
-            return { *(it - 2), *(it - 1) };
-        } else {
-            return { *(it - 1), *it };
-        }
-    }
-
-    /* 線形補間で電圧を計算する関数 */
-    double interpolateVoltage(const DischargeData& lower, const DischargeData& upper, double targetCapacity) {
-        double slope = (upper.voltage - lower.voltage) / (upper.capacity - lower.capacity);
-        return lower.voltage + slope * (targetCapacity - lower.capacity);
+        return discharge_table.build(curves, 0, params.NominalCapacity);
     }
     void run_battery_model()
     {
-        double discharged_capacity = this->discharge_capacity_hour;
-        /* 放電容量は増え続けるため、最大容量を超えたら、最大容量にすることで、電圧レベルを固定値にする */
-        if (discharged_capacity > params.NominalCapacity) {
-            discharged_capacity = params.NominalCapacity;
-        }
-        /* 前後のデータ取得 */
-        auto [lower, upper] = findSurroundingData(discharged_capacity);
-        /* 線形補間で電圧を計算 */
-        double interpolatedVoltage = interpolateVoltage(lower, upper, discharged_capacity);
-        this->current_charge_voltage = interpolatedVoltage;
+        this->current_charge_voltage = open_circuit_voltage(this->discharge_capacity_hour);
     }
     void run_constant_model()
     {
         this->current_charge_voltage = this->params.NominalVoltage;
     }
-    void run_linear_model()
+    /* 開放電圧(放電容量に対する電圧) */
+    double open_circuit_voltage(double discharged_capacity)
     {
-        double discharged_capacity = this->discharge_capacity_hour;
         /* 放電容量は増え続けるため、最大容量を超えたら、最大容量にすることで、電圧レベルを固定値にする */
         if (discharged_capacity > params.NominalCapacity) {
             discharged_capacity = params.NominalCapacity;
         }
+        if (this->is_battery_model_enabled) {
+            /* 温度と放電容量から双線形補間で電圧を計算 */
+            return discharge_table.lookup(current_factor.temperature, discharged_capacity);
+        }
 
         double slope = 0;
         double battery_voltage = 0;
@@ -219,7 +190,28 @@ private:
             slope = (params.VoltageLevelGreen - params.EODVoltage) / (params.NominalCapacity - this->params.CapacityLevelYellow);
             battery_voltage = params.VoltageLevelGreen - (slope * (discharged_capacity - this->params.CapacityLevelYellow));
         }
-        this->current_charge_voltage = battery_voltage;
+        return battery_voltage;
+    }
+    void run_linear_model()
+    {
+        this->current_charge_voltage = open_circuit_voltage(this->discharge_capacity_hour);
+    }
+    /*
+     * 等価回路モデル: V = OCV(放電容量) - R0 * I - V1
+     * linear の開放電圧では、放電容量を温度による実効容量の変化で公称容量に換算する。
+     * CSV のテーブルは温度ごとの特性なので、温度はテーブルの参照だけで反映する
+     */
+    void run_thevenin_model()
+    {
+        double capacity = this->discharge_capacity_hour;
+        if (!this->is_battery_model_enabled) {
+            double scale = 1.0 + params.CapacityTemperatureCoefficient * (current_factor.temperature - params.ReferenceTemperature);
+            capacity = capacity / std::max(scale, 1e-3);
+        }
+        double ocv = open_circuit_voltage(capacity);
+        this->polarization_voltage = (this->rc_decay * this->polarization_voltage) + (this->rc_gain * this->discharge_current);
+        double battery_voltage = ocv - (params.InternalResistance * this->discharge_current) - this->polarization_voltage;
+        this->current_charge_voltage = std::max(battery_voltage, 0.0);
     }
 public:
     virtual ~BatteryDynamics() {}
@@ -232,6 +224,10 @@ public:
         this->discharge_capacity_hour = 0;
         this->is_battery_model_enabled = false;
         this->is_battery_mode_constant = false;
+        this->is_battery_mode_thevenin = false;
+        this->polarization_voltage = 0;
+        this->rc_decay = 0;
+        this->rc_gain = 0;
     }
     void reset() override {
         std::cout << "BatteryDynamics reset" << std::endl;
@@ -239,6 +235,7 @@ public:
         this->accumulated_capacity_sec = 0;
         this->discharge_current = 0;
         this->discharge_capacity_hour = 0;
+        this->polarization_voltage = 0;
         for (auto* entry : devices) {
             entry->discharge_capacity_sec = 0;
         }
@@ -252,6 +249,15 @@ public:
         else {
             this->is_battery_mode_constant = false;
         }
+        this->is_battery_mode_thevenin = (params.model == "thevenin");
+        if (this->is_battery_mode_thevenin) {
+            double tau = params.PolarizationResistance * params.PolarizationCapacitance;
+            this->rc_decay = (tau > 0) ? std::exp(-this->delta_time_sec / tau) : 0.0;
+            this->rc_gain = params.PolarizationResistance * (1.0 - this->rc_decay);
+            std::cout << "INFO: battery thevenin model: R0 = " << params.InternalResistance
+                      << " R1 = " << params.PolarizationResistance
+                      << " C1 = " << params.PolarizationCapacitance << std::endl;
+        }
 
         if (params.BatteryModelCsvFilePath.empty()) {
             std::cout << "BatteryModelCsvFilePath is empty." << std::endl;
@@ -267,7 +273,13 @@ public:
                 /* 2段階目：放電データの読み込みとマップ化 */
                 loadDischargeData(params.BatteryModelCsvFilePath);
 
-                this->is_battery_model_enabled = true;
+                /* 3段階目：(温度, 放電容量) のテーブルに展開 */
+                this->is_battery_model_enabled = buildDischargeTable();
+                if (this->is_battery_model_enabled && this->is_battery_mode_thevenin
+                    && params.CapacityTemperatureCoefficient != 0) {
+                    std::cerr << "WARNING: battery: CapacityTemperatureCoefficient is ignored: "
+                              << "the temperature is taken from " << params.BatteryModelCsvFilePath << std::endl;
+                }
             }
             else {
                 std::cout << "BatteryModelCsvFilePath does not exist." << std::endl;
@@ -283,7 +295,10 @@ public:
         }
         else {
             run_discharged_capacity();
-            if (!this->is_battery_model_enabled) {
+            if (this->is_battery_mode_thevenin) {
+                run_thevenin_model();
+            }
+            else if (!this->is_battery_model_enabled) {
                 run_linear_model();
             }
             else {
@@ -314,6 +329,18 @@ public:
         /* std::cout << "BatteryStatus: " << status.curr_voltage << "V" << std::endl; */
         return status;
     }
+    void add_state_regions(HakoStateRegions& regions) override
+    {
+        regions.add(current_charge_voltage);
+        regions.add(accumulated_capacity_sec);
+        regions.add(discharge_capacity_hour);
+        regions.add(discharge_current);
+        regions.add(polarization_voltage);
+        regions.add(current_factor);
+        for (auto* entry : devices) {
+            regions.add(entry->discharge_capacity_sec);
+        }
+    }
     const std::vector<std::string> log_head() override
     {
         return { "timestamp", "DischargeCurrent", "Voltage", "DischargeCapacity" };
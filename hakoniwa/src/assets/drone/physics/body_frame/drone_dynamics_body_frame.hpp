@@ -322,6 +322,21 @@ public:
         }
         this->total_time_sec += this->delta_time_sec;
     }
+    void add_state_regions(HakoStateRegions& regions) override
+    {
+        regions.add(position);
+        regions.add(velocity);
+        regions.add(angle);
+        regions.add(quaternion);
+        regions.add(quaternion_velocity);
+        regions.add(eulerRate);
+        regions.add(torque);
+        regions.add(thrust);
+        regions.add(ground_height);
+        regions.add(velocityBodyFrame);
+        regions.add(angularVelocityBodyFrame);
+        regions.add(total_time_sec);
+    }
     const std::vector<std::string> log_head() override
     {
         return { "timestamp", "X", "Y", "Z", "Rx", "Ry", "Rz", "Vx", "Vy", "Vz", "VRx", "VRy", "VRz", "Thrust", "Tx", "Ty", "Tz" };
@@ -48,6 +48,10 @@ private:
 
     double delta_time_sec;
     double total_time_sec;
+    /*
+     * matlab model instance (one per vehicle)
+     */
+    mi_drone_model_t* model;
     /*
      * Ground position
      */
@@ -117,9 +121,17 @@ public:
         this->param_collision_detection = false;
         this->param_manual_control = false;
         this->ground_height = 0;
-        mi_drone_acceleration_initialize();
+        this->model = mi_drone_model_create();
+        if (this->model == nullptr) {
+            std::cerr << "ERROR: can not create matlab model instance" << std::endl;
+        }
+    }
+    virtual ~DroneDynamicsBodyFrameMatlab()
+    {
+        mi_drone_model_destroy(this->model);
     }
-    virtual ~DroneDynamicsBodyFrameMatlab() {}
+    DroneDynamicsBodyFrameMatlab(const DroneDynamicsBodyFrameMatlab&) = delete;
+    DroneDynamicsBodyFrameMatlab& operator=(const DroneDynamicsBodyFrameMatlab&) = delete;
     void reset() override
     {
         position = initial_position;
@@ -233,7 +245,8 @@ public:
         in.Izz = param_cz;
         in.gravity = GRAVITY;
         in.drag = param_drag1;
-        mi_drone_acceleration_out_t out = mi_drone_acceleration(&in);
+        mi_drone_acceleration_out_t out;
+        mi_drone_model_step(this->model, &in, &out);
 
         DroneAccelerationBodyFrame acc;
         DroneAngularAccelerationBodyFrame acc_angular;
@@ -307,6 +320,20 @@ public:
         }
         this->total_time_sec += this->delta_time_sec;
     }
+    /*
+     * matlab モデルは加速度の計算のみで、インスタンスに状態を持たない
+     */
+    void add_state_regions(HakoStateRegions& regions) override
+    {
+        regions.add(position);
+        regions.add(velocity);
+        regions.add(angle);
+        regions.add(angularVelocity);
+        regions.add(velocityBodyFrame);
+        regions.add(angularVelocityBodyFrame);
+        regions.add(total_time_sec);
+        regions.add(ground_height);
+    }
     const std::vector<std::string> log_head() override
     {
         return { "timestamp", "X", "Y", "Z", "Rx", "Ry", "Rz" };
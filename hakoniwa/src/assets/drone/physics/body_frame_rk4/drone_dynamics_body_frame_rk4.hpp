@@ -348,6 +348,20 @@ public:
 
         this->total_time_sec += this->delta_time_sec;
     }
+    void add_state_regions(HakoStateRegions& regions) override
+    {
+        regions.add(position);
+        regions.add(velocity);
+        regions.add(angle);
+        regions.add(angularVelocity);
+        regions.add(torque);
+        regions.add(thrust);
+        regions.add(velocityBodyFrame);
+        regions.add(angularVelocityBodyFrame);
+        regions.add(body_wind_disturbance);
+        regions.add(total_time_sec);
+        regions.add(ground_height);
+    }
     const std::vector<std::string> log_head() override
     {
         return { "timestamp", "X", "Y", "Z", "Rx", "Ry", "Rz", "Vx", "Vy", "Vz", "VRx", "VRy", "VRz", "Thrust", "Tx", "Ty", "Tz" };
@@ -260,6 +260,15 @@ public:
         }
         this->total_time_sec += this->delta_time_sec;
     }
+    void add_state_regions(HakoStateRegions& regions) override
+    {
+        regions.add(ground_height);
+        regions.add(position);
+        regions.add(velocity);
+        regions.add(angle);
+        regions.add(angularVelocity);
+        regions.add(total_time_sec);
+    }
     const std::vector<std::string> log_head() override
     {
         return { "timestamp", "X", "Y", "Z", "Rx", "Ry", "Rz" };
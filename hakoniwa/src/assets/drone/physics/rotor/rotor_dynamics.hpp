@@ -7,9 +7,26 @@
 #include "utils/icsv_log.hpp"
 #include "rotor_physics.hpp"
 #include <math.h>
+#include <cmath>
+#include <algorithm>
 
 namespace hako::assets::drone {
 
+/*
+ * ロータの角速度は、1ステップの間の duty(とバッテリー電圧)を一定として、
+ * 微分方程式の解で厳密に更新する(前進オイラー法は、timeStep が時定数に近づくと
+ * 誤差が大きくなり、時定数の2倍を超えると発散する)。
+ *
+ * 1次遅れモデル: dω/dt = (Kr * d - ω) / Tr
+ *   ω' = ω * a + Kr * d * (1 - a), a = exp(-dt / Tr)
+ *
+ * バッテリーモデル: J * R * dω/dt = K * V * d - (Cq * R * ω + K^2 + D * R) * ω
+ *   dω/dt = p - q * ω - c * ω^2 (p = K * V * d / (J * R), q = (K^2 + D * R) / (J * R), c = Cq / J)
+ *   平衡点 ω* = 2p / (q + s), s = sqrt(q^2 + 4cp) からのずれ u = ω - ω* は
+ *   du/dt = -s * u - c * u^2 (ベルヌーイ型)となり、
+ *   u' = u * E / (1 + c * u * (1 - E) / s), E = exp(-s * dt)
+ *   ω >= 0 では分母は E 以上のため、dt によらず発散しない。
+ */
 
 class RotorDynamics : public hako::assets::drone::IRotorDynamics, public hako::assets::drone::ICurrentDynamics, public ICsvLog {
 private:
@@ -24,6 +41,33 @@ private:
     double total_time_sec;
     double current; /* [A] */
     double duty;
+    /* 1次遅れモデルの係数 */
+    double lag_decay = 0;                           /* exp(-dt / Tr) */
+    double lag_gain = 0;                            /* Kr * (1 - exp(-dt / Tr)) */
+    /* バッテリーモデルの係数 */
+    double battery_p_gain = 0;                      /* K / (J * R) */
+    double battery_q = 0;                           /* (K^2 + D * R) / (J * R) */
+    double battery_c = 0;                           /* Cq / J */
+
+    void update_lag_coefficients()
+    {
+        this->lag_decay = std::exp(-this->delta_time_sec / this->param_tr);
+        this->lag_gain = this->param_kr * (1.0 - this->lag_decay);
+    }
+    double next_omega_battery(double vbat, double omega, double duty_rate) const
+    {
+        double p = this->battery_p_gain * vbat * duty_rate;
+        double q = this->battery_q;
+        double c = this->battery_c;
+        double s = std::sqrt(std::max(q * q + 4.0 * c * p, 0.0));
+        double omega_eq = ((q + s) > 0) ? (2.0 * p / (q + s)) : 0.0;
+        double u = omega - omega_eq;
+        double st = s * this->delta_time_sec;
+        double e = std::exp(-st);
+        /* (1 - E) / s, s -> 0 では dt */
+        double f = (st > 1e-12) ? (-std::expm1(-st) / s) : this->delta_time_sec;
+        return omega_eq + (u * e) / (1.0 + c * u * f);
+    }
 
     void run_current(double vbat, double omega, double duty_rate)
     {
@@ -44,6 +88,8 @@ public:
         this->total_time_sec = 0;
         this->speed.data = 0;
         this->current = 0;
+        this->duty = 0;
+        update_lag_coefficients();
     }
     void reset() override
     {
@@ -55,6 +101,9 @@ public:
     {
         battery_dynamics = true;
         this->constants = c;
+        this->battery_p_gain = c.K / (c.J * c.R);
+        this->battery_q = (c.K * c.K + c.D * c.R) / (c.J * c.R);
+        this->battery_c = c.Cq / c.J;
     }
     bool has_battery_dynamics() override
     {
@@ -66,6 +115,7 @@ public:
         this->param_rad_per_sec_max = rad_per_sec_max;
         this->param_tr = tr;
         this->param_kr = kr;
+        update_lag_coefficients();
     }
     void set_rotor_speed(DroneRotorSpeedType &rotor_speed) override 
     {
@@ -85,10 +135,7 @@ public:
     void run(double control) override
     {
         this->duty = control;
-        this->next_speed.data =   (
-                                    drone_physics::rotor_omega_acceleration(param_kr, param_tr, speed.data, control)
-                                  ) * this->delta_time_sec
-                                + this->speed.data;
+        this->next_speed.data = (this->speed.data * this->lag_decay) + (this->lag_gain * control);
         // Cap the next speed at the maximum RPS if it exceeds it
         if (this->next_speed.data > this->param_rad_per_sec_max) {
             this->next_speed.data = this->param_rad_per_sec_max;
@@ -104,10 +151,7 @@ public:
     {
         this->duty = control;
         this->run_current(vbat, this->speed.data, control);
-        this->next_speed.data =   (
-                                    drone_physics::rotor_omega_acceleration(vbat, constants.R, constants.Cq, constants.J, constants.K, constants.D, speed.data, control)
-                                  ) * this->delta_time_sec
-                                + this->speed.data;
+        this->next_speed.data = next_omega_battery(vbat, this->speed.data, control);
         // Cap the next speed at the maximum RPS if it exceeds it
         if (this->next_speed.data > this->param_rad_per_sec_max) {
             this->next_speed.data = this->param_rad_per_sec_max;
@@ -123,6 +167,14 @@ public:
     {
         return this->current;
     }
+    void add_state_regions(HakoStateRegions& regions) override
+    {
+        regions.add(speed);
+        regions.add(next_speed);
+        regions.add(total_time_sec);
+        regions.add(current);
+        regions.add(duty);
+    }
     const std::vector<std::string> log_head() override
     {
         return { "timestamp", "Duty", "RadPerSec", "Current" };
@@ -73,6 +73,11 @@ public:
     {
         return run(control);
     }    
+    void add_state_regions(HakoStateRegions& regions) override
+    {
+        regions.add(w);
+        regions.add(total_time_sec);
+    }
     const std::vector<std::string> log_head() override
     {
         return { "timestamp", "RadPerSec" };
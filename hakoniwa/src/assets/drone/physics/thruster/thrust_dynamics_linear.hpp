@@ -5,6 +5,8 @@
 #include "ithrust_dynamics.hpp"
 #include "utils/icsv_log.hpp"
 #include "rotor_physics.hpp"
+#include "thrust_kernel.hpp"
+#include "utils/hako_utils.hpp"
 #include <glm/glm.hpp>
 #include <iostream>
 
@@ -18,10 +20,12 @@ private:
     double param_Cq;
     DroneThrustType thrust;
     DroneTorqueType torque;
-    RotorConfigType rotor_config[ROTOR_NUM];
-    double omega[ROTOR_NUM];
-    drone_physics::VectorType position[ROTOR_NUM];
-    double ccw[ROTOR_NUM];
+    int rotor_num = ROTOR_NUM;
+    ThrustKernelType kernel = nullptr;
+    RotorConfigType rotor_config[ROTOR_NUM_MAX];
+    double omega[ROTOR_NUM_MAX];
+    drone_physics::VectorType position[ROTOR_NUM_MAX];
+    double ccw[ROTOR_NUM_MAX];
 
 public:
     ThrustDynamicsLinear(double dt)
@@ -53,14 +57,21 @@ public:
         this->param_Cq = Cq;
     }
 
-    void set_rotor_config(const RotorConfigType rotor_config_[ROTOR_NUM]) override
+    void set_rotor_config(const RotorConfigType rotor_config_[], int num = ROTOR_NUM) override
     {
-        for (int i = 0; i < ROTOR_NUM; i++) {
+        HAKO_ASSERT(num > 0 && num <= ROTOR_NUM_MAX);
+        this->rotor_num = num;
+        this->kernel = thrust_kernel_select_linear(num);
+        for (int i = 0; i < num; i++) {
             this->rotor_config[i] = rotor_config_[i];
             this->position[i] = { rotor_config_[i].data.x, rotor_config_[i].data.y, rotor_config_[i].data.z};
             this->ccw[i] = rotor_config_[i].ccw;
         }
     }
+    int get_rotor_num() const override
+    {
+        return this->rotor_num;
+    }
     void set_thrust(const DroneThrustType &_thrust) override 
     {
         this->thrust = _thrust;
@@ -79,13 +90,15 @@ public:
         return this->torque;
     }
 
-    void run(const DroneRotorSpeedType rotor_speed[ROTOR_NUM]) override
+    void run(const DroneRotorSpeedType rotor_speed[]) override
     {
-        for (int i = 0; i < ROTOR_NUM; i++) {
+        for (int i = 0; i < rotor_num; i++) {
             omega[i] = rotor_speed[i].data;
         }
-        this->thrust.data = drone_physics::body_thrust_linear(param_Ct, ROTOR_NUM, omega);
-        this->torque = drone_physics::body_torque_linear(param_Ct, param_Cq, ROTOR_NUM, position, ccw, omega);
+        const ThrustKernelParamType param = { param_Ct, param_Cq, 0, rotor_num, position, ccw };
+        drone_physics::TorqueType body_torque;
+        kernel(param, omega, nullptr, this->thrust.data, body_torque);
+        this->torque = body_torque;
 
         total_time_sec += delta_time_sec;
     }
@@ -98,6 +111,12 @@ public:
                   << " , " << this->torque.data.z 
                   << " )" << std::endl;
     }
+    void add_state_regions(HakoStateRegions& regions) override
+    {
+        regions.add(total_time_sec);
+        regions.add(thrust);
+        regions.add(torque);
+    }
     const std::vector<std::string> log_head() override
     {
         return { "timestamp", "Thrust", "Tx", "Ty", "Tz" };
@@ -5,6 +5,9 @@
 #include "ithrust_dynamics.hpp"
 #include "utils/icsv_log.hpp"
 #include "rotor_physics.hpp"
+#include "thrust_kernel.hpp"
+#include "thrust_kernel_simd.hpp"
+#include "utils/hako_utils.hpp"
 #include <glm/glm.hpp>
 #include <iostream>
 
@@ -19,17 +22,28 @@ private:
     double param_J;
     DroneThrustType thrust;
     DroneTorqueType torque;
-    DroneRotorSpeedType prev_rotor_speed[ROTOR_NUM];
-    RotorConfigType rotor_config[ROTOR_NUM];
-    double omega[ROTOR_NUM];
-    drone_physics::VectorType position[ROTOR_NUM];
-    double ccw[ROTOR_NUM];
-    double omega_acceleration[ROTOR_NUM];
+    int rotor_num = ROTOR_NUM;
+    RotorConfigType rotor_config[ROTOR_NUM_MAX];
+    drone_physics::VectorType position[ROTOR_NUM_MAX];
+    double ccw[ROTOR_NUM_MAX];
+#ifdef HAKO_THRUST_KERNEL_SIMD
+    /* 前回の角速度は simd が持つ */
+    double inv_delta_time_sec;
+    ThrustKernelSimd simd;
+#else
+    ThrustKernelType kernel = nullptr;
+    DroneRotorSpeedType prev_rotor_speed[ROTOR_NUM_MAX] = {};
+    double omega[ROTOR_NUM_MAX];
+    double omega_acceleration[ROTOR_NUM_MAX];
+#endif
 
 public:
     ThrustDynamicsNonLinear(double dt)
     {
         this->delta_time_sec = dt;
+#ifdef HAKO_THRUST_KERNEL_SIMD
+        this->inv_delta_time_sec = 1.0 / dt;
+#endif
         // 1kg の機体が 6000 rpm でホバリングする定数
         // A = mg / (Ω0^2 * ROTOR_NUM)
         this->param_Ct =  GRAVITY / (ROTOR_NUM * HOVERING_ROTOR_RPM * HOVERING_ROTOR_RPM);
@@ -57,13 +71,24 @@ public:
         this->param_J = J;
     }
 
-    void set_rotor_config(const RotorConfigType _rotor_config[ROTOR_NUM]) override
+    void set_rotor_config(const RotorConfigType _rotor_config[], int num = ROTOR_NUM) override
     {
-        for (int i = 0; i < ROTOR_NUM; i++) {
+        HAKO_ASSERT(num > 0 && num <= ROTOR_NUM_MAX);
+        this->rotor_num = num;
+        for (int i = 0; i < num; i++) {
             this->rotor_config[i] = _rotor_config[i];
             this->position[i] = { _rotor_config[i].data.x, _rotor_config[i].data.y, _rotor_config[i].data.z};
             this->ccw[i] = _rotor_config[i].ccw;
         }
+#ifdef HAKO_THRUST_KERNEL_SIMD
+        this->simd.set_geometry(num, this->position, this->ccw);
+#else
+        this->kernel = thrust_kernel_select_nonlinear(num);
+#endif
+    }
+    int get_rotor_num() const override
+    {
+        return this->rotor_num;
     }
     void set_thrust(const DroneThrustType &_thrust) override 
     {
@@ -83,19 +108,30 @@ public:
         return this->torque;
     }
 
-    void run(const DroneRotorSpeedType rotor_speed[ROTOR_NUM]) override
+    void run(const DroneRotorSpeedType rotor_speed[]) override
     {
-        for (int i = 0; i < ROTOR_NUM; i++) {
+#ifdef HAKO_THRUST_KERNEL_SIMD
+        double* lanes = simd.omega_lanes();
+        for (int i = 0; i < rotor_num; i++) {
+            lanes[i] = rotor_speed[i].data;
+        }
+        drone_physics::TorqueType body_torque;
+        simd.run(param_Ct, param_Cq, param_J, inv_delta_time_sec, this->thrust.data, body_torque);
+        this->torque = body_torque;
+#else
+        for (int i = 0; i < rotor_num; i++) {
             omega[i] = rotor_speed[i].data;
             omega_acceleration[i] = (rotor_speed[i].data - this->prev_rotor_speed[i].data) / this->delta_time_sec;
         }
-        this->thrust.data = drone_physics::body_thrust(param_Ct, ROTOR_NUM, omega);
-        this->torque = drone_physics::body_torque(param_Ct, param_Cq, param_J, ROTOR_NUM,
-                                            position, ccw, omega, omega_acceleration);
+        const ThrustKernelParamType param = { param_Ct, param_Cq, param_J, rotor_num, position, ccw };
+        drone_physics::TorqueType body_torque;
+        kernel(param, omega, omega_acceleration, this->thrust.data, body_torque);
+        this->torque = body_torque;
 
-        for (int i = 0; i < ROTOR_NUM; i++) {
+        for (int i = 0; i < rotor_num; i++) {
             this->prev_rotor_speed[i] = rotor_speed[i];
         }
+#endif
 
         total_time_sec += delta_time_sec;
     }
@@ -103,9 +139,13 @@ public:
     {
         this->thrust.data = 0;
         this->torque.data = {0, 0, 0};
-        for (int i = 0; i < ROTOR_NUM; i++) {
+#ifdef HAKO_THRUST_KERNEL_SIMD
+        simd.reset();
+#else
+        for (int i = 0; i < ROTOR_NUM_MAX; i++) {
             this->prev_rotor_speed[i].data = 0;
         }
+#endif
         total_time_sec = 0;
     }
 
@@ -117,6 +157,17 @@ public:
                   << " , " << this->torque.data.z 
                   << " )" << std::endl;
     }
+    void add_state_regions(HakoStateRegions& regions) override
+    {
+        regions.add(total_time_sec);
+        regions.add(thrust);
+        regions.add(torque);
+#ifdef HAKO_THRUST_KERNEL_SIMD
+        simd.add_state_regions(regions);
+#else
+        regions.add(prev_rotor_speed);
+#endif
+    }
     const std::vector<std::string> log_head() override
     {
         return { "timestamp", "Thrust", "Tx", "Ty", "Tz" };
@@ -0,0 +1,119 @@
+#ifndef _THRUST_KERNEL_HPP_
+#define _THRUST_KERNEL_HPP_
+
+/*
+ * 機体の推力・トルク計算(ロータ数ごとの特殊化)
+ *
+ * drone_physics::body_thrust()/body_torque() と同じ式を、ロータ数 N を
+ * コンパイル時定数としたテンプレートで計算する。よく使う機体形状
+ * (4/6/8 ロータ)は set_rotor_config() の時点で特殊化版を選び、ステップ毎の
+ * 分岐やループ回数の判定をなくす。それ以外のロータ数は drone_physics の
+ * 汎用版で計算する。
+ */
+#include "ithrust_dynamics.hpp"
+#include "rotor_physics.hpp"
+
+namespace hako::assets::drone {
+
+typedef struct {
+    double Ct;
+    double Cq;
+    double J;                                           /* 線形モデルでは未使用 */
+    int rotor_num;
+    const drone_physics::VectorType *position;
+    const double *ccw;
+} ThrustKernelParamType;
+
+typedef void (*ThrustKernelType)(const ThrustKernelParamType& param, const double* omega,
+                                 const double* omega_acceleration, double& thrust, drone_physics::TorqueType& torque);
+
+/*
+ * 非線形モデル: T = Ct * Omega^2, Ta = ccw * (Cq * Omega^2 + J * dOmega/dt)
+ */
+template <int N>
+inline void thrust_kernel_nonlinear(const ThrustKernelParamType& param, const double* omega,
+                                    const double* omega_acceleration, double& thrust, drone_physics::TorqueType& torque)
+{
+    double total_thrust = 0;
+    drone_physics::TorqueType total_torque = { 0, 0, 0 };
+    for (int i = 0; i < N; i++) {
+        double t = drone_physics::rotor_thrust(param.Ct, omega[i]);
+        total_thrust += t;
+        /* cross(position, {0, 0, -t}) */
+        total_torque.x += param.position[i].y * (-t);
+        total_torque.y -= param.position[i].x * (-t);
+        total_torque.z += drone_physics::rotor_anti_torque(param.Cq, param.J, omega[i], omega_acceleration[i], param.ccw[i]);
+    }
+    thrust = total_thrust;
+    torque = total_torque;
+}
+inline void thrust_kernel_nonlinear_generic(const ThrustKernelParamType& param, const double* omega,
+                                            const double* omega_acceleration, double& thrust, drone_physics::TorqueType& torque)
+{
+    thrust = drone_physics::body_thrust(param.Ct, param.rotor_num, const_cast<double*>(omega));
+    torque = drone_physics::body_torque(param.Ct, param.Cq, param.J, param.rotor_num,
+                                        const_cast<drone_physics::VectorType*>(param.position), const_cast<double*>(param.ccw),
+                                        const_cast<double*>(omega), const_cast<double*>(omega_acceleration));
+}
+
+/*
+ * 線形モデル(jMAVsim 互換): T = Ct * Omega, Ta = ccw * Cq * Omega
+ */
+template <int N>
+inline void thrust_kernel_linear(const ThrustKernelParamType& param, const double* omega,
+                                 const double* /* omega_acceleration */, double& thrust, drone_physics::TorqueType& torque)
+{
+    double total_thrust = 0;
+    drone_physics::TorqueType total_torque = { 0, 0, 0 };
+    for (int i = 0; i < N; i++) {
+        double t = drone_physics::rotor_thrust_linear(param.Ct, omega[i]);
+        total_thrust += t;
+        total_torque.x += param.position[i].y * (-t);
+        total_torque.y -= param.position[i].x * (-t);
+        total_torque.z += drone_physics::rotor_anti_torque_linear(param.Cq, omega[i], param.ccw[i]);
+    }
+    thrust = total_thrust;
+    torque = total_torque;
+}
+inline void thrust_kernel_linear_generic(const ThrustKernelParamType& param, const double* omega,
+                                         const double* /* omega_acceleration */, double& thrust, drone_physics::TorqueType& torque)
+{
+    thrust = drone_physics::body_thrust_linear(param.Ct, param.rotor_num, const_cast<double*>(omega));
+    torque = drone_physics::body_torque_linear(param.Ct, param.Cq, param.rotor_num,
+                                               const_cast<drone_physics::VectorType*>(param.position),
+                                               const_cast<double*>(param.ccw), const_cast<double*>(omega));
+}
+
+/*
+ * ロータ数に応じたカーネルの選択(セットアップ時に1回だけ呼ぶ)
+ */
+inline ThrustKernelType thrust_kernel_select_nonlinear(int rotor_num)
+{
+    switch (rotor_num) {
+    case 4:
+        return thrust_kernel_nonlinear<4>;
+    case 6:
+        return thrust_kernel_nonlinear<6>;
+    case 8:
+        return thrust_kernel_nonlinear<8>;
+    default:
+        return thrust_kernel_nonlinear_generic;
+    }
+}
+inline ThrustKernelType thrust_kernel_select_linear(int rotor_num)
+{
+    switch (rotor_num) {
+    case 4:
+        return thrust_kernel_linear<4>;
+    case 6:
+        return thrust_kernel_linear<6>;
+    case 8:
+        return thrust_kernel_linear<8>;
+    default:
+        return thrust_kernel_linear_generic;
+    }
+}
+
+}
+
+#endif /* _THRUST_KERNEL_HPP_ */
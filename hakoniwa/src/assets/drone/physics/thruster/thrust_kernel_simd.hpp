@@ -0,0 +1,152 @@
+#ifndef _THRUST_KERNEL_SIMD_HPP_
+#define _THRUST_KERNEL_SIMD_HPP_
+
+/*
+ * 非線形モデルの推力・トルク計算(固定幅 SIMD 版)
+ *
+ * T = Ct * Omega^2, Ta = ccw * (Cq * Omega^2 + J * (Omega - Omega_prev) / dt) を、
+ * ロータを 4 レーン単位(1-4 ロータは 4、5-8 ロータは 8 レーン)にまとめて1回の走査で計算する。
+ *
+ * ロータの位置・回転方向は set_geometry() の時点でレーン毎の配列(SoA)に詰めておく。
+ * 余ったレーンは位置・回転方向・角速度が 0 のため、合計に影響しない。
+ * 角加速度はカーネルの中で前回の角速度との差分から求め、1/dt は事前に計算しておく。
+ *
+ * GCC/Clang のベクトル拡張で書いている。ベクトル型の幅はターゲットのレジスタ幅に合わせ、
+ * AVX が有効(-march で指定)なら 4 要素、それ以外(SSE2/NEON)は 2 要素とする。
+ * レジスタより広いベクトル型は、スカラーの複製がメモリ経由になり遅くなるため使わない。
+ * ベクトル拡張がないコンパイラでは HAKO_THRUST_KERNEL_SIMD が定義されず、
+ * 呼び出し側はスカラー版(thrust_kernel.hpp)を使う。
+ */
+#include "ithrust_dynamics.hpp"
+#include "rotor_physics.hpp"
+#include "utils/hako_state_snapshot.hpp"
+#include <cstring>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define HAKO_THRUST_KERNEL_SIMD
+#endif
+
+#ifdef HAKO_THRUST_KERNEL_SIMD
+
+namespace hako::assets::drone {
+
+#ifdef __AVX__
+const int THRUST_VECTOR_WIDTH = 4;
+#else
+const int THRUST_VECTOR_WIDTH = 2;
+#endif
+typedef double ThrustVectorType __attribute__((vector_size(THRUST_VECTOR_WIDTH * sizeof(double))));
+const int THRUST_LANE_WIDTH = 4;
+const int THRUST_LANE_MAX = ((ROTOR_NUM_MAX + THRUST_LANE_WIDTH - 1) / THRUST_LANE_WIDTH) * THRUST_LANE_WIDTH;
+
+class ThrustKernelSimd {
+private:
+    int lanes = 0;
+    alignas(32) double px[THRUST_LANE_MAX] = {};
+    alignas(32) double py[THRUST_LANE_MAX] = {};
+    alignas(32) double ccw[THRUST_LANE_MAX] = {};
+    alignas(32) double omega[THRUST_LANE_MAX] = {};
+    alignas(32) double prev_omega[THRUST_LANE_MAX] = {};
+
+    /* 値渡しは AVX の有無で ABI が変わるため、参照で受け渡す */
+    static void load(ThrustVectorType& v, const double* p)
+    {
+        std::memcpy(&v, p, sizeof(v));
+    }
+    static double sum(const ThrustVectorType& v)
+    {
+        double total = 0;
+        for (int i = 0; i < THRUST_VECTOR_WIDTH; i++) {
+            total += v[i];
+        }
+        return total;
+    }
+    /* L: 計算するレーン数 */
+    template <int L>
+    void run_lanes(double Ct, double Cq, double J_inv_dt, double& thrust, drone_physics::TorqueType& torque)
+    {
+        ThrustVectorType ct = Ct - ThrustVectorType{};
+        ThrustVectorType cq = Cq - ThrustVectorType{};
+        ThrustVectorType jdt = J_inv_dt - ThrustVectorType{};
+        ThrustVectorType total_thrust = {};
+        ThrustVectorType total_x = {};
+        ThrustVectorType total_y = {};
+        ThrustVectorType total_z = {};
+        for (int k = 0; k < L; k += THRUST_VECTOR_WIDTH) {
+            ThrustVectorType w, wp, x, y, c;
+            load(w, &omega[k]);
+            load(wp, &prev_omega[k]);
+            load(x, &px[k]);
+            load(y, &py[k]);
+            load(c, &ccw[k]);
+            ThrustVectorType w2 = w * w;
+            ThrustVectorType t = ct * w2;
+            total_thrust += t;
+            /* cross(position, {0, 0, -t}) = { -y * t, x * t, 0 } */
+            total_x += y * t;
+            total_y += x * t;
+            total_z += c * (cq * w2 + jdt * (w - wp));
+        }
+        thrust = sum(total_thrust);
+        torque = { -sum(total_x), sum(total_y), sum(total_z) };
+    }
+
+public:
+    /*
+     * ロータの形状をレーン毎の配列に詰める(ロータ数が変わった時だけ呼ぶ)
+     */
+    void set_geometry(int rotor_num, const drone_physics::VectorType* position, const double* _ccw)
+    {
+        lanes = ((rotor_num + THRUST_LANE_WIDTH - 1) / THRUST_LANE_WIDTH) * THRUST_LANE_WIDTH;
+        for (int i = 0; i < THRUST_LANE_MAX; i++) {
+            bool used = (i < rotor_num);
+            px[i] = used ? position[i].x : 0;
+            py[i] = used ? position[i].y : 0;
+            ccw[i] = used ? _ccw[i] : 0;
+            omega[i] = 0;
+            prev_omega[i] = 0;
+        }
+    }
+    int get_lanes() const
+    {
+        return lanes;
+    }
+    /* 角速度の入力先(余ったレーンは 0 のまま) */
+    double* omega_lanes()
+    {
+        return omega;
+    }
+    void reset()
+    {
+        for (int i = 0; i < THRUST_LANE_MAX; i++) {
+            omega[i] = 0;
+            prev_omega[i] = 0;
+        }
+    }
+    /*
+     * 状態は前回の角速度のみ(omega は run() の前に毎回書く)
+     */
+    void add_state_regions(HakoStateRegions& regions)
+    {
+        regions.add(prev_omega);
+    }
+    /*
+     * omega_lanes() に書いた角速度で推力・トルクを計算し、前回の角速度として保存する
+     */
+    void run(double Ct, double Cq, double J, double inv_dt, double& thrust, drone_physics::TorqueType& torque)
+    {
+        if (lanes > THRUST_LANE_WIDTH) {
+            run_lanes<THRUST_LANE_MAX>(Ct, Cq, J * inv_dt, thrust, torque);
+        }
+        else {
+            run_lanes<THRUST_LANE_WIDTH>(Ct, Cq, J * inv_dt, thrust, torque);
+        }
+        std::memcpy(prev_omega, omega, sizeof(prev_omega));
+    }
+};
+
+}
+
+#endif /* HAKO_THRUST_KERNEL_SIMD */
+
+#endif /* _THRUST_KERNEL_SIMD_HPP_ */
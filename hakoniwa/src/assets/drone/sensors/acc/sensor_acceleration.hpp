@@ -51,6 +51,16 @@ public:
         return value;
     }
 
+    void add_state_regions(HakoStateRegions& regions) override
+    {
+        regions.add(total_time_sec);
+        regions.add(this->has_prev_data);
+        regions.add(this->prev_data);
+        this->acc_x.add_state_regions(regions);
+        this->acc_y.add_state_regions(regions);
+        this->acc_z.add_state_regions(regions);
+        this->add_noise_state_regions(regions);
+    }
     void print() override
     {
         auto result = sensor_value();
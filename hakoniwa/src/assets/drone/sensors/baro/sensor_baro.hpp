@@ -57,6 +57,12 @@ public:
         }
         return value;
     }
+    void add_state_regions(HakoStateRegions& regions) override
+    {
+        regions.add(total_time_sec);
+        this->asm_alt.add_state_regions(regions);
+        this->add_noise_state_regions(regions);
+    }
     void print() override
     {
         auto result = sensor_value();
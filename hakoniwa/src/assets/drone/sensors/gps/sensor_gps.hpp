@@ -114,6 +114,19 @@ public:
         value.num_satelites_visible = 10;
         return value;
     }
+    void add_state_regions(HakoStateRegions& regions) override
+    {
+        regions.add(total_time_sec);
+        this->asm_lat.add_state_regions(regions);
+        this->asm_lon.add_state_regions(regions);
+        this->asm_alt.add_state_regions(regions);
+        this->asm_vel.add_state_regions(regions);
+        this->asm_vn.add_state_regions(regions);
+        this->asm_ve.add_state_regions(regions);
+        this->asm_vd.add_state_regions(regions);
+        this->asm_cog.add_state_regions(regions);
+        this->add_noise_state_regions(regions);
+    }
     void print() override
     {
         auto result = sensor_value();
@@ -67,6 +67,17 @@ public:
         }
         return value;
     }
+    /*
+     * vendor モデル(context)の内部状態は含まない
+     */
+    void add_state_regions(HakoStateRegions& regions) override
+    {
+        regions.add(total_time_sec);
+        this->gyro_x.add_state_regions(regions);
+        this->gyro_y.add_state_regions(regions);
+        this->gyro_z.add_state_regions(regions);
+        this->add_noise_state_regions(regions);
+    }
     void print() override
     {
         auto result = sensor_value();
@@ -103,6 +103,14 @@ public:
         }
         return value;
     }
+    void add_state_regions(HakoStateRegions& regions) override
+    {
+        regions.add(total_time_sec);
+        this->mag_x.add_state_regions(regions);
+        this->mag_y.add_state_regions(regions);
+        this->mag_z.add_state_regions(regions);
+        this->add_noise_state_regions(regions);
+    }
     void print() override
     {
         auto result = sensor_value();
@@ -3,13 +3,19 @@
 
 #include "isensor_data_assembler.hpp"
 #include <vector>
-#include <numeric> 
 
 namespace hako::assets::drone {
 
+/*
+ * 直近 sample_num 個の移動平均
+ * データは固定長のリングバッファに置く(追加でメモリ確保・移動をせず、
+ * 状態のスナップショットの領域も変わらない)
+ */
 class SensorDataAssembler : public hako::assets::drone::ISensorDataAssembler {
 private:
     std::vector<double> data_vector;
+    int head = 0;   /* 最も古いデータの位置 */
+    int count = 0;
     SensorDataAssembler() {}
 public:
     SensorDataAssembler(int sample_num) 
@@ -17,32 +23,67 @@ public:
         this->set_sample_num(sample_num);
     }
     virtual ~SensorDataAssembler() {}
+    void set_sample_num(int n) override
+    {
+        ISensorDataAssembler::set_sample_num(n);
+        data_vector.assign((n > 0) ? n : 0, 0.0);
+        head = 0;
+        count = 0;
+    }
     void add_data(double data) override
     {
-        data_vector.push_back(data);
-        if (data_vector.size() > (unsigned long)sample_num) {
-            data_vector.erase(data_vector.begin());
+        if (sample_num <= 0) {
+            return;
+        }
+        if (count < sample_num) {
+            int tail = head + count;
+            if (tail >= sample_num) {
+                tail -= sample_num;
+            }
+            data_vector[tail] = data;
+            count++;
+        }
+        else {
+            data_vector[head] = data;
+            if (++head >= sample_num) {
+                head = 0;
+            }
         }
     }
     double get_calculated_value() override
     {
-        if (!data_vector.empty()) {
-            double sum = std::accumulate(data_vector.begin(), data_vector.end(), 0.0);
-            return sum / (double)data_vector.size();
+        if (count > 0) {
+            /* 古い順に足す */
+            double sum = 0.0;
+            int k = head;
+            for (int i = 0; i < count; i++) {
+                sum += data_vector[k];
+                if (++k >= sample_num) {
+                    k = 0;
+                }
+            }
+            return sum / (double)count;
         } else {
             return 0.0;
         }
     }
     void reset() override
     {
-        data_vector.clear();
+        head = 0;
+        count = 0;
     }
     int size() override
     {
-        return data_vector.size();
+        return count;
+    }
+    void add_state_regions(HakoStateRegions& regions) override
+    {
+        regions.add_array(data_vector.data(), data_vector.size());
+        regions.add(head);
+        regions.add(count);
     }
 };
 
 }
 
-#endif /* _SENSOR_DATA_ASSEMBLER_HPP_ */
\ No newline at end of file
+#endif /* _SENSOR_DATA_ASSEMBLER_HPP_ */
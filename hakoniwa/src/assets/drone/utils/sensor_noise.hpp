@@ -9,12 +9,34 @@
 
 namespace hako::assets::drone {
 
+/*
+ * 機体・センサを指定したノイズは、乱数の系列をインスタンスごとに持つ
+ * (状態のスナップショットで系列も保存・復元する)。
+ * 指定しないノイズは従来どおり rand() を使う(系列はスナップショットに含まれない)。
+ */
 class SensorNoise : public hako::assets::drone::ISensorNoise {
 private:
     double stdDev;
+    std::minstd_rand engine;
+    bool use_engine = false;
     SensorNoise() {}
+    double uniform()
+    {
+        if (!use_engine) {
+            return static_cast<double>(rand()) / RAND_MAX;
+        }
+        return static_cast<double>(engine() - engine.min()) / (engine.max() - engine.min());
+    }
 public:
     SensorNoise(double v) : stdDev(v) {}
+    /*
+     * 機体(index)・センサ(sensor_id)ごとに異なる系列にする
+     */
+    SensorNoise(double v, int index, int sensor_id) : stdDev(v), use_engine(true)
+    {
+        std::seed_seq seq{ index, sensor_id };
+        engine.seed(seq);
+    }
     virtual ~SensorNoise() {}
 
     double add_random_noise(double data) override
@@ -24,8 +46,8 @@ public:
         double b0, b1;
 
         do {
-            b0 = static_cast<double>(rand()) / RAND_MAX;
-            b1 = static_cast<double>(rand()) / RAND_MAX;
+            b0 = uniform();
+            b1 = uniform();
         } while (b0 <= std::numeric_limits<float>::min());
 
         x0 = sqrt(-2.0 * log(b0)) * cos(M_PI * 2.0 * b1);
@@ -36,9 +58,13 @@ public:
 
         return data + (x0 * stdDev);
     }
+    void add_state_regions(HakoStateRegions& regions) override
+    {
+        regions.add(engine);
+    }
 
 };
 
 }
 
-#endif /* _SENSOR_NOISE_HPP_ */
\ No newline at end of file
+#endif /* _SENSOR_NOISE_HPP_ */
@@ -0,0 +1,63 @@
+#include "hako_shm_client.h"
+#include "shm_ring.hpp"
+#include <new>
+
+using namespace hako::px4::comm::shm;
+
+struct hako_shm_client {
+    ShmSegmentType* segment;
+};
+
+extern "C" {
+
+hako_shm_client_t* hako_shm_client_open(int portno)
+{
+    ShmSegmentType* seg = shm_segment_attach(portno);
+    if (seg == nullptr) {
+        return nullptr;
+    }
+    hako_shm_client_t* client = new (std::nothrow) hako_shm_client_t;
+    if (client == nullptr) {
+        shm_segment_detach(seg);
+        return nullptr;
+    }
+    client->segment = seg;
+    return client;
+}
+
+int hako_shm_client_send(hako_shm_client_t* client, const void* data, int len)
+{
+    if (client == nullptr || data == nullptr || len <= 0) {
+        return -1;
+    }
+    if (!shm_ring_push(&client->segment->ring[HAKO_SHM_RING_UP], data, static_cast<uint32_t>(len))) {
+        return -1;
+    }
+    return len;
+}
+
+int hako_shm_client_recv(hako_shm_client_t* client, void* buf, int len)
+{
+    if (client == nullptr || buf == nullptr || len <= 0) {
+        return -1;
+    }
+    uint32_t recv_len = 0;
+    int ret = shm_ring_pop(&client->segment->ring[HAKO_SHM_RING_DOWN], buf, static_cast<uint32_t>(len), &recv_len);
+    if (ret <= 0) {
+        return ret;
+    }
+    return static_cast<int>(recv_len);
+}
+
+void hako_shm_client_close(hako_shm_client_t* client)
+{
+    if (client == nullptr) {
+        return;
+    }
+    shm_ring_close(&client->segment->ring[HAKO_SHM_RING_UP]);
+    shm_ring_close(&client->segment->ring[HAKO_SHM_RING_DOWN]);
+    shm_segment_detach(client->segment);
+    delete client;
+}
+
+} // extern "C"
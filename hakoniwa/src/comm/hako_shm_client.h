@@ -0,0 +1,33 @@
+#ifndef _HAKO_SHM_CLIENT_H_
+#define _HAKO_SHM_CLIENT_H_
+
+/*
+ * PX4 SITL 側から hako-px4sim の共有メモリ transport に接続するための
+ * 最小限の C インタフェース(libhako_shm_client).
+ * portno は hako-px4sim に渡す TCP ポート番号(機体ごとに +1)と同じ値を使う。
+ * メッセージ単位(MAVLink パケット単位)で送受信する。
+ */
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+typedef struct hako_shm_client hako_shm_client_t;
+
+/* return NULL if the server segment is not ready yet (caller retries) */
+extern hako_shm_client_t* hako_shm_client_open(int portno);
+/* return sent bytes, -1 on error */
+extern int hako_shm_client_send(hako_shm_client_t* client, const void* data, int len);
+/*
+ * blocking. return received bytes, 0 if closed, -1 on error.
+ * A message larger than len is dropped and -1 is returned; the connection stays
+ * open and the next call receives the next message.
+ */
+extern int hako_shm_client_recv(hako_shm_client_t* client, void* buf, int len);
+extern void hako_shm_client_close(hako_shm_client_t* client);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _HAKO_SHM_CLIENT_H_ */
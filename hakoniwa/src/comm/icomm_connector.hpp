@@ -13,12 +13,24 @@ namespace hako::px4::comm {
         virtual ~ICommIO() = default;
         virtual bool send(const char* data, int datalen, int* send_datalen) = 0;
         virtual bool recv(char* data, int datalen, int* recv_datalen) = 0;
+        /* send() をまとめて送信する transport 向け. それ以外は何もしない */
+        virtual bool flush() { return true; }
+        /*
+         * recv()/send() でブロックしているスレッドを起こす(fd は閉じない).
+         * スレッドを join してから close() する. 対応しない transport は何もしない
+         */
+        virtual bool shutdown() { return true; }
         virtual bool close() = 0;
     };
 
     class ICommServer {
     public:
         virtual ~ICommServer() = default;
+        /*
+         * 接続待ちの準備(bind/listen など)だけを先に行う. server_open() は
+         * 準備済みの endpoint があればそれを使って接続を待つ.
+         */
+        virtual bool server_bind(IcommEndpointType *endpoint) { (void)endpoint; return true; }
         virtual ICommIO* server_open(IcommEndpointType *endpoint) = 0;
     };
 
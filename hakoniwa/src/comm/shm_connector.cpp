@@ -0,0 +1,159 @@
+#include "shm_connector.hpp"
+#include <chrono>
+#include <iostream>
+
+#define MAX_ATTEMPTS 600
+#define RETRY_INTERVAL 3
+
+namespace hako::px4::comm {
+
+ShmCommIO::ShmCommIO(shm::ShmSegmentType *segment, int portno, bool is_server)
+    : segment(segment), portno(portno), is_server(is_server)
+{
+    if (is_server) {
+        tx = &segment->ring[HAKO_SHM_RING_DOWN];
+        rx = &segment->ring[HAKO_SHM_RING_UP];
+    }
+    else {
+        tx = &segment->ring[HAKO_SHM_RING_UP];
+        rx = &segment->ring[HAKO_SHM_RING_DOWN];
+    }
+}
+
+ShmCommIO::~ShmCommIO() {
+    close();
+}
+
+bool ShmCommIO::send(const char* data, int datalen, int* send_datalen) {
+    if (segment == nullptr || !data || datalen <= 0) return false;
+
+    if (!shm::shm_ring_push(tx, data, static_cast<uint32_t>(datalen))) {
+        return false;
+    }
+    if (send_datalen) {
+        *send_datalen = datalen;
+    }
+    return true;
+}
+
+bool ShmCommIO::recv(char* data, int datalen, int* recv_datalen) {
+    if (segment == nullptr || !data || datalen <= 0) return false;
+
+    uint32_t len = 0;
+    int ret;
+    while ((ret = shm::shm_ring_pop(rx, data, static_cast<uint32_t>(datalen), &len)) < 0) {
+        /* 大きすぎるメッセージは読み捨てて、次のメッセージを待つ(接続は維持する) */
+        std::cerr << "ERROR: shm recv buffer too small: " << datalen << " < " << len << ", dropped" << std::endl;
+    }
+    if (ret == 0) {
+        return false;
+    }
+    if (recv_datalen) {
+        *recv_datalen = static_cast<int>(len);
+    }
+    return true;
+}
+
+bool ShmCommIO::close() {
+    if (segment != nullptr) {
+        shm::shm_ring_close(tx);
+        shm::shm_ring_close(rx);
+        shm::shm_segment_detach(segment);
+        if (is_server) {
+            shm::shm_segment_remove(portno);
+        }
+        segment = nullptr;
+    }
+    return true;
+}
+
+ShmClient::ShmClient() {}
+
+ShmClient::~ShmClient() {}
+
+ICommIO* ShmClient::client_open(IcommEndpointType*, IcommEndpointType *dst) {
+    int attempt = 0;
+    shm::ShmSegmentType* seg = nullptr;
+    while ((seg = shm::shm_segment_attach(dst->portno)) == nullptr) {
+        if (++attempt >= MAX_ATTEMPTS) {
+            std::cerr << "Failed to attach shm after " << MAX_ATTEMPTS << " attempts: port=" << dst->portno << std::endl;
+            return nullptr;
+        }
+        std::cout << "Shm attach attempt " << attempt << " failed, retrying..." << std::endl;
+        sleep(RETRY_INTERVAL);
+    }
+    return new ShmCommIO(seg, dst->portno, false);
+}
+
+/*
+ * 既定の待ち時間は ShmClient::client_open() の再試行と同じ
+ */
+ShmServer::ShmServer() : accept_timeout_sec(MAX_ATTEMPTS * RETRY_INTERVAL) {}
+
+ShmServer::ShmServer(int accept_timeout_sec) : accept_timeout_sec(accept_timeout_sec) {}
+
+ShmServer::~ShmServer() {
+    for (auto& entry : segments) {
+        shm::shm_segment_detach(entry.second);
+        shm::shm_segment_remove(entry.first);
+    }
+}
+
+/*
+ * セグメントだけ先に作っておく(PX4 側はどの順番で attach してもよい)
+ */
+bool ShmServer::server_bind(IcommEndpointType *endpoint) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (segments.count(endpoint->portno) > 0) {
+        return true;
+    }
+    shm::ShmSegmentType* seg = shm::shm_segment_create(endpoint->portno);
+    if (seg == nullptr) {
+        std::cerr << "Failed to create shm segment: port=" << endpoint->portno << std::endl;
+        return false;
+    }
+    segments[endpoint->portno] = seg;
+    return true;
+}
+
+ICommIO* ShmServer::server_open(IcommEndpointType *endpoint) {
+    if (!server_bind(endpoint)) {
+        return nullptr;
+    }
+    shm::ShmSegmentType* seg;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        seg = segments[endpoint->portno];
+        segments.erase(endpoint->portno);
+    }
+    std::cout << "Waiting for shm client on port " << endpoint->portno << std::endl;
+    // TcpServer::server_open() の accept() と同様に、相手が来るまで待つ
+    // (attach は client_attached の doorbell で通知される)
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(accept_timeout_sec);
+    while (seg->client_attached.load(std::memory_order_acquire) == 0) {
+        if (stopping.load(std::memory_order_acquire)) {
+            std::cerr << "ERROR: shm server stopped while waiting for client on port " << endpoint->portno << std::endl;
+            shm::shm_segment_detach(seg);
+            shm::shm_segment_remove(endpoint->portno);
+            return nullptr;
+        }
+        if ((accept_timeout_sec > 0) && (std::chrono::steady_clock::now() >= deadline)) {
+            std::cerr << "ERROR: shm client did not attach within " << accept_timeout_sec << " sec on port " << endpoint->portno << std::endl;
+            shm::shm_segment_detach(seg);
+            shm::shm_segment_remove(endpoint->portno);
+            return nullptr;
+        }
+        shm::shm_doorbell_wait(&seg->client_attached, 0);
+    }
+    std::cout << "Shm client attached on port " << endpoint->portno << std::endl;
+    return new ShmCommIO(seg, endpoint->portno, true);
+}
+
+/*
+ * 接続待ちの server_open() を終わらせる
+ */
+void ShmServer::stop() {
+    stopping.store(true, std::memory_order_release);
+}
+
+} // namespace hako::px4::comm
@@ -0,0 +1,65 @@
+#ifndef _SHMCONNECTOR_HPP_
+#define _SHMCONNECTOR_HPP_
+
+#include "icomm_connector.hpp"
+#include "shm_ring.hpp"
+#include <atomic>
+#include <map>
+#include <mutex>
+
+namespace hako::px4::comm {
+
+/*
+ * 同一ホスト上の PX4 SITL 向けの共有メモリ transport.
+ * endpoint の portno ごとに1セグメントを作るため、TCP と同じポート番号の
+ * 割り当てで複数機体を扱える(ipaddr は使わない)。
+ */
+class ShmCommIO : public ICommIO {
+private:
+    shm::ShmSegmentType *segment;
+    shm::ShmRingType *tx;
+    shm::ShmRingType *rx;
+    int portno;
+    bool is_server;
+
+public:
+    ShmCommIO(shm::ShmSegmentType *segment, int portno, bool is_server);
+    ~ShmCommIO() override;
+
+    bool send(const char* data, int datalen, int* send_datalen) override;
+    bool recv(char* data, int datalen, int* recv_datalen) override;
+    bool close() override;
+};
+
+class ShmClient : public ICommClient {
+public:
+    ShmClient();
+    ~ShmClient() override;
+
+    ICommIO* client_open(IcommEndpointType *src, IcommEndpointType *dst) override;
+};
+
+/*
+ * server_open() は client が attach するまで待つ。
+ * accept_timeout_sec(0 なら無制限)を過ぎるか stop() を呼ぶと nullptr を返す。
+ */
+class ShmServer : public ICommServer {
+private:
+    std::mutex mutex;
+    std::map<int, shm::ShmSegmentType*> segments;   // server_bind() 済みで未接続のセグメント
+    int accept_timeout_sec;
+    std::atomic<bool> stopping { false };
+
+public:
+    ShmServer();
+    ShmServer(int accept_timeout_sec);
+    ~ShmServer() override;
+
+    bool server_bind(IcommEndpointType *endpoint) override;
+    ICommIO* server_open(IcommEndpointType *endpoint) override;
+    void stop();
+};
+
+} // namespace hako::px4::comm
+
+#endif /* _SHMCONNECTOR_HPP_ */
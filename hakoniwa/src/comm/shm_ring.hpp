@@ -0,0 +1,256 @@
+#ifndef _SHM_RING_HPP_
+#define _SHM_RING_HPP_
+
+/*
+ * 共有メモリ上の SPSC リング(1 producer / 1 consumer)
+ *
+ * 同一ホストの PX4 SITL と hako-px4sim 間でメッセージ単位(4byte 長 + payload)
+ * のデータを受け渡す。セグメント内にリングを2本(PX4 -> sim, sim -> PX4)持つ。
+ * 待ち合わせは Linux では共有 futex(doorbell) で行い、それ以外の POSIX では
+ * 短い usleep によるポーリングになる。
+ *
+ * ShmCommIO(hako-px4sim 側)と hako_shm_client(PX4 側のシム)の両方から使う
+ * ため、ヘッダだけで完結させている。
+ */
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <time.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+namespace hako::px4::comm::shm {
+
+#define HAKO_SHM_COMM_MAGICNO       0x48534D43  /* "HSMC" */
+#define HAKO_SHM_COMM_VERSION       1
+#define HAKO_SHM_COMM_RING_SIZE     (64 * 1024) /* must be power of 2 */
+#define HAKO_SHM_COMM_NAME_FMT      "/hako_px4sim_shm_%d"
+#define HAKO_SHM_COMM_CACHELINE     64
+#define HAKO_SHM_COMM_MODE          0600        /* 同じユーザのプロセスのみ */
+
+static_assert((HAKO_SHM_COMM_RING_SIZE & (HAKO_SHM_COMM_RING_SIZE - 1)) == 0, "ring size must be power of 2");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be 32bit");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared atomics must be lock free");
+
+typedef struct {
+    alignas(HAKO_SHM_COMM_CACHELINE) std::atomic<uint32_t> head;    /* producer が書く */
+    alignas(HAKO_SHM_COMM_CACHELINE) std::atomic<uint32_t> tail;    /* consumer が書く */
+    alignas(HAKO_SHM_COMM_CACHELINE) std::atomic<uint32_t> doorbell;
+    std::atomic<uint32_t> waiters;
+    std::atomic<uint32_t> closed;
+    alignas(HAKO_SHM_COMM_CACHELINE) uint8_t data[HAKO_SHM_COMM_RING_SIZE];
+} ShmRingType;
+
+#define HAKO_SHM_RING_UP        0   /* PX4(client) -> sim(server) */
+#define HAKO_SHM_RING_DOWN      1   /* sim(server) -> PX4(client) */
+
+typedef struct {
+    uint32_t magicno;
+    uint32_t version;
+    std::atomic<uint32_t> server_ready;
+    std::atomic<uint32_t> client_attached;
+    ShmRingType ring[2];
+} ShmSegmentType;
+
+static inline void shm_segment_name(int portno, char* name, size_t len)
+{
+    snprintf(name, len, HAKO_SHM_COMM_NAME_FMT, portno);
+}
+
+static inline void shm_doorbell_wait(std::atomic<uint32_t>* word, uint32_t expected)
+{
+#ifdef __linux__
+    /* 共有マッピング上の futex なので FUTEX_PRIVATE_FLAG は付けない */
+    struct timespec ts = { 0, 10 * 1000 * 1000 }; /* closed を拾うためのタイムアウト */
+    (void)syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, &ts, nullptr, 0);
+#else
+    if (word->load(std::memory_order_acquire) == expected) {
+        usleep(50);
+    }
+#endif
+}
+static inline void shm_doorbell_wake(std::atomic<uint32_t>* word)
+{
+#ifdef __linux__
+    (void)syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+static inline void shm_ring_init(ShmRingType* ring)
+{
+    ring->head.store(0, std::memory_order_relaxed);
+    ring->tail.store(0, std::memory_order_relaxed);
+    ring->doorbell.store(0, std::memory_order_relaxed);
+    ring->waiters.store(0, std::memory_order_relaxed);
+    ring->closed.store(0, std::memory_order_release);
+}
+
+static inline void shm_ring_copy_in(ShmRingType* ring, uint32_t pos, const void* src, uint32_t len)
+{
+    uint32_t off = pos & (HAKO_SHM_COMM_RING_SIZE - 1);
+    uint32_t first = HAKO_SHM_COMM_RING_SIZE - off;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(&ring->data[off], src, first);
+    memcpy(&ring->data[0], static_cast<const uint8_t*>(src) + first, len - first);
+}
+static inline void shm_ring_copy_out(const ShmRingType* ring, uint32_t pos, void* dst, uint32_t len)
+{
+    uint32_t off = pos & (HAKO_SHM_COMM_RING_SIZE - 1);
+    uint32_t first = HAKO_SHM_COMM_RING_SIZE - off;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(dst, &ring->data[off], first);
+    memcpy(static_cast<uint8_t*>(dst) + first, &ring->data[0], len - first);
+}
+
+/*
+ * 1メッセージ書き込む。空きが無い場合は consumer が読み進めるまで待つ。
+ * return: true 成功, false 相手が close 済み or メッセージが大きすぎる
+ */
+static inline bool shm_ring_push(ShmRingType* ring, const void* data, uint32_t len)
+{
+    const uint32_t need = static_cast<uint32_t>(sizeof(uint32_t)) + len;
+    if (need > HAKO_SHM_COMM_RING_SIZE) {
+        return false;
+    }
+    uint32_t head = ring->head.load(std::memory_order_relaxed);
+    while ((head - ring->tail.load(std::memory_order_acquire)) + need > HAKO_SHM_COMM_RING_SIZE) {
+        if (ring->closed.load(std::memory_order_acquire)) {
+            return false;
+        }
+        usleep(10);
+    }
+    shm_ring_copy_in(ring, head, &len, sizeof(uint32_t));
+    shm_ring_copy_in(ring, head + sizeof(uint32_t), data, len);
+    ring->head.store(head + need, std::memory_order_release);
+
+    ring->doorbell.fetch_add(1, std::memory_order_release);
+    if (ring->waiters.load(std::memory_order_acquire) > 0) {
+        shm_doorbell_wake(&ring->doorbell);
+    }
+    return true;
+}
+
+/*
+ * 1メッセージ読み込む。データが無い場合は doorbell で待つ。
+ * return: 1 成功, 0 相手が close 済み,
+ *         -1 バッファが小さすぎる(そのメッセージは読み捨て、*recv_len にその長さを返す)
+ */
+static inline int shm_ring_pop(ShmRingType* ring, void* data, uint32_t datalen, uint32_t* recv_len)
+{
+    uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+    while (true) {
+        uint32_t seq = ring->doorbell.load(std::memory_order_acquire);
+        if (ring->head.load(std::memory_order_acquire) != tail) {
+            break;
+        }
+        if (ring->closed.load(std::memory_order_acquire)) {
+            return 0;
+        }
+        ring->waiters.fetch_add(1, std::memory_order_acq_rel);
+        if (ring->head.load(std::memory_order_acquire) == tail) {
+            shm_doorbell_wait(&ring->doorbell, seq);
+        }
+        ring->waiters.fetch_sub(1, std::memory_order_acq_rel);
+    }
+    uint32_t len;
+    shm_ring_copy_out(ring, tail, &len, sizeof(uint32_t));
+    *recv_len = len;
+    if (len > datalen) {
+        /* 残すと以後のメッセージも読めなくなるため、読み進める */
+        ring->tail.store(tail + static_cast<uint32_t>(sizeof(uint32_t)) + len, std::memory_order_release);
+        return -1;
+    }
+    shm_ring_copy_out(ring, tail + sizeof(uint32_t), data, len);
+    ring->tail.store(tail + static_cast<uint32_t>(sizeof(uint32_t)) + len, std::memory_order_release);
+    return 1;
+}
+
+static inline void shm_ring_close(ShmRingType* ring)
+{
+    ring->closed.store(1, std::memory_order_release);
+    ring->doorbell.fetch_add(1, std::memory_order_release);
+    shm_doorbell_wake(&ring->doorbell);
+}
+
+/*
+ * セグメントの作成(server) / 接続(client)
+ */
+static inline ShmSegmentType* shm_segment_create(int portno)
+{
+    char name[64];
+    shm_segment_name(portno, name, sizeof(name));
+    (void)shm_unlink(name);
+    int fd = shm_open(name, O_CREAT | O_RDWR, HAKO_SHM_COMM_MODE);
+    if (fd < 0) {
+        return nullptr;
+    }
+    if (ftruncate(fd, sizeof(ShmSegmentType)) < 0) {
+        ::close(fd);
+        return nullptr;
+    }
+    void* addr = mmap(nullptr, sizeof(ShmSegmentType), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        return nullptr;
+    }
+    ShmSegmentType* seg = static_cast<ShmSegmentType*>(addr);
+    seg->version = HAKO_SHM_COMM_VERSION;
+    seg->client_attached.store(0, std::memory_order_relaxed);
+    shm_ring_init(&seg->ring[HAKO_SHM_RING_UP]);
+    shm_ring_init(&seg->ring[HAKO_SHM_RING_DOWN]);
+    seg->magicno = HAKO_SHM_COMM_MAGICNO;
+    seg->server_ready.store(1, std::memory_order_release);
+    return seg;
+}
+static inline ShmSegmentType* shm_segment_attach(int portno)
+{
+    char name[64];
+    shm_segment_name(portno, name, sizeof(name));
+    int fd = shm_open(name, O_RDWR, HAKO_SHM_COMM_MODE);
+    if (fd < 0) {
+        return nullptr;
+    }
+    void* addr = mmap(nullptr, sizeof(ShmSegmentType), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        return nullptr;
+    }
+    ShmSegmentType* seg = static_cast<ShmSegmentType*>(addr);
+    if (seg->server_ready.load(std::memory_order_acquire) == 0
+        || seg->magicno != HAKO_SHM_COMM_MAGICNO || seg->version != HAKO_SHM_COMM_VERSION) {
+        munmap(addr, sizeof(ShmSegmentType));
+        return nullptr;
+    }
+    seg->client_attached.store(1, std::memory_order_release);
+    shm_doorbell_wake(&seg->client_attached);
+    return seg;
+}
+static inline void shm_segment_detach(ShmSegmentType* seg)
+{
+    if (seg != nullptr) {
+        munmap(seg, sizeof(ShmSegmentType));
+    }
+}
+static inline void shm_segment_remove(int portno)
+{
+    char name[64];
+    shm_segment_name(portno, name, sizeof(name));
+    (void)shm_unlink(name);
+}
+
+} // namespace hako::px4::comm::shm
+
+#endif /* _SHM_RING_HPP_ */
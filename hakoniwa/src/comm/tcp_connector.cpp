@@ -9,6 +9,7 @@
 #pragma comment(lib, "Ws2_32.lib")
 #else
 #include <arpa/inet.h>  // for inet_pton
+#include <sys/socket.h> // for shutdown
 #include <unistd.h>
 #endif
 #include <string.h>
@@ -110,16 +111,46 @@ ICommIO* TcpClient::client_open(IcommEndpointType *src, IcommEndpointType *dst)
 
 TcpServer::TcpServer() {}
 
-TcpServer::~TcpServer() {}
-
+TcpServer::~TcpServer() {
+    for (auto& entry : listen_sockets) {
 #ifdef WIN32
-ICommIO* TcpServer::server_open(IcommEndpointType* endpoint) {
+        closesocket((SOCKET)entry.second);
+#else
+        ::close((int)entry.second);
+#endif
+    }
+}
 
+/*
+ * server_bind() で bind/listen したソケットを portno ごとに保持しておき、
+ * server_open() では accept() だけを行う。複数機体のポートを先に全部 bind して
+ * おけば、PX4 側はどの順番で接続してもよい。
+ */
+bool TcpServer::take_listen_socket(int portno, uintptr_t* sockfd)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = listen_sockets.find(portno);
+    if (it == listen_sockets.end()) {
+        return false;
+    }
+    *sockfd = it->second;
+    listen_sockets.erase(it);
+    return true;
+}
+
+#ifdef WIN32
+bool TcpServer::server_bind(IcommEndpointType* endpoint) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (listen_sockets.count(endpoint->portno) > 0) {
+            return true;
+        }
+    }
     SOCKET sockfd = socket(AF_INET, SOCK_STREAM, 0);
     if (sockfd == INVALID_SOCKET) {
         std::cerr << "Failed to create socket: " << WSAGetLastError() << std::endl;
         WSACleanup();
-        return nullptr;
+        return false;
     }
 
     char optval = 1;
@@ -127,7 +158,7 @@ ICommIO* TcpServer::server_open(IcommEndpointType* endpoint) {
         std::cerr << "Failed to set SO_REUSEADDR: " << WSAGetLastError() << std::endl;
         closesocket(sockfd);
         WSACleanup();
-        return nullptr;
+        return false;
     }
 
     struct sockaddr_in local_addr;
@@ -140,15 +171,28 @@ ICommIO* TcpServer::server_open(IcommEndpointType* endpoint) {
         std::cerr << "Failed to bind socket: " << WSAGetLastError() << std::endl;
         closesocket(sockfd);
         WSACleanup();
-        return nullptr;
+        return false;
     }
 
     if (listen(sockfd, 1) == SOCKET_ERROR) {
         std::cerr << "Failed to listen on socket: " << WSAGetLastError() << std::endl;
         closesocket(sockfd);
         WSACleanup();
-        return nullptr;
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    listen_sockets[endpoint->portno] = (uintptr_t)sockfd;
+    return true;
+}
+
+ICommIO* TcpServer::server_open(IcommEndpointType* endpoint) {
+    uintptr_t listen_fd;
+    if (!take_listen_socket(endpoint->portno, &listen_fd)) {
+        if (!server_bind(endpoint) || !take_listen_socket(endpoint->portno, &listen_fd)) {
+            return nullptr;
+        }
     }
+    SOCKET sockfd = (SOCKET)listen_fd;
 
     struct sockaddr_in remote_addr;
     int addr_len = sizeof(remote_addr);
@@ -159,21 +203,28 @@ ICommIO* TcpServer::server_open(IcommEndpointType* endpoint) {
         WSACleanup();
         return nullptr;
     }
+    closesocket(sockfd);
     return new TcpCommIO(client_sockfd);
 }
 #else
-ICommIO* TcpServer::server_open(IcommEndpointType *endpoint) {
+bool TcpServer::server_bind(IcommEndpointType *endpoint) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (listen_sockets.count(endpoint->portno) > 0) {
+            return true;
+        }
+    }
     int sockfd = socket(AF_INET, SOCK_STREAM, 0);
     if (sockfd < 0) {
         std::cout << "Failed to create socket: " << strerror(errno) << std::endl;
-        return nullptr;
+        return false;
     }
     // SO_REUSEADDR オプションを設定
     int optval = 1;
     if (setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval)) < 0) {
         std::cout << "Failed to set SO_REUSEADDR: " << strerror(errno) << std::endl;
         ::close(sockfd);
-        return nullptr;
+        return false;
     }
     struct sockaddr_in local_addr;
     memset(&local_addr, 0, sizeof(local_addr));
@@ -183,14 +234,27 @@ ICommIO* TcpServer::server_open(IcommEndpointType *endpoint) {
     if (bind(sockfd, (struct sockaddr*)&local_addr, sizeof(local_addr)) < 0) {
         std::cout << "Failed to bind socket: " << strerror(errno) << std::endl;
         ::close(sockfd);
-        return nullptr;
+        return false;
     }
 
     if (listen(sockfd, 1) < 0) {
         std::cout << "Failed to listen on socket: " << strerror(errno) << std::endl;
         ::close(sockfd);
-        return nullptr;
+        return false;
     }
+    std::lock_guard<std::mutex> lock(mutex);
+    listen_sockets[endpoint->portno] = (uintptr_t)sockfd;
+    return true;
+}
+
+ICommIO* TcpServer::server_open(IcommEndpointType *endpoint) {
+    uintptr_t listen_fd;
+    if (!take_listen_socket(endpoint->portno, &listen_fd)) {
+        if (!server_bind(endpoint) || !take_listen_socket(endpoint->portno, &listen_fd)) {
+            return nullptr;
+        }
+    }
+    int sockfd = (int)listen_fd;
 
     struct sockaddr_in remote_addr;
     socklen_t addr_len = sizeof(remote_addr);
@@ -200,6 +264,8 @@ ICommIO* TcpServer::server_open(IcommEndpointType *endpoint) {
         ::close(sockfd);
         return nullptr;
     }
+    /* 1ポート1接続なので、listen ソケットはここで閉じる */
+    ::close(sockfd);
 
     return new TcpCommIO(client_sockfd);
 }
@@ -332,8 +398,24 @@ bool TcpCommIO::send(const char* data, int datalen, int* send_datalen) {
 #endif
 
 #ifdef WIN32
+bool TcpCommIO::shutdown() {
+    if (sockfd < 0) {
+        return true;
+    }
+    if (::shutdown(sockfd, SD_BOTH) == SOCKET_ERROR) {
+        std::cerr << "Failed to shutdown socket: " << WSAGetLastError() << std::endl;
+        return false;
+    }
+    return true;
+}
+
 bool TcpCommIO::close() {
-    if (closesocket(sockfd) == SOCKET_ERROR) {
+    if (sockfd < 0) {
+        return true;
+    }
+    int fd = sockfd;
+    sockfd = -1;
+    if (closesocket(fd) == SOCKET_ERROR) {
         std::cerr << "Failed to close socket: " << WSAGetLastError() << std::endl;
         return false;
     }
@@ -341,8 +423,25 @@ bool TcpCommIO::close() {
 }
 
 #else
+bool TcpCommIO::shutdown() {
+    if (sockfd < 0) {
+        return true;
+    }
+    if (::shutdown(sockfd, SHUT_RDWR) < 0) {
+        std::cout << "Failed to shutdown socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
 bool TcpCommIO::close() {
-    if (::close(sockfd) < 0) {
+    if (sockfd < 0) {
+        return true;
+    }
+    /* デストラクタからも呼ばれるので、2回目は何もしない */
+    int fd = sockfd;
+    sockfd = -1;
+    if (::close(fd) < 0) {
         std::cout << "Failed to close socket: " << strerror(errno) << std::endl;
         return false;
     }
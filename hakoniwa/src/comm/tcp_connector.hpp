@@ -2,6 +2,9 @@
 #define _TCPCONNECTOR_HPP_
 
 #include "icomm_connector.hpp"
+#include <cstdint>
+#include <map>
+#include <mutex>
 
 namespace hako::px4::comm {
 
@@ -15,6 +18,7 @@ public:
 
     bool send(const char* data, int datalen, int* send_datalen) override;
     bool recv(char* data, int datalen, int* recv_datalen) override;
+    bool shutdown() override;
     bool close() override;
 };
 
@@ -30,11 +34,15 @@ public:
 
 class TcpServer : public ICommServer {
 private:
+    std::mutex mutex;
+    std::map<int, uintptr_t> listen_sockets;    // portno -> listen ソケット
+    bool take_listen_socket(int portno, uintptr_t* sockfd);
 
 public:
     TcpServer();
     ~TcpServer() override;
 
+    bool server_bind(IcommEndpointType *endpoint) override;
     ICommIO* server_open(IcommEndpointType *endpoint) override;
 };
 
@@ -1,25 +1,108 @@
 #include "udp_connector.hpp"
 #include <cstring>      // for std::memset
+#include <iostream>
+#include <errno.h>
 #include <unistd.h>     // for close
 #include <arpa/inet.h>  // for inet_pton
 
 namespace hako::px4::comm {
 
+bool udp_socket_set_options(int sockfd, const UdpSocketOptionType& opt)
+{
+    if (opt.rcvbuf_size > 0) {
+        if (setsockopt(sockfd, SOL_SOCKET, SO_RCVBUF, &opt.rcvbuf_size, sizeof(opt.rcvbuf_size)) < 0) {
+            std::cerr << "Failed to set SO_RCVBUF: " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
+    if (opt.sndbuf_size > 0) {
+        if (setsockopt(sockfd, SOL_SOCKET, SO_SNDBUF, &opt.sndbuf_size, sizeof(opt.sndbuf_size)) < 0) {
+            std::cerr << "Failed to set SO_SNDBUF: " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * まとめて受信する. Linux 以外では recvfrom 1回分だけ読む。
+ * UDP_COMM_DATAGRAM_MAX を超えたデータグラムの len は UDP_COMM_DATAGRAM_MAX + 1 になる。
+ * return: 受信したデータグラム数(エラー時 -1)
+ */
+static int udp_recv_batch(int sockfd, char buffer[][UDP_COMM_DATAGRAM_MAX], int len[], struct sockaddr_in addr[], int num)
+{
+#ifdef __linux__
+    struct mmsghdr msgs[UDP_COMM_BATCH_NUM];
+    struct iovec iovecs[UDP_COMM_BATCH_NUM];
+    if (num > UDP_COMM_BATCH_NUM) {
+        num = UDP_COMM_BATCH_NUM;
+    }
+    std::memset(msgs, 0, sizeof(msgs[0]) * num);
+    for (int i = 0; i < num; i++) {
+        iovecs[i].iov_base = buffer[i];
+        iovecs[i].iov_len = UDP_COMM_DATAGRAM_MAX;
+        msgs[i].msg_hdr.msg_iov = &iovecs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_name = &addr[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(addr[i]);
+    }
+    // 1つ目が届くまでブロックし、その時点で溜まっている分をまとめて読む
+    int n = recvmmsg(sockfd, msgs, num, MSG_WAITFORONE, nullptr);
+    for (int i = 0; i < n; i++) {
+        len[i] = static_cast<int>(msgs[i].msg_len);
+        if ((msgs[i].msg_hdr.msg_flags & MSG_TRUNC) != 0) {
+            // バッファに収まらず切り詰められた
+            len[i] = UDP_COMM_DATAGRAM_MAX + 1;
+        }
+    }
+    return n;
+#else
+    (void)num;
+    // 切り詰めは検出できない(MSG_TRUNC の戻り値は Linux 依存)
+    socklen_t addr_len = sizeof(addr[0]);
+    int n = recvfrom(sockfd, buffer[0], UDP_COMM_DATAGRAM_MAX, 0, (struct sockaddr*)&addr[0], &addr_len);
+    if (n < 0) {
+        return -1;
+    }
+    len[0] = n;
+    return 1;
+#endif
+}
+
 UdpCommIO::UdpCommIO(int sockfd, const sockaddr_in& remote_addr) : sockfd(sockfd), remote_addr(remote_addr) {}
 
 UdpCommIO::~UdpCommIO() {
     close();
 }
 
+bool UdpCommIO::fill_rx_buffer() {
+    int n = udp_recv_batch(sockfd, rx_buffer, rx_len, rx_addr, UDP_COMM_BATCH_NUM);
+    if (n <= 0) {
+        return false;
+    }
+    rx_num = n;
+    rx_pos = 0;
+    return true;
+}
 
 bool UdpCommIO::recv(char* data, int datalen, int* recv_datalen) {
     if(sockfd < 0 || !data || datalen <= 0) return false;
 
-    socklen_t addr_len = sizeof(remote_addr);
-    int bytes_received = recvfrom(sockfd, data, datalen, 0, (struct sockaddr*)&remote_addr, &addr_len);
-    if(bytes_received < 0) {
+    if (rx_pos >= rx_num) {
+        if (!fill_rx_buffer()) {
+            return false;
+        }
+    }
+    int bytes_received = rx_len[rx_pos];
+    if (bytes_received > UDP_COMM_DATAGRAM_MAX || bytes_received > datalen) {
+        std::cerr << "WARNING: udp datagram dropped: size=" << bytes_received << " buffer=" << datalen << std::endl;
+        rx_pos++;
         return false;
     }
+    std::memcpy(data, rx_buffer[rx_pos], bytes_received);
+    // 返信先は最後に受信した相手
+    remote_addr = rx_addr[rx_pos];
+    rx_pos++;
 
     if(recv_datalen) {
         *recv_datalen = bytes_received;
@@ -42,6 +125,13 @@ bool UdpCommIO::send(const char* data, int datalen, int* send_datalen) {
 
     return true;
 }
+bool UdpCommIO::shutdown() {
+    if(sockfd >= 0) {
+        // 未接続の UDP ソケットでは ENOTCONN になるが、recvfrom で待っているスレッドは起きる
+        ::shutdown(sockfd, SHUT_RDWR);
+    }
+    return true;
+}
 bool UdpCommIO::close() {
     if(sockfd >= 0) {
         ::close(sockfd);
@@ -52,6 +142,10 @@ bool UdpCommIO::close() {
 
 UdpClient::UdpClient() {
     std::memset(&local_addr, 0, sizeof(local_addr));
+    option = { 0, 0 };
+}
+UdpClient::UdpClient(const UdpSocketOptionType& opt) : UdpClient() {
+    option = opt;
 }
 
 UdpClient::~UdpClient() {}
@@ -61,19 +155,25 @@ ICommIO* UdpClient::client_open(IcommEndpointType *src, IcommEndpointType *dst)
     if(sockfd < 0) {
         return nullptr;
     }
-
-    local_addr.sin_family = AF_INET;
-    local_addr.sin_port = htons(src->portno);
-    inet_pton(AF_INET, src->ipaddr, &(local_addr.sin_addr));
+    if (!udp_socket_set_options(sockfd, option)) {
+        ::close(sockfd);
+        return nullptr;
+    }
 
     struct sockaddr_in remote_addr;
+    std::memset(&remote_addr, 0, sizeof(remote_addr));
     remote_addr.sin_family = AF_INET;
     remote_addr.sin_port = htons(dst->portno);
     inet_pton(AF_INET, dst->ipaddr, &(remote_addr.sin_addr));
 
-    if(bind(sockfd, (struct sockaddr *)&local_addr, sizeof(local_addr)) < 0) {
-        ::close(sockfd);
-        return nullptr;
+    if (src != nullptr) {
+        local_addr.sin_family = AF_INET;
+        local_addr.sin_port = htons(src->portno);
+        inet_pton(AF_INET, src->ipaddr, &(local_addr.sin_addr));
+        if(bind(sockfd, (struct sockaddr *)&local_addr, sizeof(local_addr)) < 0) {
+            ::close(sockfd);
+            return nullptr;
+        }
     }
 
     return new UdpCommIO(sockfd, remote_addr);
@@ -81,6 +181,10 @@ ICommIO* UdpClient::client_open(IcommEndpointType *src, IcommEndpointType *dst)
 
 UdpServer::UdpServer() {
     std::memset(&local_addr, 0, sizeof(local_addr));
+    option = { 0, 0 };
+}
+UdpServer::UdpServer(const UdpSocketOptionType& opt) : UdpServer() {
+    option = opt;
 }
 
 UdpServer::~UdpServer() {}
@@ -90,6 +194,10 @@ ICommIO* UdpServer::server_open(IcommEndpointType *endpoint) {
     if(sockfd < 0) {
         return nullptr;
     }
+    if (!udp_socket_set_options(sockfd, option)) {
+        ::close(sockfd);
+        return nullptr;
+    }
 
     local_addr.sin_family = AF_INET;
     local_addr.sin_port = htons(endpoint->portno);
@@ -101,7 +209,328 @@ ICommIO* UdpServer::server_open(IcommEndpointType *endpoint) {
     }
 
     struct sockaddr_in remote_addr;  // このアドレスは、recvfromで設定される
+    std::memset(&remote_addr, 0, sizeof(remote_addr));
     return new UdpCommIO(sockfd, remote_addr);
 }
 
+/*
+ * UdpMuxCommIO
+ */
+bool UdpMuxCommIO::send(const char* data, int datalen, int* send_datalen) {
+    if (!server->send(channel, data, datalen)) {
+        return false;
+    }
+    if (send_datalen) {
+        *send_datalen = datalen;
+    }
+    return true;
+}
+bool UdpMuxCommIO::recv(char* data, int datalen, int* recv_datalen) {
+    return server->recv(channel, data, datalen, recv_datalen);
+}
+bool UdpMuxCommIO::flush() {
+    return server->flush();
+}
+bool UdpMuxCommIO::close() {
+    //ソケットは全機体で共有しているので UdpMuxServer::close() で閉じる
+    return true;
+}
+
+/*
+ * UdpMuxServer
+ */
+UdpMuxServer::UdpMuxServer() {
+    option = { 0, 0 };
+    tx_batch.reserve(UDP_COMM_BATCH_NUM);
+}
+UdpMuxServer::UdpMuxServer(const UdpSocketOptionType& opt) : UdpMuxServer() {
+    option = opt;
+}
+UdpMuxServer::~UdpMuxServer() {
+    close();
+}
+
+bool UdpMuxServer::open_socket(IcommEndpointType *endpoint) {
+    sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sockfd < 0) {
+        std::cerr << "Failed to create socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+    if (!udp_socket_set_options(sockfd, option)) {
+        ::close(sockfd);
+        sockfd = -1;
+        return false;
+    }
+    // endpoint のポートは PX4 側が bind するので、こちらは空きポートを使う
+    struct sockaddr_in local_addr;
+    std::memset(&local_addr, 0, sizeof(local_addr));
+    local_addr.sin_family = AF_INET;
+    local_addr.sin_port = htons(0);
+    local_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(sockfd, (struct sockaddr *)&local_addr, sizeof(local_addr)) < 0) {
+        std::cerr << "Failed to bind socket: " << strerror(errno) << std::endl;
+        ::close(sockfd);
+        sockfd = -1;
+        return false;
+    }
+    base_portno = endpoint->portno;
+    running = true;
+    rx_thread = std::thread(&UdpMuxServer::rx_loop, this);
+    std::cout << "INFO: udp mux server on port " << get_local_portno() << ", px4 base port " << base_portno << std::endl;
+    return true;
+}
+
+/*
+ * 最初に呼ばれた endpoint の portno が基準ポートになるため、複数機体を並行して
+ * server_open() する場合は、先に小さいポートから順に server_bind() しておく。
+ */
+bool UdpMuxServer::server_bind(IcommEndpointType *endpoint) {
+    std::lock_guard<std::mutex> lock(channels_mutex);
+    if (sockfd < 0) {
+        if (!open_socket(endpoint)) {
+            return false;
+        }
+    }
+    int channel = endpoint->portno - base_portno;
+    if (channel < 0) {
+        std::cerr << "ERROR: udp mux port must be larger than " << base_portno << std::endl;
+        return false;
+    }
+    while ((int)channels.size() <= channel) {
+        channels.push_back(std::make_unique<Channel>());
+        Channel& ch = *channels.back();
+        std::memset(&ch.peer_addr, 0, sizeof(ch.peer_addr));
+        ch.peer_addr.sin_family = AF_INET;
+        ch.peer_addr.sin_port = htons(base_portno + (int)channels.size() - 1);
+        inet_pton(AF_INET, endpoint->ipaddr, &(ch.peer_addr.sin_addr));
+        ch.remote_addr = ch.peer_addr;
+    }
+    return true;
+}
+
+ICommIO* UdpMuxServer::server_open(IcommEndpointType *endpoint) {
+    if (!server_bind(endpoint)) {
+        return nullptr;
+    }
+    return new UdpMuxCommIO(this, endpoint->portno - base_portno);
+}
+
+UdpMuxServer::Channel* UdpMuxServer::get_channel(int channel) {
+    std::lock_guard<std::mutex> lock(channels_mutex);
+    if (channel < 0 || channel >= (int)channels.size()) {
+        return nullptr;
+    }
+    return channels[channel].get();
+}
+
+int UdpMuxServer::get_local_portno() {
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    if (sockfd < 0 || getsockname(sockfd, (struct sockaddr*)&addr, &addr_len) < 0) {
+        return -1;
+    }
+    return ntohs(addr.sin_port);
+}
+
+bool UdpMuxServer::get_channel_stats(int channel, UdpMuxChannelStatsType& stats) {
+    Channel* ch = get_channel(channel);
+    if (ch == nullptr) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(ch->mutex);
+    stats.dropped = ch->dropped;
+    stats.oversize = ch->oversize;
+    return true;
+}
+
+/*
+ * MAVLink v1: STX(0xFE) len seq sysid ...
+ * MAVLink v2: STX(0xFD) len incompat compat seq sysid ...
+ */
+static int mavlink_packet_sysid(const char* data, int len)
+{
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+    if (len >= 6 && p[0] == 0xFD) {
+        return p[5];
+    }
+    if (len >= 4 && p[0] == 0xFE) {
+        return p[3];
+    }
+    return -1;
+}
+
+/*
+ * 送信元が機体の endpoint と一致すればその機体, そうでなければ sysid で探す
+ */
+UdpMuxServer::Channel* UdpMuxServer::find_channel(const char* data, int len, const struct sockaddr_in& from) {
+    Channel* ch = get_channel(static_cast<int>(ntohs(from.sin_port)) - base_portno);
+    if (ch != nullptr && ch->peer_addr.sin_addr.s_addr == from.sin_addr.s_addr) {
+        return ch;
+    }
+    if (len > UDP_COMM_DATAGRAM_MAX) {
+        return nullptr;
+    }
+    int sysid = mavlink_packet_sysid(data, len);
+    return (sysid > 0) ? get_channel(sysid - 1) : nullptr;
+}
+
+void UdpMuxServer::dispatch(const char* data, int len, const struct sockaddr_in& from) {
+    Channel* ch = find_channel(data, len, from);
+    if (ch == nullptr) {
+        return;
+    }
+    if (len > UDP_COMM_DATAGRAM_MAX) {
+        uint64_t count;
+        {
+            std::lock_guard<std::mutex> lock(ch->mutex);
+            count = ++ch->oversize;
+        }
+        if ((count % 100) == 1) {
+            std::cerr << "WARNING: udp datagram larger than " << UDP_COMM_DATAGRAM_MAX
+                      << " bytes dropped: port=" << ntohs(ch->peer_addr.sin_port) << " total=" << count << std::endl;
+        }
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(ch->mutex);
+        ch->remote_addr = from;
+        if ((ch->head - ch->tail) >= UDP_COMM_CHANNEL_QUEUE_NUM) {
+            // 古いものから捨てる(UDP と同じく遅れたデータより新しいデータを優先)
+            ch->tail++;
+            ch->dropped++;
+        }
+        unsigned idx = ch->head % UDP_COMM_CHANNEL_QUEUE_NUM;
+        std::memcpy(ch->queue[idx], data, len);
+        ch->queue_len[idx] = len;
+        ch->head++;
+    }
+    ch->cond.notify_one();
+}
+
+void UdpMuxServer::rx_loop() {
+    while (running) {
+        int n = udp_recv_batch(sockfd, rx_buffer, rx_len, rx_addr, UDP_COMM_BATCH_NUM);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            dispatch(rx_buffer[i], rx_len[i], rx_addr[i]);
+        }
+    }
+}
+
+bool UdpMuxServer::recv(int channel, char* data, int datalen, int* recv_datalen) {
+    Channel* ch = get_channel(channel);
+    if (ch == nullptr || !data || datalen <= 0) {
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(ch->mutex);
+    ch->cond.wait(lock, [&] { return ch->head != ch->tail || !running; });
+    if (ch->head == ch->tail) {
+        return false;
+    }
+    unsigned idx = ch->tail % UDP_COMM_CHANNEL_QUEUE_NUM;
+    int len = ch->queue_len[idx];
+    ch->tail++;
+    if (len > datalen) {
+        std::cerr << "ERROR: udp recv buffer too small: " << datalen << " < " << len << std::endl;
+        return false;
+    }
+    std::memcpy(data, ch->queue[idx], len);
+    if (recv_datalen) {
+        *recv_datalen = len;
+    }
+    return true;
+}
+
+bool UdpMuxServer::send(int channel, const char* data, int datalen) {
+    Channel* ch = get_channel(channel);
+    if (ch == nullptr || !data || datalen <= 0 || datalen > UDP_COMM_DATAGRAM_MAX) {
+        return false;
+    }
+    struct sockaddr_in addr;
+    {
+        // PX4 は最初のデータを受信するまで送ってこないので、受信前から送る
+        std::lock_guard<std::mutex> lock(ch->mutex);
+        addr = ch->remote_addr;
+    }
+    std::lock_guard<std::mutex> lock(tx_mutex);
+    tx_batch.emplace_back();
+    TxEntry& e = tx_batch.back();
+    std::memcpy(e.data, data, datalen);
+    e.len = datalen;
+    e.addr = addr;
+    if (tx_batch.size() >= UDP_COMM_BATCH_NUM) {
+        return flush_locked();
+    }
+    return true;
+}
+
+bool UdpMuxServer::flush() {
+    std::lock_guard<std::mutex> lock(tx_mutex);
+    return flush_locked();
+}
+
+bool UdpMuxServer::flush_locked() {
+    if (tx_batch.empty() || sockfd < 0) {
+        tx_batch.clear();
+        return true;
+    }
+    bool ret = true;
+#ifdef __linux__
+    struct mmsghdr msgs[UDP_COMM_BATCH_NUM];
+    struct iovec iovecs[UDP_COMM_BATCH_NUM];
+    size_t num = tx_batch.size();
+    std::memset(msgs, 0, sizeof(msgs[0]) * num);
+    for (size_t i = 0; i < num; i++) {
+        iovecs[i].iov_base = tx_batch[i].data;
+        iovecs[i].iov_len = tx_batch[i].len;
+        msgs[i].msg_hdr.msg_iov = &iovecs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_name = &tx_batch[i].addr;
+        msgs[i].msg_hdr.msg_namelen = sizeof(tx_batch[i].addr);
+    }
+    size_t sent = 0;
+    while (sent < num) {
+        int n = sendmmsg(sockfd, &msgs[sent], num - sent, 0);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ret = false;
+            break;
+        }
+        sent += n;
+    }
+#else
+    for (auto& e : tx_batch) {
+        if (sendto(sockfd, e.data, e.len, 0, (struct sockaddr*)&e.addr, sizeof(e.addr)) < 0) {
+            ret = false;
+        }
+    }
+#endif
+    tx_batch.clear();
+    return ret;
+}
+
+void UdpMuxServer::close() {
+    if (sockfd < 0) {
+        return;
+    }
+    running = false;
+    ::shutdown(sockfd, SHUT_RDWR);
+    if (rx_thread.joinable()) {
+        rx_thread.join();
+    }
+    ::close(sockfd);
+    sockfd = -1;
+    std::lock_guard<std::mutex> lock(channels_mutex);
+    for (auto& ch : channels) {
+        ch->cond.notify_all();
+    }
+}
+
 } // namespace hako::px4::comm
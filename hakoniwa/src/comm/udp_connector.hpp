@@ -4,13 +4,42 @@
 #include "icomm_connector.hpp"
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace hako::px4::comm {
 
+#define UDP_COMM_BATCH_NUM          32      /* recvmmsg/sendmmsg 1回あたりの最大データグラム数 */
+#define UDP_COMM_DATAGRAM_MAX       1024
+#define UDP_COMM_CHANNEL_QUEUE_NUM  256     /* 機体ごとの受信キュー長 */
+
+/*
+ * ソケットバッファサイズ(0 は OS のデフォルト)
+ */
+typedef struct {
+    int rcvbuf_size;
+    int sndbuf_size;
+} UdpSocketOptionType;
+
+extern bool udp_socket_set_options(int sockfd, const UdpSocketOptionType& opt);
+
 class UdpCommIO : public ICommIO {
 private:
     int sockfd; // ソケットのディスクリプタ
     struct sockaddr_in remote_addr; // リモートのアドレス情報
+    /*
+     * recvmmsg でまとめて受信したデータグラムを1つずつ返すためのバッファ
+     */
+    char rx_buffer[UDP_COMM_BATCH_NUM][UDP_COMM_DATAGRAM_MAX];
+    int rx_len[UDP_COMM_BATCH_NUM];
+    struct sockaddr_in rx_addr[UDP_COMM_BATCH_NUM];
+    int rx_num = 0;
+    int rx_pos = 0;
+    bool fill_rx_buffer();
 
 public:
     UdpCommIO(int sockfd, const sockaddr_in& remote_addr);
@@ -18,15 +47,18 @@ public:
 
     bool send(const char* data, int datalen, int* send_datalen) override;
     bool recv(char* data, int datalen, int* recv_datalen) override;
+    bool shutdown() override;
     bool close() override;
 };
 
 class UdpClient : public ICommClient {
 private:
     struct sockaddr_in local_addr; // ローカルのアドレス情報
+    UdpSocketOptionType option;
 
 public:
     UdpClient();
+    UdpClient(const UdpSocketOptionType& opt);
     ~UdpClient() override;
 
     ICommIO* client_open(IcommEndpointType *src, IcommEndpointType *dst) override;
@@ -35,14 +67,106 @@ public:
 class UdpServer : public ICommServer {
 private:
     struct sockaddr_in local_addr; // ローカルのアドレス情報
+    UdpSocketOptionType option;
 
 public:
     UdpServer();
+    UdpServer(const UdpSocketOptionType& opt);
     ~UdpServer() override;
 
     ICommIO* server_open(IcommEndpointType *endpoint) override;
 };
 
+/*
+ * 複数機体を1つの UDP ソケットで扱うサーバ.
+ *
+ * PX4 SITL の UDP モードは PX4 側が 4560 + インスタンス番号を bind し、
+ * シミュレータから最初のデータが届くのを待つ。そのため server_bind()/server_open()
+ * の endpoint は PX4 側(送信先)のアドレスとして扱い、(portno - 最初の portno)
+ * 番目の機体のチャネルは最初からその endpoint へ送信する。ソケット自体は
+ * 空きポートに bind する。
+ * 受信データは送信元アドレスで機体に振り分け、どの機体の endpoint とも一致しない
+ * 場合は MAVLink ヘッダの sysid (PX4 の MAV_SYS_ID, インスタンス番号 + 1)で振り分ける。
+ *
+ * 受信は専用スレッドが recvmmsg でまとめて読み出して各チャネルのキューに積む。
+ * 送信は send() で溜めて flush() で sendmmsg により一括送信する。
+ */
+class UdpMuxServer;
+
+class UdpMuxCommIO : public ICommIO {
+private:
+    UdpMuxServer *server;
+    int channel;
+
+public:
+    UdpMuxCommIO(UdpMuxServer *server, int channel) : server(server), channel(channel) {}
+    ~UdpMuxCommIO() override {}
+
+    bool send(const char* data, int datalen, int* send_datalen) override;
+    bool recv(char* data, int datalen, int* recv_datalen) override;
+    bool flush() override;
+    bool close() override;
+};
+
+typedef struct {
+    uint64_t dropped;   /* キューあふれで捨てた数 */
+    uint64_t oversize;  /* UDP_COMM_DATAGRAM_MAX を超えて捨てた数 */
+} UdpMuxChannelStatsType;
+
+class UdpMuxServer : public ICommServer {
+private:
+    struct Channel {
+        std::mutex mutex;
+        std::condition_variable cond;
+        char queue[UDP_COMM_CHANNEL_QUEUE_NUM][UDP_COMM_DATAGRAM_MAX];
+        int queue_len[UDP_COMM_CHANNEL_QUEUE_NUM];
+        unsigned head = 0;
+        unsigned tail = 0;
+        uint64_t dropped = 0;
+        uint64_t oversize = 0;
+        struct sockaddr_in peer_addr;   // server_bind() の endpoint (変更しない)
+        struct sockaddr_in remote_addr; // 送信先. sysid で振り分けた場合はその送信元
+    };
+    struct TxEntry {
+        char data[UDP_COMM_DATAGRAM_MAX];
+        int len;
+        struct sockaddr_in addr;
+    };
+    int sockfd = -1;
+    int base_portno = -1;
+    UdpSocketOptionType option;
+    std::vector<std::unique_ptr<Channel>> channels;
+    std::mutex channels_mutex;
+    std::mutex tx_mutex;
+    std::vector<TxEntry> tx_batch;
+    std::thread rx_thread;
+    std::atomic<bool> running { false };
+    char rx_buffer[UDP_COMM_BATCH_NUM][UDP_COMM_DATAGRAM_MAX];
+    int rx_len[UDP_COMM_BATCH_NUM];
+    struct sockaddr_in rx_addr[UDP_COMM_BATCH_NUM];
+
+    bool open_socket(IcommEndpointType *endpoint);
+    void rx_loop();
+    void dispatch(const char* data, int len, const struct sockaddr_in& from);
+    Channel* get_channel(int channel);
+    Channel* find_channel(const char* data, int len, const struct sockaddr_in& from);
+    bool flush_locked();
+
+public:
+    UdpMuxServer();
+    UdpMuxServer(const UdpSocketOptionType& opt);
+    ~UdpMuxServer() override;
+
+    bool server_bind(IcommEndpointType *endpoint) override;
+    ICommIO* server_open(IcommEndpointType *endpoint) override;
+    bool send(int channel, const char* data, int datalen);
+    bool recv(int channel, char* data, int datalen, int* recv_datalen);
+    bool flush();
+    void close();
+    int get_local_portno();
+    bool get_channel_stats(int channel, UdpMuxChannelStatsType& stats);
+};
+
 } // namespace hako::px4::comm
 
 #endif /* _UDPCONNECTOR_HPP_ */
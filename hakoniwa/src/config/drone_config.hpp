@@ -7,353 +7,218 @@
 #include <vector>
 #include <filesystem>
 #include <optional>
+#include <memory>
+#include <mutex>
+#include <set>
 #include "drone_config_types.hpp"
+#include "drone_config_data.hpp"
+#include "utils/hako_parallel.hpp"
 
 using json = nlohmann::json;
 namespace fs = std::filesystem;
-#ifdef __APPLE__
-#define SHARED_LIB_EXT  ".so"
-#elif __linux__
-#define SHARED_LIB_EXT  ".so"
-#else
-#define SHARED_LIB_EXT  ".dll"
-#endif
 
 /* #define DRONE_PX4_RX_DEBUG_ENABLE */
 /* DRONE_PX4_TX_DEBUG_ENABLE */
 /* DRONE_PID_CONTROL_CPP */
-struct RotorPosition {
-    std::vector<double> position;
-    double rotationDirection;
-};
 #define DEGREE2RADIAN(v)    ( (v) * M_PI / (180.0) )
 #define RADIAN2DEGREE(v)    ( (180.0 * (v)) / M_PI )
 
+/*
+ * DroneConfigData の読み取り用ビュー
+ * 中身は shared_ptr で共有するのでコピーは安価。getter は解析済みの値を返すだけ。
+ */
 class DroneConfig {
 private:
-    json configJson;
-    std::string config_filepath;
+    std::shared_ptr<const DroneConfigData> data;
+
+    const DroneSensorConfigData& sensor(const std::string& sensor_name) const
+    {
+        static const DroneSensorConfigData empty = {};
+        auto it = data->sensors.find(sensor_name);
+        if (it == data->sensors.end()) {
+            std::cerr << "ERROR: unknown sensor: " << sensor_name << std::endl;
+            return empty;
+        }
+        return it->second;
+    }
+    template <typename T>
+    static T lookup(const std::map<std::string, T>& table, const std::string& key, T default_value)
+    {
+        auto it = table.find(key);
+        return (it != table.end()) ? it->second : default_value;
+    }
 public:
     DroneConfig() {}
+    DroneConfig(std::shared_ptr<const DroneConfigData> data) : data(data) {}
     bool init(const std::string& configFilePath) {
-        config_filepath = configFilePath;
-        std::ifstream configFile(config_filepath);
-        if (configFile.is_open()) {
-            try {
-                configFile >> configJson;
-            } catch (json::parse_error& e) {
-                std::cerr << "JSON parsing error: " << e.what() << std::endl;
-                return false;
-            }
-        } else {
-            std::cerr << "Unable to open config file: " << config_filepath << std::endl;
-            return false;
-        }
-        return true;
+        data = drone_config_data_parse(configFilePath);
+        return (data != nullptr);
+    }
+    const DroneConfigData& getData() const {
+        return *data;
+    }
+    std::shared_ptr<const DroneConfigData> getDataPtr() const {
+        return data;
     }
 
     /* Simulation parameters */
     double getSimTimeStep() const {
-        return configJson["simulation"]["timeStep"].get<double>();
+        return data->simulation.timeStep;
     }
     bool getSimLockStep() const {
-        return configJson["simulation"]["lockstep"].get<bool>();
+        return data->simulation.lockstep;
     }
     std::string getSimLogOutputDirectory() const 
     {
-        std::string directory = configJson["simulation"]["logOutputDirectory"].get<std::string>();
-        if (!std::filesystem::exists(directory)) {
-            std::cerr << "Error: Log output directory '" << directory << "' does not exist." << std::endl;
-            return "./";
-        }
-        return directory;
+        return data->simulation.logOutputDirectory;
     }
     std::string getRoboName() const
     {
-        return configJson["name"].get<std::string>();
+        return data->name;
     }
     std::string getSimLogFullPath(const std::string& filename) const
     {
-        std::string logDirectory = getSimLogOutputDirectory();
-
-        if (logDirectory.back() != '/' && logDirectory.back() != '\\') {
-            logDirectory += "/";
-        }
-
-        return logDirectory + filename;
+        return data->simulation.logOutputDirectory + filename;
     }
-    void createDirectory(const std::string dirpath) const
+    /*
+     * 同じディレクトリに対しては最初の1回だけファイルシステムを参照する
+     */
+    static void createDirectory(const std::string dirpath)
     {
+        static std::mutex mutex;
+        static std::set<std::string> created;
+        std::lock_guard<std::mutex> lock(mutex);
+        if (created.count(dirpath) > 0) {
+            return;
+        }
         if (!std::filesystem::exists(dirpath)) {
             if (std::filesystem::create_directory(dirpath)) {
                 std::cout << "INFO: create directory " << dirpath << std::endl;
             } else {
                 std::cout << "ERROR: can not create directory: " << dirpath << std::endl;
+                return;
             }
-        } else {
-            /* std::cout << "INFO: directory is already exist: " << dirpath << std::endl; */
         }
+        created.insert(dirpath);
     }
     std::string getSimLogFullPathFromIndex(int index, const std::string& name) const
     {
-        std::string logDirectory = getSimLogDirectoryPathFromIndex(index);
-        if (logDirectory.back() != '/' && logDirectory.back() != '\\') {
-            logDirectory += "/";
-        }
-        return logDirectory + name;
+        return getSimLogDirectoryPathFromIndex(index) + "/" + name;
     }
     std::string getSimLogDirectoryPathFromIndex(int index) const
     {
-        std::string logDirectory = getSimLogOutputDirectory();
-        if (logDirectory.back() != '/' && logDirectory.back() != '\\') {
-            logDirectory += "/";
-        }
-        std::string path = logDirectory + "drone_log" + std::to_string(index);
+        std::string path = data->simulation.logOutputDirectory + "drone_log" + std::to_string(index);
         createDirectory(path);
         return path;
     }
 
     /* Log Output for Sensors */
     bool isSimSensorLogEnabled(const std::string& sensorName) const {
-        return configJson["simulation"]["logOutput"]["sensors"][sensorName].get<bool>();
+        return lookup(data->simulation.sensorLogEnabled, sensorName, false);
     }
 
     /* Log Output for MAVLINK */
     bool isMSimavlinkLogEnabled(const std::string& mavlinkMessage) const {
-        return configJson["simulation"]["logOutput"]["mavlink"][mavlinkMessage].get<bool>();
+        return lookup(data->simulation.mavlinkLogEnabled, mavlinkMessage, false);
     }
 
     /* MAVLINK Transmission Period */
     int getSimMavlinkTransmissionPeriod(const std::string& mavlinkMessage) const {
-        return configJson["simulation"]["mavlink_tx_period_msec"][mavlinkMessage].get<int>();
+        return lookup(data->simulation.mavlinkTxPeriodMsec, mavlinkMessage, 0);
     }
 
     /* Location parameters */
     double getSimLatitude() const {
-        return configJson["simulation"]["location"]["latitude"].get<double>();
+        return data->simulation.latitude;
     }
 
     double getSimLongitude() const {
-        return configJson["simulation"]["location"]["longitude"].get<double>();
+        return data->simulation.longitude;
     }
 
     double getSimAltitude() const {
-        return configJson["simulation"]["location"]["altitude"].get<double>();
+        return data->simulation.altitude;
     }
 
-    struct MagneticField {
-        double intensity_nT;
-        double declination_deg;
-        double inclination_deg;
-    };
+    typedef DroneMagneticField MagneticField;
 
-    MagneticField getSimMagneticField() const {
-        MagneticField field;
-        field.intensity_nT = configJson["simulation"]["location"]["magneticField"]["intensity_nT"].get<double>();
-        field.declination_deg = configJson["simulation"]["location"]["magneticField"]["declination_deg"].get<double>();
-        field.inclination_deg = configJson["simulation"]["location"]["magneticField"]["inclination_deg"].get<double>();
-        return field;
+    const MagneticField& getSimMagneticField() const {
+        return data->simulation.magneticField;
     }
 
     /* Drone Dynamics parameters */
-    std::string getCompDroneDynamicsPhysicsEquation() const {
-        return configJson["components"]["droneDynamics"]["physicsEquation"].get<std::string>();
+    const std::string& getCompDroneDynamicsPhysicsEquation() const {
+        return data->droneDynamics.physicsEquation;
     }
     bool getCompDroneDynamicsUseQuaternion() const {
-        if (configJson["components"]["droneDynamics"].contains("useQuaternion")) {
-            return configJson["components"]["droneDynamics"]["useQuaternion"].get<bool>();
-        }
-        return false;
+        return data->droneDynamics.useQuaternion;
     }
-    std::vector<double> getCompDroneDynamicsAirFrictionCoefficient() const {
-        std::vector<double> frictions;
-        for (const auto& item : configJson["components"]["droneDynamics"]["airFrictionCoefficient"]) {
-            frictions.push_back(item);
-        }
-        return frictions;
+    const std::vector<double>& getCompDroneDynamicsAirFrictionCoefficient() const {
+        return data->droneDynamics.airFrictionCoefficient;
     }
     bool getCompDroneDynamicsCollisionDetection() const {
-        return configJson["components"]["droneDynamics"]["collision_detection"].get<bool>();
+        return data->droneDynamics.collisionDetection;
     }
     bool getCompDroneDynamicsEnableDisturbance() const {
-         if (configJson["components"]["droneDynamics"].contains("enable_disturbance")) {
-            return configJson["components"]["droneDynamics"]["enable_disturbance"].get<bool>();
-         }
-         else {
-            return false;
-         }
+        return data->droneDynamics.enableDisturbance;
     }
     bool getCompDroneDynamicsManualControl() const {
-        return configJson["components"]["droneDynamics"]["manual_control"].get<bool>();
+        return data->droneDynamics.manualControl;
     }
-    std::vector<double> getCompDroneDynamicsBodySize() const {
-        std::vector<double> body_size;
-        for (const auto& item : configJson["components"]["droneDynamics"]["body_size"]) {
-            body_size.push_back(item);
-        }
-        return body_size;
+    const std::vector<double>& getCompDroneDynamicsBodySize() const {
+        return data->droneDynamics.bodySize;
     }
-    std::vector<double> getCompDroneDynamicsInertia() const {
-        std::vector<double> inertia;
-        for (const auto& item : configJson["components"]["droneDynamics"]["inertia"]) {
-            inertia.push_back(item);
-        }
-        return inertia;
+    const std::vector<double>& getCompDroneDynamicsInertia() const {
+        return data->droneDynamics.inertia;
     }
-    std::vector<double> getCompDroneDynamicsPosition() const {
-        std::vector<double> inertia;
-        for (const auto& item : configJson["components"]["droneDynamics"]["position_meter"]) {
-            inertia.push_back(item);
-        }
-        return inertia;
+    const std::vector<double>& getCompDroneDynamicsPosition() const {
+        return data->droneDynamics.position;
     }
-    std::vector<double> getCompDroneDynamicsAngle() const {
-        std::vector<double> inertia;
-        for (const auto& item : configJson["components"]["droneDynamics"]["angle_degree"]) {
-            inertia.push_back(item);
-        }
-        return inertia;
+    const std::vector<double>& getCompDroneDynamicsAngle() const {
+        return data->droneDynamics.angle;
     }
     double getCompDroneDynamicsMass() const {
-        return configJson["components"]["droneDynamics"]["mass_kg"].get<double>();
-    }
-    std::optional<hako::assets::drone::OutOfBoundsReset> getCompDroneDynamicsOutOfBoundsReset() const {
-        if (configJson["components"]["droneDynamics"].contains("out_of_bounds_reset")) {
-            std::cout << "out_of_bounds_reset values are enabled." << std::endl;
-            hako::assets::drone::OutOfBoundsReset out_of_bounds_reset;
-            out_of_bounds_reset.position = configJson["components"]["droneDynamics"]["out_of_bounds_reset"]["position"].get<std::vector<bool>>();
-            out_of_bounds_reset.velocity = configJson["components"]["droneDynamics"]["out_of_bounds_reset"]["velocity"].get<std::vector<bool>>();
-            out_of_bounds_reset.angular_velocity = configJson["components"]["droneDynamics"]["out_of_bounds_reset"]["angular_velocity"].get<std::vector<bool>>();
-            return std::make_optional(out_of_bounds_reset);  /* std::optional にラップして返す */
-        }
-        return std::nullopt;  /* 未設定時 */
+        return data->droneDynamics.mass;
+    }
+    const std::optional<hako::assets::drone::OutOfBoundsReset>& getCompDroneDynamicsOutOfBoundsReset() const {
+        return data->droneDynamics.outOfBoundsReset;
     }
 
 
-    std::string getCompRotorVendor() const {
-        if (configJson["components"]["rotor"].contains("vendor")) {
-            return configJson["components"]["rotor"]["vendor"].get<std::string>();
-        } else {
-            return "None";
-        }
+    const std::string& getCompRotorVendor() const {
+        return data->rotor.vendor;
     }
 
-    hako::assets::drone::BatteryModelParameters getComDroneDynamicsBattery() const {
-        hako::assets::drone::BatteryModelParameters params = {};
-        try {
-            if (configJson["components"].contains("battery")) {
-                params.vendor = configJson["components"]["battery"]["vendor"].get<std::string>();
-                if (configJson["components"]["battery"].contains("BatteryModelCsvFilePath")) {
-                    params.BatteryModelCsvFilePath = configJson["components"]["battery"]["BatteryModelCsvFilePath"].get<std::string>();
-                }
-                if (configJson["components"]["battery"].contains("model")) {
-                    params.model = configJson["components"]["battery"]["model"].get<std::string>();
-                }
-                else {
-                    params.model = "constant";
-                }
-                params.VoltageLevelGreen = configJson["components"]["battery"]["VoltageLevelGreen"].get<double>();
-                params.VoltageLevelYellow = configJson["components"]["battery"]["VoltageLevelYellow"].get<double>();
-                params.NominalVoltage = configJson["components"]["battery"]["NominalVoltage"].get<double>();
-                params.NominalCapacity = configJson["components"]["battery"]["NominalCapacity"].get<double>();
-                params.EODVoltage = configJson["components"]["battery"]["EODVoltage"].get<double>();
-                params.CapacityLevelYellow = configJson["components"]["battery"]["CapacityLevelYellow"].get<double>();
-                std::cout << "Battery model is enabled." << std::endl;
-                return params;
-            }
-            else {
-                std::cout << "ERROR: Battery model config is invalid." << std::endl;
-            }
-        } catch (const std::exception& e) {
-            std::cerr << "Error retrieving Battery Model config: " << e.what() << std::endl;
-        }
-        return params;
+    /* battery 未設定時は vendor が空のパラメータを返す */
+    const hako::assets::drone::BatteryModelParameters& getComDroneDynamicsBattery() const {
+        return data->battery;
     }
 
-    hako::assets::drone::RotorBatteryModelConstants getCompDroneDynamicsRotorDynamicsConstants() const {
-        hako::assets::drone::RotorBatteryModelConstants constants = {};
-        try {
-            /* 必要な全てのキーが存在するかを確認 */
-            if (configJson.contains("components") &&
-                configJson["components"].contains("rotor") &&
-                configJson["components"]["rotor"].contains("dynamics_constants")) {
-                
-                /* 各定数を取得し、エラーハンドリングも考慮 */
-                constants.R  = configJson["components"]["rotor"]["dynamics_constants"]["R"].get<double>();
-                constants.Cq = configJson["components"]["rotor"]["dynamics_constants"]["Cq"].get<double>();
-                constants.K  = configJson["components"]["rotor"]["dynamics_constants"]["K"].get<double>();
-                constants.D  = configJson["components"]["rotor"]["dynamics_constants"]["D"].get<double>();
-                constants.J  = configJson["components"]["rotor"]["dynamics_constants"]["J"].get<double>();
-                std::cout << "Rotor battery model is enabled." << std::endl;
-                return constants;
-            }
-        } catch (const std::exception& e) {
-            std::cerr << "Error retrieving rotor dynamics constants: " << e.what() << std::endl;
-        }
-        std::cout << "ERROR: Rotor battery model config is invalid." << std::endl;
-        return constants;
+    /* dynamics_constants 未設定時はすべて 0 */
+    const hako::assets::drone::RotorBatteryModelConstants& getCompDroneDynamicsRotorDynamicsConstants() const {
+        return data->rotor.dynamicsConstants;
     }
     int getCompRotorRpmMax() const {
-        return configJson["components"]["rotor"]["rpmMax"].get<int>();
+        return data->rotor.rpmMax;
     }
 
     /* Thruster parameters */
-    std::vector<RotorPosition> getCompThrusterRotorPositions() const {
-        std::vector<RotorPosition> positions;
-        for (const auto& item : configJson["components"]["thruster"]["rotorPositions"]) {
-            RotorPosition pos;
-            pos.position = item["position"].get<std::vector<double>>();
-            pos.rotationDirection = item["rotationDirection"].get<double>();
-            positions.push_back(pos);
-        }
-        return positions;
+    const std::vector<RotorPosition>& getCompThrusterRotorPositions() const {
+        return data->thruster.rotorPositions;
     }
 
     double getCompThrusterParameter(const std::string& param_name) const {
-        if (configJson["components"]["thruster"].contains(param_name)) {
-            return configJson["components"]["thruster"][param_name].get<double>();
-        } else {
-            return 0.0;
-        }
+        return lookup(data->thruster.parameters, param_name, 0.0);
     }
 
-    std::string getCompThrusterVendor() const {
-        if (configJson["components"]["thruster"].contains("vendor")) {
-            return configJson["components"]["thruster"]["vendor"].get<std::string>();
-        } else {
-            return "None";
-        }
+    const std::string& getCompThrusterVendor() const {
+        return data->thruster.vendor;
     }
     std::string getLastDirectoryName(const std::string& pathStr) const {
-        fs::path pathObj(pathStr);
-
-        if (!pathObj.empty()) {
-            if (pathObj.filename() == "." || pathObj.filename() == ".." || pathObj.filename() == fs::path()) {
-                pathObj = pathObj.parent_path();
-            }
-            return pathObj.filename().string();
-        } else {
-            return "";
-        }
+        return drone_config_last_directory_name(pathStr);
     }
-    std::string getCompSensorVendor(const std::string& sensor_name) const {
-        if (configJson["components"]["sensors"][sensor_name].contains("vendor")) {
-            std::string moduleDirectory = configJson["components"]["sensors"][sensor_name]["vendor"].get<std::string>();
-            if (moduleDirectory.back() != '/' && moduleDirectory.back() != '\\') {
-                moduleDirectory += "/";
-            }
-            std::string moduleName = getCompSensorContextModuleName(sensor_name);
-            if (moduleName.empty()) {
-                moduleName = getLastDirectoryName(moduleDirectory);
-            }
-#if WIN32
-            return moduleDirectory + moduleName + SHARED_LIB_EXT;
-#else
-            return moduleDirectory + "lib" + moduleName + SHARED_LIB_EXT;
-#endif
-        } else {
-            return "";
-        }
+    const std::string& getCompSensorVendor(const std::string& sensor_name) const {
+        return sensor(sensor_name).vendorPath;
     }
     std::string getCompSensorContextModuleName(const std::string& sensor_name) const
     {
@@ -362,90 +227,73 @@ public:
 
     std::string getCompSensorContext(const std::string& sensor_name, const std::string& param) const
     {
-         if (configJson["components"]["sensors"][sensor_name].contains("context")) {
-            if (configJson["components"]["sensors"][sensor_name]["context"].contains(param)) {
-                return configJson["components"]["sensors"][sensor_name]["context"][param];
-            }
-        }
-        return "";
+        return lookup(sensor(sensor_name).context, param, std::string());
     }
 
     double getCompSensorSampleCount(const std::string& sensor_name) const {
-        return configJson["components"]["sensors"][sensor_name]["sampleCount"].get<double>();
+        return sensor(sensor_name).sampleCount;
     }
     double getCompSensorNoise(const std::string& sensor_name) const {
-        return configJson["components"]["sensors"][sensor_name]["noise"].get<double>();
+        return sensor(sensor_name).noise;
     }
-    bool isExistController(const std::string& param)
+    bool isExistController(const std::string& param) const
     {
-        if (!configJson.contains("controller")) {
+        if (data->controller.keys.empty()) {
             std::cerr << "WARING: can not find controller on drone_config" << std::endl;
             return false;
         }
-        if (!configJson["controller"].contains(param)) {
-            std::cerr << "WARING: can not find controller[ " << param << " ] on drone_config" << std::endl;
-            return false;
+        for (const auto& key : data->controller.keys) {
+            if (key == param) {
+                return true;
+            }
         }
-        return true;
+        std::cerr << "WARING: can not find controller[ " << param << " ] on drone_config" << std::endl;
+        return false;
     }
-    double getControllerPid(const std::string& param1, const std::string& param2, const std::string& param3)
+    double getControllerPid(const std::string& param1, const std::string& param2, const std::string& param3) const
     {
-        return configJson["controller"]["pid"][param1][param2][param3].get<double>();
+        auto group = data->controller.pid.find(param1);
+        if (group != data->controller.pid.end()) {
+            auto axis = group->second.find(param2);
+            if (axis != group->second.end()) {
+                const DronePidGain& gain = axis->second;
+                if (param3 == "Kp") {
+                    return gain.Kp;
+                }
+                else if (param3 == "Ki") {
+                    return gain.Ki;
+                }
+                else if (param3 == "Kd") {
+                    return gain.Kd;
+                }
+                else if (param3 == "setpoint") {
+                    return gain.setpoint;
+                }
+            }
+        }
+        std::cerr << "ERROR: can not find controller pid[ " << param1 << " ][ " << param2 << " ][ " << param3 << " ]" << std::endl;
+        return 0.0;
     }
-    std::string getControllerModuleName() const
+    const std::string& getControllerModuleName() const
     {
-        if (configJson["controller"].contains("moduleName")) {
-            return configJson["controller"]["moduleName"];
-        }
-        else {
-            return getRoboName();
-        }
+        return data->controller.moduleName;
     }
     std::string getControllerContext(const std::string& param) const
     {
-        if (configJson["controller"].contains("context")) {
-            if (configJson["controller"]["context"].contains(param)) {
-                return configJson["controller"]["context"][param];
-            }
-        }
-        return "";
+        return lookup(data->controller.context, param, std::string());
     }
-    std::string getControllerModuleFilePath() const
+    const std::string& getControllerModuleFilePath() const
     {
-        if (configJson["controller"].contains("moduleDirectory")) {
-            std::string moduleDirectory = configJson["controller"]["moduleDirectory"].get<std::string>();
-            if (moduleDirectory.back() != '/' && moduleDirectory.back() != '\\') {
-                moduleDirectory += "/";
-            }
-#if WIN32
-            return moduleDirectory + getControllerModuleName() + SHARED_LIB_EXT;
-#else
-            return moduleDirectory + "lib" + getControllerModuleName() + SHARED_LIB_EXT;
-#endif
-        }
-        else {
-            return "";
-        }
+        return data->controller.moduleFilePath;
     }
-    struct MixerInfo {
-        bool enable;
-        std::string vendor;
-        bool enableDebugLog;
-        bool enableErrorLog;
-
-        // not config info
-        double K;
-        double R;
-        double Cq;
-        double V_bat;
-    };
+    typedef DroneMixerInfo MixerInfo;
 
     bool getControllerMixerInfo(MixerInfo& info) const
     {
-        if (configJson["controller"].contains("mixer")) {
-            info.vendor = configJson["controller"]["mixer"]["vendor"];
-            info.enableDebugLog = configJson["controller"]["mixer"]["enableDebugLog"];
-            info.enableErrorLog = configJson["controller"]["mixer"]["enableErrorLog"];
+        if (data->controller.hasMixer) {
+            info.vendor = data->controller.mixer.vendor;
+            info.enableDebugLog = data->controller.mixer.enableDebugLog;
+            info.enableErrorLog = data->controller.mixer.enableErrorLog;
             info.enable = true;
             return true;
         }
@@ -456,12 +304,7 @@ public:
 
     bool getControllerDirectRotorControl() const
     {
-        if (configJson["controller"].contains("direct_rotor_control")) {
-            return configJson["controller"]["direct_rotor_control"];
-        }
-        else {
-            return false;
-        }
+        return data->controller.directRotorControl;
     }
 };
 
@@ -510,11 +353,22 @@ public:
             return a.first < b.first;
         });
 
+        /*
+         * 解析は並列に行い、登録は index 順に行う
+         */
+        std::vector<std::shared_ptr<const DroneConfigData>> parsed(filesWithIndex.size());
+        hako_parallel_for(filesWithIndex.size(), [&](size_t i) {
+            parsed[i] = drone_config_data_parse(filesWithIndex[i].second);
+        });
         int loadedCount = 0;
-        for (const auto& [index, filePath] : filesWithIndex) {
-            if (loadConfigFromFile(filePath)) {
+        for (size_t i = 0; i < filesWithIndex.size(); i++) {
+            const std::string& filePath = filesWithIndex[i].second;
+            if (parsed[i] != nullptr) {
+                std::cout << "INFO: LOADED drone config file: " << filePath << std::endl;
+                configs.push_back(DroneConfig(parsed[i]));
                 loadedCount++;
             } else {
+                std::cerr << "ERROR: invalid drone config: " << filePath << std::endl;
                 std::cerr << "Failed to load config from: " << filePath << std::endl;
             }
         }
@@ -524,7 +378,7 @@ public:
     bool loadConfigFromFile(const std::string& drone_config_path) {
         DroneConfig drone_config;
         if (!drone_config.init(drone_config_path)) {
-            std::cerr << "ERROR: can not find drone config path: " << drone_config_path << std::endl;
+            std::cerr << "ERROR: invalid drone config: " << drone_config_path << std::endl;
             return false;
         }
         std::cout << "INFO: LOADED drone config file: " << drone_config_path << std::endl;
@@ -533,14 +387,23 @@ public:
     }
 
 
-    bool getConfig(size_t index, DroneConfig& config) {
+    /*
+     * DroneConfig は解析済みデータへの shared_ptr だけを持つので、コピーは安価
+     */
+    bool getConfig(size_t index, DroneConfig& config) const {
         if (index >= configs.size()) {
             return false;
         }
         config = configs[index];
         return true;
     }
-    int getConfigCount() {
+    const DroneConfig* getConfigRef(size_t index) const {
+        if (index >= configs.size()) {
+            return nullptr;
+        }
+        return &configs[index];
+    }
+    int getConfigCount() const {
         return configs.size();
     }
 };
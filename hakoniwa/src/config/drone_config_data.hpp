@@ -0,0 +1,521 @@
+#ifndef _DRONE_CONFIG_DATA_HPP_
+#define _DRONE_CONFIG_DATA_HPP_
+
+/*
+ * drone_config_N.json を起動時に1回だけ解析した結果(読み取り専用)
+ *
+ * JSON の参照や型チェックはすべて drone_config_data_parse() で行い、スキーマ
+ * エラーはその時点でまとめて報告する。解析後は std::shared_ptr<const DroneConfigData>
+ * として共有し、実行時に JSON を辿ることはない。
+ */
+#include <nlohmann/json.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "drone_config_types.hpp"
+
+#ifdef __APPLE__
+#define SHARED_LIB_EXT  ".so"
+#elif __linux__
+#define SHARED_LIB_EXT  ".so"
+#else
+#define SHARED_LIB_EXT  ".dll"
+#endif
+
+struct RotorPosition {
+    std::vector<double> position;
+    double rotationDirection;
+};
+
+struct DroneMagneticField {
+    double intensity_nT;
+    double declination_deg;
+    double inclination_deg;
+};
+
+struct DroneMixerInfo {
+    bool enable;
+    std::string vendor;
+    bool enableDebugLog;
+    bool enableErrorLog;
+
+    // not config info
+    double K;
+    double R;
+    double Cq;
+    double V_bat;
+};
+
+struct DronePidGain {
+    double Kp;
+    double Ki;
+    double Kd;
+    double setpoint;
+};
+
+struct DroneSensorConfigData {
+    double sampleCount;
+    double noise;
+    std::string vendorPath;     /* 共有ライブラリのパス(vendor 未指定時は空) */
+    std::map<std::string, std::string> context;
+};
+
+struct DroneConfigData {
+    std::string config_filepath;
+    std::string name;
+
+    struct {
+        double timeStep;
+        bool lockstep;
+        std::string logOutputDirectory;     /* 末尾は '/' */
+        std::map<std::string, bool> sensorLogEnabled;
+        std::map<std::string, bool> mavlinkLogEnabled;
+        std::map<std::string, int> mavlinkTxPeriodMsec;
+        double latitude;
+        double longitude;
+        double altitude;
+        DroneMagneticField magneticField;
+    } simulation;
+
+    struct {
+        std::string physicsEquation;
+        bool useQuaternion;
+        std::vector<double> airFrictionCoefficient;
+        bool collisionDetection;
+        bool enableDisturbance;
+        bool manualControl;
+        std::vector<double> bodySize;
+        std::vector<double> inertia;
+        std::vector<double> position;
+        std::vector<double> angle;
+        double mass;
+        std::optional<hako::assets::drone::OutOfBoundsReset> outOfBoundsReset;
+    } droneDynamics;
+
+    bool hasBattery;
+    hako::assets::drone::BatteryModelParameters battery;
+
+    struct {
+        std::string vendor;
+        bool hasDynamicsConstants;
+        hako::assets::drone::RotorBatteryModelConstants dynamicsConstants;
+        int rpmMax;
+    } rotor;
+
+    struct {
+        std::string vendor;
+        std::vector<RotorPosition> rotorPositions;
+        std::map<std::string, double> parameters;   /* Ct など数値パラメータ */
+    } thruster;
+
+    std::map<std::string, DroneSensorConfigData> sensors;
+
+    struct {
+        std::vector<std::string> keys;              /* controller 直下に存在するキー */
+        std::string moduleName;
+        std::string moduleFilePath;
+        std::map<std::string, std::string> context;
+        std::map<std::string, std::map<std::string, DronePidGain>> pid;
+        bool hasMixer;
+        DroneMixerInfo mixer;
+        bool directRotorControl;
+    } controller;
+};
+
+/*
+ * スキーマチェック付きの JSON 読み出し
+ * エラーは "<json pointer>: <理由>" の形で溜めておき、最後にまとめて出力する。
+ */
+class DroneConfigSchemaReader {
+private:
+    std::vector<std::string> errors;
+
+public:
+    const std::vector<std::string>& get_errors() const { return errors; }
+    void error(const std::string& path, const std::string& reason)
+    {
+        errors.push_back(path + ": " + reason);
+    }
+    const nlohmann::json* object(const nlohmann::json& parent, const std::string& path, const char* key, bool required = true)
+    {
+        if (parent.is_object() && parent.contains(key)) {
+            const nlohmann::json& value = parent.at(key);
+            if (!value.is_object()) {
+                error(path + "/" + key, "must be an object");
+                return nullptr;
+            }
+            return &value;
+        }
+        if (required) {
+            error(path + "/" + key, "is missing");
+        }
+        return nullptr;
+    }
+    template <typename T>
+    bool value(const nlohmann::json* parent, const std::string& path, const char* key, T& out, bool required = true)
+    {
+        if (parent == nullptr) {
+            return false;
+        }
+        if (!parent->contains(key)) {
+            if (required) {
+                error(path + "/" + key, "is missing");
+            }
+            return false;
+        }
+        try {
+            out = parent->at(key).get<T>();
+        } catch (const nlohmann::json::exception& e) {
+            error(path + "/" + key, std::string("invalid type (") + e.what() + ")");
+            return false;
+        }
+        return true;
+    }
+    template <typename T>
+    bool array(const nlohmann::json* parent, const std::string& path, const char* key, std::vector<T>& out, size_t size, bool required = true)
+    {
+        if (!value(parent, path, key, out, required)) {
+            return false;
+        }
+        if ((size > 0) && (out.size() != size)) {
+            error(path + "/" + key, "must have " + std::to_string(size) + " elements");
+            return false;
+        }
+        return true;
+    }
+    template <typename T>
+    void table(const nlohmann::json* parent, const std::string& path, const char* key, std::map<std::string, T>& out)
+    {
+        const nlohmann::json* obj = (parent != nullptr) ? object(*parent, path, key, false) : nullptr;
+        if (obj == nullptr) {
+            return;
+        }
+        for (auto it = obj->begin(); it != obj->end(); ++it) {
+            T v;
+            if (value(obj, path + "/" + key, it.key().c_str(), v)) {
+                out[it.key()] = v;
+            }
+        }
+    }
+};
+
+static inline std::string drone_config_directory_with_separator(std::string directory)
+{
+    if (directory.empty() || (directory.back() != '/' && directory.back() != '\\')) {
+        directory += "/";
+    }
+    return directory;
+}
+
+static inline std::string drone_config_last_directory_name(const std::string& pathStr)
+{
+    std::filesystem::path pathObj(pathStr);
+
+    if (!pathObj.empty()) {
+        if (pathObj.filename() == "." || pathObj.filename() == ".." || pathObj.filename() == std::filesystem::path()) {
+            pathObj = pathObj.parent_path();
+        }
+        return pathObj.filename().string();
+    } else {
+        return "";
+    }
+}
+
+static inline std::string drone_config_module_path(const std::string& moduleDirectory, const std::string& moduleName)
+{
+#if WIN32
+    return drone_config_directory_with_separator(moduleDirectory) + moduleName + SHARED_LIB_EXT;
+#else
+    return drone_config_directory_with_separator(moduleDirectory) + "lib" + moduleName + SHARED_LIB_EXT;
+#endif
+}
+
+static inline void drone_config_parse_simulation(DroneConfigSchemaReader& r, const nlohmann::json& root, DroneConfigData& data)
+{
+    const std::string path = "/simulation";
+    const nlohmann::json* sim = r.object(root, "", "simulation");
+    if (r.value(sim, path, "timeStep", data.simulation.timeStep) && (data.simulation.timeStep <= 0)) {
+        r.error(path + "/timeStep", "must be positive");
+    }
+    r.value(sim, path, "lockstep", data.simulation.lockstep);
+    std::string directory = ".";
+    if (r.value(sim, path, "logOutputDirectory", directory)) {
+        if (!std::filesystem::exists(directory)) {
+            std::cerr << "Error: Log output directory '" << directory << "' does not exist." << std::endl;
+            directory = "./";
+        }
+    }
+    data.simulation.logOutputDirectory = drone_config_directory_with_separator(directory);
+
+    const nlohmann::json* log_output = (sim != nullptr) ? r.object(*sim, path, "logOutput", false) : nullptr;
+    r.table(log_output, path + "/logOutput", "sensors", data.simulation.sensorLogEnabled);
+    r.table(log_output, path + "/logOutput", "mavlink", data.simulation.mavlinkLogEnabled);
+    r.table(sim, path, "mavlink_tx_period_msec", data.simulation.mavlinkTxPeriodMsec);
+
+    const std::string loc_path = path + "/location";
+    const nlohmann::json* loc = (sim != nullptr) ? r.object(*sim, path, "location") : nullptr;
+    r.value(loc, loc_path, "latitude", data.simulation.latitude);
+    r.value(loc, loc_path, "longitude", data.simulation.longitude);
+    r.value(loc, loc_path, "altitude", data.simulation.altitude);
+    const nlohmann::json* mag = (loc != nullptr) ? r.object(*loc, loc_path, "magneticField") : nullptr;
+    r.value(mag, loc_path + "/magneticField", "intensity_nT", data.simulation.magneticField.intensity_nT);
+    r.value(mag, loc_path + "/magneticField", "declination_deg", data.simulation.magneticField.declination_deg);
+    r.value(mag, loc_path + "/magneticField", "inclination_deg", data.simulation.magneticField.inclination_deg);
+}
+
+static inline void drone_config_parse_drone_dynamics(DroneConfigSchemaReader& r, const nlohmann::json* comp, DroneConfigData& data)
+{
+    const std::string path = "/components/droneDynamics";
+    const nlohmann::json* dyn = (comp != nullptr) ? r.object(*comp, "/components", "droneDynamics") : nullptr;
+    auto& d = data.droneDynamics;
+    r.value(dyn, path, "physicsEquation", d.physicsEquation);
+    d.useQuaternion = false;
+    r.value(dyn, path, "useQuaternion", d.useQuaternion, false);
+    r.array(dyn, path, "airFrictionCoefficient", d.airFrictionCoefficient, 0);
+    r.value(dyn, path, "collision_detection", d.collisionDetection);
+    d.enableDisturbance = false;
+    r.value(dyn, path, "enable_disturbance", d.enableDisturbance, false);
+    r.value(dyn, path, "manual_control", d.manualControl);
+    r.array(dyn, path, "body_size", d.bodySize, 3);
+    r.array(dyn, path, "inertia", d.inertia, 3);
+    r.array(dyn, path, "position_meter", d.position, 3);
+    r.array(dyn, path, "angle_degree", d.angle, 3);
+    if (r.value(dyn, path, "mass_kg", d.mass) && (d.mass <= 0)) {
+        r.error(path + "/mass_kg", "must be positive");
+    }
+    const nlohmann::json* oob = (dyn != nullptr) ? r.object(*dyn, path, "out_of_bounds_reset", false) : nullptr;
+    if (oob != nullptr) {
+        hako::assets::drone::OutOfBoundsReset reset;
+        const std::string oob_path = path + "/out_of_bounds_reset";
+        r.array(oob, oob_path, "position", reset.position, 3);
+        r.array(oob, oob_path, "velocity", reset.velocity, 3);
+        r.array(oob, oob_path, "angular_velocity", reset.angular_velocity, 3);
+        d.outOfBoundsReset = reset;
+    }
+}
+
+static inline void drone_config_parse_battery(DroneConfigSchemaReader& r, const nlohmann::json* comp, DroneConfigData& data)
+{
+    const std::string path = "/components/battery";
+    const nlohmann::json* bat = (comp != nullptr) ? r.object(*comp, "/components", "battery", false) : nullptr;
+    data.hasBattery = (bat != nullptr);
+    data.battery = {};
+    if (bat == nullptr) {
+        return;
+    }
+    auto& b = data.battery;
+    r.value(bat, path, "vendor", b.vendor);
+    r.value(bat, path, "BatteryModelCsvFilePath", b.BatteryModelCsvFilePath, false);
+    b.model = "constant";
+    r.value(bat, path, "model", b.model, false);
+    r.value(bat, path, "VoltageLevelGreen", b.VoltageLevelGreen);
+    r.value(bat, path, "VoltageLevelYellow", b.VoltageLevelYellow);
+    r.value(bat, path, "NominalVoltage", b.NominalVoltage);
+    r.value(bat, path, "NominalCapacity", b.NominalCapacity);
+    r.value(bat, path, "EODVoltage", b.EODVoltage);
+    r.value(bat, path, "CapacityLevelYellow", b.CapacityLevelYellow);
+    b.ReferenceTemperature = 25.0;
+    r.value(bat, path, "InternalResistance", b.InternalResistance, false);
+    r.value(bat, path, "PolarizationResistance", b.PolarizationResistance, false);
+    r.value(bat, path, "PolarizationCapacitance", b.PolarizationCapacitance, false);
+    r.value(bat, path, "CapacityTemperatureCoefficient", b.CapacityTemperatureCoefficient, false);
+    r.value(bat, path, "ReferenceTemperature", b.ReferenceTemperature, false);
+    if (b.model == "thevenin") {
+        if (b.InternalResistance < 0) {
+            r.error(path + "/InternalResistance", "must not be negative");
+        }
+        if (b.PolarizationResistance < 0) {
+            r.error(path + "/PolarizationResistance", "must not be negative");
+        }
+        if (b.PolarizationCapacitance < 0) {
+            r.error(path + "/PolarizationCapacitance", "must not be negative");
+        }
+    }
+}
+
+static inline void drone_config_parse_rotor(DroneConfigSchemaReader& r, const nlohmann::json* comp, DroneConfigData& data)
+{
+    const std::string path = "/components/rotor";
+    const nlohmann::json* rotor = (comp != nullptr) ? r.object(*comp, "/components", "rotor") : nullptr;
+    data.rotor.vendor = "None";
+    r.value(rotor, path, "vendor", data.rotor.vendor, false);
+    data.rotor.rpmMax = 0;
+    r.value(rotor, path, "rpmMax", data.rotor.rpmMax, false);
+    data.rotor.dynamicsConstants = {};
+    const nlohmann::json* dc = (rotor != nullptr) ? r.object(*rotor, path, "dynamics_constants", false) : nullptr;
+    data.rotor.hasDynamicsConstants = (dc != nullptr);
+    if (dc != nullptr) {
+        auto& c = data.rotor.dynamicsConstants;
+        const std::string dc_path = path + "/dynamics_constants";
+        r.value(dc, dc_path, "R", c.R);
+        r.value(dc, dc_path, "Cq", c.Cq);
+        r.value(dc, dc_path, "K", c.K);
+        r.value(dc, dc_path, "D", c.D);
+        r.value(dc, dc_path, "J", c.J);
+    }
+}
+
+static inline void drone_config_parse_thruster(DroneConfigSchemaReader& r, const nlohmann::json* comp, DroneConfigData& data)
+{
+    const std::string path = "/components/thruster";
+    const nlohmann::json* thr = (comp != nullptr) ? r.object(*comp, "/components", "thruster") : nullptr;
+    data.thruster.vendor = "None";
+    if (thr == nullptr) {
+        return;
+    }
+    r.value(thr, path, "vendor", data.thruster.vendor, false);
+    if (!thr->contains("rotorPositions") || !thr->at("rotorPositions").is_array() || thr->at("rotorPositions").empty()) {
+        r.error(path + "/rotorPositions", "must be a non-empty array");
+    }
+    else {
+        const auto& positions = thr->at("rotorPositions");
+        for (size_t i = 0; i < positions.size(); i++) {
+            const std::string item_path = path + "/rotorPositions/" + std::to_string(i);
+            RotorPosition pos = {};
+            r.array(&positions[i], item_path, "position", pos.position, 3);
+            r.value(&positions[i], item_path, "rotationDirection", pos.rotationDirection);
+            data.thruster.rotorPositions.push_back(pos);
+        }
+    }
+    for (auto it = thr->begin(); it != thr->end(); ++it) {
+        if (it.value().is_number()) {
+            data.thruster.parameters[it.key()] = it.value().get<double>();
+        }
+    }
+}
+
+static inline void drone_config_parse_sensors(DroneConfigSchemaReader& r, const nlohmann::json* comp, DroneConfigData& data)
+{
+    const std::string path = "/components/sensors";
+    const nlohmann::json* sensors = (comp != nullptr) ? r.object(*comp, "/components", "sensors") : nullptr;
+    for (const char* name : { "acc", "gyro", "mag", "baro", "gps" }) {
+        const nlohmann::json* s = (sensors != nullptr) ? r.object(*sensors, path, name) : nullptr;
+        if (s == nullptr) {
+            continue;
+        }
+        const std::string s_path = path + "/" + name;
+        DroneSensorConfigData& sensor = data.sensors[name];
+        r.value(s, s_path, "sampleCount", sensor.sampleCount);
+        r.value(s, s_path, "noise", sensor.noise);
+        r.table(s, s_path, "context", sensor.context);
+        std::string moduleDirectory;
+        if (r.value(s, s_path, "vendor", moduleDirectory, false)) {
+            moduleDirectory = drone_config_directory_with_separator(moduleDirectory);
+            auto it = sensor.context.find("moduleName");
+            std::string moduleName = (it != sensor.context.end()) ? it->second : "";
+            if (moduleName.empty()) {
+                moduleName = drone_config_last_directory_name(moduleDirectory);
+            }
+            sensor.vendorPath = drone_config_module_path(moduleDirectory, moduleName);
+        }
+    }
+}
+
+static inline void drone_config_parse_controller(DroneConfigSchemaReader& r, const nlohmann::json& root, DroneConfigData& data)
+{
+    const std::string path = "/controller";
+    const nlohmann::json* ctrl = r.object(root, "", "controller", false);
+    auto& c = data.controller;
+    c.moduleName = data.name;
+    c.hasMixer = false;
+    c.mixer = {};
+    c.directRotorControl = false;
+    if (ctrl == nullptr) {
+        return;
+    }
+    for (auto it = ctrl->begin(); it != ctrl->end(); ++it) {
+        c.keys.push_back(it.key());
+    }
+    r.value(ctrl, path, "moduleName", c.moduleName, false);
+    std::string moduleDirectory;
+    if (r.value(ctrl, path, "moduleDirectory", moduleDirectory, false)) {
+        c.moduleFilePath = drone_config_module_path(moduleDirectory, c.moduleName);
+    }
+    r.table(ctrl, path, "context", c.context);
+    r.value(ctrl, path, "direct_rotor_control", c.directRotorControl, false);
+
+    const nlohmann::json* mixer = r.object(*ctrl, path, "mixer", false);
+    if (mixer != nullptr) {
+        r.value(mixer, path + "/mixer", "vendor", c.mixer.vendor);
+        r.value(mixer, path + "/mixer", "enableDebugLog", c.mixer.enableDebugLog);
+        r.value(mixer, path + "/mixer", "enableErrorLog", c.mixer.enableErrorLog);
+        c.mixer.enable = true;
+        c.hasMixer = true;
+    }
+
+    const nlohmann::json* pid = r.object(*ctrl, path, "pid", false);
+    if (pid != nullptr) {
+        for (auto group = pid->begin(); group != pid->end(); ++group) {
+            const std::string group_path = path + "/pid/" + group.key();
+            if (!group.value().is_object()) {
+                r.error(group_path, "must be an object");
+                continue;
+            }
+            for (auto axis = group.value().begin(); axis != group.value().end(); ++axis) {
+                const std::string axis_path = group_path + "/" + axis.key();
+                DronePidGain gain = {};
+                const nlohmann::json* g = &axis.value();
+                r.value(g, axis_path, "Kp", gain.Kp);
+                r.value(g, axis_path, "Ki", gain.Ki);
+                r.value(g, axis_path, "Kd", gain.Kd);
+                r.value(g, axis_path, "setpoint", gain.setpoint);
+                c.pid[group.key()][axis.key()] = gain;
+            }
+        }
+    }
+}
+
+/*
+ * configFilePath を解析して DroneConfigData を返す。
+ * スキーマエラーがあればすべて出力して nullptr を返す。
+ */
+static inline std::shared_ptr<const DroneConfigData> drone_config_data_parse(const std::string& configFilePath)
+{
+    nlohmann::json root;
+    std::ifstream configFile(configFilePath);
+    if (configFile.is_open()) {
+        try {
+            configFile >> root;
+        } catch (nlohmann::json::parse_error& e) {
+            std::cerr << "JSON parsing error: " << e.what() << std::endl;
+            return nullptr;
+        }
+    } else {
+        std::cerr << "Unable to open config file: " << configFilePath << std::endl;
+        return nullptr;
+    }
+    auto data = std::make_shared<DroneConfigData>();
+    DroneConfigSchemaReader r;
+    data->config_filepath = configFilePath;
+    r.value(&root, "", "name", data->name, false);
+    drone_config_parse_simulation(r, root, *data);
+    const nlohmann::json* comp = r.object(root, "", "components");
+    drone_config_parse_drone_dynamics(r, comp, *data);
+    drone_config_parse_battery(r, comp, *data);
+    drone_config_parse_rotor(r, comp, *data);
+    drone_config_parse_thruster(r, comp, *data);
+    drone_config_parse_sensors(r, comp, *data);
+    drone_config_parse_controller(r, root, *data);
+    if ((data->rotor.vendor == "BatteryModel") && (comp != nullptr)) {
+        if (!data->rotor.hasDynamicsConstants) {
+            r.error("/components/rotor/dynamics_constants", "is required for BatteryModel rotor");
+        }
+        if (data->battery.vendor != "None") {
+            r.error("/components/battery", "vendor \"None\" is required for BatteryModel rotor");
+        }
+    }
+    if (!r.get_errors().empty()) {
+        for (const auto& e : r.get_errors()) {
+            std::cerr << "ERROR: " << configFilePath << ": " << e << std::endl;
+        }
+        return nullptr;
+    }
+    return data;
+}
+
+#endif /* _DRONE_CONFIG_DATA_HPP_ */
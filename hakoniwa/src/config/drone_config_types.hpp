@@ -23,6 +23,7 @@ namespace hako::assets::drone {
         /* constant: バッテリ電圧が一定のモデル */
         /* linear: リニアモデル */
         /* custom: CSVファイルで指定するモデル */
+        /* thevenin: 等価回路(内部抵抗 + RC 1段)モデル */
         std::string model;
         /* 公称容量: [Ah] */
         /* バッテリーが供給できる理論上の電気量 */
@@ -38,6 +39,20 @@ namespace hako::assets::drone {
         double VoltageLevelYellow;
         /* 容量 Yellow レベルのミニマム値： [Ah] */
         double CapacityLevelYellow;
+        /*
+         * thevenin モデルのパラメータ
+         * 開放電圧は、CSV ファイルがあれば CSV の放電特性、なければ linear モデルの電圧とする
+         */
+        /* 内部抵抗: [Ω] */
+        double InternalResistance;
+        /* 分極抵抗: [Ω] */
+        double PolarizationResistance;
+        /* 分極容量: [F] */
+        double PolarizationCapacitance;
+        /* 容量の温度係数: [1/℃] 実効容量 = NominalCapacity * (1 + 係数 * (温度 - 基準温度)) */
+        double CapacityTemperatureCoefficient;
+        /* 容量の基準温度: [℃] */
+        double ReferenceTemperature;
     };
 }
 
@@ -21,6 +21,7 @@
 #define HAKO_AVATOR_CHANNEL_ID_LIDAR_DATA   16
 #define HAKO_AVATOR_CHANNEL_ID_LIDAR_POS    17
 #define HAKO_AVATOR_CHANNLE_ID_CTRL         18 /* for pid control program only */
+#define HAKO_AVATOR_CHANNEL_ID_REPLAY_CTRL  19 /* for replay program only */
 /*
 
         {
@@ -228,7 +229,7 @@ static inline bool do_io_write_battery_status(hako::assets::drone::IAirCraft *dr
     return false;
 }
 
-static inline void do_io_write(hako::assets::drone::IAirCraft *drone, const double controls[hako::assets::drone::ROTOR_NUM])
+static inline void do_io_write(hako::assets::drone::IAirCraft *drone, const double controls[])
 {
     Hako_HakoHilActuatorControls hil_actuator_controls;
     Hako_Twist pos;
@@ -236,7 +237,7 @@ static inline void do_io_write(hako::assets::drone::IAirCraft *drone, const doub
     char buffer_pos[HAKO_PDU_FIXED_DATA_SIZE_BY_TYPE(Hako_Twist)];
 
     memset(&hil_actuator_controls, 0, sizeof(hil_actuator_controls));
-    for (int i = 0; i < hako::assets::drone::ROTOR_NUM; i++) {
+    for (int i = 0; i < drone->get_rotor_num(); i++) {
         hil_actuator_controls.controls[i] = controls[i];
     }
     if (hako_pdu_put_fixed_data(buffer_hil_actuator, reinterpret_cast<const char*>(&hil_actuator_controls), sizeof(Hako_HakoHilActuatorControls), sizeof(buffer_hil_actuator)) < 0) {
@@ -42,6 +42,10 @@ bool mavlink_capture_append_data(MavlinkCaptureControllerType &controller, uint3
     auto now = std::chrono::system_clock::now();
     auto duration_since_epoch = now.time_since_epoch();
     uint64_t time_usec = std::chrono::duration_cast<std::chrono::microseconds>(duration_since_epoch).count();
+    return mavlink_capture_append_data_at(controller, owner, time_usec, dataLength, data);
+}
+
+bool mavlink_capture_append_data_at(MavlinkCaptureControllerType &controller, uint32_t owner, uint64_t time_usec, uint32_t dataLength, const uint8_t *data) {
     if (controller.packet_num == 0) {
         controller.start_time = time_usec;
     }
@@ -49,7 +53,7 @@ bool mavlink_capture_append_data(MavlinkCaptureControllerType &controller, uint3
     packet.dataLength = dataLength;
     packet.owner = owner;
     packet.relativeTimestamp = time_usec - controller.start_time;
-    uint64_t packet_size = sizeof(packet.dataLength) + sizeof(packet.owner) + (packet.relativeTimestamp) + dataLength;
+    uint64_t packet_size = sizeof(packet.dataLength) + sizeof(packet.owner) + sizeof(packet.relativeTimestamp) + dataLength;
 
     if (controller.offset + packet_size > controller.memsize) {
         controller.memsize += MAVLINK_CAPTURE_INC_DATA_SIZE;
@@ -8,6 +8,11 @@ extern bool mavlink_capture_create_controller(MavlinkCaptureControllerType &cont
 #define MAVLINK_CAPTURE_DATA_OWNER_CONTROL 0
 #define MAVLINK_CAPTURE_DATA_OWNER_PHYSICS 1
 extern bool mavlink_capture_append_data(MavlinkCaptureControllerType &controller, uint32_t owner, uint32_t dataLength, const uint8_t  *data);
+/*
+ * time_usec: 受信時刻(system_clock の epoch からの usec)
+ * 受信スレッドとは別スレッドで記録する場合に、受信時点の時刻を渡すために使う。
+ */
+extern bool mavlink_capture_append_data_at(MavlinkCaptureControllerType &controller, uint32_t owner, uint64_t time_usec, uint32_t dataLength, const uint8_t  *data);
 extern bool mavlink_capture_save(MavlinkCaptureControllerType &controller);
 
 #endif /* _MAVLINK_CAPTURE_HPP_ */
\ No newline at end of file
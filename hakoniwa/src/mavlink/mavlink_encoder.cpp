@@ -144,6 +144,17 @@ bool mavlink_encode_message(mavlink_message_t *msg, const MavlinkDecodedMessage
                 message->data.hil_gps.yaw  // Assuming yaw field is present in your struct
             );
             return true;
+        case MAVLINK_MSG_TYPE_HIL_ACTUATOR_CONTROLS:
+            mavlink_msg_hil_actuator_controls_pack(
+                MAVLINK_CONFIG_SYSTEM_ID,
+                MAVLINK_CONFIG_COMPONENT_ID,
+                msg,
+                message->data.hil_actuator_controls.time_usec,
+                message->data.hil_actuator_controls.controls,
+                message->data.hil_actuator_controls.mode,
+                message->data.hil_actuator_controls.flags
+            );
+            return true;
         default:
             std::cerr << "Unsupported message type for encoding: " << message->type << std::endl;
             return false;
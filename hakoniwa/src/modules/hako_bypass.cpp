@@ -1,10 +1,17 @@
 #include "hako_bypass.hpp"
 #include "../comm/tcp_connector.hpp"
+#include "../comm/udp_connector.hpp"
 #include "../utils/hako_params.hpp"
 #include "../mavlink/mavlink_capture.hpp"
 #include "../utils/hako_utils.hpp"
+#include "../utils/hako_spsc_queue.hpp"
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
 #include <iostream>
+#include <memory>
 #include "utils/csv_logger.hpp"
 #include "mavlink/log/mavlink_log_hil_sensor.hpp"
 #include "mavlink/log/mavlink_log_hil_gps.hpp"
@@ -24,15 +31,61 @@ static MavlinkLogHilSensor log_hil_sensor;
 static MavlinkLogHilGps log_hil_gps;
 static MavlinkLogHilActuatorControls log_hil_actuator_controls;
 
+/*
+ * 転送スレッドは recv -> send だけを行い、キャプチャと CSV ログは
+ * lock-free キュー経由でレコーダスレッドに任せる(転送経路で fsync や
+ * CSV 書き込みを待たないため)。キューが満杯の場合は記録側を捨てる。
+ * キャプチャ(fsync あり)と CSV ログはそれぞれ別のスレッド・キューで記録し、
+ * 一方が遅れても他方は止まらない。
+ */
+#define HAKO_BYPASS_FRAME_SIZE          1024
+#define HAKO_BYPASS_QUEUE_NUM           1024
+#define HAKO_BYPASS_RECORDER_IDLE_USEC  200
+#define HAKO_BYPASS_LATENCY_BUCKET_NUM  1024    /* 1usec 刻み, 最後のバケットは 1023usec 以上 */
+#define HAKO_BYPASS_LATENCY_REPORT_SEC  10
+
+typedef struct {
+    uint64_t time_usec;     /* 受信時刻(system_clock) */
+    uint32_t owner;
+    uint32_t len;
+    char data[HAKO_BYPASS_FRAME_SIZE];
+} HakoBypassFrameType;
+
+typedef hako::utils::SpscQueue<HakoBypassFrameType, HAKO_BYPASS_QUEUE_NUM> HakoBypassQueueType;
+
+/*
+ * 転送遅延(recv 完了から send 完了まで)のヒストグラム
+ * 転送スレッドが書き、レコーダスレッドが定期的に読み出してリセットする。
+ */
+typedef struct {
+    std::atomic<uint64_t> bucket[HAKO_BYPASS_LATENCY_BUCKET_NUM];
+    std::atomic<uint64_t> max_usec;
+    std::atomic<uint64_t> capture_dropped;
+    std::atomic<uint64_t> log_dropped;
+} HakoBypassLatencyType;
+
 typedef struct {
     const char* name;
     uint32_t owner;
     hako::px4::comm::ICommIO *src_comm;
     hako::px4::comm::ICommIO *dst_comm;
-    MavlinkCaptureControllerType *capture;
-    pthread_mutex_t *mutex;
+    HakoBypassQueueType *capture_queue;
+    HakoBypassQueueType *log_queue;
+    HakoBypassLatencyType *latency;
 } HakoBypassCommType;
 
+/*
+ * レコーダスレッド: 2方向のキュー queue[i](comm[i] のもの)を記録する
+ */
+typedef struct HakoBypassRecorder {
+    const char* name;
+    HakoBypassCommType *comm[2];
+    HakoBypassQueueType *queue[2];
+    MavlinkCaptureControllerType *capture;
+    void (*record)(struct HakoBypassRecorder *recorder, HakoBypassCommType *comm, const HakoBypassFrameType *frame);
+    bool report_latency;
+} HakoBypassRecorderType;
+
 static void hako_bypass_logging(const char* recvBuffer, int recvDataLen)
 {
     mavlink_message_t msg;
@@ -62,40 +115,142 @@ static void hako_bypass_logging(const char* recvBuffer, int recvDataLen)
     }    
 }
 
-static void *hako_bypass_thread(void *argp)
+static uint64_t hako_bypass_latency_percentile(const uint64_t *bucket, uint64_t count, double p)
 {
-    HakoBypassCommType *bypass_ctrl = (HakoBypassCommType*)argp;
-    std::cout << "INFO: start " << bypass_ctrl->name << " : " << bypass_ctrl->owner << std::endl;
+    uint64_t target = (uint64_t)(p * (double)count);
+    uint64_t sum = 0;
+    for (int i = 0; i < HAKO_BYPASS_LATENCY_BUCKET_NUM; i++) {
+        sum += bucket[i];
+        if (sum > target) {
+            return (uint64_t)i;
+        }
+    }
+    return HAKO_BYPASS_LATENCY_BUCKET_NUM - 1;
+}
 
-    if (bypass_ctrl->owner == MAVLINK_CAPTURE_DATA_OWNER_CONTROL) {
-        //px4
-        logger_hil_actuator_controls.add_entry(log_hil_actuator_controls, "./log_comm_hil_actuator_controls.csv");
+static void hako_bypass_latency_report(HakoBypassCommType *comm)
+{
+    uint64_t bucket[HAKO_BYPASS_LATENCY_BUCKET_NUM];
+    uint64_t count = 0;
+    for (int i = 0; i < HAKO_BYPASS_LATENCY_BUCKET_NUM; i++) {
+        bucket[i] = comm->latency->bucket[i].exchange(0, std::memory_order_relaxed);
+        count += bucket[i];
     }
-    else {
-        //airsim
-        logger_hil_sensor.add_entry(log_hil_sensor, "./log_comm_hil_sensor.csv");
-        logger_hil_gps.add_entry(log_hil_gps, "./log_comm_hil_gps.csv");
+    uint64_t max_usec = comm->latency->max_usec.exchange(0, std::memory_order_relaxed);
+    uint64_t capture_dropped = comm->latency->capture_dropped.exchange(0, std::memory_order_relaxed);
+    uint64_t log_dropped = comm->latency->log_dropped.exchange(0, std::memory_order_relaxed);
+    if (count == 0) {
+        return;
     }
+    std::cout << "INFO: bypass latency " << comm->name
+              << " count=" << count
+              << " p50=" << hako_bypass_latency_percentile(bucket, count, 0.50) << "us"
+              << " p99=" << hako_bypass_latency_percentile(bucket, count, 0.99) << "us"
+              << " max=" << max_usec << "us"
+              << " capture_dropped=" << capture_dropped
+              << " log_dropped=" << log_dropped
+              << std::endl;
+}
 
+static void hako_bypass_record_capture(HakoBypassRecorderType *recorder, HakoBypassCommType *comm, const HakoBypassFrameType *frame)
+{
+    if (mavlink_capture_append_data_at(*recorder->capture, frame->owner, frame->time_usec, frame->len, (const uint8_t*) frame->data) == false) {
+        std::cerr << "ERROR: " << comm->name << " Failed to capture data" << std::endl;
+    }
+}
+static void hako_bypass_record_log(HakoBypassRecorderType *recorder, HakoBypassCommType *comm, const HakoBypassFrameType *frame)
+{
+    (void)recorder;
+    (void)comm;
+    hako_bypass_logging(frame->data, (int)frame->len);
+}
+
+static void *hako_bypass_recorder_thread(void *argp)
+{
+    HakoBypassRecorderType *recorder = (HakoBypassRecorderType*)argp;
+    auto last_report = std::chrono::steady_clock::now();
     while (true) {
-        char recvBuffer[1024];
+        /*
+         * 2方向のキューから受信時刻の古い方を先に記録して、キャプチャファイル・
+         * ログ上の順序を保つ
+         */
+        int index = -1;
+        const HakoBypassFrameType *frame = nullptr;
+        for (int i = 0; i < 2; i++) {
+            const HakoBypassFrameType *f = recorder->queue[i]->front();
+            if ((f != nullptr) && ((frame == nullptr) || (f->time_usec < frame->time_usec))) {
+                index = i;
+                frame = f;
+            }
+        }
+        if (frame != nullptr) {
+            recorder->record(recorder, recorder->comm[index], frame);
+            recorder->queue[index]->release();
+        }
+        else {
+            usleep(HAKO_BYPASS_RECORDER_IDLE_USEC);
+        }
+        if (!recorder->report_latency) {
+            continue;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_report >= std::chrono::seconds(HAKO_BYPASS_LATENCY_REPORT_SEC)) {
+            for (auto *c : recorder->comm) {
+                hako_bypass_latency_report(c);
+            }
+            last_report = now;
+        }
+    }
+    return nullptr;
+}
+
+static bool hako_bypass_enqueue(HakoBypassQueueType *queue, uint32_t owner, uint64_t time_usec, const char* data, int len)
+{
+    HakoBypassFrameType *frame = queue->reserve();
+    if (frame == nullptr) {
+        return false;
+    }
+    frame->time_usec = time_usec;
+    frame->owner = owner;
+    frame->len = (uint32_t)len;
+    memcpy(frame->data, data, len);
+    queue->commit();
+    return true;
+}
+
+static void *hako_bypass_thread(void *argp)
+{
+    HakoBypassCommType *bypass_ctrl = (HakoBypassCommType*)argp;
+    std::cout << "INFO: start " << bypass_ctrl->name << " : " << bypass_ctrl->owner << std::endl;
+
+    while (true) {
+        char recvBuffer[HAKO_BYPASS_FRAME_SIZE];
         int recvDataLen;
         if (bypass_ctrl->src_comm->recv(recvBuffer, sizeof(recvBuffer), &recvDataLen)) 
         {
-            //std::cout << "Capture data with length: " << recvDataLen << std::endl;
-            pthread_mutex_lock(bypass_ctrl->mutex);
-            bool ret = mavlink_capture_append_data(*bypass_ctrl->capture, bypass_ctrl->owner, recvDataLen, (const uint8_t*) recvBuffer);
-            pthread_mutex_unlock(bypass_ctrl->mutex);
-            if (ret == false) {
-                std::cerr << "ERROR: " << bypass_ctrl->name << " Failed to capture data" << std::endl;
-            }
-            hako_bypass_logging(recvBuffer, recvDataLen);
-
+            auto recv_time = std::chrono::steady_clock::now();
+            uint64_t recv_time_usec = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
             int sndLen = 0;
-            ret = bypass_ctrl->dst_comm->send(recvBuffer, recvDataLen, &sndLen);
+            bool ret = bypass_ctrl->dst_comm->send(recvBuffer, recvDataLen, &sndLen);
             if (ret == false) {
                 //std::cerr << "ERROR: " << bypass_ctrl->name << " Failed to send data" << std::endl;
             }
+            auto send_time = std::chrono::steady_clock::now();
+            uint64_t latency_usec = std::chrono::duration_cast<std::chrono::microseconds>(send_time - recv_time).count();
+            HakoBypassLatencyType *latency = bypass_ctrl->latency;
+            latency->bucket[(latency_usec < HAKO_BYPASS_LATENCY_BUCKET_NUM) ? latency_usec : (HAKO_BYPASS_LATENCY_BUCKET_NUM - 1)]
+                .fetch_add(1, std::memory_order_relaxed);
+            if (latency_usec > latency->max_usec.load(std::memory_order_relaxed)) {
+                latency->max_usec.store(latency_usec, std::memory_order_relaxed);
+            }
+
+            if (!hako_bypass_enqueue(bypass_ctrl->capture_queue, bypass_ctrl->owner, recv_time_usec, recvBuffer, recvDataLen)) {
+                latency->capture_dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (!hako_bypass_enqueue(bypass_ctrl->log_queue, bypass_ctrl->owner, recv_time_usec, recvBuffer, recvDataLen)) {
+                latency->log_dropped.fetch_add(1, std::memory_order_relaxed);
+            }
         } else {
             //std::cerr << "ERROR: " << bypass_ctrl->name << " Failed to receive data" << std::endl;
         }
@@ -113,6 +268,11 @@ void hako_bypass_main(const char* sever_ipaddr, int server_portno)
     }
     hako::px4::comm::ICommIO *phys_comm  = nullptr;
     hako::px4::comm::ICommIO *ctrl_comm  = nullptr;
+    std::string transport = hako_param_env_get_string(HAKO_COMM_TRANSPORT);
+    hako::px4::comm::UdpSocketOptionType udp_option = { 0, 0 };
+    hako_param_env_get_integer(HAKO_UDP_RCVBUF_SIZE, &udp_option.rcvbuf_size);
+    hako_param_env_get_integer(HAKO_UDP_SNDBUF_SIZE, &udp_option.sndbuf_size);
+    std::cout << "INFO: comm transport: " << transport << std::endl;
     MavlinkCaptureControllerType capture;
     {
         const char* filepath = hako_param_env_get_string(HAKO_CAPTURE_SAVE_FILEPATH);
@@ -124,7 +284,13 @@ void hako_bypass_main(const char* sever_ipaddr, int server_portno)
         }
     }
     {
-        hako::px4::comm::TcpClient client;
+        std::unique_ptr<hako::px4::comm::ICommClient> client;
+        if (transport == "udp") {
+            client = std::make_unique<hako::px4::comm::UdpClient>(udp_option);
+        }
+        else {
+            client = std::make_unique<hako::px4::comm::TcpClient>();
+        }
         std::cout << "INFO: connecting phys server" << std::endl;
         const char* srv_ip = hako_param_env_get_string(HAKO_BYPASS_IPADDR);
         if (srv_ip == NULL) {
@@ -137,7 +303,7 @@ void hako_bypass_main(const char* sever_ipaddr, int server_portno)
         hako::px4::comm::IcommEndpointType physEndpoint = { srv_ip, portno };
         std::cout << "client ipaddr: " << physEndpoint.ipaddr << std::endl;
         std::cout << "client portno: " << physEndpoint.portno << std::endl;
-        phys_comm = client.client_open(nullptr, &physEndpoint);
+        phys_comm = client->client_open(nullptr, &physEndpoint);
         if (phys_comm == nullptr) 
         {
             HAKO_ABORT("Failed to connect phys");
@@ -145,40 +311,84 @@ void hako_bypass_main(const char* sever_ipaddr, int server_portno)
         std::cout << "INFO: connected phys server" << std::endl;
     }
     {
-        hako::px4::comm::TcpServer srv_comm;
+        std::unique_ptr<hako::px4::comm::ICommServer> srv_comm;
+        if (transport == "udp") {
+            srv_comm = std::make_unique<hako::px4::comm::UdpServer>(udp_option);
+        }
+        else {
+            srv_comm = std::make_unique<hako::px4::comm::TcpServer>();
+        }
         std::cout << "INFO: waiting for controller connection" << std::endl;
         hako::px4::comm::IcommEndpointType ctrlEndpoint = { sever_ipaddr, server_portno };
-        ctrl_comm = srv_comm.server_open(&ctrlEndpoint);
+        ctrl_comm = srv_comm->server_open(&ctrlEndpoint);
         if (ctrl_comm == nullptr) 
         {
             HAKO_ABORT("Failed to connect controller");
         }
         std::cout << "INFO: connected to controller" << std::endl;
     }
-    pthread_mutex_t capture_mutex = PTHREAD_MUTEX_INITIALIZER;
+    logger_hil_actuator_controls.add_entry(log_hil_actuator_controls, "./log_comm_hil_actuator_controls.csv");
+    logger_hil_sensor.add_entry(log_hil_sensor, "./log_comm_hil_sensor.csv");
+    logger_hil_gps.add_entry(log_hil_gps, "./log_comm_hil_gps.csv");
+
+    static HakoBypassQueueType phys2ctrl_capture_queue;
+    static HakoBypassQueueType ctrl2phys_capture_queue;
+    static HakoBypassQueueType phys2ctrl_log_queue;
+    static HakoBypassQueueType ctrl2phys_log_queue;
+    static HakoBypassLatencyType phys2ctrl_latency;
+    static HakoBypassLatencyType ctrl2phys_latency;
     static HakoBypassCommType phys2ctrl_arg;
+    static HakoBypassCommType ctrl2phys_arg;
+    phys2ctrl_arg.name = "phys2ctrl";
+    phys2ctrl_arg.src_comm = phys_comm;
+    phys2ctrl_arg.dst_comm = ctrl_comm;
+    phys2ctrl_arg.capture_queue = &phys2ctrl_capture_queue;
+    phys2ctrl_arg.log_queue = &phys2ctrl_log_queue;
+    phys2ctrl_arg.latency = &phys2ctrl_latency;
+    phys2ctrl_arg.owner = (uint32_t)MAVLINK_CAPTURE_DATA_OWNER_PHYSICS;
+
+    ctrl2phys_arg.name = "ctrl2phys";
+    ctrl2phys_arg.src_comm = ctrl_comm;
+    ctrl2phys_arg.dst_comm = phys_comm;
+    ctrl2phys_arg.capture_queue = &ctrl2phys_capture_queue;
+    ctrl2phys_arg.log_queue = &ctrl2phys_log_queue;
+    ctrl2phys_arg.latency = &ctrl2phys_latency;
+    ctrl2phys_arg.owner = (uint32_t)MAVLINK_CAPTURE_DATA_OWNER_CONTROL;
+
+    static HakoBypassRecorderType capture_recorder_arg;
+    capture_recorder_arg.name = "capture";
+    capture_recorder_arg.comm[0] = &phys2ctrl_arg;
+    capture_recorder_arg.comm[1] = &ctrl2phys_arg;
+    capture_recorder_arg.queue[0] = &phys2ctrl_capture_queue;
+    capture_recorder_arg.queue[1] = &ctrl2phys_capture_queue;
+    capture_recorder_arg.capture = &capture;
+    capture_recorder_arg.record = hako_bypass_record_capture;
+    capture_recorder_arg.report_latency = false;
+
+    static HakoBypassRecorderType log_recorder_arg;
+    log_recorder_arg.name = "log";
+    log_recorder_arg.comm[0] = &phys2ctrl_arg;
+    log_recorder_arg.comm[1] = &ctrl2phys_arg;
+    log_recorder_arg.queue[0] = &phys2ctrl_log_queue;
+    log_recorder_arg.queue[1] = &ctrl2phys_log_queue;
+    log_recorder_arg.capture = nullptr;
+    log_recorder_arg.record = hako_bypass_record_log;
+    log_recorder_arg.report_latency = true;
+
+    HakoBypassRecorderType *recorders[] = { &capture_recorder_arg, &log_recorder_arg };
+    for (auto *recorder : recorders) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, hako_bypass_recorder_thread, recorder) != 0) {
+            HAKO_ABORT("Failed to create thread recorder");
+        }
+    }
     {
         pthread_t thread;
-        phys2ctrl_arg.name = "phys2ctrl";
-        phys2ctrl_arg.src_comm = phys_comm;
-        phys2ctrl_arg.dst_comm = ctrl_comm;
-        phys2ctrl_arg.capture = &capture;
-        phys2ctrl_arg.mutex = &capture_mutex;
-        phys2ctrl_arg.owner = (uint32_t)MAVLINK_CAPTURE_DATA_OWNER_PHYSICS;
         if (pthread_create(&thread, NULL, hako_bypass_thread, &phys2ctrl_arg) != 0) {
             HAKO_ABORT("Failed to create thread phys2ctrl");
         }
     }
-    static HakoBypassCommType ctrl2phys_arg;
-    {
-        ctrl2phys_arg.name = "ctrl2phys";
-        ctrl2phys_arg.src_comm = ctrl_comm;
-        ctrl2phys_arg.dst_comm = phys_comm;
-        ctrl2phys_arg.capture = &capture;
-        ctrl2phys_arg.mutex = &capture_mutex;
-        ctrl2phys_arg.owner = (uint32_t)MAVLINK_CAPTURE_DATA_OWNER_CONTROL;
-        hako_bypass_thread(&ctrl2phys_arg);
-    }
+    hako_bypass_thread(&ctrl2phys_arg);
     HAKO_ABORT("Not reached: hako_bypass");
     return;
 }
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include "hako/runner/hako_px4_master.hpp"
 #include "config/drone_config.hpp"
 #include "utils/hako_params.hpp"
+#include "utils/hako_rtf_monitor.hpp"
 #include "utils/csv_logger.hpp"
 
 #include "utils/hako_osdep.h"
@@ -151,17 +152,23 @@ static void asset_runner()
         std::cerr << "ERROR: " << "hako_asset_runner_init() error" << std::endl;
         return;
     }
+    HakoRtfMonitor rtf_monitor;
+    rtf_monitor.init(delta_time_usec);
     while (true) {
         hako_asset_time = 0;
         std::cout << "INFO: start simulation" << std::endl;
         while (true) {
             if (hako_asset_runner_step(1) == false) {
                 std::cout << "INFO: stopped simulation" << std::endl;
+                rtf_monitor.stop();
                 break;
             }
             else {
                 hako_asset_time += delta_time_usec;
                 CsvLogger::set_time_usec(hako_asset_time);
+                if (rtf_monitor.step() == false) {
+                    std::exit(EXIT_FAILURE);
+                }
             }
         }
     }
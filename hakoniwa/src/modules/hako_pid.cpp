@@ -97,12 +97,7 @@ static void my_task()
         in.q = angular_velocity.data.y;
         in.r = angular_velocity.data.z;
 
-        if (module.control_module.controller != nullptr) {
-            out = module.control_module.controller->run(&in);
-        }
-        else {
-            out = module.controller->run(in);
-        }
+        out = module.run_controller(in);
 
         DroneThrustType thrust;
         DroneTorqueType torque;
@@ -7,6 +7,7 @@
 #include "config/drone_config.hpp"
 #include "hako/pdu/hako_pdu_accessor.hpp"
 #include "utils/hako_replayer.hpp"
+#include "utils/hako_rtf_monitor.hpp"
 #include "hako/runner/hako_px4_master.hpp"
 
 #include "utils/hako_osdep.h"
@@ -15,6 +16,7 @@
 #include <thread>
 
 static HakoReplayer hako_replayer;
+static Hako_uint64 replay_delta_time_usec = 0;
 
 #define HAKO_ASSET_NAME "hako-replay"
 static void* asset_runner(void*);
@@ -91,27 +93,50 @@ static inline void replay_for_controls(double hovering_force, const DroneThrustT
     }
     return;
 }
+/*
+ * 再生制御は Hako_Twist で受け取る(HAKO_AVATOR_CHANNEL_ID_REPLAY_CTRL)
+ *   linear.x  : 1 で一時停止, 0 で再生
+ *   linear.y  : 再生速度(0 以下は変更なし)
+ *   linear.z  : シーク先のログ時刻[sec]
+ *   angular.x : シーク要求番号(値が変わったときだけシークする)
+ */
+static void do_io_read_replay_control(const std::string& name)
+{
+    Hako_Twist packet;
+    char buffer[HAKO_PDU_FIXED_DATA_SIZE_BY_TYPE(Hako_Twist)];
+    if (!hako_asset_runner_pdu_read(name.c_str(), HAKO_AVATOR_CHANNEL_ID_REPLAY_CTRL, buffer, sizeof(buffer))) {
+        return;
+    }
+    if (hako_pdu_get_fixed_data(buffer, (char*)&packet, sizeof(Hako_Twist), sizeof(buffer)) < 0) {
+        return;
+    }
+    HakoReplayControl ctrl;
+    ctrl.paused = (packet.linear.x != 0.0);
+    ctrl.rate = packet.linear.y;
+    ctrl.seek_time_sec = packet.linear.z;
+    ctrl.seek_request_id = static_cast<uint64_t>(packet.angular.x);
+    hako_replayer.apply_control(name, ctrl);
+}
+
 static void my_task()
 {
     std::vector<std::string> vehicle_ids = hako_replayer.get_vehicle_ids();
     for (auto& id : vehicle_ids) {
-        std::vector<std::string> data;
-        if (hako_replayer.next(id, data)) {
+        do_io_read_replay_control(id);
+        HakoReplaySample sample;
+        if (hako_replayer.next(id, replay_delta_time_usec, sample)) {
             //X, Y, Z
             DronePositionType position;
-            position.data.x = std::stod(data[1]);
-            position.data.y = std::stod(data[2]);
-            position.data.z = std::stod(data[3]);
-            //std::cout << "position(" << position.data.x << ", " << position.data.y << ", " << position.data.z << " )" << std::endl;
+            position.data.x = sample.pos[0];
+            position.data.y = sample.pos[1];
+            position.data.z = sample.pos[2];
             //Rx, Ry, Rz
             DroneEulerType angle;
-            angle.data.x = std::stod(data[4]);
-            angle.data.y = std::stod(data[5]);
-            angle.data.z = std::stod(data[6]);
-            //std::cout << "angle(" << angle.data.x << ", " << angle.data.y << ", " << angle.data.z << " )" << std::endl;
+            angle.data.x = sample.euler[0];
+            angle.data.y = sample.euler[1];
+            angle.data.z = sample.euler[2];
             DroneThrustType thrust;
-            thrust.data = std::stod(data[13]);
-            //std::cout << "thrust(" << thrust.data << " )" << std::endl;
+            thrust.data = sample.thrust;
             double controls[hako::assets::drone::ROTOR_NUM];
             double param = hako_replayer.get_mass(id) * hako::assets::drone::GRAVITY;
             replay_for_controls(param, thrust, controls);
@@ -142,6 +167,7 @@ static void* asset_runner(void*)
         return nullptr;
     }
     Hako_uint64 delta_time_usec = static_cast<Hako_uint64>(drone_config.getSimTimeStep() * 1000000.0);
+    replay_delta_time_usec = delta_time_usec;
 
     hako_asset_runner_register_callback(&my_callbacks);
     const char* config_path = hako_param_env_get_string(HAKO_CUSTOM_JSON_PATH);
@@ -149,11 +175,17 @@ static void* asset_runner(void*)
         std::cerr << "ERROR: " << "hako_asset_runner_init() error" << std::endl;
         return nullptr;
     }
+    HakoRtfMonitor rtf_monitor;
+    rtf_monitor.init(delta_time_usec);
     while (true) {
         if (hako_asset_runner_step(1) == false) {
             std::cout << "INFO: stopped simulation" << std::endl;
+            rtf_monitor.stop();
             continue;
         }
+        if (rtf_monitor.step() == false) {
+            std::exit(EXIT_FAILURE);
+        }
     }
     std::cout << "INFO: end simulation" << std::endl;
     hako_asset_runner_fin();
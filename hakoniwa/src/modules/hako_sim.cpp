@@ -10,8 +10,16 @@
 #include "config/drone_config.hpp"
 #include "hako/pdu/hako_pdu_accessor.hpp"
 #include "comm/tcp_connector.hpp"
+#ifndef WIN32
+#include "comm/shm_connector.hpp"
+#include "comm/udp_connector.hpp"
+#endif
 #include "utils/hako_osdep.h"
 #include <memory.h>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
 #include <thread>
 
@@ -23,25 +31,60 @@ static void* asset_runner(void*);
 
 static hako::assets::drone::AirCraftManager drone_manager;
 
+/*
+ * 起動時間の内訳(config 解析, 機体生成, bind, PX4 の接続)
+ */
+static std::chrono::steady_clock::time_point hako_sim_startup_time;
+static void hako_sim_startup_report(const char* stage, std::chrono::steady_clock::time_point start)
+{
+    auto now = std::chrono::steady_clock::now();
+    std::cout << "INFO: startup: " << stage
+              << ": " << std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count() << " msec"
+              << " (total " << std::chrono::duration_cast<std::chrono::milliseconds>(now - hako_sim_startup_time).count() << " msec)"
+              << std::endl;
+}
+
 void hako_sim_main(bool master, hako::px4::comm::IcommEndpointType serverEndpoint)
 {
+    hako_sim_startup_time = std::chrono::steady_clock::now();
     if (hako::px4::comm::comm_init() != 0) {
         std::cerr << "ERROR: can not init tcp comm on " << std::endl;
         return;
     }
     std::string drone_config_directory = hako_param_env_get_string(DRONE_CONFIG_PATH);
+    auto stage_start = std::chrono::steady_clock::now();
     if (drone_config_manager.loadConfigsFromDirectory(drone_config_directory) == 0)
     {
         std::cerr << "ERROR: can not find drone config file on " << drone_config_directory << std::endl;
         return;
     }
+    hako_sim_startup_report("parse drone configs", stage_start);
     int max_delay_time_usec;
     if (hako_param_env_get_integer(HAKO_MAXDELAY_TIME_USEC, &max_delay_time_usec) == false) {
         HAKO_ABORT("Failed to get HAKO_MAXDELAY_TIME_USEC");
     }
     std::cout << "INFO: max_delay_time_usec: " << max_delay_time_usec << std::endl;
 
-    hako::px4::comm::TcpServer server;
+    std::unique_ptr<hako::px4::comm::ICommServer> server;
+    std::string transport = hako_param_env_get_string(HAKO_COMM_TRANSPORT);
+#ifndef WIN32
+    if (transport == "shm") {
+        server = std::make_unique<hako::px4::comm::ShmServer>();
+    }
+    else if (transport == "udp") {
+        hako::px4::comm::UdpSocketOptionType udp_option = { 0, 0 };
+        hako_param_env_get_integer(HAKO_UDP_RCVBUF_SIZE, &udp_option.rcvbuf_size);
+        hako_param_env_get_integer(HAKO_UDP_SNDBUF_SIZE, &udp_option.sndbuf_size);
+        server = std::make_unique<hako::px4::comm::UdpMuxServer>(udp_option);
+    }
+#endif
+    if (server == nullptr) {
+        if (transport != "tcp") {
+            std::cerr << "WARNING: unsupported transport: " << transport << ", use tcp" << std::endl;
+        }
+        server = std::make_unique<hako::px4::comm::TcpServer>();
+    }
+    std::cout << "INFO: comm transport: " << transport << std::endl;
     DroneConfig drone_config;
     if (drone_config_manager.getConfig(0, drone_config) == false) {
         std::cerr << "ERROR: " << "drone_config_manager.getConfig() error" << std::endl;
@@ -67,6 +110,30 @@ void hako_sim_main(bool master, hako::px4::comm::IcommEndpointType serverEndpoin
         }
 
     }
+    size_t configCount = drone_config_manager.getConfigCount();
+    /*
+     * 受信・送信スレッドが参照する機体ごとの情報は、接続待ちを始める前に用意する
+     */
+    if (px4sim_receiver_init(drone_config_manager) == false) {
+        return;
+    }
+    px4sim_sender_prepare(configCount);
+
+    /*
+     * 全機体のポートを先に bind しておき、PX4 側はどの順番で接続してもよいようにする
+     */
+    stage_start = std::chrono::steady_clock::now();
+    std::vector<hako::px4::comm::IcommEndpointType> endpoints(configCount);
+    for (size_t i = 0; i < configCount; ++i) {
+        endpoints[i] = serverEndpoint;
+        endpoints[i].portno = serverEndpoint.portno + i;
+        if (server->server_bind(&endpoints[i]) == false) {
+            std::cerr << "Failed to bind " << transport << " server: port=" << endpoints[i].portno << std::endl;
+            return;
+        }
+    }
+    hako_sim_startup_report("bind all ports", stage_start);
+
     try {
         std::thread thread(asset_runner, (void*)nullptr);
         thread.detach();
@@ -75,29 +142,52 @@ void hako_sim_main(bool master, hako::px4::comm::IcommEndpointType serverEndpoin
         std::cerr << "Failed to create asset_runner thread: " << e.what() << std::endl;
         return;
     }
-    size_t configCount = drone_config_manager.getConfigCount();
+    /*
+     * 機体ごとに接続待ちを並行して行い、接続したスレッドがそのまま受信スレッドになる
+     */
+    stage_start = std::chrono::steady_clock::now();
+    std::atomic<size_t> connected_count { 0 };
+    std::atomic<bool> startup_failed { false };
     std::vector<std::thread> threads;
     std::vector<Px4simRcvArgType> rcv_arg(configCount);
     for (size_t i = 0; i < configCount; ++i) {
-        hako::px4::comm::IcommEndpointType ep = serverEndpoint;
-        ep.portno = serverEndpoint.portno + i;
-        auto comm_io = server.server_open(&ep);
-        if (comm_io == nullptr) 
-        {
-            std::cerr << "Failed to open TCP server" << std::endl;
-            return;
-        }
-        px4sim_sender_init(comm_io);
-        rcv_arg[i].index = i;
-        rcv_arg[i].comm_io = comm_io;
         try {
-            threads.emplace_back(px4sim_thread_receiver, (void*)&rcv_arg[i]);
+            threads.emplace_back([&, i]() {
+                auto comm_io = server->server_open(&endpoints[i]);
+                if (comm_io == nullptr) 
+                {
+                    std::cerr << "Failed to open " << transport << " server: port=" << endpoints[i].portno << std::endl;
+                    startup_failed.store(true);
+                    return;
+                }
+                px4sim_sender_init(i, comm_io);
+                rcv_arg[i].index = i;
+                rcv_arg[i].comm_io = comm_io;
+                if (connected_count.fetch_add(1) + 1 == configCount) {
+                    hako_sim_startup_report("all vehicles connected", stage_start);
+                }
+                px4sim_thread_receiver((void*)&rcv_arg[i]);
+            });
         }
         catch (const std::exception& e) {
             std::cerr << "Failed to create px4sim_thread_receiver thread: " << e.what() << std::endl;
-            return;
+            startup_failed.store(true);
+            break;
         }
     }
+    /*
+     * 1機でも接続待ちに失敗したら、他の機体の接続待ちとアセットランナーごと異常終了する
+     */
+    while ((connected_count.load() < configCount) && (startup_failed.load() == false)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    if (startup_failed.load()) {
+        std::cerr << "ERROR: can not connect all vehicles: " << connected_count.load() << "/" << configCount << std::endl;
+        for (auto& thread : threads) {
+            thread.detach();
+        }
+        std::exit(EXIT_FAILURE);
+    }
     for (auto& thread : threads) {
         if (thread.joinable()) {
             thread.join();
@@ -111,6 +201,8 @@ void hako_sim_main(bool master, hako::px4::comm::IcommEndpointType serverEndpoin
 
 #include <chrono>
 #include "utils/csv_logger.hpp"
+#include "utils/hako_profiler.hpp"
+#include "utils/hako_rtf_monitor.hpp"
 bool CsvLogger::enable_flag = false;
 uint64_t CsvLogger::time_usec = 0; 
 class AircraftContainer
@@ -119,7 +211,7 @@ public:
     IAirCraft *drone;
     bool isRecvControl = false;
     int recv_count = 0;
-    double controls[hako::assets::drone::ROTOR_NUM] = { 0, 0, 0, 0};
+    double controls[hako::assets::drone::ROTOR_NUM_MAX] = {};
     hako::assets::drone::MavlinkIO mavlink_io;
     Hako_uint64 px4_time_usec;
     void reset() {
@@ -148,13 +240,17 @@ private:
     void send_sensor_data(Hako_uint64 _hako_asset_time_usec, Hako_uint64 microseconds)
     {
         for (auto& container : aircraft_container) {
+            HAKO_PROF_SCOPE(HAKO_PROF_MAVLINK_TX, container.drone->get_index());
             container.mavlink_io.write_sensor_data(*container.drone);
             px4sim_send_sensor_data(container.drone->get_index(), _hako_asset_time_usec, microseconds);
         }
+        HAKO_PROF_SCOPE(HAKO_PROF_MAVLINK_TX, -1);
+        px4sim_sender_flush();
     }
     bool recv_actuator_controls()
     {
         for (auto& container : aircraft_container) {
+            HAKO_PROF_SCOPE(HAKO_PROF_MAVLINK_RX, container.drone->get_index());
             if (container.mavlink_io.read_actuator_data(*container.drone, container.controls, container.px4_time_usec)) {
                 container.isRecvControl = true;
                 container.recv_count++;
@@ -168,6 +264,34 @@ private:
         }
         return true;
     }
+    /*
+     * PX4 の時刻は機体ごとに最初の HIL_ACTUATOR_CONTROLS からの経過時間なので、
+     * シミュレーション時刻も開始からの経過時間にして比べる
+     * 記録するのは、ずれの絶対値が最も大きい機体の値
+     */
+    void monitor_step()
+    {
+        const int64_t sim_time = static_cast<int64_t>(hako_asset_time_usec - activated_time_usec);
+        bool has_skew = false;
+        int64_t worst_skew = 0;
+        for (auto& container : aircraft_container) {
+            hako_time_t px4_time = px4sim_receiver_get_px4_time(container.drone->get_index());
+            if (px4_time <= 0) {
+                continue;
+            }
+            int64_t skew = sim_time - static_cast<int64_t>(px4_time);
+            if (!has_skew || std::llabs(skew) > std::llabs(worst_skew)) {
+                worst_skew = skew;
+                has_skew = true;
+            }
+        }
+        if (has_skew) {
+            rtf_monitor.record_skew(worst_skew);
+        }
+        if (rtf_monitor.step() == false) {
+            std::exit(EXIT_FAILURE);
+        }
+    }
     bool do_asset_task_nolockstep()
     {
         clear_rcv_flags();
@@ -179,9 +303,11 @@ private:
         }
         if (hako_asset_runner_step(1) == false) {
             std::cout << "INFO: stopped simulation" << std::endl;
+            rtf_monitor.stop();
             return false;
         }
         hako_asset_time_usec += delta_time_usec;
+        monitor_step();
         send_sensor_data(hako_asset_time_usec, activated_time_usec);
         return true;
     }
@@ -199,9 +325,11 @@ private:
         CsvLogger::set_time_usec(aircraft_container[0].px4_time_usec);
         if (hako_asset_runner_step(1) == false) {
             std::cout << "INFO: stopped simulation" << std::endl;
+            rtf_monitor.stop();
             return false;
         }
         hako_asset_time_usec += delta_time_usec;
+        monitor_step();
         send_sensor_data(hako_asset_time_usec, activated_time_usec);
         return true;
     }
@@ -210,6 +338,7 @@ public:
     Hako_uint64 hako_asset_time_usec;
     Hako_uint64 delta_time_usec;
     Hako_uint64 activated_time_usec;
+    HakoRtfMonitor rtf_monitor;
     void init(Hako_uint64 microseconds, Hako_uint64 dt_usec)
     {
         activated_time_usec = microseconds;
@@ -221,6 +350,8 @@ public:
             arg.drone = drone;
             aircraft_container.push_back(arg);
         }
+        HAKO_PROF_START(static_cast<int>(aircraft_container.size()), dt_usec * 1000);
+        rtf_monitor.init(dt_usec);
     }
     void do_task(bool lockStep)
     {
@@ -249,23 +380,28 @@ static AircraftTaskManager task_manager;
 
 static void my_task()
 {
+    HAKO_PROF_SCOPE(HAKO_PROF_STEP, -1);
     for (auto& container : task_manager.aircraft_container) {
         hako::assets::drone::DroneDynamicsInputType drone_input = {};
         drone_input.no_use_actuator = false;
         drone_input.manual.control = false;
-        if (container.drone->get_drone_dynamics().has_collision_detection()) {
-            do_io_read_collision(container.drone, drone_input.collision);
-        }
-        if (container.drone->get_drone_dynamics().has_manual_control()) {
-            do_io_read_manual(container.drone, drone_input.manual);
-        }
-        if (container.drone->is_enabled_disturbance()) {
-            do_io_read_disturb(container.drone, drone_input.disturbance);
+        {
+            HAKO_PROF_SCOPE(HAKO_PROF_PDU_IO, container.drone->get_index());
+            if (container.drone->get_drone_dynamics().has_collision_detection()) {
+                do_io_read_collision(container.drone, drone_input.collision);
+            }
+            if (container.drone->get_drone_dynamics().has_manual_control()) {
+                do_io_read_manual(container.drone, drone_input.manual);
+            }
+            if (container.drone->is_enabled_disturbance()) {
+                do_io_read_disturb(container.drone, drone_input.disturbance);
+            }
         }
-        for (int i = 0; i < hako::assets::drone::ROTOR_NUM; i++) {
+        for (int i = 0; i < container.drone->get_rotor_num(); i++) {
             drone_input.controls[i] = container.controls[i];
         }
         container.drone->run(drone_input);
+        HAKO_PROF_SCOPE(HAKO_PROF_PDU_IO, container.drone->get_index());
         do_io_write_battery_status(container.drone);
         do_io_write(container.drone, container.controls);
     }
@@ -306,9 +442,10 @@ static void* asset_runner(void*)
     auto duration = now.time_since_epoch();
     auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
     Hako_uint64 delta_time_usec = static_cast<Hako_uint64>(drone_config.getSimTimeStep() * 1000000.0);
-    px4sim_receiver_init(drone_config_manager);
     hako_pdu_data_init(drone_config_manager);
+    auto stage_start = std::chrono::steady_clock::now();
     task_manager.init(microseconds, delta_time_usec);
+    hako_sim_startup_report("create aircrafts", stage_start);
     bool lockstep = drone_config.getSimLockStep();
     hako_asset_runner_register_callback(&my_callbacks);
     const char* config_path = hako_param_env_get_string(HAKO_CUSTOM_JSON_PATH);
@@ -0,0 +1,450 @@
+/*
+ * Python から機体を直接動かすモジュール(pybind11)
+ *
+ * 箱庭のアセットランナーと PDU を使わず、create_aircraft() で作った N 機体と
+ * 制御モジュールをプロセス内で動かす。強化学習やゲイン最適化のように、
+ * 数百万ステップを回す用途向け。
+ *
+ *   sim = hakosim_native.Simulator("config/api_sample", num=64)
+ *   obs = sim.step(actions)   # actions: float64[N, 4] -> obs: float64[N, OBS_DIM]
+ *   states = sim.snapshot()   # uint8[N, state_size]
+ *   sim.restore(states)       # 途中の状態から何度でも分岐する
+ *
+ * - actions は C 連続の float64 配列をそのまま読む(型・配置が違う場合は変換せずエラー)
+ * - 観測値は新しい配列、または out に渡した配列に直接書く
+ * - 計算中は GIL を解放するので、別スレッドの Simulator は並列に動く
+ *   (1つの Simulator を複数のスレッドから同時に使うことはできない)
+ * - 制御モジュールはプロセスで共有する(FlightController は全機体の PID を
+ *   モジュール内の1つのバンクに置く)。そのため Simulator の生成・破棄は、
+ *   他の Simulator の step() 等が終わるまで待ち、その間は他の Simulator も止まる
+ *
+ * 行動(action)の種類
+ * - "thrust_torque": [推力, トルク x, トルク y, トルク z] をミキサー(なければ機体)に渡す
+ * - "radio_control": [roll, pitch, throttle, yaw rate] を制御モジュールの目標値(ラジコン操作)にする
+ *
+ * 観測値(OBS_DIM)
+ *   位置 x, y, z / オイラー角 x, y, z / 機体座標の速度 u, v, w / 機体座標の角速度 p, q, r / バッテリー電圧
+ *
+ * snapshot() は同じ設定の Simulator の間でのみ restore() できる(同じビルドであれば
+ * ファイルに保存してもよい)。制御モジュールの状態は v3 以降のモジュールとサンプルコントローラのみ含む。
+ *
+ * drone_config_manager はプロセスで1つのため、設定ディレクトリもプロセスで1つに限る。
+ * CSV ログは出力しない。
+ */
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include "assets/drone/aircraft/aircraft_factory.hpp"
+#include "utils/hako_aircraft_module.hpp"
+#include "utils/csv_logger.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace py = pybind11;
+using namespace hako::assets::drone;
+
+bool CsvLogger::enable_flag = false;
+uint64_t CsvLogger::time_usec = 0;
+class DroneConfigManager drone_config_manager;
+
+#define HAKO_SIM_ACTION_DIM     4
+#define HAKO_SIM_OBS_DIM        13
+
+typedef enum {
+    HAKO_SIM_ACTION_THRUST_TORQUE = 0,
+    HAKO_SIM_ACTION_RADIO_CONTROL,
+} HakoSimActionType;
+
+static std::string hako_sim_config_directory;
+/*
+ * 生成・破棄(制御モジュールへの機体の追加・削除)は排他、
+ * 計算(制御モジュールの実行と状態の読み書き)は共有で取る
+ */
+static std::shared_mutex hako_sim_module_mutex;
+
+class HakoSimNative {
+private:
+    AirCraftManager drone_manager;
+    HakoControllerModuleRegistry module_registry;
+    std::vector<AirCraftModule> modules;
+    AirCraftControllerBatch controller_batch;
+    std::vector<mi_drone_control_in_t> control_in;
+    std::vector<mi_drone_control_out_t> control_out;
+    std::vector<bool> control_active;
+    std::vector<DroneMixer*> mixer_ptrs;
+    std::vector<DroneMixerInputType> mixer_in;
+    std::vector<PwmDuty> mixer_duty;
+    HakoSimActionType action_type;
+    uint64_t time_usec = 0;
+    uint64_t delta_time_usec = 0;
+    size_t state_size = 0;
+
+    void reset_control_in(int index)
+    {
+        mi_drone_control_in_t& in = control_in[index];
+        in = {};
+        in.context = modules[index].get_context();
+        in.mass = modules[index].drone->get_drone_dynamics().get_mass();
+        in.drag = modules[index].drone->get_drone_dynamics().get_drag();
+    }
+    template <typename T>
+    void check_array(const py::array_t<T, py::array::c_style>& array, ssize_t dim, const char* name) const
+    {
+        if ((array.ndim() != 2) || (array.shape(0) != get_num()) || (array.shape(1) != dim)) {
+            throw py::value_error(std::string(name) + ": shape must be (" + std::to_string(get_num())
+                                  + ", " + std::to_string(dim) + ")");
+        }
+    }
+    /*
+     * DroneControlProxyManager::run() から PDU の入出力を除いたもの
+     */
+    void step_once(const double* actions)
+    {
+        const int num = get_num();
+        for (int index = 0; index < num; index++) {
+            const double* action = &actions[index * HAKO_SIM_ACTION_DIM];
+            if (action_type == HAKO_SIM_ACTION_RADIO_CONTROL) {
+                IAirCraft* drone = modules[index].drone;
+                mi_drone_control_in_t& in = control_in[index];
+                DronePositionType pos = drone->get_drone_dynamics().get_pos();
+                DroneEulerType angle = drone->get_drone_dynamics().get_angle();
+                DroneVelocityBodyFrameType velocity = drone->get_drone_dynamics().get_vel_body_frame();
+                DroneAngularVelocityBodyFrameType angular_velocity = drone->get_gyro().sensor_value();
+                in.max_rpm = drone->get_rpm_max(0);
+                in.pos_x = pos.data.x;
+                in.pos_y = pos.data.y;
+                in.pos_z = pos.data.z;
+                in.euler_x = angle.data.x;
+                in.euler_y = angle.data.y;
+                in.euler_z = angle.data.z;
+                in.u = velocity.data.x;
+                in.v = velocity.data.y;
+                in.w = velocity.data.z;
+                in.p = angular_velocity.data.x;
+                in.q = angular_velocity.data.y;
+                in.r = angular_velocity.data.z;
+                in.radio_control = 1;
+                in.target.attitude.roll = action[0];
+                in.target.attitude.pitch = action[1];
+                in.target.throttle.power = action[2];
+                in.target.direction_velocity.r = action[3];
+                control_out[index] = {};
+                control_active[index] = true;
+            }
+            else {
+                control_out[index] = {};
+                control_out[index].thrust = action[0];
+                control_out[index].torque_x = action[1];
+                control_out[index].torque_y = action[2];
+                control_out[index].torque_z = action[3];
+            }
+        }
+        if (action_type == HAKO_SIM_ACTION_RADIO_CONTROL) {
+            controller_batch.run(modules, control_active, [&](int index) -> mi_drone_control_in_t& {
+                return control_in[index];
+            }, control_out);
+        }
+        for (int index = 0; index < num; index++) {
+            const mi_drone_control_out_t& out = control_out[index];
+            mixer_ptrs[index] = modules[index].drone->get_mixer();
+            mixer_in[index] = { control_in[index].mass, out.thrust, out.torque_x, out.torque_y, out.torque_z };
+        }
+        DroneMixer::run_batch(mixer_ptrs.data(), mixer_in.data(), mixer_duty.data(), num);
+        for (int index = 0; index < num; index++) {
+            IAirCraft* drone = modules[index].drone;
+            const mi_drone_control_out_t& out = control_out[index];
+            DroneDynamicsInputType drone_input = {};
+            if (mixer_ptrs[index] != nullptr) {
+                for (int i = 0; i < drone->get_rotor_num(); i++) {
+                    drone_input.controls[i] = mixer_duty[index].d[i];
+                }
+                drone_input.no_use_actuator = false;
+            }
+            else if (drone->is_rotor_control_enabled()) {
+                for (int i = 0; i < drone->get_rotor_num(); i++) {
+                    drone_input.controls[i] = out.rotor.controls[i];
+                }
+                drone_input.no_use_actuator = false;
+            }
+            else {
+                drone_input.no_use_actuator = true;
+            }
+            drone_input.manual.control = false;
+            drone_input.thrust.data = out.thrust;
+            drone_input.torque.data.x = out.torque_x;
+            drone_input.torque.data.y = out.torque_y;
+            drone_input.torque.data.z = out.torque_z;
+            drone->run(drone_input);
+        }
+        time_usec += delta_time_usec;
+    }
+    void observe_all(double* obs)
+    {
+        const int num = get_num();
+        for (int index = 0; index < num; index++) {
+            IAirCraft* drone = modules[index].drone;
+            IDroneDynamics& dynamics = drone->get_drone_dynamics();
+            DronePositionType pos = dynamics.get_pos();
+            DroneEulerType angle = dynamics.get_angle();
+            DroneVelocityBodyFrameType velocity = dynamics.get_vel_body_frame();
+            DroneAngularVelocityBodyFrameType angular_velocity = dynamics.get_angular_vel_body_frame();
+            IBatteryDynamics* battery = drone->get_battery_dynamics();
+            double* o = &obs[index * HAKO_SIM_OBS_DIM];
+            o[0] = pos.data.x;
+            o[1] = pos.data.y;
+            o[2] = pos.data.z;
+            o[3] = angle.data.x;
+            o[4] = angle.data.y;
+            o[5] = angle.data.z;
+            o[6] = velocity.data.x;
+            o[7] = velocity.data.y;
+            o[8] = velocity.data.z;
+            o[9] = angular_velocity.data.x;
+            o[10] = angular_velocity.data.y;
+            o[11] = angular_velocity.data.z;
+            o[12] = (battery != nullptr) ? battery->get_vbat() : 0;
+        }
+    }
+    py::array_t<double, py::array::c_style> get_out(py::object out)
+    {
+        if (out.is_none()) {
+            return py::array_t<double, py::array::c_style>({ get_num(), HAKO_SIM_OBS_DIM });
+        }
+        if (!py::isinstance<py::array_t<double, py::array::c_style>>(out)) {
+            throw py::type_error("out: must be a C-contiguous float64 array");
+        }
+        auto array = out.cast<py::array_t<double, py::array::c_style>>();
+        check_array(array, HAKO_SIM_OBS_DIM, "out");
+        if (!array.writeable()) {
+            throw py::value_error("out: must be writeable");
+        }
+        return array;
+    }
+
+public:
+    /*
+     * config_dir: drone_config_N.json のあるディレクトリ
+     * num: 0 なら設定ファイルごとに1機、1以上なら drone_config_0.json の機体を num 機
+     */
+    HakoSimNative(const std::string& config_dir, int num, const std::string& action)
+    {
+        std::unique_lock<std::shared_mutex> lock(hako_sim_module_mutex, std::defer_lock);
+        {
+            py::gil_scoped_release release;
+            lock.lock();
+        }
+        if (action == "thrust_torque") {
+            action_type = HAKO_SIM_ACTION_THRUST_TORQUE;
+        }
+        else if (action == "radio_control") {
+            action_type = HAKO_SIM_ACTION_RADIO_CONTROL;
+        }
+        else {
+            throw py::value_error("unknown action: " + action);
+        }
+        if (hako_sim_config_directory.empty()) {
+            if (drone_config_manager.loadConfigsFromDirectory(config_dir) == 0) {
+                throw std::runtime_error("can not find drone config file on " + config_dir);
+            }
+            hako_sim_config_directory = config_dir;
+        }
+        else if (hako_sim_config_directory != config_dir) {
+            throw std::runtime_error("drone config is already loaded from " + hako_sim_config_directory);
+        }
+        CsvLogger::disable();
+        if (num > 0) {
+            if (!drone_manager.createSameAirCrafts(drone_config_manager, num)) {
+                throw std::runtime_error("can not create aircrafts");
+            }
+        }
+        else {
+            drone_manager.createAirCrafts(drone_config_manager);
+        }
+        for (auto* drone : drone_manager.getAllAirCrafts()) {
+            AirCraftModule module;
+            module.drone = drone;
+            if (action_type == HAKO_SIM_ACTION_RADIO_CONTROL) {
+                module.load(module_registry, (num > 0) ? 0 : drone->get_index());
+            }
+            modules.push_back(module);
+        }
+        if (modules.empty()) {
+            throw std::runtime_error("no aircraft is created");
+        }
+        DroneConfig drone_config;
+        drone_config_manager.getConfig(0, drone_config);
+        delta_time_usec = static_cast<uint64_t>(drone_config.getSimTimeStep() * 1000000.0);
+
+        size_t size = modules.size();
+        controller_batch.resize(size);
+        control_in.resize(size);
+        control_out.resize(size);
+        control_active.resize(size);
+        mixer_ptrs.resize(size);
+        mixer_in.resize(size);
+        mixer_duty.resize(size);
+        for (int index = 0; index < get_num(); index++) {
+            reset_control_in(index);
+        }
+        size_t max_size = 0;
+        for (auto& module : modules) {
+            max_size = std::max(max_size, module.get_state_size());
+            if ((action_type == HAKO_SIM_ACTION_RADIO_CONTROL) && !module.has_controller_state()) {
+                std::cerr << "WARNING: controller state of " << module.drone->get_name()
+                          << " is not included in snapshot" << std::endl;
+            }
+        }
+        state_size = sizeof(uint64_t) + max_size;
+    }
+    ~HakoSimNative()
+    {
+        std::unique_lock<std::shared_mutex> lock(hako_sim_module_mutex, std::defer_lock);
+        {
+            py::gil_scoped_release release;
+            lock.lock();
+        }
+        for (auto& module : modules) {
+            module.unload();
+        }
+    }
+    int get_num() const
+    {
+        return static_cast<int>(modules.size());
+    }
+    double get_dt() const
+    {
+        return static_cast<double>(delta_time_usec) / 1000000.0;
+    }
+    double get_time() const
+    {
+        return static_cast<double>(time_usec) / 1000000.0;
+    }
+    size_t get_state_size() const
+    {
+        return state_size;
+    }
+    /*
+     * index < 0 なら全機体とシミュレーション時間を戻す
+     */
+    void reset(int index)
+    {
+        if (index >= get_num()) {
+            throw py::index_error("index out of range: " + std::to_string(index));
+        }
+        int first = (index < 0) ? 0 : index;
+        int last = (index < 0) ? get_num() : (index + 1);
+        {
+            py::gil_scoped_release release;
+            std::shared_lock<std::shared_mutex> lock(hako_sim_module_mutex);
+            for (int i = first; i < last; i++) {
+                modules[i].reset();
+                reset_control_in(i);
+            }
+        }
+        if (index < 0) {
+            time_usec = 0;
+        }
+    }
+    /*
+     * 全機体の状態のスナップショット(1行が1機体: シミュレーション時間, 機体と制御の状態)
+     * CSV ログは含めない
+     */
+    py::array_t<uint8_t, py::array::c_style> snapshot()
+    {
+        py::array_t<uint8_t, py::array::c_style> states({ static_cast<ssize_t>(get_num()), static_cast<ssize_t>(state_size) });
+        uint8_t* ptr = states.mutable_data();
+        {
+            py::gil_scoped_release release;
+            std::shared_lock<std::shared_mutex> lock(hako_sim_module_mutex);
+            /* 状態が max_size より小さい機体の行の残りも 0 にする(未初期化のメモリを返さない) */
+            std::memset(ptr, 0, static_cast<size_t>(get_num()) * state_size);
+            for (int index = 0; index < get_num(); index++) {
+                uint8_t* row = &ptr[index * state_size];
+                std::memcpy(row, &time_usec, sizeof(uint64_t));
+                modules[index].save_state(row + sizeof(uint64_t));
+            }
+        }
+        return states;
+    }
+    /*
+     * snapshot() の状態に戻す
+     * index < 0 なら全機体とシミュレーション時間(先頭行)、そうでなければ index の機体のみ戻す
+     */
+    void restore(py::array_t<uint8_t, py::array::c_style> states, int index)
+    {
+        check_array(states, static_cast<ssize_t>(state_size), "states");
+        if (index >= get_num()) {
+            throw py::index_error("index out of range: " + std::to_string(index));
+        }
+        const uint8_t* ptr = states.data();
+        int first = (index < 0) ? 0 : index;
+        int last = (index < 0) ? get_num() : (index + 1);
+        {
+            py::gil_scoped_release release;
+            std::shared_lock<std::shared_mutex> lock(hako_sim_module_mutex);
+            for (int i = first; i < last; i++) {
+                modules[i].restore_state(&ptr[i * state_size] + sizeof(uint64_t));
+            }
+            if (index < 0) {
+                std::memcpy(&time_usec, ptr, sizeof(uint64_t));
+            }
+        }
+    }
+    py::array_t<double, py::array::c_style> observe(py::object out)
+    {
+        auto obs = get_out(out);
+        double* obs_ptr = obs.mutable_data();
+        {
+            py::gil_scoped_release release;
+            observe_all(obs_ptr);
+        }
+        return obs;
+    }
+    /*
+     * 同じ行動で substeps ステップ進め、最後の観測値を返す
+     */
+    py::array_t<double, py::array::c_style> step(py::array_t<double, py::array::c_style> actions, int substeps, py::object out)
+    {
+        check_array(actions, HAKO_SIM_ACTION_DIM, "actions");
+        if (substeps < 1) {
+            throw py::value_error("substeps must be >= 1");
+        }
+        auto obs = get_out(out);
+        const double* actions_ptr = actions.data();
+        double* obs_ptr = obs.mutable_data();
+        {
+            py::gil_scoped_release release;
+            std::shared_lock<std::shared_mutex> lock(hako_sim_module_mutex);
+            for (int k = 0; k < substeps; k++) {
+                step_once(actions_ptr);
+            }
+            observe_all(obs_ptr);
+        }
+        return obs;
+    }
+};
+
+PYBIND11_MODULE(hakosim_native, m)
+{
+    m.doc() = "in-process hakoniwa drone simulation without the asset runner";
+    m.attr("ACTION_DIM") = HAKO_SIM_ACTION_DIM;
+    m.attr("OBS_DIM") = HAKO_SIM_OBS_DIM;
+    py::class_<HakoSimNative>(m, "Simulator")
+        .def(py::init<const std::string&, int, const std::string&>(),
+             py::arg("config_dir"), py::arg("num") = 0, py::arg("action") = "thrust_torque")
+        .def("reset", &HakoSimNative::reset, py::arg("index") = -1)
+        .def("observe", &HakoSimNative::observe, py::arg("out") = py::none())
+        .def("snapshot", &HakoSimNative::snapshot)
+        .def("restore", &HakoSimNative::restore, py::arg("states").noconvert(), py::arg("index") = -1)
+        .def("step", &HakoSimNative::step,
+             py::arg("actions").noconvert(), py::arg("substeps") = 1, py::arg("out") = py::none())
+        .def_property_readonly("num", &HakoSimNative::get_num)
+        .def_property_readonly("dt", &HakoSimNative::get_dt)
+        .def_property_readonly("state_size", &HakoSimNative::get_state_size)
+        .def_property_readonly("time", &HakoSimNative::get_time);
+}
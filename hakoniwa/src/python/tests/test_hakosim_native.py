@@ -0,0 +1,152 @@
+import glob
+import os
+import unittest
+
+import numpy as np
+
+import hakosim_native
+
+# 設定ファイルの相対パス(制御モジュール等)は hakoniwa ディレクトリからの相対パス
+HAKONIWA_DIR = os.path.abspath(os.path.join(os.path.dirname(__file__), '../../..'))
+CONFIG_DIR = 'config/api_sample'
+CONTROLLER_MODULE_DIR = '../drone_control/cmake-build/workspace/FlightController'
+CONTROLLER_PARAM_FILE = '../drone_control/config/param-api-mixer.txt'
+NUM = 4
+
+
+def has_controller_module():
+    return len(glob.glob(os.path.join(HAKONIWA_DIR, CONTROLLER_MODULE_DIR, '*FlightController*'))) > 0
+
+
+class TestHakoSimNative(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        os.chdir(HAKONIWA_DIR)
+        os.environ.setdefault('HAKO_CONTROLLER_PARAM_FILE', CONTROLLER_PARAM_FILE)
+
+    def setUp(self):
+        self.sim = hakosim_native.Simulator(CONFIG_DIR, num=NUM)
+
+    def actions(self, thrust=0.0):
+        actions = np.zeros((NUM, hakosim_native.ACTION_DIM))
+        actions[:, 0] = thrust
+        return actions
+
+    def test_shape_dtype(self):
+        """行動の形・型が違う場合は変換せずにエラーにする"""
+        self.assertEqual(NUM, self.sim.num)
+        with self.assertRaises(ValueError):
+            self.sim.step(np.zeros((NUM, hakosim_native.ACTION_DIM - 1)))
+        with self.assertRaises(ValueError):
+            self.sim.step(np.zeros((NUM + 1, hakosim_native.ACTION_DIM)))
+        with self.assertRaises(ValueError):
+            self.sim.step(np.zeros(NUM * hakosim_native.ACTION_DIM))
+        with self.assertRaises(ValueError):
+            self.sim.step(self.actions(), substeps=0)
+
+    def test_noconvert(self):
+        """float64 の C 連続配列以外は受け付けない(暗黙の変換をしない)"""
+        with self.assertRaises(TypeError):
+            self.sim.step(self.actions().astype(np.float32))
+        with self.assertRaises(TypeError):
+            self.sim.step(np.zeros((NUM, hakosim_native.ACTION_DIM), dtype=np.int64))
+        with self.assertRaises(TypeError):
+            self.sim.step(np.zeros((NUM, hakosim_native.ACTION_DIM * 2))[:, ::2])
+        with self.assertRaises(TypeError):
+            self.sim.step(np.asfortranarray(np.zeros((NUM, hakosim_native.ACTION_DIM))))
+        with self.assertRaises(TypeError):
+            self.sim.step(self.actions().tolist())
+        states = self.sim.snapshot()
+        with self.assertRaises(TypeError):
+            self.sim.restore(states.astype(np.int16))
+        with self.assertRaises(ValueError):
+            self.sim.restore(states[:, :-1].copy())
+
+    def test_out(self):
+        """out に渡した配列に観測値を直接書く"""
+        out = np.full((NUM, hakosim_native.OBS_DIM), np.nan)
+        obs = self.sim.step(self.actions(), out=out)
+        self.assertTrue(np.shares_memory(obs, out))
+        self.assertFalse(np.isnan(out).any())
+        np.testing.assert_array_equal(self.sim.observe(), out)
+
+        out2 = np.full((NUM, hakosim_native.OBS_DIM), np.nan)
+        obs2 = self.sim.observe(out=out2)
+        self.assertTrue(np.shares_memory(obs2, out2))
+        np.testing.assert_array_equal(out, out2)
+
+        with self.assertRaises(ValueError):
+            self.sim.step(self.actions(), out=np.zeros((NUM, hakosim_native.OBS_DIM + 1)))
+        with self.assertRaises(TypeError):
+            self.sim.step(self.actions(), out=np.zeros((NUM, hakosim_native.OBS_DIM), dtype=np.float32))
+        with self.assertRaises(TypeError):
+            self.sim.observe(out=np.zeros((NUM, hakosim_native.OBS_DIM * 2))[:, ::2])
+        readonly = np.zeros((NUM, hakosim_native.OBS_DIM))
+        readonly.setflags(write=False)
+        with self.assertRaises(ValueError):
+            self.sim.observe(out=readonly)
+
+    def test_step_observe_reset(self):
+        """step で時間と機体が進み、reset で初期状態に戻る"""
+        obs0 = self.sim.observe()
+        self.assertEqual((NUM, hakosim_native.OBS_DIM), obs0.shape)
+        self.assertEqual(np.float64, obs0.dtype)
+        self.assertEqual(0.0, self.sim.time)
+
+        obs = self.sim.step(self.actions(thrust=20.0), substeps=100)
+        self.assertAlmostEqual(100 * self.sim.dt, self.sim.time)
+        self.assertFalse(np.array_equal(obs0, obs))
+        # 同じ設定・同じ行動の機体は同じ状態になる
+        for index in range(1, NUM):
+            np.testing.assert_array_equal(obs[0], obs[index])
+        np.testing.assert_array_equal(obs, self.sim.observe())
+
+        self.sim.reset(1)
+        obs = self.sim.observe()
+        np.testing.assert_array_equal(obs0[1], obs[1])
+        self.assertFalse(np.array_equal(obs0[0], obs[0]))
+        with self.assertRaises(IndexError):
+            self.sim.reset(NUM)
+
+        self.sim.reset()
+        self.assertEqual(0.0, self.sim.time)
+        np.testing.assert_array_equal(obs0, self.sim.observe())
+
+    def test_snapshot_restore(self):
+        """restore した状態から同じ行動で進めると同じ結果になる"""
+        self.sim.step(self.actions(thrust=20.0), substeps=50)
+        states = self.sim.snapshot()
+        self.assertEqual((NUM, self.sim.state_size), states.shape)
+        self.assertEqual(np.uint8, states.dtype)
+        # 同じ状態の snapshot はバイト単位で一致する(未使用領域も 0)
+        np.testing.assert_array_equal(states, self.sim.snapshot())
+        time = self.sim.time
+        obs1 = self.sim.step(self.actions(thrust=5.0), substeps=50)
+
+        self.sim.restore(states)
+        self.assertEqual(time, self.sim.time)
+        obs2 = self.sim.step(self.actions(thrust=5.0), substeps=50)
+        np.testing.assert_array_equal(obs1, obs2)
+
+    @unittest.skipUnless(has_controller_module(), 'FlightController module is not built')
+    def test_radio_control(self):
+        """制御モジュールを使う場合も restore 後は同じ結果になり、破棄後に作り直せる"""
+        actions = np.zeros((2, hakosim_native.ACTION_DIM))
+        actions[:, 2] = 1.0
+        for _ in range(2):
+            sim = hakosim_native.Simulator(CONFIG_DIR, num=2, action='radio_control')
+            obs0 = sim.observe()
+            sim.step(actions, substeps=200)
+            states = sim.snapshot()
+            obs1 = sim.step(actions, substeps=200)
+            self.assertFalse(np.array_equal(obs0, obs1))
+            sim.restore(states)
+            obs2 = sim.step(actions, substeps=200)
+            np.testing.assert_array_equal(obs1, obs2)
+            # 2回目はモジュール内の PID の枠を再利用する
+            del sim
+
+
+if __name__ == '__main__':
+    unittest.main()
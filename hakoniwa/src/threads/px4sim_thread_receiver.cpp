@@ -6,6 +6,7 @@
 #include "../threads/px4sim_thread_sender.hpp"
 #include "../hako/pdu/hako_pdu_data.hpp"
 #include "config/drone_config.hpp"
+#include <atomic>
 #include <iostream>
 
 #include "../mavlink/mavlink_msg_types.hpp"
@@ -18,12 +19,18 @@ class HakoRecvInfo {
 public:
     CsvLogger logger_recv;
     MavlinkLogHilActuatorControls log_hil_actuator_controls;
+    /*
+     * px4_boot_time は受信スレッドのみ, px4_asset_time はアセットランナーも読む
+     */
+    uint64_t px4_boot_time = 0;
+    std::atomic<hako_time_t> px4_asset_time { 0 };
 };
 static std::vector<std::unique_ptr<HakoRecvInfo>> hako_recv_info;
 
-
-hako_time_t hako_px4_asset_time = 0;
-static uint64_t px4_boot_time = 0;
+hako_time_t px4sim_receiver_get_px4_time(int index)
+{
+    return hako_recv_info[index]->px4_asset_time.load(std::memory_order_relaxed);
+}
 bool px4sim_receiver_init(DroneConfigManager& mgr)
 {
     for (int i = 0; i < mgr.getConfigCount(); i++)
@@ -54,14 +61,13 @@ static void hako_mavlink_write_data(int index, MavlinkDecodedMessage &message)
             hako_recv_info[index]->log_hil_actuator_controls.set_data(message.data.hil_actuator_controls);
             hako_recv_info[index]->logger_recv.run();
             hako_mavlink_write_hil_actuator_controls(index, message.data.hil_actuator_controls);
-            if (px4_boot_time == 0) {
-                px4_boot_time = message.data.hil_actuator_controls.time_usec;
+            if (hako_recv_info[index]->px4_boot_time == 0) {
+                hako_recv_info[index]->px4_boot_time = message.data.hil_actuator_controls.time_usec;
             }
             else {
-                hako_px4_asset_time = message.data.hil_actuator_controls.time_usec - px4_boot_time;
-                //std::cout << "px4_asset_time : " << hako_px4_asset_time << std::endl;
-                //std::cout << "hako_asset_time: " << hako_asset_time << std::endl;
-                //std::cout << "diff_time      : " << (long long)(hako_asset_time - hako_px4_asset_time) << std::endl;
+                hako_recv_info[index]->px4_asset_time.store(
+                    message.data.hil_actuator_controls.time_usec - hako_recv_info[index]->px4_boot_time,
+                    std::memory_order_relaxed);
             }
             break;
         case MAVLINK_MSG_TYPE_HEARTBEAT:
@@ -109,6 +115,7 @@ void *px4sim_thread_receiver(void *arg)
 #endif
                     if (message.type == MAVLINK_MSG_TYPE_LONG) {
                         px4sim_send_dummy_command_long_ack(*clientConnector);
+                        clientConnector->flush();
                     }
                     hako_mavlink_write_data(rcv_argp->index, message);
                 }
@@ -4,10 +4,14 @@
 #include "hako_capi.h"
 #include "config/drone_config.hpp"
 
-extern hako_time_t hako_px4_asset_time;
 extern hako_time_t hako_asset_time;
 
 extern bool px4sim_receiver_init(DroneConfigManager& mgr);
+/*
+ * index 番目の機体の PX4 の時刻(最初の HIL_ACTUATOR_CONTROLS からの経過時間, 未受信なら 0)
+ * 受信スレッド以外から読んでよい
+ */
+extern hako_time_t px4sim_receiver_get_px4_time(int index);
 typedef struct {
     int index;
     void* comm_io;
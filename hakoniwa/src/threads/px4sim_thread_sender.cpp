@@ -4,7 +4,9 @@
 #include "../comm/tcp_connector.hpp"
 #include "../hako/pdu/hako_pdu_data.hpp"
 #include "../mavlink/mavlink_dump.hpp"
+#include <atomic>
 #include <iostream>
+#include <memory>
 #include "utils/csv_logger.hpp"
 #include "mavlink/log/mavlink_log_hil_sensor.hpp"
 #include "mavlink/log/mavlink_log_hil_gps.hpp"
@@ -15,8 +17,6 @@
 static void px4sim_send_hil_gps(int index, hako::px4::comm::ICommIO &clientConnector, uint64_t time_usec);
 static void px4sim_send_sensor(int index, hako::px4::comm::ICommIO &clientConnector, uint64_t time_usec);
 
-static std::vector<std::unique_ptr<hako::px4::comm::ICommIO>> px4_comm_ios_unique;
-
 using hako::assets::drone::mavlink::log::MavlinkLogHilSensor;
 using hako::assets::drone::mavlink::log::MavlinkLogHilGps;
 
@@ -29,39 +29,56 @@ public:
     CsvLogger logger_hil_gps;
     MavlinkLogHilSensor log_hil_sensor;
     MavlinkLogHilGps log_hil_gps;
+    /*
+     * 接続スレッドが px4sim_sender_init() で設定し、シミュレーションスレッドが参照する
+     */
+    std::unique_ptr<hako::px4::comm::ICommIO> comm_io_owner;
+    std::atomic<hako::px4::comm::ICommIO*> comm_io { nullptr };
 };
 static std::vector<std::unique_ptr<HakoSenderInfo>> hako_sender_info;
 
-void px4sim_sender_init(hako::px4::comm::ICommIO *comm_io)
+/*
+ * 機体数分の送信先を用意する。接続(px4sim_sender_init)より前に1回だけ呼ぶ。
+ */
+void px4sim_sender_prepare(int vehicle_num)
+{
+    hako_sender_info.clear();
+    for (int i = 0; i < vehicle_num; i++) {
+        hako_sender_info.push_back(std::make_unique<HakoSenderInfo>());
+    }
+}
+
+/*
+ * index 番目の機体の接続を登録する。機体ごとの接続スレッドから並行に呼ばれる。
+ */
+void px4sim_sender_init(int index, hako::px4::comm::ICommIO *comm_io)
 {
     DroneConfig drone_config;
-    int index = px4_comm_ios_unique.size();
     if (drone_config_manager.getConfig(index, drone_config) == false) {
         std::cerr << "ERROR: " << "drone_config_manager.getConfig() error" << std::endl;
         return;
     }
-    px4_comm_ios_unique.push_back(std::unique_ptr<hako::px4::comm::ICommIO>(comm_io));
-    HakoSenderInfo* info = new HakoSenderInfo();
-    if (info == nullptr) {
-        std::cerr << "ERROR: " << "cannot allocate memory on sender_init" << std::endl;
+    if (index < 0 || index >= (int)hako_sender_info.size()) {
+        std::cerr << "ERROR: " << "px4sim_sender_init(): invalid index: " << index << std::endl;
         return;
     }
-    hako_sender_info.push_back(std::unique_ptr<HakoSenderInfo>(info));
-
+    HakoSenderInfo* info = hako_sender_info[index].get();
     info->logger_hil_sensor.add_entry(info->log_hil_sensor, drone_config.getSimLogFullPathFromIndex(index, "log_comm_hil_sensor.csv"));
     info->logger_hil_gps.add_entry(info->log_hil_gps, drone_config.getSimLogFullPathFromIndex(index, "log_comm_hil_gps.csv"));
+    info->comm_io_owner.reset(comm_io);
+    info->comm_io.store(comm_io, std::memory_order_release);
     std::cout << "INFO: px4sim_sender_init(): register comm_io: " << index << std::endl;
     return;
 }
 
 void px4sim_send_sensor_data(int index, Hako_uint64 time_usec, Hako_uint64 boot_time_usec)
 {
-    if (index < 0 || index >= (int)px4_comm_ios_unique.size()) {
+    if (index < 0 || index >= (int)hako_sender_info.size()) {
         //std::cerr << "ERROR: Index out of range: " << index << std::endl;
         return;
     }    
     (void)boot_time_usec;
-    auto* px4_comm_io = px4_comm_ios_unique[index].get();
+    auto* px4_comm_io = hako_sender_info[index]->comm_io.load(std::memory_order_acquire);
     if (px4_comm_io == nullptr) {
         return;
     }
@@ -73,6 +90,18 @@ void px4sim_send_sensor_data(int index, Hako_uint64 time_usec, Hako_uint64 boot_
     return;
 }
 
+/*
+ * 全機体分の送信をまとめて送る(UDP の sendmmsg など). 即時送信の transport では何もしない
+ */
+void px4sim_sender_flush(void)
+{
+    for (auto& info : hako_sender_info) {
+        auto* comm_io = info->comm_io.load(std::memory_order_acquire);
+        if (comm_io != nullptr) {
+            comm_io->flush();
+        }
+    }
+}
 
 void px4sim_send_message(hako::px4::comm::ICommIO &clientConnector, MavlinkDecodedMessage &message)
 {
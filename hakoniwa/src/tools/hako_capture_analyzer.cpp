@@ -0,0 +1,239 @@
+#include "hako_capture_analyzer.hpp"
+#include "../mavlink/mavlink_decoder.hpp"
+#include "../mavlink/mavlink_capture.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+const char* capture_msg_type_name(MavlinkMsgType type)
+{
+    switch (type) {
+        case MAVLINK_MSG_TYPE_HEARTBEAT:                return "HEARTBEAT";
+        case MAVLINK_MSG_TYPE_LONG:                     return "COMMAND_LONG";
+        case MAVLINK_MSG_TYPE_ACK:                      return "COMMAND_ACK";
+        case MAVLINK_MSG_TYPE_HIL_SENSOR:               return "HIL_SENSOR";
+        case MAVLINK_MSG_TYPE_HIL_STATE_QUATERNION:     return "HIL_STATE_QUATERNION";
+        case MAVLINK_MSG_TYPE_SYSTEM_TIME:              return "SYSTEM_TIME";
+        case MAVLINK_MSG_TYPE_HIL_GPS:                  return "HIL_GPS";
+        case MAVLINK_MSG_TYPE_HIL_ACTUATOR_CONTROLS:    return "HIL_ACTUATOR_CONTROLS";
+        default:                                        return "UNKNOWN";
+    }
+}
+const char* capture_owner_name(uint32_t owner)
+{
+    return (owner == MAVLINK_CAPTURE_DATA_OWNER_CONTROL) ? "control" : "physics";
+}
+
+/*
+ * Walk the record headers only. This is a cheap sequential pass over the
+ * already loaded buffer and gives every worker an independent record range.
+ */
+bool capture_build_index(const MavlinkCaptureControllerType& controller, std::vector<CaptureRecordRefType>& index)
+{
+    uint64_t offset = 0;
+    index.reserve(controller.packet_num);
+    while (offset + CAPTURE_RECORD_HEADER_SIZE <= controller.total_size) {
+        CaptureRecordRefType ref;
+        memcpy(&ref.length, controller.data + offset, sizeof(uint32_t));
+        memcpy(&ref.owner, controller.data + offset + sizeof(uint32_t), sizeof(uint32_t));
+        memcpy(&ref.timestamp, controller.data + offset + 2 * sizeof(uint32_t), sizeof(uint64_t));
+        ref.offset = offset + CAPTURE_RECORD_HEADER_SIZE;
+        if (ref.offset + ref.length > controller.total_size) {
+            std::cerr << "WARNING: truncated record at offset " << offset << std::endl;
+            break;
+        }
+        index.push_back(ref);
+        offset = ref.offset + ref.length;
+    }
+    return !index.empty();
+}
+
+/*
+ * mavlink_parse_char() keeps its parser state per channel in a global table,
+ * so workers use mavlink_frame_char_buffer() with their own status instead.
+ */
+static bool decode_packet(const uint8_t* data, uint32_t len, mavlink_message_t& msg)
+{
+    mavlink_message_t rxmsg;
+    mavlink_status_t status;
+    mavlink_status_t r_status;
+    memset(&rxmsg, 0, sizeof(rxmsg));
+    memset(&status, 0, sizeof(status));
+    bool received = false;
+    for (uint32_t i = 0; i < len; i++) {
+        if (mavlink_frame_char_buffer(&rxmsg, &status, data[i], &msg, &r_status) == MAVLINK_FRAMING_OK) {
+            received = true;
+        }
+    }
+    return received;
+}
+
+static void decode_chunk(const MavlinkCaptureControllerType* controller,
+    const std::vector<CaptureRecordRefType>* index, size_t begin, size_t end, ChunkResult* result)
+{
+    result->records.reserve(end - begin);
+    for (size_t i = begin; i < end; i++) {
+        const CaptureRecordRefType& ref = (*index)[i];
+        mavlink_message_t msg;
+        if (!decode_packet(controller->data + ref.offset, ref.length, msg)) {
+            result->decode_errors++;
+            continue;
+        }
+        CaptureDecodedRecordType rec;
+        rec.timestamp = ref.timestamp;
+        rec.owner = ref.owner;
+        if (!mavlink_get_message(&msg, &rec.message)) {
+            result->unknown_messages++;
+            continue;
+        }
+        result->records.push_back(rec);
+    }
+}
+
+void capture_decode(const MavlinkCaptureControllerType& controller, const std::vector<CaptureRecordRefType>& index,
+    unsigned threads, std::vector<ChunkResult>& chunks)
+{
+    chunks.clear();
+    if (index.empty()) {
+        return;
+    }
+    size_t chunk_num = std::min<size_t>(std::max(1u, threads), index.size());
+    size_t chunk_size = (index.size() + chunk_num - 1) / chunk_num;
+    chunks.resize(chunk_num);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < chunk_num; i++) {
+        size_t begin = i * chunk_size;
+        size_t end = std::min(index.size(), begin + chunk_size);
+        workers.emplace_back(decode_chunk, &controller, &index, begin, end, &chunks[i]);
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+}
+
+/*
+ * CSV rows follow the columns of mavlink/log/mavlink_log_*.hpp so the output
+ * can be fed to the same plotting scripts as the online logs.
+ */
+bool capture_format_csv_row(const CaptureDecodedRecordType& rec, std::string& out)
+{
+    char buf[512];
+    int n = 0;
+    switch (rec.message.type) {
+        case MAVLINK_MSG_TYPE_HIL_SENSOR:
+        {
+            const mavlink_hil_sensor_t& m = rec.message.data.sensor;
+            n = std::snprintf(buf, sizeof(buf), "%llu,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f\n",
+                (unsigned long long)rec.timestamp, m.xacc, m.yacc, m.zacc, m.xgyro, m.ygyro, m.zgyro,
+                m.xmag, m.ymag, m.zmag, m.abs_pressure, m.diff_pressure, m.pressure_alt, m.temperature);
+            break;
+        }
+        case MAVLINK_MSG_TYPE_HIL_GPS:
+        {
+            const mavlink_hil_gps_t& m = rec.message.data.hil_gps;
+            n = std::snprintf(buf, sizeof(buf), "%llu,%d,%d,%d,%u,%u,%u,%d,%d,%d,%u,%u,%u,%u\n",
+                (unsigned long long)rec.timestamp, m.lat, m.lon, m.alt, m.eph, m.epv, m.vel,
+                m.vn, m.ve, m.vd, m.cog, m.satellites_visible, m.id, m.yaw);
+            break;
+        }
+        case MAVLINK_MSG_TYPE_HIL_ACTUATOR_CONTROLS:
+        {
+            const mavlink_hil_actuator_controls_t& m = rec.message.data.hil_actuator_controls;
+            n = std::snprintf(buf, sizeof(buf), "%llu,%u,%llu", (unsigned long long)rec.timestamp,
+                m.mode, (unsigned long long)m.flags);
+            for (int i = 0; i < 16 && n > 0 && n < (int)sizeof(buf); i++) {
+                n += std::snprintf(buf + n, sizeof(buf) - n, ",%f", m.controls[i]);
+            }
+            if (n > 0 && n < (int)sizeof(buf) - 1) {
+                buf[n++] = '\n';
+                buf[n] = '\0';
+            }
+            break;
+        }
+        default:
+            return false;
+    }
+    if (n <= 0 || n >= (int)sizeof(buf)) {
+        return false;
+    }
+    out.append(buf, n);
+    return true;
+}
+const char* capture_csv_header(MavlinkMsgType type)
+{
+    switch (type) {
+        case MAVLINK_MSG_TYPE_HIL_SENSOR:
+            return "timestamp,xacc,yacc,zacc,xgyro,ygyro,zgyro,xmag,ymag,zmag,abs_pressure,diff_pressure,pressure_alt,temperature\n";
+        case MAVLINK_MSG_TYPE_HIL_GPS:
+            return "timestamp,lat,lon,alt,eph,epv,vel,vn,ve,vd,cog,satellites_visible,id,yaw\n";
+        case MAVLINK_MSG_TYPE_HIL_ACTUATOR_CONTROLS:
+            return "timestamp,mode,flags,controls[0],controls[1],controls[2],controls[3],"
+                   "controls[4],controls[5],controls[6],controls[7],controls[8],controls[9],"
+                   "controls[10],controls[11],controls[12],controls[13],controls[14],controls[15]\n";
+        default:
+            return nullptr;
+    }
+}
+
+/*
+ * Each worker formats its own chunk into per-stream buffers, the main thread
+ * only concatenates them in chunk order.
+ */
+static void format_chunk(const ChunkResult* chunk, bool csv, std::map<StreamKey, std::string>* out)
+{
+    for (const auto& rec : chunk->records) {
+        StreamKey key = { rec.message.type, rec.owner };
+        if (csv) {
+            if (capture_csv_header(key.type) == nullptr) {
+                continue;
+            }
+            (void)capture_format_csv_row(rec, (*out)[key]);
+        }
+        else {
+            CaptureBinaryRecordHeaderType hdr = { rec.timestamp, rec.owner, (uint32_t)rec.message.type };
+            std::string& buf = (*out)[key];
+            buf.append(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+            buf.append(reinterpret_cast<const char*>(&rec.message.data), sizeof(rec.message.data));
+        }
+    }
+}
+
+bool capture_write_outputs(const std::vector<ChunkResult>& chunks, const std::string& dir, bool csv, unsigned threads)
+{
+    std::vector<std::map<StreamKey, std::string>> formatted(chunks.size());
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < chunks.size(); i++) {
+        workers.emplace_back(format_chunk, &chunks[i], csv, &formatted[i]);
+        if (workers.size() >= threads) {
+            for (auto& w : workers) w.join();
+            workers.clear();
+        }
+    }
+    for (auto& w : workers) w.join();
+
+    std::map<StreamKey, std::ofstream> files;
+    for (const auto& part : formatted) {
+        for (const auto& [key, buf] : part) {
+            auto it = files.find(key);
+            if (it == files.end()) {
+                std::string path = dir + "/" + capture_msg_type_name(key.type) + "_" + capture_owner_name(key.owner) + (csv ? ".csv" : ".bin");
+                std::ofstream ofs(path, std::ios::out | std::ios::binary);
+                if (!ofs.is_open()) {
+                    std::cerr << "ERROR: can not open " << path << std::endl;
+                    return false;
+                }
+                if (csv) {
+                    ofs << capture_csv_header(key.type);
+                }
+                std::cout << "INFO: write " << path << std::endl;
+                it = files.emplace(key, std::move(ofs)).first;
+            }
+            it->second.write(buf.data(), buf.size());
+        }
+    }
+    return true;
+}
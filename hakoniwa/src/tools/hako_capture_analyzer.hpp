@@ -0,0 +1,78 @@
+#ifndef _HAKO_CAPTURE_ANALYZER_HPP_
+#define _HAKO_CAPTURE_ANALYZER_HPP_
+
+/*
+ * Decoder/converter core of hako-capture-tool.
+ *
+ * Split from the command line front end so that the conversion can be
+ * checked without running the tool (see test/src/tools).
+ */
+#include "mavlink.h"
+#include "../mavlink/mavlink_msg_types.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#define CAPTURE_RECORD_HEADER_SIZE  (sizeof(uint32_t) + sizeof(uint32_t) + sizeof(uint64_t))
+
+typedef struct {
+    uint64_t offset; /* offset of packet data in controller.data */
+    uint32_t length;
+    uint32_t owner;
+    uint64_t timestamp;
+} CaptureRecordRefType;
+
+typedef struct {
+    uint64_t timestamp;
+    uint32_t owner;
+    MavlinkDecodedMessage message;
+} CaptureDecodedRecordType;
+
+/*
+ * Binary output record. One file per message type, fixed size records:
+ * this header followed by the decoded payload union (MavlinkDecodedMessage::data).
+ */
+typedef struct {
+    uint64_t timestamp;
+    uint32_t owner;
+    uint32_t type;
+} CaptureBinaryRecordHeaderType;
+
+struct StreamKey {
+    MavlinkMsgType type;
+    uint32_t owner;
+    bool operator<(const StreamKey& other) const
+    {
+        return (type != other.type) ? (type < other.type) : (owner < other.owner);
+    }
+};
+
+struct ChunkResult {
+    std::vector<CaptureDecodedRecordType> records;
+    uint64_t decode_errors = 0;
+    uint64_t unknown_messages = 0;
+};
+
+extern const char* capture_msg_type_name(MavlinkMsgType type);
+extern const char* capture_owner_name(uint32_t owner);
+/*
+ * Walk the record headers of a loaded capture (mavlink_capture_load_controller()).
+ */
+extern bool capture_build_index(const MavlinkCaptureControllerType& controller, std::vector<CaptureRecordRefType>& index);
+/*
+ * Decode all records with up to `threads` workers. chunks are in file order.
+ */
+extern void capture_decode(const MavlinkCaptureControllerType& controller, const std::vector<CaptureRecordRefType>& index,
+    unsigned threads, std::vector<ChunkResult>& chunks);
+/*
+ * CSV header/row in the column layout of mavlink/log. nullptr/false for types without CSV output.
+ */
+extern const char* capture_csv_header(MavlinkMsgType type);
+extern bool capture_format_csv_row(const CaptureDecodedRecordType& rec, std::string& out);
+/*
+ * One file per stream: <dir>/<TYPE>_<owner>.csv or .bin
+ */
+extern bool capture_write_outputs(const std::vector<ChunkResult>& chunks, const std::string& dir, bool csv, unsigned threads);
+
+#endif /* _HAKO_CAPTURE_ANALYZER_HPP_ */
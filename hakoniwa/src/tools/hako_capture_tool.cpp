@@ -0,0 +1,159 @@
+/*
+ * hako-capture-tool
+ *
+ * Offline analyzer/converter for capture files written by mavlink_capture_save().
+ * The file is decoded in parallel chunks at disk speed (no usleep pacing), then
+ *   - per message type statistics (rate, inter-arrival jitter percentiles, gaps)
+ *   - optional conversion to CSV (same columns as mavlink/log) or binary records
+ *
+ * usage: hako-capture-tool <capture file> [-j threads] [--csv dir | --bin dir] [--gap-factor N]
+ */
+#include "hako_capture_analyzer.hpp"
+#include "../mavlink/mavlink_capture_replay.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+struct ToolOptions {
+    const char* filepath = nullptr;
+    unsigned threads = 0;
+    std::string csv_dir;
+    std::string bin_dir;
+    double gap_factor = 3.0;
+};
+
+static uint64_t percentile(const std::vector<uint64_t>& sorted, double p)
+{
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t idx = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+static void print_stats(const std::map<StreamKey, std::vector<uint64_t>>& streams, double gap_factor)
+{
+    std::printf("%-22s %-8s %10s %10s %10s %10s %10s %10s %10s %6s\n",
+        "type", "owner", "count", "rate[Hz]", "p50[us]", "p90[us]", "p99[us]", "max[us]", "jitter[us]", "gaps");
+    for (const auto& [key, timestamps] : streams) {
+        std::vector<uint64_t> deltas;
+        if (timestamps.size() > 1) {
+            deltas.reserve(timestamps.size() - 1);
+            for (size_t i = 1; i < timestamps.size(); i++) {
+                deltas.push_back(timestamps[i] - timestamps[i - 1]);
+            }
+        }
+        std::vector<uint64_t> sorted = deltas;
+        std::sort(sorted.begin(), sorted.end());
+        uint64_t p50 = percentile(sorted, 0.50);
+        uint64_t gaps = 0;
+        for (auto d : deltas) {
+            if (p50 > 0 && static_cast<double>(d) > gap_factor * static_cast<double>(p50)) {
+                gaps++;
+            }
+        }
+        double duration_sec = (timestamps.size() > 1) ? static_cast<double>(timestamps.back() - timestamps.front()) / 1000000.0 : 0.0;
+        double rate = (duration_sec > 0.0) ? static_cast<double>(timestamps.size() - 1) / duration_sec : 0.0;
+        /* jitter: p99 - p50 of the inter-arrival time */
+        uint64_t p99 = percentile(sorted, 0.99);
+        std::printf("%-22s %-8s %10zu %10.2f %10llu %10llu %10llu %10llu %10llu %6llu\n",
+            capture_msg_type_name(key.type), capture_owner_name(key.owner), timestamps.size(), rate,
+            (unsigned long long)p50, (unsigned long long)percentile(sorted, 0.90), (unsigned long long)p99,
+            (unsigned long long)(sorted.empty() ? 0 : sorted.back()), (unsigned long long)(p99 - p50),
+            (unsigned long long)gaps);
+    }
+}
+
+static void usage(const char* prog)
+{
+    std::cerr << "Usage: " << prog << " <capture file> [-j threads] [--csv dir | --bin dir] [--gap-factor N]" << std::endl;
+}
+
+static bool parse_args(int argc, char* argv[], ToolOptions& opt)
+{
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-j" && (i + 1) < argc) {
+            opt.threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        }
+        else if (arg == "--csv" && (i + 1) < argc) {
+            opt.csv_dir = argv[++i];
+        }
+        else if (arg == "--bin" && (i + 1) < argc) {
+            opt.bin_dir = argv[++i];
+        }
+        else if (arg == "--gap-factor" && (i + 1) < argc) {
+            opt.gap_factor = std::atof(argv[++i]);
+        }
+        else if (opt.filepath == nullptr && arg[0] != '-') {
+            opt.filepath = argv[i];
+        }
+        else {
+            return false;
+        }
+    }
+    if (opt.filepath == nullptr || (!opt.csv_dir.empty() && !opt.bin_dir.empty())) {
+        return false;
+    }
+    if (opt.threads == 0) {
+        opt.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    ToolOptions opt;
+    if (!parse_args(argc, argv, opt)) {
+        usage(argv[0]);
+        return 1;
+    }
+    MavlinkCaptureControllerType controller;
+    memset(&controller, 0, sizeof(controller));
+    if (!mavlink_capture_load_controller(controller, opt.filepath)) {
+        std::cerr << "ERROR: can not load capture file: " << opt.filepath << std::endl;
+        return 1;
+    }
+    std::vector<CaptureRecordRefType> index;
+    if (!capture_build_index(controller, index)) {
+        std::cerr << "ERROR: no records in capture file" << std::endl;
+        return 1;
+    }
+    std::vector<ChunkResult> chunks;
+    capture_decode(controller, index, opt.threads, chunks);
+
+    uint64_t decode_errors = 0;
+    uint64_t unknown_messages = 0;
+    std::map<StreamKey, std::vector<uint64_t>> streams;
+    for (const auto& chunk : chunks) {
+        decode_errors += chunk.decode_errors;
+        unknown_messages += chunk.unknown_messages;
+        for (const auto& rec : chunk.records) {
+            streams[StreamKey{ rec.message.type, rec.owner }].push_back(rec.timestamp);
+        }
+    }
+    std::cout << "INFO: records: " << index.size()
+              << " decode_errors: " << decode_errors
+              << " unknown: " << unknown_messages
+              << " threads: " << chunks.size() << std::endl;
+    print_stats(streams, opt.gap_factor);
+
+    bool ret = true;
+    if (!opt.csv_dir.empty()) {
+        ret = capture_write_outputs(chunks, opt.csv_dir, true, opt.threads);
+    }
+    else if (!opt.bin_dir.empty()) {
+        ret = capture_write_outputs(chunks, opt.bin_dir, false, opt.threads);
+    }
+    close(controller.save_file);
+    free(controller.data);
+    return ret ? 0 : 1;
+}
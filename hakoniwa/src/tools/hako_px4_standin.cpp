@@ -0,0 +1,505 @@
+/*
+ * hako-px4-standin
+ *
+ * Synthetic PX4 SITL stand-in for load testing hako-px4sim without PX4.
+ * It connects to N consecutive TCP ports like N PX4 instances and, for each vehicle,
+ *   - sends COMMAND_LONG once after connecting and HEARTBEAT every second
+ *   - sends HIL_ACTUATOR_CONTROLS
+ *       --rate 0 (default): in reply to every HIL_SENSOR, as PX4 does in lockstep
+ *       --rate Hz         : at a fixed rate, independent of the simulator
+ *   - measures the round trip from HIL_ACTUATOR_CONTROLS to the next HIL_SENSOR
+ *
+ * After --duration seconds (counted from the first HIL_SENSOR) it reports HIL_SENSOR
+ * rate (= simulation steps/sec in lockstep), round trip percentiles and the CPU use of
+ * this process, as a table and optionally as one JSON object (--json).
+ *
+ * usage: hako-px4-standin [-n vehicles] [--host addr] [--port base] [--rate Hz]
+ *                         [--duration sec] [--throttle 0..1] [--json file]
+ */
+#include "mavlink.h"
+#include "../mavlink/mavlink_msg_types.hpp"
+#include "../mavlink/mavlink_decoder.hpp"
+#include "../mavlink/mavlink_encoder.hpp"
+#include "../comm/tcp_connector.hpp"
+#include "../utils/hako_profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+
+#define STANDIN_ROTOR_NUM           4
+#define STANDIN_HEARTBEAT_USEC      1000000ULL
+#define STANDIN_CONNECT_TIMEOUT_SEC 60
+
+struct StandinOptions {
+    int vehicles = 1;
+    std::string host = "127.0.0.1";
+    int port = 4560;
+    double rate_hz = 0;
+    double duration_sec = 10.0;
+    float throttle = 0.5f;
+    std::string json_path;
+};
+
+struct VehicleStats {
+    std::atomic<uint64_t> hil_sensor { 0 };     /* read by the main thread while running */
+    uint64_t hil_gps = 0;
+    uint64_t command_ack = 0;
+    uint64_t actuator_sent = 0;
+    uint64_t heartbeat_sent = 0;
+    uint64_t send_errors = 0;
+};
+
+static std::atomic<bool> standin_running { true };
+
+static uint64_t now_ns()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+class StandinVehicle {
+private:
+    int index;
+    const StandinOptions& options;
+    std::unique_ptr<hako::px4::comm::ICommIO> comm_io;
+    std::mutex send_mutex;
+    /*
+     * comm_io is set by the vehicle thread and shut down by the main thread
+     */
+    std::mutex io_mutex;
+    bool stopped = false;
+    std::atomic<bool> connecting { true };
+    /*
+     * mavlink_parse_char() keeps its parser state per channel in a global table,
+     * which limits the number of vehicles. Each vehicle keeps its own state instead.
+     */
+    mavlink_message_t rxmsg;
+    mavlink_status_t rxstatus;
+    uint64_t last_heartbeat_ns = 0;
+    std::atomic<uint64_t> last_actuator_ns { 0 };
+    std::atomic<uint64_t> sensor_time_usec { 0 };
+
+    int append(char* buffer, int offset, int size, const MavlinkDecodedMessage& message)
+    {
+        mavlink_message_t msg;
+        if (!mavlink_encode_message(&msg, &message)) {
+            return offset;
+        }
+        int len = mavlink_get_packet(buffer + offset, size - offset, &msg);
+        return (len > 0) ? offset + len : offset;
+    }
+    bool send_buffer(const char* buffer, int len)
+    {
+        int sent = 0;
+        while (sent < len) {
+            int n = 0;
+            if (!comm_io->send(buffer + sent, len - sent, &n) || n <= 0) {
+                if (standin_running.load(std::memory_order_relaxed)) {
+                    stats.send_errors++;
+                }
+                return false;
+            }
+            sent += n;
+        }
+        return true;
+    }
+    void send_command_long()
+    {
+        MavlinkDecodedMessage message = {};
+        message.type = MAVLINK_MSG_TYPE_LONG;
+        message.data.command_long.target_system = 1;
+        message.data.command_long.target_component = 1;
+        message.data.command_long.command = MAV_CMD_SET_MESSAGE_INTERVAL;
+        message.data.command_long.param1 = MAVLINK_MSG_ID_HIL_ACTUATOR_CONTROLS;
+        char buffer[MAVLINK_MAX_PACKET_LEN];
+        int len = append(buffer, 0, sizeof(buffer), message);
+        std::lock_guard<std::mutex> lock(send_mutex);
+        send_buffer(buffer, len);
+    }
+
+public:
+    VehicleStats stats;
+    HakoProfHistogram rtt;
+
+    StandinVehicle(int index, const StandinOptions& options) : index(index), options(options)
+    {
+        memset(&rxmsg, 0, sizeof(rxmsg));
+        memset(&rxstatus, 0, sizeof(rxstatus));
+    }
+    bool connect()
+    {
+        std::string host = options.host;
+        hako::px4::comm::IcommEndpointType dst = { host.c_str(), options.port + index };
+        hako::px4::comm::TcpClient client;
+        std::unique_ptr<hako::px4::comm::ICommIO> io(client.client_open(nullptr, &dst));
+        {
+            std::lock_guard<std::mutex> lock(io_mutex);
+            connecting.store(false);
+            if (io == nullptr) {
+                std::cerr << "ERROR: vehicle " << index << ": can not connect to " << host << ":" << dst.portno << std::endl;
+                return false;
+            }
+            if (stopped) {
+                return false;
+            }
+            comm_io = std::move(io);
+        }
+        send_command_long();
+        return true;
+    }
+    bool is_connecting() const
+    {
+        return connecting.load();
+    }
+    /*
+     * wakes up the receiver blocked in recv(); the socket is closed by close() after the join
+     */
+    void shutdown()
+    {
+        std::lock_guard<std::mutex> lock(io_mutex);
+        stopped = true;
+        if (comm_io != nullptr) {
+            comm_io->shutdown();
+        }
+    }
+    void close()
+    {
+        if (comm_io != nullptr) {
+            comm_io->close();
+        }
+    }
+    /*
+     * HEARTBEAT is put in front of HIL_ACTUATOR_CONTROLS in the same write, because
+     * the simulator only keeps the last message of each received chunk.
+     */
+    void send_actuator(uint64_t time_usec)
+    {
+        std::lock_guard<std::mutex> lock(send_mutex);
+        char buffer[2 * MAVLINK_MAX_PACKET_LEN];
+        int len = 0;
+        uint64_t now = now_ns();
+        bool heartbeat = (now - last_heartbeat_ns) >= STANDIN_HEARTBEAT_USEC * 1000ULL;
+        if (heartbeat) {
+            MavlinkDecodedMessage message = {};
+            message.type = MAVLINK_MSG_TYPE_HEARTBEAT;
+            message.data.heartbeat.type = MAV_TYPE_QUADROTOR;
+            message.data.heartbeat.autopilot = MAV_AUTOPILOT_PX4;
+            message.data.heartbeat.base_mode = MAV_MODE_FLAG_HIL_ENABLED;
+            len = append(buffer, len, sizeof(buffer), message);
+            last_heartbeat_ns = now;
+        }
+        MavlinkDecodedMessage message = {};
+        message.type = MAVLINK_MSG_TYPE_HIL_ACTUATOR_CONTROLS;
+        message.data.hil_actuator_controls.time_usec = time_usec;
+        for (int i = 0; i < STANDIN_ROTOR_NUM; i++) {
+            message.data.hil_actuator_controls.controls[i] = options.throttle;
+        }
+        message.data.hil_actuator_controls.mode = MAV_MODE_FLAG_SAFETY_ARMED;
+        len = append(buffer, len, sizeof(buffer), message);
+
+        last_actuator_ns.store(now_ns(), std::memory_order_release);
+        if (send_buffer(buffer, len)) {
+            stats.actuator_sent++;
+            stats.heartbeat_sent += heartbeat ? 1 : 0;
+        }
+    }
+    void on_message(const MavlinkDecodedMessage& message, uint64_t recv_ns)
+    {
+        switch (message.type) {
+            case MAVLINK_MSG_TYPE_HIL_SENSOR:
+            {
+                uint64_t sent_ns = last_actuator_ns.exchange(0, std::memory_order_acq_rel);
+                if (sent_ns != 0 && recv_ns > sent_ns) {
+                    rtt.record(recv_ns - sent_ns);
+                }
+                stats.hil_sensor.fetch_add(1, std::memory_order_relaxed);
+                sensor_time_usec.store(message.data.sensor.time_usec, std::memory_order_relaxed);
+                if (options.rate_hz <= 0) {
+                    send_actuator(message.data.sensor.time_usec);
+                }
+                break;
+            }
+            case MAVLINK_MSG_TYPE_HIL_GPS:
+                stats.hil_gps++;
+                break;
+            case MAVLINK_MSG_TYPE_LONG:
+            case MAVLINK_MSG_TYPE_ACK:
+                stats.command_ack++;
+                break;
+            default:
+                break;
+        }
+    }
+    void receiver()
+    {
+        if (options.rate_hz <= 0) {
+            /* the simulator waits for the first actuator output before sending sensors in lockstep */
+            send_actuator(0);
+        }
+        char buffer[4096];
+        while (standin_running.load(std::memory_order_relaxed)) {
+            int len = 0;
+            if (!comm_io->recv(buffer, sizeof(buffer), &len) || len <= 0) {
+                if (standin_running.load(std::memory_order_relaxed)) {
+                    std::cerr << "ERROR: vehicle " << index << ": connection closed" << std::endl;
+                }
+                return;
+            }
+            uint64_t recv_ns = now_ns();
+            for (int i = 0; i < len; i++) {
+                mavlink_message_t msg;
+                mavlink_status_t status;
+                if (mavlink_frame_char_buffer(&rxmsg, &rxstatus, static_cast<uint8_t>(buffer[i]), &msg, &status) != MAVLINK_FRAMING_OK) {
+                    continue;
+                }
+                MavlinkDecodedMessage message;
+                if (mavlink_get_message(&msg, &message)) {
+                    on_message(message, recv_ns);
+                }
+            }
+        }
+    }
+    /*
+     * fixed rate mode: PX4 time follows the last received sensor time when there is one
+     */
+    void sender()
+    {
+        auto period = std::chrono::nanoseconds(static_cast<int64_t>(1.0e9 / options.rate_hz));
+        auto next = std::chrono::steady_clock::now();
+        uint64_t start_usec = now_ns() / 1000ULL;
+        while (standin_running.load(std::memory_order_relaxed)) {
+            uint64_t time_usec = sensor_time_usec.load(std::memory_order_relaxed);
+            send_actuator((time_usec != 0) ? time_usec : (now_ns() / 1000ULL) - start_usec);
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+    }
+};
+
+static void usage(const char* prog)
+{
+    std::cerr << "usage: " << prog << " [-n vehicles] [--host addr] [--port base] [--rate Hz]"
+              << " [--duration sec] [--throttle 0..1] [--json file]" << std::endl;
+}
+
+static bool parse_options(int argc, char* argv[], StandinOptions& options)
+{
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char* value = argv[++i];
+        if (arg == "-n") {
+            options.vehicles = std::atoi(value);
+        }
+        else if (arg == "--host") {
+            options.host = value;
+        }
+        else if (arg == "--port") {
+            options.port = std::atoi(value);
+        }
+        else if (arg == "--rate") {
+            options.rate_hz = std::atof(value);
+        }
+        else if (arg == "--duration") {
+            options.duration_sec = std::atof(value);
+        }
+        else if (arg == "--throttle") {
+            options.throttle = static_cast<float>(std::atof(value));
+        }
+        else if (arg == "--json") {
+            options.json_path = value;
+        }
+        else {
+            return false;
+        }
+    }
+    return (options.vehicles > 0) && (options.duration_sec > 0);
+}
+
+static double cpu_sec()
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+         + static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1.0e6;
+}
+
+static double to_usec(uint64_t ns)
+{
+    return static_cast<double>(ns) / 1000.0;
+}
+
+/*
+ * A vehicle thread that is still retrying its connection (TcpClient retries for
+ * minutes) is detached so that stopping does not wait for it; the thread keeps its
+ * own reference to the vehicle. The other threads are joined before their sockets
+ * are closed.
+ */
+static void stop_vehicles(std::vector<std::shared_ptr<StandinVehicle>>& vehicles, std::vector<std::thread>& threads)
+{
+    standin_running.store(false);
+    for (auto& vehicle : vehicles) {
+        vehicle->shutdown();
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+        if (vehicles[i]->is_connecting()) {
+            threads[i].detach();
+            continue;
+        }
+        threads[i].join();
+        vehicles[i]->close();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    StandinOptions options;
+    if (!parse_options(argc, argv, options)) {
+        usage(argv[0]);
+        return 1;
+    }
+    std::vector<std::shared_ptr<StandinVehicle>> vehicles;
+    for (int i = 0; i < options.vehicles; i++) {
+        vehicles.push_back(std::make_shared<StandinVehicle>(i, options));
+    }
+    /*
+     * connect in parallel: the simulator accepts the vehicles in any order
+     */
+    std::atomic<int> connected { 0 };
+    std::vector<std::thread> threads;
+    for (auto& vehicle : vehicles) {
+        std::shared_ptr<StandinVehicle> v = vehicle;
+        threads.emplace_back([v, &connected, &options]() {
+            if (!v->connect()) {
+                return;
+            }
+            connected.fetch_add(1);
+            std::thread sender;
+            if (options.rate_hz > 0) {
+                sender = std::thread(&StandinVehicle::sender, v.get());
+            }
+            v->receiver();
+            if (sender.joinable()) {
+                sender.join();
+            }
+        });
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(STANDIN_CONNECT_TIMEOUT_SEC);
+    while (connected.load() < options.vehicles && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::cout << "INFO: connected vehicles: " << connected.load() << "/" << options.vehicles << std::endl;
+
+    /*
+     * the measurement window starts with the first HIL_SENSOR (the simulation may be started later)
+     */
+    uint64_t start_ns = 0;
+    deadline = std::chrono::steady_clock::now() + std::chrono::seconds(STANDIN_CONNECT_TIMEOUT_SEC);
+    while (start_ns == 0 && std::chrono::steady_clock::now() < deadline) {
+        for (auto& vehicle : vehicles) {
+            if (vehicle->stats.hil_sensor.load() > 0) {
+                start_ns = now_ns();
+                break;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (start_ns == 0) {
+        std::cerr << "ERROR: no HIL_SENSOR received" << std::endl;
+        stop_vehicles(vehicles, threads);
+        return 1;
+    }
+    std::vector<uint64_t> sensor_start(vehicles.size());
+    for (size_t i = 0; i < vehicles.size(); i++) {
+        sensor_start[i] = vehicles[i]->stats.hil_sensor.load();
+    }
+    double cpu_start = cpu_sec();
+    std::this_thread::sleep_for(std::chrono::nanoseconds(static_cast<int64_t>(options.duration_sec * 1.0e9)));
+    uint64_t elapsed_ns = now_ns() - start_ns;
+    double cpu = cpu_sec() - cpu_start;
+
+    stop_vehicles(vehicles, threads);
+
+    /*
+     * report
+     */
+    double elapsed_sec = static_cast<double>(elapsed_ns) / 1.0e9;
+    std::vector<uint64_t> total_buckets(HAKO_PROF_HIST_BUCKET_NUM, 0);
+    uint64_t total_max_ns = 0;
+    double rate_sum = 0;
+    double rate_min = -1;
+    uint64_t actuator_sent = 0;
+    uint64_t heartbeat_sent = 0;
+    uint64_t command_ack = 0;
+    uint64_t send_errors = 0;
+    std::printf("%-8s %12s %12s %10s %10s %10s %10s %8s\n",
+        "vehicle", "hil_sensor", "rate[Hz]", "p50[us]", "p99[us]", "max[us]", "actuator", "ack");
+    for (size_t i = 0; i < vehicles.size(); i++) {
+        auto& v = *vehicles[i];
+        std::vector<uint64_t> buckets;
+        v.rtt.snapshot(buckets);
+        for (size_t b = 0; b < buckets.size(); b++) {
+            total_buckets[b] += buckets[b];
+        }
+        total_max_ns = std::max(total_max_ns, v.rtt.get_max_ns());
+        uint64_t hil_sensor = v.stats.hil_sensor.load();
+        double rate = static_cast<double>(hil_sensor - sensor_start[i]) / elapsed_sec;
+        rate_sum += rate;
+        rate_min = (rate_min < 0) ? rate : std::min(rate_min, rate);
+        actuator_sent += v.stats.actuator_sent;
+        heartbeat_sent += v.stats.heartbeat_sent;
+        command_ack += v.stats.command_ack;
+        send_errors += v.stats.send_errors;
+        std::printf("%-8zu %12llu %12.1f %10.1f %10.1f %10.1f %10llu %8llu\n", i,
+            (unsigned long long)hil_sensor, rate,
+            to_usec(HakoProfHistogram::quantile(buckets, 0.50)),
+            to_usec(HakoProfHistogram::quantile(buckets, 0.99)),
+            to_usec(v.rtt.get_max_ns()),
+            (unsigned long long)v.stats.actuator_sent, (unsigned long long)v.stats.command_ack);
+    }
+    double p50 = to_usec(HakoProfHistogram::quantile(total_buckets, 0.50));
+    double p90 = to_usec(HakoProfHistogram::quantile(total_buckets, 0.90));
+    double p99 = to_usec(HakoProfHistogram::quantile(total_buckets, 0.99));
+    double cpu_percent = 100.0 * cpu / elapsed_sec;
+    std::printf("vehicles=%d steps/sec(mean)=%.1f steps/sec(min)=%.1f rtt[us] p50=%.1f p90=%.1f p99=%.1f max=%.1f standin_cpu=%.1f%%\n",
+        options.vehicles, rate_sum / options.vehicles, rate_min, p50, p90, p99, to_usec(total_max_ns), cpu_percent);
+
+    if (!options.json_path.empty()) {
+        std::ofstream ofs(options.json_path);
+        if (!ofs) {
+            std::cerr << "ERROR: can not write " << options.json_path << std::endl;
+            return 1;
+        }
+        ofs << "{\"vehicles\": " << options.vehicles
+            << ", \"connected\": " << connected.load()
+            << ", \"rate_hz\": " << options.rate_hz
+            << ", \"duration_sec\": " << elapsed_sec
+            << ", \"steps_per_sec_mean\": " << (rate_sum / options.vehicles)
+            << ", \"steps_per_sec_min\": " << rate_min
+            << ", \"rtt_usec\": {\"p50\": " << p50 << ", \"p90\": " << p90 << ", \"p99\": " << p99
+            << ", \"max\": " << to_usec(total_max_ns) << "}"
+            << ", \"actuator_sent\": " << actuator_sent
+            << ", \"heartbeat_sent\": " << heartbeat_sent
+            << ", \"command_ack\": " << command_ack
+            << ", \"send_errors\": " << send_errors
+            << ", \"standin_cpu_percent\": " << cpu_percent
+            << "}" << std::endl;
+    }
+    return (connected.load() == options.vehicles) ? 0 : 1;
+}
@@ -0,0 +1,244 @@
+#ifndef _HAKO_AIRCRAFT_MODULE_HPP_
+#define _HAKO_AIRCRAFT_MODULE_HPP_
+
+/*
+ * 機体と制御モジュールの組
+ *
+ * 箱庭のアセットランナー(AirCraftModuleSimulator)と、ランナーを使わない
+ * Python バインディング(python/hakosim_native.cpp)で共有する。
+ */
+#include "iaircraft.hpp"
+#include "assets/drone/controller/sample_controller.hpp"
+#include "config/drone_config.hpp"
+#include "utils/hako_module_registry.hpp"
+#include "utils/hako_state_snapshot.hpp"
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+class AirCraftModule
+{
+private:
+    void *context = nullptr;
+    /*
+     * サンプルコントローラの所有(コピーしたモジュールと共有する)
+     */
+    std::shared_ptr<hako::assets::drone::IController> controller_owner;
+    HakoStateRegions controller_state_regions;
+    bool controller_state_regions_ready = false;
+    const HakoStateRegions& get_controller_state_regions()
+    {
+        if (!controller_state_regions_ready) {
+            controller->add_state_regions(controller_state_regions);
+            controller_state_regions_ready = true;
+        }
+        return controller_state_regions;
+    }
+public:
+    void *get_context()
+    {
+        return this->context;
+    }
+    /*
+     * control_module はレジストリで共有しているシンボルテーブルのコピー
+     */
+    AircraftControlModuleType control_module = {};
+    hako::assets::drone::IController *controller = nullptr;
+    hako::assets::drone::IAirCraft *drone = nullptr;
+    double controls[hako::assets::drone::ROTOR_NUM_MAX] = {};
+
+    void reset()
+    {
+        //drone dynamics
+        drone->reset();
+        //drone controller
+        if (control_module.controller != nullptr) {
+            control_module.controller->init(this->context);
+        }
+    }
+    bool load_controller(const AircraftControlModuleType& module, void* arguments)
+    {
+        control_module = module;
+        this->context = control_module.controller->create_context(arguments);
+        return (control_module.controller->init(context) == 0);
+    }
+    /*
+     * config_index の設定から制御モジュールをロードする
+     * モジュールがなく、設定に pid があればサンプルコントローラを使う
+     */
+    void load(HakoControllerModuleRegistry& registry, int config_index)
+    {
+        DroneConfig drone_config;
+        drone_config_manager.getConfig(config_index, drone_config);
+        std::string filepath = drone_config.getControllerModuleFilePath();
+        if (!filepath.empty()) {
+            void* arguments = nullptr;
+            std::string file = drone_config.getControllerContext("file");
+            if (!file.empty()) {
+                arguments = (void*)file.c_str();
+            }
+            const AircraftControlModuleType* module = registry.load(filepath);
+            if ((module != nullptr) && !load_controller(*module, arguments)) {
+                std::cerr << "ERROR: can not initialize controller module for " << drone->get_name() << std::endl;
+            }
+        }
+        else {
+            std::cerr << "WARNING: can not find module for " << drone->get_name() << std::endl;
+        }
+        if (control_module.controller == nullptr) {
+            if (drone_config.isExistController("pid")) {
+                controller_owner = std::make_shared<hako::assets::drone::SampleController>(config_index);
+                controller = controller_owner.get();
+            }
+            if (controller == nullptr) {
+                std::cerr << "ERROR: no controller for " << drone->get_name() << ": it runs without control" << std::endl;
+            }
+        }
+    }
+    /*
+     * 制御モジュールのコンテキストとサンプルコントローラを破棄する
+     * コンテキストはコピーしたモジュールと共有しているため、機体を使い終わったときに
+     * 1つのモジュールから1回だけ呼ぶ。
+     * v3 以前のモジュールは破棄のエントリがないため、コンテキストはプロセス終了まで残る。
+     */
+    void unload()
+    {
+        if ((control_module.destroy_context != nullptr) && (context != nullptr)) {
+            control_module.destroy_context(context);
+        }
+        context = nullptr;
+        control_module = {};
+        controller = nullptr;
+        controller_owner.reset();
+        controller_state_regions = HakoStateRegions();
+        controller_state_regions_ready = false;
+    }
+    /*
+     * モジュールもフォールバックの PID もない機体は制御出力なし
+     */
+    bool has_controller() const
+    {
+        return (control_module.controller != nullptr) || (controller != nullptr);
+    }
+    /*
+     * 機体と制御の状態のスナップショット(機体, 制御の順に並べる)
+     * 制御の状態は v3 以降のモジュール(状態の保存・復元あり)とサンプルコントローラのみ含める。
+     * それ以外のモジュールは復元しても制御の内部状態(積分値等)は戻らない。
+     */
+    bool has_controller_state() const
+    {
+        if (control_module.controller != nullptr) {
+            return (control_module.get_state_size != nullptr);
+        }
+        return true;
+    }
+    size_t get_controller_state_size()
+    {
+        if (control_module.controller != nullptr) {
+            return (control_module.get_state_size != nullptr) ? control_module.get_state_size(context) : 0;
+        }
+        return (controller != nullptr) ? get_controller_state_regions().size() : 0;
+    }
+    size_t get_state_size()
+    {
+        return drone->get_state_size() + get_controller_state_size();
+    }
+    void save_state(void *buf)
+    {
+        uint8_t *p = static_cast<uint8_t*>(buf) + drone->get_state_size();
+        drone->save_state(buf);
+        if (control_module.controller != nullptr) {
+            if (control_module.save_state != nullptr) {
+                control_module.save_state(context, p);
+            }
+        }
+        else if (controller != nullptr) {
+            get_controller_state_regions().save(p);
+        }
+    }
+    void restore_state(const void *buf)
+    {
+        const uint8_t *p = static_cast<const uint8_t*>(buf) + drone->get_state_size();
+        drone->restore_state(buf);
+        if (control_module.controller != nullptr) {
+            if (control_module.restore_state != nullptr) {
+                control_module.restore_state(context, p);
+            }
+        }
+        else if (controller != nullptr) {
+            get_controller_state_regions().restore(p);
+        }
+    }
+    mi_drone_control_out_t run_controller(mi_drone_control_in_t& in)
+    {
+        if (control_module.controller != nullptr) {
+            return control_module.controller->run(&in);
+        }
+        else if (controller != nullptr) {
+            return controller->run(in);
+        }
+        mi_drone_control_out_t out = {};
+        return out;
+    }
+};
+
+/*
+ * 複数機体の制御モジュールの実行
+ * 同じ v2 モジュール(run_batch)を使う連続した機体はまとめて1回で呼び出し、
+ * それ以外は従来どおり機体ごとに run を呼ぶ。
+ * get_in(index) は index 番目の機体の制御入力を返す。
+ */
+class AirCraftControllerBatch {
+private:
+    std::vector<mi_drone_control_in_t> batch_in;
+    std::vector<mi_drone_control_out_t> batch_out;
+    std::vector<int> batch_index;
+public:
+    void resize(size_t num)
+    {
+        batch_in.resize(num);
+        batch_out.resize(num);
+        batch_index.resize(num);
+    }
+    template <typename GetIn>
+    void run(std::vector<AirCraftModule>& modules, const std::vector<bool>& active, GetIn get_in,
+             std::vector<mi_drone_control_out_t>& out)
+    {
+        const int num = static_cast<int>(modules.size());
+        int index = 0;
+        while (index < num) {
+            if (!active[index]) {
+                index++;
+                continue;
+            }
+            auto run_batch = modules[index].control_module.run_batch;
+            if (run_batch == nullptr) {
+                out[index] = modules[index].run_controller(get_in(index));
+                index++;
+                continue;
+            }
+            int n = 0;
+            int next = index;
+            for (; next < num; next++) {
+                if (!active[next]) {
+                    continue;
+                }
+                if (modules[next].control_module.run_batch != run_batch) {
+                    break;
+                }
+                batch_in[n] = get_in(next);
+                batch_index[n] = next;
+                n++;
+            }
+            run_batch(batch_in.data(), batch_out.data(), n);
+            for (int i = 0; i < n; i++) {
+                out[batch_index[i]] = batch_out[i];
+            }
+            index = next;
+        }
+    }
+};
+
+#endif /* _HAKO_AIRCRAFT_MODULE_HPP_ */
@@ -1,68 +1,29 @@
 #ifndef _HAKO_CONTROL_UTILS_HPP_
 #define _HAKO_CONTROL_UTILS_HPP_
 
-#include "utils/hako_module_loader.hpp"
-#include "hako_module_drone_controller.h"
-
-typedef struct {
-    void *handle;
-    HakoModuleHeaderType *header;
-    HakoModuleDroneControllerType *controller;
-} AircraftControlModuleType;
-
-class AirCraftModule
-{
-private:
-    void *context;
-public:
-    void *get_context()
-    {
-        return this->context;
-    }
-    AircraftControlModuleType control_module;
-    hako::assets::drone::IController *controller;
-    IAirCraft *drone;
-    double controls[hako::assets::drone::ROTOR_NUM] = { 0, 0, 0, 0};
-
-    void reset()
-    {
-        //drone dynamics
-        drone->reset();
-        //drone controller
-        control_module.controller->init(this->context);
-    }
-    bool load_controller(const char* filepath, void* arguments) 
-    {
-        control_module.header = nullptr;
-        control_module.controller = nullptr;
-        control_module.handle = hako_module_handle(filepath, &control_module.header);
-        if (control_module.handle == nullptr) {
-            return false;
-        }
-        control_module.controller = (HakoModuleDroneControllerType*)hako_module_load_symbol(control_module.handle, HAKO_MODULE_DRONE_CONTROLLER_SYMBOLE_NAME);
-        if (control_module.controller == nullptr) {
-            return false;
-        }
-        this->context = control_module.controller->create_context(arguments);
-        std::cout << "SUCCESS: Loaded module name: " << control_module.header->get_name() << std::endl;
-        return (control_module.controller->init(context) == 0);
-    }
-
-};
+#include "utils/hako_aircraft_module.hpp"
+#include "utils/hako_module_registry.hpp"
+#include "utils/hako_rtf_monitor.hpp"
 
 class AirCraftModuleSimulator
 {
 private:
     hako::assets::drone::AirCraftManager drone_manager;
+    HakoControllerModuleRegistry module_registry;
+    HakoRtfMonitor rtf_monitor;
 
     bool do_asset_task()
     {
         CsvLogger::set_time_usec(hako_asset_time_usec);
         if (hako_asset_runner_step(1) == false) {
             std::cout << "INFO: stopped simulation" << std::endl;
+            rtf_monitor.stop();
             return false;
         }
         hako_asset_time_usec += delta_time_usec;
+        if (rtf_monitor.step() == false) {
+            std::exit(EXIT_FAILURE);
+        }
         return true;
     }
     std::vector<AirCraftModule> aircraft_modules;
@@ -70,13 +31,17 @@ private:
     Hako_uint64 hako_asset_time_usec;
     Hako_uint64 delta_time_usec;
 public:
-    std::vector<AirCraftModule> get_modules() const
+    HakoControllerModuleRegistry& get_module_registry()
+    {
+        return this->module_registry;
+    }
+    std::vector<AirCraftModule>& get_modules()
     {
         return this->aircraft_modules;
     }
     void reset()
     {
-        for (auto module : get_modules()) {
+        for (auto& module : get_modules()) {
             module.reset();
         }
         hako_asset_time_usec = 0;
@@ -85,35 +50,13 @@ public:
     {
         hako_asset_time_usec = microseconds;
         delta_time_usec = dt_usec;
+        rtf_monitor.init(dt_usec);
         drone_manager.createAirCrafts(drone_config_manager);
         for (auto* drone : drone_manager.getAllAirCrafts()) {
             std::cout << "INFO: loading drone & controller: " << drone->get_index() << std::endl;
             AirCraftModule arg;
             arg.drone = drone;
-            DroneConfig drone_config;
-            drone_config_manager.getConfig(drone->get_index(), drone_config);
-            arg.control_module.controller = nullptr;
-            std::string filepath = drone_config.getControllerModuleFilePath();
-            if (!filepath.empty()) {
-                void* arguments = nullptr;
-                std::string file = drone_config.getControllerContext("file");
-                if (!file.empty()) {
-                    arguments = (void*)file.c_str();
-                }
-                arg.load_controller(filepath.c_str(), arguments);
-            }
-            else {
-                std::cerr << "WARNING: can not find module for " << drone->get_name() << std::endl;
-            }
-            if (arg.control_module.controller == nullptr) {
-                HAKO_ASSERT(drone_config.isExistController("pid"));
-                arg.controller = new hako::assets::drone::SampleController(drone->get_index());
-                if (arg.controller == nullptr) {
-                    std::cerr << "ERROR: can not create Controller: " << drone->get_index() << std::endl;
-                    HAKO_ASSERT(arg.controller != nullptr);
-                    return;
-                }
-            }
+            arg.load(module_registry, drone->get_index());
             aircraft_modules.push_back(arg);
         }
     }
@@ -133,7 +76,7 @@ static inline void calculate_simple_controls(AirCraftModule& module, const Drone
     else {
         control = thrust.data / max_hovering_force;
     }
-    for (int i = 0; i < hako::assets::drone::ROTOR_NUM; i++) {
+    for (int i = 0; i < module.drone->get_rotor_num(); i++) {
         module.controls[i] = control;
     }
     return;
@@ -2,7 +2,24 @@
 #define _HAKO_MODULE_HEADER_H_
 
 #define HAKO_MODULE_MAGICNO         0xFEFE8528
-#define HAKO_MODULE_VERSION         0x00001010
+#define HAKO_MODULE_VERSION_1       0x00001010
+/*
+ * version 2: モジュール固有のシンボルに拡張エントリ(drone controller の
+ * run_batch 等)を追加した版。v1 のメンバ配置はそのまま先頭に残す。
+ */
+#define HAKO_MODULE_VERSION_2       0x00002010
+/*
+ * version 3: v2 の末尾に状態の保存・復元のエントリを追加した版
+ */
+#define HAKO_MODULE_VERSION_3       0x00003010
+/*
+ * version 4: v3 の末尾にコンテキストの破棄のエントリを追加した版
+ */
+#define HAKO_MODULE_VERSION_4       0x00004010
+#define HAKO_MODULE_VERSION         HAKO_MODULE_VERSION_1
+#define HAKO_MODULE_VERSION_IS_SUPPORTED(v) \
+    ( ((v) == HAKO_MODULE_VERSION_1) || ((v) == HAKO_MODULE_VERSION_2) || ((v) == HAKO_MODULE_VERSION_3) \
+      || ((v) == HAKO_MODULE_VERSION_4) )
 #define HAOKO_MODULE_HEADER_NAME   "hako_module_header"
 typedef struct {
     unsigned int magicno;
@@ -21,7 +21,7 @@ void* hako_module_handle(const char* filepath, HakoModuleHeaderType** header) {
         std::cerr << "ERROR: invalid magicno: " << (*header)->magicno << " on module filepath: " << filepath << std::endl;
         return nullptr;
     }
-    if ((*header)->version != HAKO_MODULE_VERSION) {
+    if (!HAKO_MODULE_VERSION_IS_SUPPORTED((*header)->version)) {
         std::cerr << "ERROR: invalid version: " << (*header)->version << " on module filepath: " << filepath << std::endl;
         return nullptr;
     }
@@ -56,7 +56,7 @@ void *hako_module_handle(const char* filepath, HakoModuleHeaderType** header)
         std::cerr << "ERROR: invalid magicno: " << (*header)->magicno << " on module filepath: " << filepath << std::endl;
         return nullptr;
     }
-    if ((*header)->version != HAKO_MODULE_VERSION) {
+    if (!HAKO_MODULE_VERSION_IS_SUPPORTED((*header)->version)) {
         std::cerr << "ERROR: invalid version: " << (*header)->version << " on module filepath: " << filepath << std::endl;
         return nullptr;
     }
@@ -0,0 +1,126 @@
+#ifndef _HAKO_MODULE_REGISTRY_HPP_
+#define _HAKO_MODULE_REGISTRY_HPP_
+
+/*
+ * 制御モジュールのレジストリ
+ *
+ * 同じモジュール(.so/.dll)を使う機体が複数あっても、ロードとヘッダの検証、
+ * シンボルの解決はファイルごとに1回だけ行い、解決済みのシンボルテーブルを
+ * 全機体で共有する。機体ごとに作るのはコンテキスト(create_context)のみ。
+ * ロードに失敗したファイルも記録し、同じファイルのロードを繰り返さない。
+ *
+ * モジュールはプロセス終了までアンロードしない(従来どおり)。
+ */
+#include "utils/hako_module_loader.hpp"
+#include "hako_module_drone_controller.h"
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+
+typedef struct {
+    void *handle;
+    HakoModuleHeaderType *header;
+    HakoModuleDroneControllerType *controller;
+    /*
+     * v2 モジュールのみ(それ以外は nullptr で controller->run を機体ごとに呼ぶ)
+     */
+    void (*run_batch) (const mi_drone_control_in_t *ins, mi_drone_control_out_t *outs, int n);
+    /*
+     * v3 以降のモジュールのみ(それ以外は nullptr で、状態のスナップショットに含めない)
+     */
+    size_t (*get_state_size) (void* context);
+    void (*save_state) (void* context, void* buf);
+    void (*restore_state) (void* context, const void* buf);
+    /*
+     * v4 モジュールのみ(それ以外は nullptr で、コンテキストを破棄しない)
+     */
+    void (*destroy_context) (void* context);
+} AircraftControlModuleType;
+
+class HakoControllerModuleRegistry {
+private:
+    struct Entry {
+        bool loaded;
+        AircraftControlModuleType module;
+    };
+    std::map<std::string, Entry> entries;
+    std::mutex mutex;
+
+    /*
+     * 同じファイルを別のパス表記で指定しても1つにまとめる
+     */
+    static std::string get_key(const std::string& filepath)
+    {
+#ifdef _WIN32
+        char path[_MAX_PATH];
+        if (_fullpath(path, filepath.c_str(), sizeof(path)) != nullptr) {
+            return std::string(path);
+        }
+#else
+        char path[PATH_MAX];
+        if (realpath(filepath.c_str(), path) != nullptr) {
+            return std::string(path);
+        }
+#endif
+        return filepath;
+    }
+    static bool load_module(const std::string& filepath, AircraftControlModuleType& module)
+    {
+        module = {};
+        module.handle = hako_module_handle(filepath.c_str(), &module.header);
+        if (module.handle == nullptr) {
+            return false;
+        }
+        module.controller = (HakoModuleDroneControllerType*)hako_module_load_symbol(module.handle, HAKO_MODULE_DRONE_CONTROLLER_SYMBOLE_NAME);
+        if (module.controller == nullptr) {
+            return false;
+        }
+        if (module.header->version == HAKO_MODULE_VERSION_2) {
+            module.run_batch = ((HakoModuleDroneControllerV2Type*)module.controller)->run_batch;
+        }
+        else if ((module.header->version == HAKO_MODULE_VERSION_3) || (module.header->version == HAKO_MODULE_VERSION_4)) {
+            /* v4 は v3 の末尾に追加しただけなので、先頭は v3 として読める */
+            HakoModuleDroneControllerV3Type* v3 = (HakoModuleDroneControllerV3Type*)module.controller;
+            module.run_batch = v3->run_batch;
+            module.get_state_size = v3->get_state_size;
+            module.save_state = v3->save_state;
+            module.restore_state = v3->restore_state;
+            if (module.header->version == HAKO_MODULE_VERSION_4) {
+                module.destroy_context = ((HakoModuleDroneControllerV4Type*)module.controller)->destroy_context;
+            }
+        }
+        std::cout << "SUCCESS: Loaded module name: " << module.header->get_name() << std::endl;
+        return true;
+    }
+
+public:
+    HakoControllerModuleRegistry() {}
+    HakoControllerModuleRegistry(const HakoControllerModuleRegistry&) = delete;
+    HakoControllerModuleRegistry& operator=(const HakoControllerModuleRegistry&) = delete;
+
+    /*
+     * return value: 共有のシンボルテーブル(ロードできない場合は nullptr)
+     */
+    const AircraftControlModuleType* load(const std::string& filepath)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::string key = get_key(filepath);
+        auto it = entries.find(key);
+        if (it == entries.end()) {
+            Entry entry = {};
+            entry.loaded = load_module(filepath, entry.module);
+            it = entries.emplace(key, entry).first;
+        }
+        return it->second.loaded ? &it->second.module : nullptr;
+    }
+    size_t size()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.size();
+    }
+};
+
+#endif /* _HAKO_MODULE_REGISTRY_HPP_ */
@@ -0,0 +1,43 @@
+#ifndef _HAKO_PARALLEL_HPP_
+#define _HAKO_PARALLEL_HPP_
+
+/*
+ * 起動時の機体ごとの処理(config 解析, 機体生成など)を並列に実行する
+ *
+ * fn(i) を i = 0 .. count-1 について呼ぶ。ワーカ数は CPU 数と count の小さい方.
+ * 呼び出し順は不定なので、fn は結果を i 番目の要素に書くだけにすること。
+ */
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+template <typename Fn>
+static inline void hako_parallel_for(size_t count, Fn fn)
+{
+    size_t worker_num = std::max<size_t>(1, std::thread::hardware_concurrency());
+    worker_num = std::min(worker_num, count);
+    if (worker_num <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            fn(i);
+        }
+        return;
+    }
+    std::atomic<size_t> next { 0 };
+    auto worker = [&]() {
+        for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+            fn(i);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < worker_num; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+#endif /* _HAKO_PARALLEL_HPP_ */
@@ -13,7 +13,7 @@ typedef struct {
     int value;
 } HakoParamIntegerType;
 
-#define HAKO_PARAM_STRING_NUM 4
+#define HAKO_PARAM_STRING_NUM 5
 static HakoParamStringType hako_param_string[HAKO_PARAM_STRING_NUM] = {
     {
        HAKO_CAPTURE_SAVE_FILEPATH,
@@ -31,8 +31,12 @@ static HakoParamStringType hako_param_string[HAKO_PARAM_STRING_NUM] = {
         DRONE_CONFIG_PATH,
         "../config"
     },
+    {
+        HAKO_COMM_TRANSPORT,
+        "tcp"
+    },
 };
-#define HAKO_PARAM_INTEGER_NUM 2
+#define HAKO_PARAM_INTEGER_NUM 4
 static HakoParamIntegerType hako_param_integer[HAKO_PARAM_INTEGER_NUM] = {
     {
         HAKO_BYPASS_PORTNO,
@@ -42,6 +46,14 @@ static HakoParamIntegerType hako_param_integer[HAKO_PARAM_INTEGER_NUM] = {
         HAKO_MAXDELAY_TIME_USEC,
         20000 // 20msec
     },
+    {
+        HAKO_UDP_RCVBUF_SIZE,
+        0
+    },
+    {
+        HAKO_UDP_SNDBUF_SIZE,
+        0
+    },
 };
 
 void hako_param_env_init()
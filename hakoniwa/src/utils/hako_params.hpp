@@ -8,12 +8,15 @@
 #define HAKO_BYPASS_IPADDR "HAKO_BYPASS_IPADDR"
 #define HAKO_CUSTOM_JSON_PATH   "HAKO_CUSTOM_JSON_PATH"
 #define DRONE_CONFIG_PATH "DRONE_CONFIG_PATH"
+#define HAKO_COMM_TRANSPORT "HAKO_COMM_TRANSPORT" /* tcp | shm | udp */
 
 /*
  * integer params
  */
 #define HAKO_BYPASS_PORTNO "HAKO_BYPASS_PORTNO"
 #define HAKO_MAXDELAY_TIME_USEC "HAKO_MAXDELAY_TIME_USEC"
+#define HAKO_UDP_RCVBUF_SIZE "HAKO_UDP_RCVBUF_SIZE" /* 0: OS default */
+#define HAKO_UDP_SNDBUF_SIZE "HAKO_UDP_SNDBUF_SIZE" /* 0: OS default */
 
 extern void hako_param_env_init();
 extern const char* hako_param_env_get_string(const char* param_name);
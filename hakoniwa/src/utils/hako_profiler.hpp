@@ -0,0 +1,525 @@
+#ifndef _HAKO_PROFILER_HPP_
+#define _HAKO_PROFILER_HPP_
+
+/*
+ * シミュレーションステップの区間プロファイラ
+ *
+ * HAKO_PROF_SCOPE(stage, aircraft) を置いたブロックの処理時間を、処理段(stage)・
+ * 機体・スレッドごとの HDR 形式ヒストグラム(2 のべき乗ごとに 16 分割, 誤差 約6%)に
+ * 記録する。記録はスレッドごとの表に対して行うため、ロックもアトミック演算の
+ * read-modify-write も使わない。
+ *
+ * 出力スレッドが一定周期で Prometheus のテキスト形式に変換して、ファイル
+ * (一時ファイルを書いて rename)または Unix ドメインソケット(接続ごとに最新の
+ * 値を返す)に出力する。
+ *
+ *   HAKO_PROFILER_OUTPUT=/tmp/hako_profile.prom     ファイル(既定: ./hako_profile.prom)
+ *   HAKO_PROFILER_OUTPUT=unix:/tmp/hako_profile.sock Unix ドメインソケット
+ *   HAKO_PROFILER_INTERVAL_MSEC=1000                 出力周期
+ *
+ * HAKO_PROFILER_ENABLE を定義してビルドした場合のみ計測する(cmake -D profiler=true)。
+ * 未定義の場合、マクロは空になり計測コードは残らない。
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAKO_PROF_USE_RDTSC
+#endif
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+typedef enum {
+    HAKO_PROF_STEP = 0,         /* 全機体の1ステップ(機体は all) */
+    HAKO_PROF_AIRCRAFT,         /* AirCraft::run 全体 */
+    HAKO_PROF_BATTERY,
+    HAKO_PROF_ROTOR,
+    HAKO_PROF_THRUST,
+    HAKO_PROF_DYNAMICS,
+    HAKO_PROF_SENSOR_ACC,
+    HAKO_PROF_SENSOR_GYRO,
+    HAKO_PROF_SENSOR_GPS,
+    HAKO_PROF_SENSOR_MAG,
+    HAKO_PROF_SENSOR_BARO,
+    HAKO_PROF_LOGGER,
+    HAKO_PROF_PDU_IO,
+    HAKO_PROF_MAVLINK_TX,
+    HAKO_PROF_MAVLINK_RX,
+    HAKO_PROF_STAGE_NUM
+} HakoProfStageType;
+
+static inline const char* hako_prof_stage_name(int stage)
+{
+    static const char* names[HAKO_PROF_STAGE_NUM] = {
+        "step", "aircraft", "battery", "rotor", "thrust", "dynamics",
+        "acc", "gyro", "gps", "mag", "baro", "logger",
+        "pdu_io", "mavlink_tx", "mavlink_rx",
+    };
+    return ((stage >= 0) && (stage < HAKO_PROF_STAGE_NUM)) ? names[stage] : "unknown";
+}
+
+/*
+ * HDR 形式のヒストグラム(単位: nsec)
+ *   v < 16        : 幅 1 のバケット
+ *   2^e <= v < 2^(e+1): 16 分割(e は HAKO_PROF_HIST_EXP_MAX まで, それ以上は最後のバケット)
+ * 書き込みは1スレッドのみ。読み出し(出力スレッド)と並行してよい。
+ */
+#define HAKO_PROF_HIST_SUB_BITS     4
+#define HAKO_PROF_HIST_SUB_NUM      (1 << HAKO_PROF_HIST_SUB_BITS)
+#define HAKO_PROF_HIST_EXP_MAX      40
+#define HAKO_PROF_HIST_BUCKET_NUM   ((HAKO_PROF_HIST_EXP_MAX - HAKO_PROF_HIST_SUB_BITS + 2) * HAKO_PROF_HIST_SUB_NUM)
+
+class HakoProfHistogram {
+private:
+    std::atomic<uint64_t> counts[HAKO_PROF_HIST_BUCKET_NUM];
+    std::atomic<uint64_t> total_count { 0 };
+    std::atomic<uint64_t> total_ns { 0 };
+    std::atomic<uint64_t> max_ns { 0 };
+
+    static void add(std::atomic<uint64_t>& v, uint64_t n)
+    {
+        v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+public:
+    HakoProfHistogram()
+    {
+        for (auto& c : counts) {
+            c.store(0, std::memory_order_relaxed);
+        }
+    }
+    static int bucket_index(uint64_t v)
+    {
+        if (v < HAKO_PROF_HIST_SUB_NUM) {
+            return static_cast<int>(v);
+        }
+#ifdef _MSC_VER
+        int e = 63;
+        while ((v >> e) == 0) {
+            e--;
+        }
+#else
+        int e = 63 - __builtin_clzll(v);
+#endif
+        if (e > HAKO_PROF_HIST_EXP_MAX) {
+            return HAKO_PROF_HIST_BUCKET_NUM - 1;
+        }
+        int top = static_cast<int>(v >> (e - HAKO_PROF_HIST_SUB_BITS));  /* [16, 32) */
+        return (e - HAKO_PROF_HIST_SUB_BITS + 1) * HAKO_PROF_HIST_SUB_NUM + (top - HAKO_PROF_HIST_SUB_NUM);
+    }
+    /*
+     * バケットの上限値(このバケットの値はすべてこれ未満)
+     */
+    static uint64_t bucket_upper(int index)
+    {
+        if (index < HAKO_PROF_HIST_SUB_NUM) {
+            return static_cast<uint64_t>(index) + 1;
+        }
+        int e = (index / HAKO_PROF_HIST_SUB_NUM) + HAKO_PROF_HIST_SUB_BITS - 1;
+        uint64_t top = static_cast<uint64_t>(index % HAKO_PROF_HIST_SUB_NUM) + HAKO_PROF_HIST_SUB_NUM + 1;
+        return top << (e - HAKO_PROF_HIST_SUB_BITS);
+    }
+    void record(uint64_t ns)
+    {
+        add(counts[bucket_index(ns)], 1);
+        add(total_count, 1);
+        add(total_ns, ns);
+        if (ns > max_ns.load(std::memory_order_relaxed)) {
+            max_ns.store(ns, std::memory_order_relaxed);
+        }
+    }
+    uint64_t get_count() const { return total_count.load(std::memory_order_relaxed); }
+    uint64_t get_sum_ns() const { return total_ns.load(std::memory_order_relaxed); }
+    uint64_t get_max_ns() const { return max_ns.load(std::memory_order_relaxed); }
+    /*
+     * 出力用のスナップショット(書き込み中の値が混ざることはあるが、各値は壊れない)
+     */
+    void snapshot(std::vector<uint64_t>& out) const
+    {
+        out.resize(HAKO_PROF_HIST_BUCKET_NUM);
+        for (int i = 0; i < HAKO_PROF_HIST_BUCKET_NUM; i++) {
+            out[i] = counts[i].load(std::memory_order_relaxed);
+        }
+    }
+    /*
+     * q 分位点[nsec](バケットの上限値で返す)
+     */
+    static uint64_t quantile(const std::vector<uint64_t>& buckets, double q)
+    {
+        uint64_t total = 0;
+        for (auto c : buckets) {
+            total += c;
+        }
+        if (total == 0) {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(std::ceil(q * static_cast<double>(total)));
+        rank = std::max<uint64_t>(rank, 1);
+        uint64_t acc = 0;
+        for (size_t i = 0; i < buckets.size(); i++) {
+            acc += buckets[i];
+            if (acc >= rank) {
+                return bucket_upper(static_cast<int>(i));
+            }
+        }
+        return bucket_upper(static_cast<int>(buckets.size()) - 1);
+    }
+};
+
+/*
+ * 計測用の時計: x86 は rdtsc(起動時に steady_clock で較正), それ以外は steady_clock
+ */
+class HakoProfClock {
+private:
+    double ns_per_tick = 1.0;
+public:
+    void calibrate()
+    {
+#ifdef HAKO_PROF_USE_RDTSC
+        auto t0 = std::chrono::steady_clock::now();
+        uint64_t c0 = __rdtsc();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        auto t1 = std::chrono::steady_clock::now();
+        uint64_t c1 = __rdtsc();
+        double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+        if (c1 > c0) {
+            ns_per_tick = ns / static_cast<double>(c1 - c0);
+        }
+#endif
+    }
+    static uint64_t ticks()
+    {
+#ifdef HAKO_PROF_USE_RDTSC
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+    uint64_t to_ns(uint64_t ticks) const
+    {
+        return static_cast<uint64_t>(static_cast<double>(ticks) * ns_per_tick);
+    }
+};
+
+class HakoProfiler {
+private:
+    /*
+     * スレッドごとの表: [機体(最後は all)][段]
+     * 作成後はサイズを変えないので、出力スレッドは表の一覧だけをロックして読む
+     */
+    struct ThreadTable {
+        int thread_id;
+        int aircraft_num;
+        std::unique_ptr<HakoProfHistogram[]> hist;
+        std::atomic<uint64_t> overrun { 0 };
+        HakoProfHistogram& get(int aircraft, int stage)
+        {
+            int a = ((aircraft < 0) || (aircraft >= aircraft_num)) ? aircraft_num : aircraft;
+            return hist[static_cast<size_t>(a) * HAKO_PROF_STAGE_NUM + stage];
+        }
+    };
+    HakoProfClock clock;
+    int aircraft_num = 0;
+    uint64_t step_budget_ns = 0;
+    std::atomic<bool> enabled { false };
+    std::mutex tables_mutex;
+    std::vector<std::unique_ptr<ThreadTable>> tables;
+
+    std::string output;
+    int interval_msec = 1000;
+    std::thread thread;
+    std::atomic<bool> running { false };
+    int listen_fd = -1;
+
+    ThreadTable* get_thread_table()
+    {
+        thread_local ThreadTable* table = nullptr;
+        thread_local const HakoProfiler* owner = nullptr;
+        if ((table == nullptr) || (owner != this)) {
+            std::lock_guard<std::mutex> lock(tables_mutex);
+            std::unique_ptr<ThreadTable> t(new ThreadTable());
+            t->thread_id = static_cast<int>(tables.size());
+            t->aircraft_num = aircraft_num;
+            t->hist.reset(new HakoProfHistogram[static_cast<size_t>(aircraft_num + 1) * HAKO_PROF_STAGE_NUM]);
+            table = t.get();
+            owner = this;
+            tables.push_back(std::move(t));
+        }
+        return table;
+    }
+    static void write_histogram(std::ostream& os, const std::string& labels, const HakoProfHistogram& h, std::vector<uint64_t>& buckets)
+    {
+        static const double bounds[] = {
+            1e-6, 2e-6, 5e-6, 1e-5, 2e-5, 5e-5, 1e-4, 2e-4, 5e-4,
+            1e-3, 2e-3, 5e-3, 1e-2, 2e-2, 5e-2, 1e-1,
+        };
+        h.snapshot(buckets);
+        uint64_t total = 0;
+        for (auto c : buckets) {
+            total += c;
+        }
+        size_t i = 0;
+        uint64_t acc = 0;
+        for (double le : bounds) {
+            const uint64_t le_ns = static_cast<uint64_t>(le * 1e9);
+            while ((i < buckets.size()) && (HakoProfHistogram::bucket_upper(static_cast<int>(i)) <= le_ns)) {
+                acc += buckets[i++];
+            }
+            os << "hako_step_stage_duration_seconds_bucket{" << labels << ",le=\"" << le << "\"} " << acc << "\n";
+        }
+        os << "hako_step_stage_duration_seconds_bucket{" << labels << ",le=\"+Inf\"} " << total << "\n";
+        os << "hako_step_stage_duration_seconds_sum{" << labels << "} " << (static_cast<double>(h.get_sum_ns()) * 1e-9) << "\n";
+        os << "hako_step_stage_duration_seconds_count{" << labels << "} " << total << "\n";
+    }
+    bool write_file(const std::string& path, const std::string& text)
+    {
+        std::string tmp = path + ".tmp";
+        FILE* fp = fopen(tmp.c_str(), "w");
+        if (fp == nullptr) {
+            return false;
+        }
+        bool ok = (fwrite(text.data(), 1, text.size(), fp) == text.size());
+        ok = (fclose(fp) == 0) && ok;
+        return ok && (rename(tmp.c_str(), path.c_str()) == 0);
+    }
+#ifndef _WIN32
+    bool open_socket(const std::string& path)
+    {
+        struct sockaddr_un addr = {};
+        if (path.size() >= sizeof(addr.sun_path)) {
+            return false;
+        }
+        listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listen_fd < 0) {
+            return false;
+        }
+        addr.sun_family = AF_UNIX;
+        path.copy(addr.sun_path, path.size());
+        unlink(path.c_str());
+        if ((bind(listen_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) || (listen(listen_fd, 4) < 0)) {
+            ::close(listen_fd);
+            listen_fd = -1;
+            return false;
+        }
+        return true;
+    }
+    /*
+     * 接続を待ち、接続ごとに最新の値を返して閉じる(周期ごとに戻る)
+     */
+    void serve_socket()
+    {
+        struct pollfd pfd = { listen_fd, POLLIN, 0 };
+        if (poll(&pfd, 1, interval_msec) <= 0) {
+            return;
+        }
+        int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            return;
+        }
+        std::string text = to_prometheus();
+        const char* p = text.data();
+        size_t len = text.size();
+        while (len > 0) {
+            ssize_t n = ::write(fd, p, len);
+            if (n <= 0) {
+                break;
+            }
+            p += n;
+            len -= static_cast<size_t>(n);
+        }
+        ::close(fd);
+    }
+#endif
+    void export_loop()
+    {
+        const std::string unix_prefix = "unix:";
+        if (output.compare(0, unix_prefix.size(), unix_prefix) == 0) {
+#ifndef _WIN32
+            std::string path = output.substr(unix_prefix.size());
+            if (!open_socket(path)) {
+                std::cerr << "ERROR: profiler can not listen on " << path << std::endl;
+                return;
+            }
+            while (running.load(std::memory_order_acquire)) {
+                serve_socket();
+            }
+            ::close(listen_fd);
+            unlink(path.c_str());
+            listen_fd = -1;
+#endif
+            return;
+        }
+        bool warned = false;
+        while (running.load(std::memory_order_acquire)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(interval_msec));
+            if (!write_file(output, to_prometheus()) && !warned) {
+                std::cerr << "ERROR: profiler can not write " << output << std::endl;
+                warned = true;
+            }
+        }
+    }
+
+public:
+    HakoProfiler() {}
+    HakoProfiler(const HakoProfiler&) = delete;
+    HakoProfiler& operator=(const HakoProfiler&) = delete;
+    ~HakoProfiler()
+    {
+        stop();
+    }
+
+    /*
+     * 計測の開始: 機体数とステップの予算(超過をカウントする)を指定する
+     */
+    void start(int num, uint64_t budget_ns)
+    {
+        if (enabled.load()) {
+            return;
+        }
+        aircraft_num = num;
+        step_budget_ns = budget_ns;
+        clock.calibrate();
+        const char* out = std::getenv("HAKO_PROFILER_OUTPUT");
+        output = (out != nullptr) ? out : "hako_profile.prom";
+        const char* interval = std::getenv("HAKO_PROFILER_INTERVAL_MSEC");
+        if (interval != nullptr) {
+            interval_msec = std::max(10, std::atoi(interval));
+        }
+        enabled.store(true, std::memory_order_release);
+        running.store(true, std::memory_order_release);
+        thread = std::thread(&HakoProfiler::export_loop, this);
+        std::cout << "INFO: profiler output: " << output << " interval(msec): " << interval_msec << std::endl;
+    }
+    void stop()
+    {
+        running.store(false, std::memory_order_release);
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    bool is_enabled() const
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+    uint64_t now() const
+    {
+        return HakoProfClock::ticks();
+    }
+    void record(int stage, int aircraft, uint64_t start_ticks)
+    {
+        uint64_t end_ticks = HakoProfClock::ticks();
+        ThreadTable* table = get_thread_table();
+        uint64_t ns = clock.to_ns(end_ticks - start_ticks);
+        table->get(aircraft, stage).record(ns);
+        if ((stage == HAKO_PROF_STEP) && (step_budget_ns > 0) && (ns > step_budget_ns)) {
+            table->overrun.store(table->overrun.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+    }
+
+    /*
+     * Prometheus テキスト形式
+     */
+    std::string to_prometheus()
+    {
+        std::ostringstream os;
+        std::vector<uint64_t> buckets;
+        std::lock_guard<std::mutex> lock(tables_mutex);
+        os << "# HELP hako_step_stage_duration_seconds Processing time of each simulation stage.\n";
+        os << "# TYPE hako_step_stage_duration_seconds histogram\n";
+        for (auto& t : tables) {
+            for (int a = 0; a <= t->aircraft_num; a++) {
+                for (int s = 0; s < HAKO_PROF_STAGE_NUM; s++) {
+                    const HakoProfHistogram& h = t->get(a, s);
+                    if (h.get_count() == 0) {
+                        continue;
+                    }
+                    write_histogram(os, make_labels(t->thread_id, a, t->aircraft_num, s), h, buckets);
+                }
+            }
+        }
+        os << "# HELP hako_step_stage_quantile_seconds Quantiles of the processing time (HDR histogram).\n";
+        os << "# TYPE hako_step_stage_quantile_seconds gauge\n";
+        for (auto& t : tables) {
+            for (int a = 0; a <= t->aircraft_num; a++) {
+                for (int s = 0; s < HAKO_PROF_STAGE_NUM; s++) {
+                    const HakoProfHistogram& h = t->get(a, s);
+                    if (h.get_count() == 0) {
+                        continue;
+                    }
+                    std::string labels = make_labels(t->thread_id, a, t->aircraft_num, s);
+                    h.snapshot(buckets);
+                    for (double q : { 0.5, 0.9, 0.99, 0.999 }) {
+                        os << "hako_step_stage_quantile_seconds{" << labels << ",quantile=\"" << q << "\"} "
+                           << (static_cast<double>(HakoProfHistogram::quantile(buckets, q)) * 1e-9) << "\n";
+                    }
+                    os << "hako_step_stage_quantile_seconds{" << labels << ",quantile=\"1\"} "
+                       << (static_cast<double>(h.get_max_ns()) * 1e-9) << "\n";
+                }
+            }
+        }
+        os << "# HELP hako_step_budget_overrun_total Steps that exceeded the step budget.\n";
+        os << "# TYPE hako_step_budget_overrun_total counter\n";
+        for (auto& t : tables) {
+            os << "hako_step_budget_overrun_total{thread=\"" << t->thread_id << "\"} " << t->overrun.load(std::memory_order_relaxed) << "\n";
+        }
+        os << "# HELP hako_step_budget_seconds Step budget (simulation delta time).\n";
+        os << "# TYPE hako_step_budget_seconds gauge\n";
+        os << "hako_step_budget_seconds " << (static_cast<double>(step_budget_ns) * 1e-9) << "\n";
+        return os.str();
+    }
+    static std::string make_labels(int thread_id, int aircraft, int aircraft_num, int stage)
+    {
+        std::string a = (aircraft >= aircraft_num) ? std::string("all") : std::to_string(aircraft);
+        return "thread=\"" + std::to_string(thread_id) + "\",aircraft=\"" + a + "\",stage=\"" + hako_prof_stage_name(stage) + "\"";
+    }
+};
+
+inline HakoProfiler& hako_profiler()
+{
+    static HakoProfiler instance;
+    return instance;
+}
+
+class HakoProfScope {
+private:
+    int stage;
+    int aircraft;
+    uint64_t start;
+public:
+    HakoProfScope(int _stage, int _aircraft) : stage(_stage), aircraft(_aircraft), start(hako_profiler().now()) {}
+    ~HakoProfScope()
+    {
+        if (hako_profiler().is_enabled()) {
+            hako_profiler().record(stage, aircraft, start);
+        }
+    }
+};
+
+#define HAKO_PROF_CONCAT_(a, b)    a##b
+#define HAKO_PROF_CONCAT(a, b)     HAKO_PROF_CONCAT_(a, b)
+#ifdef HAKO_PROFILER_ENABLE
+#define HAKO_PROF_START(aircraft_num, budget_ns)    hako_profiler().start((aircraft_num), (budget_ns))
+#define HAKO_PROF_SCOPE(stage, aircraft)            HakoProfScope HAKO_PROF_CONCAT(hako_prof_scope_, __LINE__)((stage), (aircraft))
+#else
+#define HAKO_PROF_START(aircraft_num, budget_ns)    do { } while (0)
+#define HAKO_PROF_SCOPE(stage, aircraft)            do { } while (0)
+#endif
+
+#endif /* _HAKO_PROFILER_HPP_ */
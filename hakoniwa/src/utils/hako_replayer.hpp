@@ -2,15 +2,118 @@
 #define _HAKO_REPLAYER_HPP_
 
 #include "csv_data.hpp"
+#include "drone_physics.hpp"
 #include <map>
 #include <string>
 #include <vector>
 #include <iostream>
+#include <algorithm>
+#include <cstdint>
+
+/*
+ * drone_dynamics.csv の1行分(timestamp, X, Y, Z, Rx, Ry, Rz, ..., Thrust)
+ */
+struct HakoReplaySample {
+    uint64_t timestamp_usec;
+    double pos[3];
+    double euler[3];
+    double thrust;
+};
+
+/*
+ * 外部からの再生制御(PDU経由)
+ * - paused: 一時停止
+ * - rate:   再生速度(1.0 で等速)
+ * - seek_request_id: 値が変化したときだけ seek_time_sec へシークする
+ */
+struct HakoReplayControl {
+    bool paused;
+    double rate;
+    uint64_t seek_request_id;
+    double seek_time_sec;
+};
 
 class HakoReplayer {
 private:
-    std::map<std::string, CsvData*> vehicle_replayers;
+    struct VehicleLog {
+        std::vector<HakoReplaySample> samples;
+        size_t cursor = 0;
+        uint64_t play_time_usec = 0; /* ログ先頭からの経過時間 */
+        bool paused = false;
+        double rate = 1.0;
+        uint64_t seek_request_id = 0;
+    };
+    std::map<std::string, VehicleLog> vehicle_replayers;
     std::map<std::string, double> mass;
+
+    static bool parse_row(const std::vector<std::string>& row, HakoReplaySample& sample)
+    {
+        if (row.size() < 14) {
+            return false;
+        }
+        try {
+            sample.timestamp_usec = std::stoull(row[0]);
+            for (int i = 0; i < 3; i++) {
+                sample.pos[i] = std::stod(row[1 + i]);
+                sample.euler[i] = std::stod(row[4 + i]);
+            }
+            sample.thrust = std::stod(row[13]);
+        } catch (const std::exception&) {
+            return false;
+        }
+        return true;
+    }
+    /*
+     * cursor を t (ログ絶対時刻) を挟む区間 [cursor, cursor+1] に合わせる。
+     * 通常の再生では前回位置からの線形探索で済み、シーク時は二分探索する。
+     */
+    static void locate(VehicleLog& log, uint64_t t)
+    {
+        auto& s = log.samples;
+        if (log.cursor < s.size() && s[log.cursor].timestamp_usec <= t) {
+            for (int step = 0; step < 8; step++) {
+                if (log.cursor + 1 >= s.size() || s[log.cursor + 1].timestamp_usec > t) {
+                    return;
+                }
+                log.cursor++;
+            }
+        }
+        auto it = std::upper_bound(s.begin(), s.end(), t,
+            [](uint64_t v, const HakoReplaySample& e) { return v < e.timestamp_usec; });
+        log.cursor = (it == s.begin()) ? 0 : static_cast<size_t>((it - s.begin()) - 1);
+    }
+    static void interpolate(const HakoReplaySample& a, const HakoReplaySample& b, double u, HakoReplaySample& out)
+    {
+        using namespace hako::drone_physics;
+        for (int i = 0; i < 3; i++) {
+            out.pos[i] = a.pos[i] + (b.pos[i] - a.pos[i]) * u;
+        }
+        out.thrust = a.thrust + (b.thrust - a.thrust) * u;
+
+        QuaternionType qa = quaternion_from_euler(EulerType{a.euler[0], a.euler[1], a.euler[2]});
+        QuaternionType qb = quaternion_from_euler(EulerType{b.euler[0], b.euler[1], b.euler[2]});
+        double dot = qa.w*qb.w + qa.x*qb.x + qa.y*qb.y + qa.z*qb.z;
+        if (dot < 0.0) {
+            /* 最短経路側で補間する */
+            qb = -qb;
+            dot = -dot;
+        }
+        QuaternionType q;
+        if (dot > 0.9995) {
+            /* ほぼ同一姿勢は nlerp で十分 */
+            q = qa + (qb - qa) * u;
+        }
+        else {
+            double theta = std::acos(dot);
+            double sin_theta = std::sin(theta);
+            q = qa * (std::sin((1.0 - u) * theta) / sin_theta) + qb * (std::sin(u * theta) / sin_theta);
+        }
+        normalize(q);
+        EulerType e = euler_from_quaternion(q);
+        out.euler[0] = e.phi;
+        out.euler[1] = e.theta;
+        out.euler[2] = e.psi;
+    }
 public:
     HakoReplayer() {}
 
@@ -29,27 +132,97 @@ public:
     }
     void add_vehicle(const std::string& vehicle_id, const std::string& file_name) {
         std::cout << "vehicle: " << vehicle_id << " logpath: " << file_name << std::endl;
-        if (vehicle_replayers.find(vehicle_id) == vehicle_replayers.end()) {
-            vehicle_replayers[vehicle_id] = new CsvData(file_name);
-            // skip head
-            std::vector<std::string> values;
-            vehicle_replayers[vehicle_id]->read(values);
-            // Remove the last row
-            vehicle_replayers[vehicle_id]->remove_last();
+        if (vehicle_replayers.find(vehicle_id) != vehicle_replayers.end()) {
+            return;
         }
+        CsvData csv(file_name);
+        // skip head
+        std::vector<std::string> values;
+        csv.read(values);
+        // Remove the last row
+        csv.remove_last();
+
+        VehicleLog& log = vehicle_replayers[vehicle_id];
+        HakoReplaySample sample;
+        while (csv.read(values)) {
+            if (!parse_row(values, sample)) {
+                continue;
+            }
+            // 時刻が巻き戻る行(ログの再起動など)は捨てる
+            if (!log.samples.empty() && sample.timestamp_usec < log.samples.back().timestamp_usec) {
+                continue;
+            }
+            log.samples.push_back(sample);
+        }
+        std::cout << "INFO: replay samples: " << log.samples.size() << std::endl;
     }
 
-    bool next(const std::string& vehicle_id, std::vector<std::string>& data) {
-        if (vehicle_replayers.find(vehicle_id) != vehicle_replayers.end()) {
-            return vehicle_replayers[vehicle_id]->read(data);
+    /*
+     * 再生時刻を dt_usec(シミュレーション時間) * rate だけ進め、
+     * その時刻に補間したサンプルを返す。ログ終端を越えたら false。
+     */
+    bool next(const std::string& vehicle_id, uint64_t dt_usec, HakoReplaySample& out) {
+        auto it = vehicle_replayers.find(vehicle_id);
+        if (it == vehicle_replayers.end() || it->second.samples.empty()) {
+            return false;
         }
-        return false;
+        VehicleLog& log = it->second;
+        const auto& s = log.samples;
+        uint64_t t0 = s.front().timestamp_usec;
+        uint64_t duration = s.back().timestamp_usec - t0;
+        if (!log.paused) {
+            log.play_time_usec += static_cast<uint64_t>(static_cast<double>(dt_usec) * log.rate);
+        }
+        if (log.play_time_usec > duration) {
+            log.play_time_usec = duration;
+            out = s.back();
+            return false;
+        }
+        uint64_t t = t0 + log.play_time_usec;
+        locate(log, t);
+        if (log.cursor + 1 >= s.size()) {
+            out = s[log.cursor];
+            return true;
+        }
+        const HakoReplaySample& a = s[log.cursor];
+        const HakoReplaySample& b = s[log.cursor + 1];
+        uint64_t span = b.timestamp_usec - a.timestamp_usec;
+        double u = (span == 0) ? 0.0 : static_cast<double>(t - a.timestamp_usec) / static_cast<double>(span);
+        interpolate(a, b, u, out);
+        out.timestamp_usec = t;
+        return true;
     }
 
-    void close_all() {
-        for (auto& [vehicle_id, replayer] : vehicle_replayers) {
-            delete replayer;
+    void apply_control(const std::string& vehicle_id, const HakoReplayControl& ctrl)
+    {
+        auto it = vehicle_replayers.find(vehicle_id);
+        if (it == vehicle_replayers.end()) {
+            return;
+        }
+        VehicleLog& log = it->second;
+        log.paused = ctrl.paused;
+        if (ctrl.rate > 0.0) {
+            log.rate = ctrl.rate;
+        }
+        if (ctrl.seek_request_id != log.seek_request_id) {
+            log.seek_request_id = ctrl.seek_request_id;
+            seek(vehicle_id, ctrl.seek_time_sec);
         }
+    }
+    void seek(const std::string& vehicle_id, double time_sec)
+    {
+        auto it = vehicle_replayers.find(vehicle_id);
+        if (it == vehicle_replayers.end()) {
+            return;
+        }
+        VehicleLog& log = it->second;
+        log.play_time_usec = (time_sec <= 0.0) ? 0 : static_cast<uint64_t>(time_sec * 1000000.0);
+        // 次の next() で二分探索させる
+        log.cursor = 0;
+        std::cout << "INFO: replay seek vehicle: " << vehicle_id << " time_sec: " << time_sec << std::endl;
+    }
+
+    void close_all() {
         vehicle_replayers.clear();
     }
 
@@ -0,0 +1,267 @@
+#ifndef _HAKO_RTF_MONITOR_HPP_
+#define _HAKO_RTF_MONITOR_HPP_
+
+/*
+ * アセットランナーのループ(hako_asset_runner_step(1) を呼ぶループ)の実時間監視
+ *
+ * ステップが完了するたびに step() を呼ぶと、以下を記録する。
+ *   - 実時間係数(RTF): シミュレーション時間の進み / 実時間の進み
+ *   - デッドライン超過: 前のステップの完了からの間隔がデッドライン(既定: delta_time_usec)
+ *     を超えた回数と、連続して超過した最大回数
+ *   - PX4 との時刻のずれ: record_skew() で渡した (シミュレーション時刻 - PX4 の時刻) の統計
+ *
+ * 環境変数で以下を指定できる。
+ *   HAKO_RTF_REPORT_SEC=10          N 秒ごとに集計を INFO として出力する(既定: 0 = 出力しない)
+ *   HAKO_RTF_DEADLINE_USEC=3000     デッドライン(既定: delta_time_usec)
+ *   HAKO_RTF_MISS_RATE_MAX=0.01     デッドライン超過率の上限(既定: 未指定 = 判定しない)
+ *   HAKO_RTF_MISS_MIN_STEPS=1000    超過率を判定する最小ステップ数
+ *
+ * 超過率が上限を超えると step() が false を返す。ランナーはプロセスを異常終了させて、
+ * CI の実行を失敗にする。
+ *
+ * シミュレーションの停止(hako_asset_runner_step() が false)では stop() を呼ぶ。
+ * 停止中の時間は計測に含めず、その回の集計を出力してから次の回のために値を初期化する。
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+
+class HakoRtfMonitor {
+private:
+    /* 設定 */
+    uint64_t delta_time_usec = 0;
+    uint64_t deadline_usec = 0;
+    uint64_t report_interval_usec = 0;
+    double miss_rate_max = -1.0;                /* 負の値は判定しない */
+    uint64_t miss_min_steps = 1000;
+
+    /* 計測 */
+    bool has_last = false;
+    uint64_t start_usec = 0;
+    uint64_t last_usec = 0;
+    uint64_t last_report_usec = 0;
+    uint64_t steps = 0;                         /* 間隔を計測したステップ数(最初のステップは含まない) */
+    uint64_t misses = 0;
+    uint64_t miss_streak = 0;
+    uint64_t miss_streak_max = 0;
+    uint64_t period_max_usec = 0;
+    uint64_t period_sum_usec = 0;
+    /* 直前の出力からの区間 */
+    uint64_t interval_steps = 0;
+    uint64_t interval_misses = 0;
+
+    uint64_t skew_count = 0;
+    int64_t skew_last_usec = 0;
+    int64_t skew_min_usec = std::numeric_limits<int64_t>::max();
+    int64_t skew_max_usec = std::numeric_limits<int64_t>::min();
+    double skew_sum_usec = 0;
+
+    bool failed = false;
+
+    static uint64_t env_uint(const char* name, uint64_t defval)
+    {
+        const char* value = std::getenv(name);
+        if (value == nullptr || value[0] == '\0') {
+            return defval;
+        }
+        return std::strtoull(value, nullptr, 10);
+    }
+    static double rate(uint64_t num, uint64_t den)
+    {
+        return (den == 0) ? 0.0 : static_cast<double>(num) / static_cast<double>(den);
+    }
+
+public:
+    static uint64_t now_usec()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    /*
+     * dt_usec: シミュレーションの1ステップの時間
+     */
+    void init(uint64_t dt_usec)
+    {
+        delta_time_usec = dt_usec;
+        deadline_usec = env_uint("HAKO_RTF_DEADLINE_USEC", dt_usec);
+        report_interval_usec = env_uint("HAKO_RTF_REPORT_SEC", 0) * 1000000ULL;
+        miss_min_steps = env_uint("HAKO_RTF_MISS_MIN_STEPS", miss_min_steps);
+        const char* max = std::getenv("HAKO_RTF_MISS_RATE_MAX");
+        if (max != nullptr && max[0] != '\0') {
+            miss_rate_max = std::atof(max);
+        }
+        if (report_interval_usec > 0 || miss_rate_max >= 0) {
+            std::cout << "INFO: rtf monitor deadline(usec): " << deadline_usec
+                      << " report(sec): " << (report_interval_usec / 1000000ULL)
+                      << " miss rate max: " << miss_rate_max << std::endl;
+        }
+        reset();
+    }
+    void set_deadline_usec(uint64_t usec)
+    {
+        deadline_usec = usec;
+    }
+    void set_report_interval_sec(uint64_t sec)
+    {
+        report_interval_usec = sec * 1000000ULL;
+    }
+    void set_miss_rate_max(double max, uint64_t min_steps)
+    {
+        miss_rate_max = max;
+        miss_min_steps = min_steps;
+    }
+    void reset()
+    {
+        uint64_t dt = delta_time_usec;
+        uint64_t deadline = deadline_usec;
+        uint64_t report = report_interval_usec;
+        double max = miss_rate_max;
+        uint64_t min_steps = miss_min_steps;
+        *this = HakoRtfMonitor();
+        delta_time_usec = dt;
+        deadline_usec = deadline;
+        report_interval_usec = report;
+        miss_rate_max = max;
+        miss_min_steps = min_steps;
+    }
+
+    /*
+     * 1ステップ完了(シミュレーション時間が delta_time_usec 進んだ)
+     * return value: false の場合はデッドライン超過率が上限を超えた
+     */
+    bool step()
+    {
+        return step(now_usec());
+    }
+    bool step(uint64_t now)
+    {
+        if (!has_last) {
+            has_last = true;
+            start_usec = now;
+            last_usec = now;
+            last_report_usec = now;
+            return !failed;
+        }
+        uint64_t period = now - last_usec;
+        last_usec = now;
+        steps++;
+        interval_steps++;
+        period_sum_usec += period;
+        period_max_usec = std::max(period_max_usec, period);
+        if (period > deadline_usec) {
+            misses++;
+            interval_misses++;
+            miss_streak++;
+            miss_streak_max = std::max(miss_streak_max, miss_streak);
+        }
+        else {
+            miss_streak = 0;
+        }
+        if (report_interval_usec > 0 && (now - last_report_usec) >= report_interval_usec) {
+            std::cout << "INFO: rtf: " << summary(now) << std::endl;
+            last_report_usec = now;
+            interval_steps = 0;
+            interval_misses = 0;
+        }
+        if (!failed && miss_rate_max >= 0 && steps >= miss_min_steps && get_miss_rate() > miss_rate_max) {
+            failed = true;
+            std::cerr << "ERROR: rtf: deadline miss rate " << get_miss_rate()
+                      << " exceeds " << miss_rate_max << ": " << summary(now) << std::endl;
+        }
+        return !failed;
+    }
+    /*
+     * skew_usec: シミュレーション時刻 - PX4 の時刻(どちらも開始からの経過時間)
+     */
+    void record_skew(int64_t skew_usec)
+    {
+        skew_count++;
+        skew_last_usec = skew_usec;
+        skew_min_usec = std::min(skew_min_usec, skew_usec);
+        skew_max_usec = std::max(skew_max_usec, skew_usec);
+        skew_sum_usec += static_cast<double>(skew_usec);
+    }
+    /*
+     * シミュレーション停止: 集計を出力して初期化する
+     */
+    void stop()
+    {
+        if (steps > 0) {
+            std::cout << "INFO: rtf: " << summary(last_usec) << std::endl;
+        }
+        reset();
+    }
+
+    uint64_t get_steps() const
+    {
+        return steps;
+    }
+    uint64_t get_misses() const
+    {
+        return misses;
+    }
+    uint64_t get_miss_streak_max() const
+    {
+        return miss_streak_max;
+    }
+    uint64_t get_period_max_usec() const
+    {
+        return period_max_usec;
+    }
+    double get_miss_rate() const
+    {
+        return rate(misses, steps);
+    }
+    /*
+     * 最初のステップの完了から最後のステップの完了までの実時間係数
+     */
+    double get_rtf() const
+    {
+        return rate(steps * delta_time_usec, last_usec - start_usec);
+    }
+    uint64_t get_skew_count() const
+    {
+        return skew_count;
+    }
+    int64_t get_skew_min_usec() const
+    {
+        return (skew_count == 0) ? 0 : skew_min_usec;
+    }
+    int64_t get_skew_max_usec() const
+    {
+        return (skew_count == 0) ? 0 : skew_max_usec;
+    }
+    double get_skew_mean_usec() const
+    {
+        return (skew_count == 0) ? 0.0 : skew_sum_usec / static_cast<double>(skew_count);
+    }
+    bool is_failed() const
+    {
+        return failed;
+    }
+    std::string summary(uint64_t now) const
+    {
+        std::ostringstream oss;
+        oss << "steps=" << steps
+            << " rtf=" << get_rtf()
+            << " miss=" << misses << " (" << (get_miss_rate() * 100.0) << "%)"
+            << " interval_miss=" << interval_misses << "/" << interval_steps
+            << " miss_streak_max=" << miss_streak_max
+            << " period_mean_usec=" << rate(period_sum_usec, steps)
+            << " period_max_usec=" << period_max_usec
+            << " elapsed_sec=" << (static_cast<double>(now - start_usec) / 1000000.0);
+        if (skew_count > 0) {
+            oss << " px4_skew_usec(last/min/max/mean)=" << skew_last_usec
+                << "/" << skew_min_usec << "/" << skew_max_usec << "/" << get_skew_mean_usec();
+        }
+        return oss.str();
+    }
+};
+
+#endif /* _HAKO_RTF_MONITOR_HPP_ */
@@ -0,0 +1,102 @@
+#ifndef _HAKO_SPSC_QUEUE_HPP_
+#define _HAKO_SPSC_QUEUE_HPP_
+
+/*
+ * プロセス内の lock-free SPSC キュー(1 producer / 1 consumer)
+ *
+ * 要素は固定長配列に置くため、push/pop でメモリ確保は行わない。
+ * キューが満杯の場合 try_push() は false を返すので、producer 側を止めたく
+ * ない用途(転送経路など)では呼び出し側で破棄・カウントする。
+ */
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace hako::utils {
+
+#define HAKO_SPSC_QUEUE_CACHELINE   64
+
+template <typename T, size_t N>
+class SpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "queue size must be power of 2");
+private:
+    alignas(HAKO_SPSC_QUEUE_CACHELINE) std::atomic<size_t> head { 0 };  /* producer が書く */
+    alignas(HAKO_SPSC_QUEUE_CACHELINE) std::atomic<size_t> tail { 0 };  /* consumer が書く */
+    alignas(HAKO_SPSC_QUEUE_CACHELINE) T slots[N];
+
+public:
+    SpscQueue() {}
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    /*
+     * producer: 書き込み先スロットを取得する。満杯なら nullptr.
+     * 書き終えたら commit() で公開する(コピーを1回で済ませるため)。
+     */
+    T* reserve()
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= N) {
+            return nullptr;
+        }
+        return &slots[h & (N - 1)];
+    }
+    void commit()
+    {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    bool try_push(const T& value)
+    {
+        T* slot = reserve();
+        if (slot == nullptr) {
+            return false;
+        }
+        *slot = value;
+        commit();
+        return true;
+    }
+
+    /*
+     * consumer: 先頭要素を参照する。空なら nullptr.
+     * 処理し終えたら release() でスロットを返す。
+     */
+    const T* front() const
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (head.load(std::memory_order_acquire) == t) {
+            return nullptr;
+        }
+        return &slots[t & (N - 1)];
+    }
+    void release()
+    {
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    bool try_pop(T& value)
+    {
+        const T* slot = front();
+        if (slot == nullptr) {
+            return false;
+        }
+        value = *slot;
+        release();
+        return true;
+    }
+
+    size_t size() const
+    {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+    bool empty() const
+    {
+        return size() == 0;
+    }
+    static constexpr size_t capacity()
+    {
+        return N;
+    }
+};
+
+} // namespace hako::utils
+
+#endif /* _HAKO_SPSC_QUEUE_HPP_ */
@@ -0,0 +1,102 @@
+#ifndef _HAKO_STATE_SNAPSHOT_HPP_
+#define _HAKO_STATE_SNAPSHOT_HPP_
+
+/*
+ * 状態のスナップショット
+ *
+ * 各コンポーネントは、状態を持つメンバの領域(アドレスとサイズ)を
+ * add_state_regions() で登録する。保存と復元は登録した領域の memcpy のみで行い、
+ * 型ごとの変換やメモリ確保はしない(隣り合う領域は登録時に1つにまとめる)。
+ *
+ * - 領域は機体の構築(パラメータ設定)が終わった後に集める。
+ *   登録した領域のアドレスは、機体を破棄するまで変わらないこと
+ *   (std::vector などは登録後に再確保しないこと)
+ * - パラメータ(ゲイン、質量など)は含めない。同じ設定で作った機体の間でのみ交換できる
+ * - スナップショットはバイト列なので、そのままファイルに保存できる
+ *   (同じビルド、同じ設定の間でのみ有効)
+ */
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+class HakoStateRegions {
+private:
+    struct Region {
+        uint8_t *addr;
+        size_t size;
+    };
+    std::vector<Region> regions;
+    size_t total_size = 0;
+public:
+    void add(void *addr, size_t size)
+    {
+        if (size == 0) {
+            return;
+        }
+        uint8_t *p = static_cast<uint8_t*>(addr);
+        if (!regions.empty() && (regions.back().addr + regions.back().size) == p) {
+            regions.back().size += size;
+        }
+        else {
+            regions.push_back({ p, size });
+        }
+        total_size += size;
+    }
+    template <typename T>
+    void add(T& value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "state must be trivially copyable");
+        add(static_cast<void*>(&value), sizeof(T));
+    }
+    template <typename T>
+    void add_array(T *values, size_t num)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "state must be trivially copyable");
+        add(static_cast<void*>(values), sizeof(T) * num);
+    }
+    void clear()
+    {
+        regions.clear();
+        total_size = 0;
+    }
+    /*
+     * スナップショットのバイト数
+     */
+    size_t size() const
+    {
+        return total_size;
+    }
+    size_t region_num() const
+    {
+        return regions.size();
+    }
+    /*
+     * buf には size() バイト以上の領域を渡すこと
+     */
+    void save(void *buf) const
+    {
+        uint8_t *dst = static_cast<uint8_t*>(buf);
+        for (const auto& r : regions) {
+            std::memcpy(dst, r.addr, r.size);
+            dst += r.size;
+        }
+    }
+    void restore(const void *buf) const
+    {
+        const uint8_t *src = static_cast<const uint8_t*>(buf);
+        for (const auto& r : regions) {
+            std::memcpy(r.addr, src, r.size);
+            src += r.size;
+        }
+    }
+};
+
+class IStateSnapshot {
+public:
+    virtual ~IStateSnapshot() {}
+    virtual void add_state_regions(HakoStateRegions& regions) = 0;
+};
+
+#endif /* _HAKO_STATE_SNAPSHOT_HPP_ */
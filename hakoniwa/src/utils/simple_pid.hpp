@@ -2,6 +2,7 @@
 #define _SIMPLE_PID_HPP_
 
 #include <iostream>
+#include "hako_state_snapshot.hpp"
 #define SIMPLE_PID_INUM 10
 
 class PID {
@@ -55,6 +56,17 @@ public:
     void reset_integral() {
         integral = 0.0;
     }
+    /*
+     * ゲインと目標値を除く内部状態
+     */
+    void add_state_regions(HakoStateRegions& regions) {
+        regions.add(integral);
+        regions.add(prev_error);
+        regions.add(first_time);
+        regions.add(i_inx);
+        regions.add(i_num);
+        regions.add(i_values);
+    }
 };
 
 
@@ -0,0 +1,88 @@
+#include <benchmark/benchmark.h>
+#include <fstream>
+#include <cstdio>
+#include <filesystem>
+#include "aircraft/aircraft_factory.hpp"
+#include "config/drone_config.hpp"
+#include "utils/csv_logger.hpp"
+
+/*
+ * AirCraft::run() の1ステップ(バッテリー, ロータ, 推力, 機体力学, 全センサ, ログ)の
+ * ベンチマーク
+ *
+ *   ./hako-px4sim-bench --benchmark_filter=AirCraft
+ *
+ * 機体は test の設定(config/rc/drone_config_0.json)から create_aircraft() で作る。
+ * ログの出力先だけ一時ディレクトリに変える。
+ */
+using namespace hako::assets::drone;
+
+#define AIRCRAFT_BENCH_JSON "./aircraft_bench_config.json"
+
+static IAirCraft* create_bench_aircraft(const std::string& physics_equation, bool log_enable)
+{
+    std::ifstream src(std::string(HAKO_TEST_CONFIG_DIR) + "/rc/drone_config_0.json");
+    if (!src.is_open()) {
+        return nullptr;
+    }
+    nlohmann::json j;
+    src >> j;
+    j["simulation"]["logOutputDirectory"] = std::filesystem::temp_directory_path().string();
+    j["components"]["droneDynamics"]["physicsEquation"] = physics_equation;
+    j["components"]["droneDynamics"]["position_meter"] = { 0, 0, -100 };
+    std::ofstream f(AIRCRAFT_BENCH_JSON);
+    f << j.dump();
+    f.close();
+    auto data = drone_config_data_parse(AIRCRAFT_BENCH_JSON);
+    std::remove(AIRCRAFT_BENCH_JSON);
+    if (data == nullptr) {
+        return nullptr;
+    }
+    DroneConfig config(data);
+    if (log_enable) {
+        CsvLogger::enable();
+    }
+    else {
+        CsvLogger::disable();
+    }
+    return create_aircraft(0, config);
+}
+
+static void bench_aircraft_run(benchmark::State& state, const std::string& physics_equation)
+{
+    const bool log_enable = (state.range(0) != 0);
+    IAirCraft* drone = create_bench_aircraft(physics_equation, log_enable);
+    if (drone == nullptr) {
+        state.SkipWithError("can not create aircraft");
+        return;
+    }
+    DroneDynamicsInputType input = {};
+    input.no_use_actuator = false;
+    for (int i = 0; i < drone->get_rotor_num(); i++) {
+        input.controls[i] = 0.55;
+    }
+    int count = 0;
+    for (auto _ : state) {
+        drone->run(input);
+        benchmark::DoNotOptimize(drone->get_drone_dynamics().get_pos());
+        /* 発散しないように定期的に戻す */
+        if (++count == 10000) {
+            state.PauseTiming();
+            drone->reset();
+            count = 0;
+            state.ResumeTiming();
+        }
+    }
+    CsvLogger::disable();
+    delete drone;
+}
+static void BM_AirCraftRunBodyFrame(benchmark::State& state)
+{
+    bench_aircraft_run(state, "BodyFrame");
+}
+BENCHMARK(BM_AirCraftRunBodyFrame)->ArgName("log")->Arg(0)->Arg(1);
+static void BM_AirCraftRunBodyFrameRK4(benchmark::State& state)
+{
+    bench_aircraft_run(state, "BodyFrameRK4");
+}
+BENCHMARK(BM_AirCraftRunBodyFrameRK4)->ArgName("log")->Arg(0);
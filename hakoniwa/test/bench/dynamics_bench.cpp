@@ -0,0 +1,57 @@
+#include <benchmark/benchmark.h>
+#include "physics/body_frame/drone_dynamics_body_frame.hpp"
+#include "physics/body_frame_rk4/drone_dynamics_body_frame_rk4.hpp"
+#include "physics/ground_frame/drone_dynamics_ground_frame.hpp"
+#include "physics/body_frame_matlab/drone_dynamics_body_frame_matlab.hpp"
+
+/*
+ * IDroneDynamics の実装ごとの run() のベンチマーク
+ *
+ *   ./hako-px4sim-bench --benchmark_filter=Dynamics
+ *
+ * 上空(地面の境界条件にかからない高さ)でホバリング付近の推力と小さなトルクを
+ * 与え続ける。
+ */
+using namespace hako::assets::drone;
+
+template <typename T>
+static void BM_Dynamics(benchmark::State& state)
+{
+    const bool use_quaternion = (state.range(0) != 0);
+    T dynamics(0.001);
+    dynamics.set_use_quaternion(use_quaternion);
+    dynamics.set_mass(0.71);
+    dynamics.set_drag(0.2, 0.0);
+    dynamics.set_body_size(0.1, 0.1, 0.01);
+    dynamics.set_torque_constants(0.0061, 0.00653, 0.0116);
+    dynamics.set_collision_detection(false);
+    dynamics.set_manual_control(false);
+    dynamics.set_out_of_bounds_reset(std::nullopt);
+    DronePositionType pos;
+    pos.data = { 0, 0, -100 };
+    dynamics.set_pos(pos);
+    DroneEulerType angle;
+    angle.data = { 0, 0, 0 };
+    dynamics.set_angle(angle);
+
+    DroneDynamicsInputType input = {};
+    input.thrust.data = 0.71 * GRAVITY;
+    input.torque.data = { 1.0e-6, -1.0e-6, 1.0e-7 };
+    int count = 0;
+    for (auto _ : state) {
+        dynamics.run(input);
+        benchmark::DoNotOptimize(dynamics.get_pos());
+        /* 発散しないように定期的に戻す */
+        if (++count == 10000) {
+            state.PauseTiming();
+            dynamics.set_pos(pos);
+            dynamics.set_angle(angle);
+            count = 0;
+            state.ResumeTiming();
+        }
+    }
+}
+BENCHMARK_TEMPLATE(BM_Dynamics, DroneDynamicsBodyFrame)->ArgName("quaternion")->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_Dynamics, DroneDynamicsBodyFrameRK4)->ArgName("quaternion")->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_Dynamics, DroneDynamicsGroundFrame)->ArgName("quaternion")->Arg(0);
+BENCHMARK_TEMPLATE(BM_Dynamics, DroneDynamicsBodyFrameMatlab)->ArgName("quaternion")->Arg(0);
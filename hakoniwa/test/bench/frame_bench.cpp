@@ -0,0 +1,191 @@
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include "utils/csv_logger.hpp"
+#include "thruster/thrust_dynamics_nonlinear.hpp"
+#include "thruster/thrust_kernel.hpp"
+#include "thruster/thrust_kernel_simd.hpp"
+#include "controller/drone_mixer.hpp"
+
+/*
+ * 機体形状(ロータ数)ごとの推力・トルク計算とミキサーのベンチマーク
+ *
+ *   ./hako-px4sim-bench --benchmark_filter=Frame
+ */
+using namespace hako::assets::drone;
+
+static void make_frame(int num, RotorConfigType* rotor)
+{
+    for (int i = 0; i < num; i++) {
+        double angle = (M_PI / num) + (2.0 * M_PI * i / num);
+        rotor[i].data.x = 0.2 * std::cos(angle);
+        rotor[i].data.y = 0.2 * std::sin(angle);
+        rotor[i].data.z = 0;
+        rotor[i].ccw = (i % 2 == 0) ? 1 : -1;
+    }
+}
+
+/*
+ * ThrustDynamicsNonLinear::run (特殊化カーネル)
+ */
+static void BM_FrameThrustDynamics(benchmark::State& state)
+{
+    const int num = static_cast<int>(state.range(0));
+    RotorConfigType rotor[ROTOR_NUM_MAX];
+    make_frame(num, rotor);
+    ThrustDynamicsNonLinear thrust(0.001);
+    thrust.set_params(1.0e-5, 1.0e-7, 1.0e-4);
+    thrust.set_rotor_config(rotor, num);
+    DroneRotorSpeedType speed[ROTOR_NUM_MAX];
+    double k = 0;
+    for (auto _ : state) {
+        for (int i = 0; i < num; i++) {
+            speed[i].data = 500.0 + i + k;
+        }
+        k += 1e-3;
+        thrust.run(speed);
+        benchmark::DoNotOptimize(thrust.get_torque());
+    }
+}
+BENCHMARK(BM_FrameThrustDynamics)->Arg(4)->Arg(6)->Arg(8);
+
+/*
+ * 推力・トルク計算のカーネル単体: 特殊化版と drone_physics の汎用版(ロータ数は実行時)
+ */
+static void bench_thrust_kernel(benchmark::State& state, ThrustKernelType kernel)
+{
+    const int num = static_cast<int>(state.range(0));
+    RotorConfigType rotor[ROTOR_NUM_MAX];
+    make_frame(num, rotor);
+    hako::drone_physics::VectorType position[ROTOR_NUM_MAX];
+    double ccw[ROTOR_NUM_MAX];
+    double omega[ROTOR_NUM_MAX];
+    double omega_acc[ROTOR_NUM_MAX] = {};
+    for (int i = 0; i < num; i++) {
+        position[i] = { rotor[i].data.x, rotor[i].data.y, rotor[i].data.z };
+        ccw[i] = rotor[i].ccw;
+    }
+    const ThrustKernelParamType param = { 1.0e-5, 1.0e-7, 1.0e-4, num, position, ccw };
+    double thrust;
+    hako::drone_physics::TorqueType torque;
+    double k = 0;
+    for (auto _ : state) {
+        for (int i = 0; i < num; i++) {
+            omega[i] = 500.0 + i + k;
+        }
+        k += 1e-3;
+        kernel(param, omega, omega_acc, thrust, torque);
+        benchmark::DoNotOptimize(thrust);
+        benchmark::DoNotOptimize(torque);
+    }
+}
+static void BM_FrameThrustKernel(benchmark::State& state)
+{
+    bench_thrust_kernel(state, thrust_kernel_select_nonlinear(static_cast<int>(state.range(0))));
+}
+BENCHMARK(BM_FrameThrustKernel)->Arg(4)->Arg(6)->Arg(8);
+static void BM_FrameThrustGeneric(benchmark::State& state)
+{
+    bench_thrust_kernel(state, thrust_kernel_nonlinear_generic);
+}
+BENCHMARK(BM_FrameThrustGeneric)->Arg(4)->Arg(6)->Arg(8);
+
+/*
+ * 角加速度(前回との差分)を含む推力・トルク計算: スカラー版の特殊化カーネルと SIMD 版
+ */
+static void BM_FrameThrustScalarStep(benchmark::State& state)
+{
+    const int num = static_cast<int>(state.range(0));
+    const double dt = 0.001;
+    RotorConfigType rotor[ROTOR_NUM_MAX];
+    make_frame(num, rotor);
+    hako::drone_physics::VectorType position[ROTOR_NUM_MAX];
+    double ccw[ROTOR_NUM_MAX];
+    double omega[ROTOR_NUM_MAX];
+    double prev_omega[ROTOR_NUM_MAX] = {};
+    double omega_acc[ROTOR_NUM_MAX];
+    for (int i = 0; i < num; i++) {
+        position[i] = { rotor[i].data.x, rotor[i].data.y, rotor[i].data.z };
+        ccw[i] = rotor[i].ccw;
+    }
+    const ThrustKernelParamType param = { 1.0e-5, 1.0e-7, 1.0e-4, num, position, ccw };
+    ThrustKernelType kernel = thrust_kernel_select_nonlinear(num);
+    double thrust;
+    hako::drone_physics::TorqueType torque;
+    double k = 0;
+    for (auto _ : state) {
+        for (int i = 0; i < num; i++) {
+            omega[i] = 500.0 + i + k;
+            omega_acc[i] = (omega[i] - prev_omega[i]) / dt;
+        }
+        k += 1e-3;
+        kernel(param, omega, omega_acc, thrust, torque);
+        for (int i = 0; i < num; i++) {
+            prev_omega[i] = omega[i];
+        }
+        benchmark::DoNotOptimize(thrust);
+        benchmark::DoNotOptimize(torque);
+    }
+}
+BENCHMARK(BM_FrameThrustScalarStep)->Arg(4)->Arg(6)->Arg(8);
+
+#ifdef HAKO_THRUST_KERNEL_SIMD
+static void BM_FrameThrustSimdStep(benchmark::State& state)
+{
+    const int num = static_cast<int>(state.range(0));
+    const double dt = 0.001;
+    RotorConfigType rotor[ROTOR_NUM_MAX];
+    make_frame(num, rotor);
+    hako::drone_physics::VectorType position[ROTOR_NUM_MAX];
+    double ccw[ROTOR_NUM_MAX];
+    for (int i = 0; i < num; i++) {
+        position[i] = { rotor[i].data.x, rotor[i].data.y, rotor[i].data.z };
+        ccw[i] = rotor[i].ccw;
+    }
+    ThrustKernelSimd simd;
+    simd.set_geometry(num, position, ccw);
+    double thrust;
+    hako::drone_physics::TorqueType torque;
+    double k = 0;
+    for (auto _ : state) {
+        double* omega = simd.omega_lanes();
+        for (int i = 0; i < num; i++) {
+            omega[i] = 500.0 + i + k;
+        }
+        k += 1e-3;
+        simd.run(1.0e-5, 1.0e-7, 1.0e-4, 1.0 / dt, thrust, torque);
+        benchmark::DoNotOptimize(thrust);
+        benchmark::DoNotOptimize(torque);
+    }
+}
+BENCHMARK(BM_FrameThrustSimdStep)->Arg(4)->Arg(6)->Arg(8);
+#endif
+
+/*
+ * DroneMixer::run
+ */
+static void BM_FrameMixer(benchmark::State& state)
+{
+    const int num = static_cast<int>(state.range(0));
+    RotorConfigType rotor[ROTOR_NUM_MAX];
+    make_frame(num, rotor);
+    DroneMixer mixer(1000.0, 1.0e-5, 1.0e-7, rotor, num);
+    if (!mixer.calculate_M_inv()) {
+        state.SkipWithError("mixer is singular");
+        return;
+    }
+    DroneConfig::MixerInfo info = {};
+    info.enable = true;
+    info.vendor = "None";
+    info.K = 1.0;
+    info.R = 0.0;
+    info.Cq = 1.0e-7;
+    info.V_bat = 1000.0;
+    mixer.setMixerInfo(info);
+    double k = 0;
+    for (auto _ : state) {
+        PwmDuty duty = mixer.run(1.0, 9.8 + k, 0.01, -0.01, 0.001);
+        k += 1e-6;
+        benchmark::DoNotOptimize(duty);
+    }
+}
+BENCHMARK(BM_FrameMixer)->Arg(4)->Arg(6)->Arg(8);
@@ -0,0 +1,6 @@
+#include <benchmark/benchmark.h>
+#include "utils/csv_logger.hpp"
+bool CsvLogger::enable_flag = false;
+uint64_t CsvLogger::time_usec = 0;
+
+BENCHMARK_MAIN();
@@ -0,0 +1,165 @@
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include "body_physics.hpp"
+#include "rotor_physics.hpp"
+
+/*
+ * drone_physics の機体座標系の計算(座標変換, 運動方程式, 推力・トルク)のベンチマーク
+ *
+ *   ./hako-px4sim-bench --benchmark_filter=Physics
+ */
+using namespace hako::drone_physics;
+
+/*
+ * 入力がループ内で一定にならないように、毎回少しずつ変える
+ */
+static EulerType bench_angle(double k)
+{
+    return { 0.1 + k, -0.2 + k, 0.3 + k };
+}
+
+static void BM_PhysicsGroundVectorFromBody(benchmark::State& state)
+{
+    VectorType body = { 1, 2, 3 };
+    double k = 0;
+    for (auto _ : state) {
+        VectorType ground = ground_vector_from_body(body, bench_angle(k));
+        k += 1e-6;
+        benchmark::DoNotOptimize(ground);
+    }
+}
+BENCHMARK(BM_PhysicsGroundVectorFromBody);
+
+static void BM_PhysicsBodyVectorFromGround(benchmark::State& state)
+{
+    VectorType ground = { 1, 2, 3 };
+    double k = 0;
+    for (auto _ : state) {
+        VectorType body = body_vector_from_ground(ground, bench_angle(k));
+        k += 1e-6;
+        benchmark::DoNotOptimize(body);
+    }
+}
+BENCHMARK(BM_PhysicsBodyVectorFromGround);
+
+static void BM_PhysicsEulerRateFromBodyAngularVelocity(benchmark::State& state)
+{
+    AngularVelocityType w = { 0.1, 0.2, 0.3 };
+    double k = 0;
+    for (auto _ : state) {
+        EulerRateType rate = euler_rate_from_body_angular_velocity(w, bench_angle(k));
+        k += 1e-6;
+        benchmark::DoNotOptimize(rate);
+    }
+}
+BENCHMARK(BM_PhysicsEulerRateFromBodyAngularVelocity);
+
+static void BM_PhysicsQuaternionFromEuler(benchmark::State& state)
+{
+    double k = 0;
+    for (auto _ : state) {
+        QuaternionType q = quaternion_from_euler(bench_angle(k));
+        k += 1e-6;
+        benchmark::DoNotOptimize(q);
+    }
+}
+BENCHMARK(BM_PhysicsQuaternionFromEuler);
+
+static void BM_PhysicsEulerFromQuaternion(benchmark::State& state)
+{
+    QuaternionType q = quaternion_from_euler(bench_angle(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(q);
+        EulerType e = euler_from_quaternion(q);
+        benchmark::DoNotOptimize(e);
+    }
+}
+BENCHMARK(BM_PhysicsEulerFromQuaternion);
+
+static void BM_PhysicsQuaternionVelocity(benchmark::State& state)
+{
+    AngularVelocityType w = { 0.1, 0.2, 0.3 };
+    QuaternionType q = quaternion_from_euler(bench_angle(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(q);
+        QuaternionVelocityType dq = quaternion_velocity_from_body_angular_velocity(w, q);
+        benchmark::DoNotOptimize(dq);
+    }
+}
+BENCHMARK(BM_PhysicsQuaternionVelocity);
+
+/*
+ * 並進の運動方程式(風, 各軸の抗力あり)
+ */
+static void BM_PhysicsAccelerationInBodyFrame(benchmark::State& state)
+{
+    VelocityType v = { 1, 0.5, -0.2 };
+    AngularVelocityType w = { 0.1, 0.2, 0.3 };
+    VectorType wind = { 0.5, 0, 0 };
+    VectorType drag1 = { 0.2, 0.2, 0.3 };
+    VectorType drag2 = { 0.01, 0.01, 0.02 };
+    double k = 0;
+    for (auto _ : state) {
+        AccelerationType a = acceleration_in_body_frame(v, bench_angle(k), w, 7.0, 0.71, 9.81, wind, drag1, drag2);
+        k += 1e-6;
+        benchmark::DoNotOptimize(a);
+    }
+}
+BENCHMARK(BM_PhysicsAccelerationInBodyFrame);
+
+/*
+ * 並進の運動方程式(簡易版)
+ */
+static void BM_PhysicsAccelerationInBodyFrameSimple(benchmark::State& state)
+{
+    VelocityType v = { 1, 0.5, -0.2 };
+    AngularVelocityType w = { 0.1, 0.2, 0.3 };
+    double k = 0;
+    for (auto _ : state) {
+        AccelerationType a = acceleration_in_body_frame(v, bench_angle(k), w, 7.0, 0.71, 9.81, 0.2, 0.01);
+        k += 1e-6;
+        benchmark::DoNotOptimize(a);
+    }
+}
+BENCHMARK(BM_PhysicsAccelerationInBodyFrameSimple);
+
+static void BM_PhysicsAngularAccelerationInBodyFrame(benchmark::State& state)
+{
+    AngularVelocityType w = { 0.1, 0.2, 0.3 };
+    TorqueType torque = { 0.01, -0.02, 0.003 };
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(w);
+        AngularAccelerationType dw = angular_acceleration_in_body_frame(w, torque, 0.0061, 0.00653, 0.0116);
+        benchmark::DoNotOptimize(dw);
+    }
+}
+BENCHMARK(BM_PhysicsAngularAccelerationInBodyFrame);
+
+/*
+ * 機体の推力・トルク(ロータ数は引数)
+ */
+static void BM_PhysicsBodyThrustTorque(benchmark::State& state)
+{
+    const unsigned num = static_cast<unsigned>(state.range(0));
+    VectorType position[8];
+    double ccw[8];
+    double omega[8];
+    double omega_acc[8] = {};
+    for (unsigned i = 0; i < num; i++) {
+        double angle = (M_PI / num) + (2.0 * M_PI * i / num);
+        position[i] = { 0.2 * std::cos(angle), 0.2 * std::sin(angle), 0 };
+        ccw[i] = (i % 2 == 0) ? 1 : -1;
+    }
+    double k = 0;
+    for (auto _ : state) {
+        for (unsigned i = 0; i < num; i++) {
+            omega[i] = 500.0 + i + k;
+        }
+        k += 1e-3;
+        double thrust = body_thrust(8.3e-7, num, omega);
+        TorqueType torque = body_torque(8.3e-7, 3.0e-9, 1.0e-5, num, position, ccw, omega, omega_acc);
+        benchmark::DoNotOptimize(thrust);
+        benchmark::DoNotOptimize(torque);
+    }
+}
+BENCHMARK(BM_PhysicsBodyThrustTorque)->Arg(4)->Arg(6)->Arg(8);
@@ -0,0 +1,41 @@
+#include <benchmark/benchmark.h>
+#include "utils/sensor_data_assembler.hpp"
+#include "utils/sensor_noise.hpp"
+
+/*
+ * センサの移動平均(SensorDataAssembler)とノイズ(SensorNoise)のベンチマーク
+ *
+ *   ./hako-px4sim-bench --benchmark_filter=Sensor
+ */
+using namespace hako::assets::drone;
+
+/*
+ * 1回の add_data() と get_calculated_value() (引数はサンプル数)
+ */
+static void BM_SensorDataAssembler(benchmark::State& state)
+{
+    SensorDataAssembler assembler(static_cast<int>(state.range(0)));
+    double k = 0;
+    for (int i = 0; i < state.range(0); i++) {
+        assembler.add_data(k);
+        k += 1e-3;
+    }
+    for (auto _ : state) {
+        assembler.add_data(k);
+        k += 1e-3;
+        double value = assembler.get_calculated_value();
+        benchmark::DoNotOptimize(value);
+    }
+}
+BENCHMARK(BM_SensorDataAssembler)->Arg(1)->Arg(3)->Arg(10)->Arg(100);
+
+static void BM_SensorNoise(benchmark::State& state)
+{
+    SensorNoise noise(0.03);
+    double data = 9.8;
+    for (auto _ : state) {
+        double value = noise.add_random_noise(data);
+        benchmark::DoNotOptimize(value);
+    }
+}
+BENCHMARK(BM_SensorNoise);
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <gtest/gtest.h>
 #include "utils/csv_logger.hpp"
+bool CsvLogger::enable_flag = false;
 uint64_t CsvLogger::time_usec = 0; 
 
 int main(int argc, char *argv[])
@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+#include <iostream>
+#include <cmath>
+#include "controller/drone_mixer.hpp"
+
+class DroneMixerTest : public ::testing::Test {
+protected:
+    static void SetUpTestCase()
+    {
+    }
+    static void TearDownTestCase()
+    {
+    }
+    virtual void SetUp()
+    {
+    }
+    virtual void TearDown()
+    {
+    }
+
+};
+using hako::assets::drone::DroneMixer;
+using hako::assets::drone::PwmDuty;
+using hako::assets::drone::RotorConfigType;
+
+#define MIXER_TEST_KR       1000.0  /* rad/s (duty = 1) */
+#define MIXER_TEST_CT       1.0e-5
+#define MIXER_TEST_CQ       1.0e-7
+#define MIXER_TEST_ARM      0.1
+
+/*
+ * K = 1, R = 0, V_bat = Kr とすると duty = omega / Kr となり、
+ * reconstructControlInput() で U を復元できる
+ */
+static void make_mixer_info(DroneConfig::MixerInfo& info)
+{
+    info = {};
+    info.enable = true;
+    info.vendor = "None";
+    info.enableDebugLog = false;
+    info.enableErrorLog = false;
+    info.K = 1.0;
+    info.R = 0.0;
+    info.Cq = MIXER_TEST_CQ;
+    info.V_bat = MIXER_TEST_KR;
+}
+static void make_frame(RotorConfigType* rotor, int num)
+{
+    for (int i = 0; i < num; i++) {
+        double angle = (M_PI / num) + (2.0 * M_PI * i / num);
+        rotor[i].data.x = MIXER_TEST_ARM * std::cos(angle);
+        rotor[i].data.y = MIXER_TEST_ARM * std::sin(angle);
+        rotor[i].data.z = 0;
+        rotor[i].ccw = (i % 2 == 0) ? 1 : -1;
+    }
+}
+static void check_duty_range(const PwmDuty& duty, int num)
+{
+    for (int i = 0; i < num; i++) {
+        EXPECT_GE(duty.d[i], -1e-9);
+        EXPECT_LE(duty.d[i], 1.0 + 1e-9);
+    }
+}
+
+TEST_F(DroneMixerTest, quad_unsaturated)
+{
+    RotorConfigType rotor[4];
+    make_frame(rotor, 4);
+    DroneMixer mixer(MIXER_TEST_KR, MIXER_TEST_CT, MIXER_TEST_CQ, rotor, 4);
+    ASSERT_TRUE(mixer.calculate_M_inv());
+    DroneConfig::MixerInfo info;
+    make_mixer_info(info);
+    mixer.setMixerInfo(info);
+    EXPECT_EQ(hako::assets::drone::DRONE_MIXER_MODE_DEFAULT, mixer.get_mode());
+    EXPECT_TRUE(mixer.testReconstruction(20.0, 0.05, -0.03, 0.001));
+}
+
+TEST_F(DroneMixerTest, hexa_octo_unsaturated)
+{
+    for (int num : { 6, 8 }) {
+        RotorConfigType rotor[8];
+        make_frame(rotor, num);
+        DroneMixer mixer(MIXER_TEST_KR, MIXER_TEST_CT, MIXER_TEST_CQ, rotor, num);
+        ASSERT_TRUE(mixer.calculate_M_inv());
+        DroneConfig::MixerInfo info;
+        make_mixer_info(info);
+        mixer.setMixerInfo(info);
+        EXPECT_EQ(num, mixer.get_rotor_num());
+        EXPECT_TRUE(mixer.testReconstruction(30.0, 0.05, 0.02, -0.001));
+    }
+}
+
+TEST_F(DroneMixerTest, singular_frame)
+{
+    RotorConfigType rotor[4];
+    make_frame(rotor, 4);
+    for (int i = 0; i < 4; i++) {
+        rotor[i].ccw = 1;
+    }
+    DroneMixer mixer(MIXER_TEST_KR, MIXER_TEST_CT, MIXER_TEST_CQ, rotor, 4);
+    EXPECT_FALSE(mixer.calculate_M_inv());
+}
+
+TEST_F(DroneMixerTest, saturation_keeps_attitude)
+{
+    RotorConfigType rotor[4];
+    make_frame(rotor, 4);
+    DroneMixer mixer(MIXER_TEST_KR, MIXER_TEST_CT, MIXER_TEST_CQ, rotor, 4);
+    ASSERT_TRUE(mixer.calculate_M_inv());
+    DroneConfig::MixerInfo info;
+    make_mixer_info(info);
+    mixer.setMixerInfo(info);
+
+    /*
+     * 推力が上限(4 * Ct * Kr^2 = 40N)を超える: トルクは維持して推力を下げる
+     */
+    PwmDuty duty = mixer.run(1.0, 60.0, 0.1, 0.0, 0.0);
+    check_duty_range(duty, 4);
+    double U[4];
+    mixer.reconstructControlInput(duty, U);
+    EXPECT_LT(U[0], 40.0);
+    EXPECT_NEAR(0.1, U[1], 1e-6);
+    EXPECT_NEAR(0.0, U[2], 1e-6);
+    EXPECT_NEAR(0.0, U[3], 1e-6);
+
+    /*
+     * 推力が小さすぎて負の Omega^2 になる: トルクは維持して推力を上げる
+     */
+    duty = mixer.run(1.0, 0.1, 0.0, 0.05, 0.0);
+    check_duty_range(duty, 4);
+    mixer.reconstructControlInput(duty, U);
+    EXPECT_GT(U[0], 0.1);
+    EXPECT_NEAR(0.05, U[2], 1e-6);
+}
+
+TEST_F(DroneMixerTest, saturation_scales_torque)
+{
+    RotorConfigType rotor[4];
+    make_frame(rotor, 4);
+    DroneMixer mixer(MIXER_TEST_KR, MIXER_TEST_CT, MIXER_TEST_CQ, rotor, 4);
+    ASSERT_TRUE(mixer.calculate_M_inv());
+    DroneConfig::MixerInfo info;
+    make_mixer_info(info);
+    mixer.setMixerInfo(info);
+
+    /*
+     * トルクだけで飽和する: トルクの比率(方向)を保って縮小する
+     */
+    PwmDuty duty = mixer.run(1.0, 20.0, 10.0, 5.0, 0.0);
+    check_duty_range(duty, 4);
+    double U[4];
+    mixer.reconstructControlInput(duty, U);
+    EXPECT_LT(U[1], 10.0);
+    EXPECT_NEAR(2.0, U[1] / U[2], 1e-6);
+}
+
+TEST_F(DroneMixerTest, run_batch)
+{
+    RotorConfigType quad[4];
+    RotorConfigType hexa[6];
+    make_frame(quad, 4);
+    make_frame(hexa, 6);
+    DroneMixer mixer_quad(MIXER_TEST_KR, MIXER_TEST_CT, MIXER_TEST_CQ, quad, 4);
+    DroneMixer mixer_hexa(MIXER_TEST_KR, MIXER_TEST_CT, MIXER_TEST_CQ, hexa, 6);
+    ASSERT_TRUE(mixer_quad.calculate_M_inv());
+    ASSERT_TRUE(mixer_hexa.calculate_M_inv());
+    DroneConfig::MixerInfo info;
+    make_mixer_info(info);
+    mixer_quad.setMixerInfo(info);
+    mixer_hexa.setMixerInfo(info);
+
+    DroneMixer* mixers[3] = { &mixer_quad, nullptr, &mixer_hexa };
+    hako::assets::drone::DroneMixerInputType in[3] = {
+        { 1.0, 20.0, 0.01, 0.0, 0.0 },
+        { 1.0, 20.0, 0.01, 0.0, 0.0 },
+        { 1.0, 25.0, 0.0, 0.02, 0.0 },
+    };
+    PwmDuty out[3];
+    DroneMixer::run_batch(mixers, in, out, 3);
+    PwmDuty expect_quad = mixer_quad.run(1.0, 20.0, 0.01, 0.0, 0.0);
+    PwmDuty expect_hexa = mixer_hexa.run(1.0, 25.0, 0.0, 0.02, 0.0);
+    for (int i = 0; i < 6; i++) {
+        if (i < 4) {
+            EXPECT_DOUBLE_EQ(expect_quad.d[i], out[0].d[i]);
+        }
+        EXPECT_DOUBLE_EQ(0.0, out[1].d[i]);
+        EXPECT_DOUBLE_EQ(expect_hexa.d[i], out[2].d[i]);
+    }
+}
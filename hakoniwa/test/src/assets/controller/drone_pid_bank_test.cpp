@@ -0,0 +1,384 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "drone_controller_bank.hpp"
+
+class DronePidBankTest : public ::testing::Test {
+protected:
+    static void SetUpTestCase()
+    {
+    }
+    static void TearDownTestCase()
+    {
+    }
+    virtual void SetUp()
+    {
+    }
+    virtual void TearDown()
+    {
+    }
+
+};
+
+namespace {
+const double bank_test_dt = 0.001;
+
+/*
+ * 従来のコントローラ(DroneAltController::run_pos 等)と同じ周期判定・出力制限で
+ * DronePidControl を動かす
+ */
+class LegacyPidChannel {
+private:
+    DronePidControl pid;
+    double control_cycle;
+    double delta_time;
+    double max;
+    double simulation_time = 0;
+    double prev_out = 0;
+public:
+    LegacyPidChannel(const DronePidGainType& gain, double cycle, double dt, double out_max)
+        : pid(gain, 0, dt), control_cycle(cycle), delta_time(dt), max(out_max) {}
+    double run(double target, double current)
+    {
+        double out = prev_out;
+        if (simulation_time >= control_cycle) {
+            simulation_time = 0;
+            out = flight_controller_get_limit_value(pid.calculate(target, current), 0, -max, max);
+            prev_out = out;
+        }
+        simulation_time += delta_time;
+        return out;
+    }
+};
+
+/* 機体・軸・ステップごとに異なる入力 */
+double bank_test_signal(int vehicle, int axis, int step)
+{
+    return std::sin(0.013 * step * (vehicle + 1) + axis) * (2.0 + vehicle) + 0.1 * axis;
+}
+
+const std::string bank_test_dir = "./drone_pid_bank_test";
+
+/*
+ * 全制御周期を 0 以外にし、Ki, Kd も使うパラメータファイル
+ * DroneAngleController はロール・ピッチ角(およびロール・ヨー角速度)で同じ PID を
+ * 共有していたため、そのチャネルは Ki = Kd = 0 にして比較する
+ */
+std::string write_bank_param_file(const std::string& name, double alt_kp)
+{
+    std::filesystem::create_directories(bank_test_dir);
+    std::string path = bank_test_dir + "/" + name;
+    std::ofstream ofs(path);
+    ofs << "SIMULATION_DELTA_TIME 0.001\n"
+        << "MASS 0.71\n"
+        << "GRAVITY 9.81\n"
+        << "PID_ALT_CONTROL_CYCLE 0.003\n"
+        << "PID_ALT_MAX_POWER 9.81\n"
+        << "PID_ALT_THROTTLE_GAIN 1.0\n"
+        << "PID_ALT_MAX_SPD 1.5\n"
+        << "PID_ALT_Kp " << alt_kp << "\n"
+        << "PID_ALT_Ki 0.5\n"
+        << "PID_ALT_Kd 5.0\n"
+        << "PID_ALT_SPD_Kp 5.0\n"
+        << "PID_ALT_SPD_Ki 0.2\n"
+        << "PID_ALT_SPD_Kd 5.0\n"
+        << "POS_CONTROL_CYCLE 0.005\n"
+        << "SPD_CONTROL_CYCLE 0.002\n"
+        << "PID_POS_MAX_SPD 2.0\n"
+        << "PID_POS_X_Kp 6.0\n"
+        << "PID_POS_X_Ki 0.3\n"
+        << "PID_POS_X_Kd 3.0\n"
+        << "PID_POS_Y_Kp 5.0\n"
+        << "PID_POS_Y_Ki 0.4\n"
+        << "PID_POS_Y_Kd 2.0\n"
+        << "PID_POS_VX_Kp 10.0\n"
+        << "PID_POS_VX_Ki 0.1\n"
+        << "PID_POS_VX_Kd 1.0\n"
+        << "PID_POS_VY_Kp 9.0\n"
+        << "PID_POS_VY_Ki 0.2\n"
+        << "PID_POS_VY_Kd 1.5\n"
+        << "HEAD_CONTROL_CYCLE 0.004\n"
+        << "ANGULAR_CONTROL_CYCLE 0.002\n"
+        << "ANGULAR_RATE_CONTROL_CYCLE 0.0015\n"
+        << "PID_POS_MAX_ROLL 10.0\n"
+        << "PID_POS_MAX_PITCH 10.0\n"
+        << "PID_ROLL_RPM_MAX 200.0\n"
+        << "PID_PITCH_RPM_MAX 200.0\n"
+        << "PID_ROLL_TORQUE_MAX 1.0\n"
+        << "PID_PITCH_TORQUE_MAX 1.0\n"
+        << "PID_YAW_TORQUE_MAX 0.5\n"
+        << "PID_ROLL_Kp 4.0\n"
+        << "PID_ROLL_Ki 0.0\n"
+        << "PID_ROLL_Kd 0.0\n"
+        << "PID_ROLL_RATE_Kp 2.0\n"
+        << "PID_ROLL_RATE_Ki 0.0\n"
+        << "PID_ROLL_RATE_Kd 0.0\n"
+        << "PID_PITCH_Kp 4.0\n"
+        << "PID_PITCH_Ki 0.0\n"
+        << "PID_PITCH_Kd 0.0\n"
+        << "PID_PITCH_RATE_Kp 2.5\n"
+        << "PID_PITCH_RATE_Ki 0.3\n"
+        << "PID_PITCH_RATE_Kd 0.05\n"
+        << "PID_YAW_RPM_MAX 10.0\n"
+        << "PID_YAW_Kp 0.1\n"
+        << "PID_YAW_Ki 0.01\n"
+        << "PID_YAW_Kd 0.02\n"
+        << "PID_YAW_RATE_Kp 0.1\n"
+        << "PID_YAW_RATE_Ki 0.0\n"
+        << "PID_YAW_RATE_Kd 0.1\n";
+    return path;
+}
+
+/*
+ * 変更前の FlightController と同じ順序で従来のコントローラを動かす
+ */
+struct LegacyDroneController {
+    HakoControllerParamLoader loader;
+    DroneAltController alt;
+    DronePosController pos;
+    DroneHeadingController head;
+    DroneAngleController angle;
+    LegacyDroneController(const std::string& path)
+        : loader(path), alt(loader), pos(loader), head(loader), angle(loader) {}
+    FlightControllerOutputType run(const DroneControllerBankInputType& in)
+    {
+        DroneAltInputType alt_in(in.pos, in.velocity, in.target_z);
+        DroneAltOutputType alt_out = alt.run(alt_in);
+        DroneHeadingControlInputType head_in(in.euler, in.target_yaw_deg);
+        DroneHeadingControlOutputType head_out = head.run(head_in);
+        DronePosInputType pos_in(in.pos, in.velocity, in.euler, in.target_x, in.target_y, in.target_velocity);
+        DronePosOutputType pos_out = pos.run(pos_in);
+        DroneAngleInputType angle_in(in.euler, in.angular_rate, pos_out.target_roll, pos_out.target_pitch, head_out.target_yaw_rate);
+        DroneAngleOutputType angle_out = angle.run(angle_in);
+        FlightControllerOutputType out;
+        out.thrust = alt_out.thrust;
+        out.torque_x = angle_out.p;
+        out.torque_y = angle_out.q;
+        out.torque_z = angle_out.r;
+        return out;
+    }
+};
+
+DroneControllerBankInputType bank_test_input(int vehicle, int step)
+{
+    DroneControllerBankInputType in;
+    in.euler = { 0.2 * bank_test_signal(vehicle, 0, step), 0.2 * bank_test_signal(vehicle, 1, step), bank_test_signal(vehicle, 2, step) };
+    in.pos = { bank_test_signal(vehicle, 3, step), bank_test_signal(vehicle, 4, step), bank_test_signal(vehicle, 5, step) };
+    in.velocity = { bank_test_signal(vehicle, 6, step), bank_test_signal(vehicle, 7, step), bank_test_signal(vehicle, 8, step) };
+    in.angular_rate = { bank_test_signal(vehicle, 9, step), bank_test_signal(vehicle, 10, step), bank_test_signal(vehicle, 11, step) };
+    in.target_x = 3.0 + vehicle;
+    in.target_y = -2.0;
+    in.target_z = 1.0 + 0.5 * vehicle;
+    in.target_velocity = 1.0;
+    in.target_yaw_deg = (step < 500) ? 90.0 : -170.0;
+    return in;
+}
+}
+
+/*
+ * 制御周期 > 0 でも、従来の周期判定と DronePidControl の計算結果に一致すること
+ */
+TEST_F(DronePidBankTest, matches_pid_control)
+{
+    const double cycles[] = { 0.0, 0.003, 0.0025 };
+    const DronePidGainType gains[] = { { 2.0, 0.5, 0.1 }, { 1.0, 3.0, 0.02 }, { 0.5, 0.0, 0.3 } };
+    const int vehicle_num = 3;
+    const int axis_num = 2;
+    const double out_max = 1.5;
+
+    DronePidBank bank(bank_test_dt);
+    std::vector<int> groups;
+    for (double cycle : cycles) {
+        groups.push_back(bank.add_group(axis_num, cycle));
+    }
+    std::vector<std::unique_ptr<LegacyPidChannel>> legacy;
+    for (int v = 0; v < vehicle_num; v++) {
+        ASSERT_EQ(v, bank.add_vehicle());
+    }
+    for (size_t g = 0; g < groups.size(); g++) {
+        for (int v = 0; v < vehicle_num; v++) {
+            for (int a = 0; a < axis_num; a++) {
+                const DronePidGainType& gain = gains[(v + a) % 3];
+                bank.set_param(groups[g], v, a, DronePidBankParamType(gain, out_max, 0, false));
+                legacy.push_back(std::make_unique<LegacyPidChannel>(gain, cycles[g], bank_test_dt, out_max));
+            }
+        }
+    }
+    for (int step = 0; step < 2000; step++) {
+        size_t ch = 0;
+        for (size_t g = 0; g < groups.size(); g++) {
+            for (int v = 0; v < vehicle_num; v++) {
+                for (int a = 0; a < axis_num; a++) {
+                    bank.target(groups[g], v)[a] = 0.5 * a;
+                    bank.current(groups[g], v)[a] = bank_test_signal(v, a, step);
+                }
+            }
+            bank.run(groups[g], 0, vehicle_num);
+            for (int v = 0; v < vehicle_num; v++) {
+                for (int a = 0; a < axis_num; a++) {
+                    double expected = legacy[ch++]->run(0.5 * a, bank_test_signal(v, a, step));
+                    ASSERT_EQ(expected, bank.output(groups[g], v)[a]) << "group " << g << " vehicle " << v << " axis " << a << " step " << step;
+                }
+            }
+        }
+    }
+}
+
+/*
+ * 出力制限は従来どおり常にかかり、out_max = 0 の場合は 0 に制限されること
+ */
+TEST_F(DronePidBankTest, zero_out_max_clamps)
+{
+    DronePidBank bank(bank_test_dt);
+    int group = bank.add_group(1, 0);
+    bank.add_vehicle();
+    bank.set_param(group, 0, 0, DronePidBankParamType(DronePidGainType(1.0, 0, 0), 0, 0, false));
+    bank.target(group, 0)[0] = 10.0;
+    bank.current(group, 0)[0] = 0.0;
+    bank.run(group, 0, 1);
+    EXPECT_EQ(0.0, bank.output(group, 0)[0]);
+}
+
+/*
+ * anti-windup は指定した場合のみ有効で、飽和中は積分が進まないこと
+ */
+TEST_F(DronePidBankTest, anti_windup_opt_in)
+{
+    DronePidBank bank(bank_test_dt);
+    int group = bank.add_group(2, 0);
+    bank.add_vehicle();
+    DronePidGainType gain(1.0, 10.0, 0);
+    bank.set_param(group, 0, 0, DronePidBankParamType(gain, 1.0, 0, false));
+    bank.set_param(group, 0, 1, DronePidBankParamType(gain, 1.0, 0, true));
+    /* 飽和させたまま積分させる */
+    for (int i = 0; i < 1000; i++) {
+        bank.target(group, 0)[0] = 5.0;
+        bank.target(group, 0)[1] = 5.0;
+        bank.run(group, 0, 1);
+    }
+    EXPECT_EQ(1.0, bank.output(group, 0)[0]);
+    EXPECT_EQ(1.0, bank.output(group, 0)[1]);
+    /* 目標を下げると、anti-windup ありはすぐに飽和から抜ける */
+    bank.target(group, 0)[0] = -0.5;
+    bank.target(group, 0)[1] = -0.5;
+    bank.run(group, 0, 1);
+    EXPECT_EQ(1.0, bank.output(group, 0)[0]);
+    EXPECT_LT(bank.output(group, 0)[1], 0.0);
+}
+
+/*
+ * 制御周期 > 0 で Ki, Kd を使うパラメータでも、DroneControllerBank の出力が
+ * 従来のコントローラ(DroneAltController 等)の出力に一致すること
+ */
+TEST_F(DronePidBankTest, controller_bank_matches_legacy)
+{
+    std::string path = write_bank_param_file("legacy.txt", 10.0);
+    HakoControllerParamLoader loader(path);
+    DroneControllerParamType param;
+    param.load(loader);
+
+    const int vehicle_num = 2;
+    DroneControllerBank bank;
+    std::vector<std::unique_ptr<LegacyDroneController>> legacy;
+    for (int v = 0; v < vehicle_num; v++) {
+        ASSERT_EQ(v, bank.add_vehicle(param));
+        legacy.push_back(std::make_unique<LegacyDroneController>(path));
+    }
+    for (int step = 0; step < 1000; step++) {
+        DroneControllerBankInputType in[vehicle_num];
+        FlightControllerOutputType out[vehicle_num];
+        for (int v = 0; v < vehicle_num; v++) {
+            in[v] = bank_test_input(v, step);
+        }
+        bank.run(0, vehicle_num, in, out);
+        for (int v = 0; v < vehicle_num; v++) {
+            FlightControllerOutputType expected = legacy[v]->run(in[v]);
+            ASSERT_EQ(expected.thrust, out[v].thrust) << "vehicle " << v << " step " << step;
+            ASSERT_EQ(expected.torque_x, out[v].torque_x) << "vehicle " << v << " step " << step;
+            ASSERT_EQ(expected.torque_y, out[v].torque_y) << "vehicle " << v << " step " << step;
+            ASSERT_EQ(expected.torque_z, out[v].torque_z) << "vehicle " << v << " step " << step;
+        }
+    }
+    std::filesystem::remove_all(bank_test_dir);
+}
+
+/*
+ * 1機体のパラメータ差し替えは、他の機体の制御周期・刻み幅を変えないこと
+ */
+TEST_F(DronePidBankTest, set_parameters_per_vehicle)
+{
+    std::string path = write_bank_param_file("per_vehicle.txt", 10.0);
+    HakoControllerParamLoader loader(path);
+    DroneControllerParamType param;
+    param.load(loader);
+    DroneControllerParamType fast = param;
+    fast.alt.delta_time = 0.0005;
+    fast.alt.control_cycle = 0.0;
+    fast.pos.pos_control_cycle = 0.0;
+    fast.pos.spd_control_cycle = 0.0;
+    fast.head.head_control_cycle = 0.0;
+    fast.angle.angular_control_cycle = 0.0;
+    fast.angle.angular_rate_control_cycle = 0.0;
+
+    DroneControllerBank bank;
+    LegacyDroneController legacy(path);
+    bank.add_vehicle(param);
+    bank.add_vehicle(param);
+    bank.set_parameters(1, fast);
+    for (int step = 0; step < 500; step++) {
+        DroneControllerBankInputType in[2] = { bank_test_input(0, step), bank_test_input(1, step) };
+        FlightControllerOutputType out[2];
+        bank.run(0, 2, in, out);
+        FlightControllerOutputType expected = legacy.run(in[0]);
+        ASSERT_EQ(expected.thrust, out[0].thrust) << "step " << step;
+        ASSERT_EQ(expected.torque_x, out[0].torque_x) << "step " << step;
+        ASSERT_EQ(expected.torque_y, out[0].torque_y) << "step " << step;
+        ASSERT_EQ(expected.torque_z, out[0].torque_z) << "step " << step;
+    }
+    std::filesystem::remove_all(bank_test_dir);
+}
+
+/*
+ * 削除した機体の枠は次の add_vehicle() で初期状態から再利用し、
+ * 他の機体の状態・パラメータには影響しないこと
+ */
+TEST_F(DronePidBankTest, remove_vehicle_reuses_index)
+{
+    std::string path = write_bank_param_file("reuse.txt", 10.0);
+    HakoControllerParamLoader loader(path);
+    DroneControllerParamType param;
+    param.load(loader);
+
+    DroneControllerBank bank;
+    LegacyDroneController legacy1(path);
+    ASSERT_EQ(0, bank.add_vehicle(param));
+    ASSERT_EQ(1, bank.add_vehicle(param));
+    for (int step = 0; step < 200; step++) {
+        DroneControllerBankInputType in[2] = { bank_test_input(0, step), bank_test_input(1, step) };
+        FlightControllerOutputType out[2];
+        bank.run(0, 2, in, out);
+        legacy1.run(in[1]);
+    }
+    bank.remove_vehicle(0);
+    ASSERT_EQ(0, bank.add_vehicle(param));
+    EXPECT_EQ(2, bank.get_vehicle_num());
+    EXPECT_EQ(2, bank.add_vehicle(param));
+
+    LegacyDroneController legacy0(path);
+    for (int step = 0; step < 300; step++) {
+        DroneControllerBankInputType in[2] = { bank_test_input(0, step), bank_test_input(1, 200 + step) };
+        FlightControllerOutputType out[2];
+        bank.run(0, 2, in, out);
+        FlightControllerOutputType expected0 = legacy0.run(in[0]);
+        FlightControllerOutputType expected1 = legacy1.run(in[1]);
+        ASSERT_EQ(expected0.thrust, out[0].thrust) << "step " << step;
+        ASSERT_EQ(expected0.torque_x, out[0].torque_x) << "step " << step;
+        ASSERT_EQ(expected1.thrust, out[1].thrust) << "step " << step;
+        ASSERT_EQ(expected1.torque_x, out[1].torque_x) << "step " << step;
+    }
+    std::filesystem::remove_all(bank_test_dir);
+}
@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include "hako_controller_param_watcher.hpp"
+
+class HakoControllerParamWatcherTest : public ::testing::Test {
+protected:
+    static void SetUpTestCase()
+    {
+    }
+    static void TearDownTestCase()
+    {
+    }
+    virtual void SetUp()
+    {
+    }
+    virtual void TearDown()
+    {
+    }
+
+};
+
+namespace {
+struct WatcherTestParamType {
+    double gain;
+    void load(const HakoControllerParamLoader& loader)
+    {
+        gain = loader.getParameter("TEST_GAIN");
+    }
+};
+typedef HakoControllerParamWatcher<WatcherTestParamType> WatcherTestType;
+
+/* 書き込み中の状態を作るために pending_mutex を取る */
+class WatcherTestAccess : public WatcherTestType {
+public:
+    using WatcherTestType::WatcherTestType;
+    std::shared_mutex& mutex()
+    {
+        return pending_mutex;
+    }
+};
+
+const std::string watcher_test_dir = "./hako_controller_param_watcher_test";
+
+std::string write_param_file(const std::string& name, double gain)
+{
+    std::filesystem::create_directories(watcher_test_dir);
+    std::string path = watcher_test_dir + "/" + name;
+    /* エディタと同じく一時ファイルに書いて rename する */
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream ofs(tmp);
+        ofs << "# test" << std::endl;
+        ofs << "TEST_GAIN " << gain << std::endl;
+    }
+    std::filesystem::rename(tmp, path);
+    return path;
+}
+
+bool wait_fetch(WatcherTestType& watcher, HakoControllerParamWatcherCursor& cursor, WatcherTestParamType& param)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (watcher.fetch(cursor, param)) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+}
+
+/*
+ * 同じファイルの監視は共有し、機体ごとに更新後のパラメータを1回ずつ受け取ること
+ */
+TEST_F(HakoControllerParamWatcherTest, shared_reload)
+{
+    std::string path = write_param_file("shared.txt", 1.0);
+    auto w0 = WatcherTestType::acquire(path);
+    auto w1 = WatcherTestType::acquire(path);
+    ASSERT_EQ(w0.get(), w1.get());
+    std::string other_path = write_param_file("other.txt", 5.0);
+    auto other = WatcherTestType::acquire(other_path);
+    EXPECT_NE(w0.get(), other.get());
+
+    HakoControllerParamWatcherCursor c0 = w0->cursor();
+    HakoControllerParamWatcherCursor c1 = w1->cursor();
+    WatcherTestParamType param = {};
+    EXPECT_FALSE(w0->fetch(c0, param));
+
+    /* 監視の開始を待ってから更新する */
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    write_param_file("shared.txt", 2.0);
+    ASSERT_TRUE(wait_fetch(*w0, c0, param));
+    EXPECT_EQ(2.0, param.gain);
+    EXPECT_FALSE(w0->fetch(c0, param));
+    param = {};
+    ASSERT_TRUE(w1->fetch(c1, param));
+    EXPECT_EQ(2.0, param.gain);
+
+    /* ファイル更新以外の要求でも読み直す */
+    w1->request_reload();
+    ASSERT_TRUE(wait_fetch(*w1, c1, param));
+    EXPECT_EQ(2.0, param.gain);
+
+    /* 別のファイルの監視には影響しない */
+    HakoControllerParamWatcherCursor c2 = { 0 };
+    EXPECT_FALSE(other->fetch(c2, param));
+
+    /* 全員が手放したら、次の acquire() は新しい監視になる */
+    w0.reset();
+    w1.reset();
+    auto w2 = WatcherTestType::acquire(path);
+    EXPECT_EQ(0u, w2->cursor().applied_seq);
+    std::filesystem::remove_all(watcher_test_dir);
+}
+
+/*
+ * 読み込みに失敗した場合は前のパラメータのままにすること
+ */
+TEST_F(HakoControllerParamWatcherTest, invalid_file_keeps_param)
+{
+    std::string path = write_param_file("invalid.txt", 1.0);
+    auto watcher = WatcherTestType::acquire(path);
+    HakoControllerParamWatcherCursor cursor = watcher->cursor();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    {
+        std::ofstream ofs(path + ".tmp");
+        ofs << "OTHER_GAIN 3" << std::endl;
+    }
+    std::filesystem::rename(path + ".tmp", path);
+    WatcherTestParamType param = { 1.0 };
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    EXPECT_FALSE(watcher->fetch(cursor, param));
+    EXPECT_EQ(1.0, param.gain);
+    std::filesystem::remove_all(watcher_test_dir);
+}
+
+/*
+ * 監視スレッドの書き込み中は fetch() が待たずに false を返し、後で受け取れること
+ */
+TEST_F(HakoControllerParamWatcherTest, fetch_try_lock)
+{
+    std::string path = write_param_file("trylock.txt", 1.0);
+    WatcherTestAccess watcher(path);
+    HakoControllerParamWatcherCursor cursor = watcher.cursor();
+    watcher.start();
+    watcher.request_reload();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    WatcherTestParamType param = {};
+    {
+        std::unique_lock<std::shared_mutex> lock(watcher.mutex());
+        auto start = std::chrono::steady_clock::now();
+        EXPECT_FALSE(watcher.fetch(cursor, param));
+        EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(50));
+    }
+    EXPECT_TRUE(watcher.fetch(cursor, param));
+    EXPECT_EQ(1.0, param.gain);
+    watcher.stop();
+    std::filesystem::remove_all(watcher_test_dir);
+}
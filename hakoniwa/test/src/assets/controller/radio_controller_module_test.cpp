@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "utils/hako_module_registry.hpp"
+
+class RadioControllerModuleTest : public ::testing::Test {
+protected:
+    static void SetUpTestCase()
+    {
+    }
+    static void TearDownTestCase()
+    {
+    }
+    virtual void SetUp()
+    {
+    }
+    virtual void TearDown()
+    {
+    }
+
+};
+
+namespace {
+const std::string radio_test_dir = "./radio_controller_module_test";
+
+/*
+ * 制御周期と積分ゲインを 0 以外にしたパラメータファイル
+ * (経過時間と積分値がスナップショットに含まれないと結果が変わるようにする)
+ */
+std::string write_radio_param_file()
+{
+    std::filesystem::create_directories(radio_test_dir);
+    std::string path = radio_test_dir + "/param.txt";
+    std::ifstream ifs(HAKO_TEST_CONTROLLER_PARAM_FILE);
+    std::ofstream ofs(path);
+    std::string line;
+    while (std::getline(ifs, line)) {
+        std::istringstream iss(line);
+        std::string key;
+        iss >> key;
+        if ((key.size() > 6) && (key.compare(key.size() - 6, 6, "_CYCLE") == 0)) {
+            ofs << key << " 0.003" << std::endl;
+        }
+        else if ((key.size() > 3) && (key.compare(key.size() - 3, 3, "_Ki") == 0)) {
+            ofs << key << " 0.5" << std::endl;
+        }
+        else {
+            ofs << line << std::endl;
+        }
+    }
+    return path;
+}
+
+mi_drone_control_in_t radio_test_input(void* context, int step)
+{
+    mi_drone_control_in_t in = {};
+    double t = step * 0.001;
+    in.context = context;
+    in.radio_control = 1;
+    in.mass = 0.71;
+    in.pos_x = 0.3 * std::sin(t);
+    in.pos_y = 0.2 * std::cos(0.7 * t);
+    in.pos_z = -0.5 * t;
+    in.euler_x = 0.05 * std::sin(3 * t);
+    in.euler_y = 0.04 * std::cos(2 * t);
+    in.euler_z = 0.1 * t;
+    in.u = 0.2 * std::cos(t);
+    in.v = 0.1 * std::sin(1.3 * t);
+    in.w = -0.5;
+    in.p = 0.02 * std::sin(5 * t);
+    in.q = 0.03 * std::cos(4 * t);
+    in.r = 0.01;
+    in.target.attitude.roll = 0.3 * std::sin(0.5 * t);
+    in.target.attitude.pitch = -0.2;
+    in.target.throttle.power = ((step / 100) % 2 == 0) ? -1.0 : 0.5;
+    in.target.direction_velocity.r = 0.4;
+    return in;
+}
+
+void expect_same_output(const mi_drone_control_out_t& expected, const mi_drone_control_out_t& actual, int step)
+{
+    ASSERT_EQ(expected.thrust, actual.thrust) << "step " << step;
+    ASSERT_EQ(expected.torque_x, actual.torque_x) << "step " << step;
+    ASSERT_EQ(expected.torque_y, actual.torque_y) << "step " << step;
+    ASSERT_EQ(expected.torque_z, actual.torque_z) << "step " << step;
+}
+}
+
+/*
+ * RadioController の状態(目標高度・目標方位と各制御器の PID)を保存し、
+ * 復元してから同じ入力で進めると、保存後と同じ出力になること
+ */
+TEST_F(RadioControllerModuleTest, restore_then_step)
+{
+    std::string param_file = write_radio_param_file();
+    setenv("HAKO_CONTROLLER_PARAM_FILE", param_file.c_str(), 1);
+    unsetenv("HAKO_CONTROLLER_PARAM_WATCH");
+
+    HakoControllerModuleRegistry registry;
+    const AircraftControlModuleType* module = registry.load(HAKO_TEST_RADIO_CONTROLLER_MODULE);
+    ASSERT_NE(nullptr, module);
+    EXPECT_EQ((unsigned int)HAKO_MODULE_VERSION_4, module->header->version);
+    ASSERT_NE(nullptr, module->get_state_size);
+    ASSERT_NE(nullptr, module->save_state);
+    ASSERT_NE(nullptr, module->restore_state);
+    ASSERT_NE(nullptr, module->destroy_context);
+
+    void* context = module->controller->create_context(nullptr);
+    ASSERT_NE(nullptr, context);
+    ASSERT_EQ(0, module->controller->init(context));
+    size_t state_size = module->get_state_size(context);
+    ASSERT_GT(state_size, 0u);
+
+    const int warmup = 250;
+    const int steps = 500;
+    for (int step = 0; step < warmup; step++) {
+        mi_drone_control_in_t in = radio_test_input(context, step);
+        module->controller->run(&in);
+    }
+    std::vector<uint8_t> state(state_size);
+    module->save_state(context, state.data());
+    std::vector<mi_drone_control_out_t> expected(steps);
+    for (int step = 0; step < steps; step++) {
+        mi_drone_control_in_t in = radio_test_input(context, warmup + step);
+        expected[step] = module->controller->run(&in);
+    }
+
+    module->restore_state(context, state.data());
+    for (int step = 0; step < steps; step++) {
+        mi_drone_control_in_t in = radio_test_input(context, warmup + step);
+        mi_drone_control_out_t out = module->controller->run(&in);
+        expect_same_output(expected[step], out, step);
+        if (HasFatalFailure()) {
+            break;
+        }
+    }
+
+    /* 別のコンテキストに復元しても同じ出力になる */
+    void* other = module->controller->create_context(nullptr);
+    ASSERT_EQ(0, module->controller->init(other));
+    module->restore_state(other, state.data());
+    for (int step = 0; step < steps; step++) {
+        mi_drone_control_in_t in = radio_test_input(other, warmup + step);
+        mi_drone_control_out_t out = module->controller->run(&in);
+        expect_same_output(expected[step], out, step);
+        if (HasFatalFailure()) {
+            break;
+        }
+    }
+
+    /* 復元しない場合は出力が変わる(状態がスナップショットに含まれていることの確認) */
+    module->controller->init(other);
+    bool differ = false;
+    for (int step = 0; step < steps; step++) {
+        mi_drone_control_in_t in = radio_test_input(other, warmup + step);
+        mi_drone_control_out_t out = module->controller->run(&in);
+        if ((out.thrust != expected[step].thrust) || (out.torque_x != expected[step].torque_x)) {
+            differ = true;
+        }
+    }
+    EXPECT_TRUE(differ);
+
+    module->destroy_context(other);
+    module->destroy_context(context);
+    unsetenv("HAKO_CONTROLLER_PARAM_FILE");
+    std::filesystem::remove_all(radio_test_dir);
+}
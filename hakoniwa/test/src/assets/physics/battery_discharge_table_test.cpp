@@ -0,0 +1,267 @@
+#include <gtest/gtest.h>
+#include <iostream>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <cmath>
+#include "battery/battery_dynamics.hpp"
+
+class BatteryDischargeTableTest : public ::testing::Test {
+protected:
+    static void SetUpTestCase()
+    {
+    }
+    static void TearDownTestCase()
+    {
+    }
+    virtual void SetUp()
+    {
+    }
+    virtual void TearDown()
+    {
+    }
+
+};
+using hako::assets::drone::BatteryDischargeTable;
+using hako::assets::drone::DischargeCurve;
+using hako::assets::drone::DischargeData;
+
+#define BATTERY_MODEL_CSV HAKO_TEST_CONFIG_DIR "/battery_model.csv"
+
+typedef std::map<double, std::vector<DischargeData>> CurveMap;
+
+static CurveMap load_csv(const std::string& path)
+{
+    CurveMap curves;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream ss(line);
+        std::string t, c, v;
+        if (std::getline(ss, t, ',') && std::getline(ss, c, ',') && std::getline(ss, v, ',')) {
+            curves[std::stod(t)].push_back({ std::stod(c), std::stod(v) });
+        }
+    }
+    for (auto& [t, data] : curves) {
+        std::sort(data.begin(), data.end(), [](const DischargeData& a, const DischargeData& b) {
+            return a.capacity < b.capacity;
+        });
+    }
+    return curves;
+}
+
+static std::vector<DischargeCurve> to_curves(const CurveMap& map)
+{
+    std::vector<DischargeCurve> curves;
+    for (const auto& [t, data] : map) {
+        curves.push_back({ t, &data });
+    }
+    return curves;
+}
+
+/*
+ * 変更前の BatteryDynamics の計算: 最も近い温度の折れ線を2分探索して線形補間
+ */
+static double reference_voltage(const CurveMap& map, double temperature, double capacity)
+{
+    const std::vector<DischargeData>* closest = nullptr;
+    double min_difference = 0;
+    for (const auto& [t, data] : map) {
+        double difference = std::abs(temperature - t);
+        if (closest == nullptr || difference < min_difference) {
+            closest = &data;
+            min_difference = difference;
+        }
+    }
+    const auto& data = *closest;
+    auto it = std::lower_bound(data.begin(), data.end(), capacity, [](const DischargeData& a, double b) {
+        return a.capacity < b;
+    });
+    DischargeData lower, upper;
+    if (it == data.begin()) {
+        lower = *it; upper = *(it + 1);
+    } else if (it == data.end()) {
+        lower = *(it - 2); upper = *(it - 1);
+    } else {
+        lower = *(it - 1); upper = *it;
+    }
+    double slope = (upper.voltage - lower.voltage) / (upper.capacity - lower.capacity);
+    return lower.voltage + slope * (capacity - lower.capacity);
+}
+
+/*
+ * CSV の点が格子上にあれば(同梱の battery_model.csv)、CSV の温度では
+ * 変更前の折れ線の補間と一致すること
+ */
+TEST_F(BatteryDischargeTableTest, matches_csv_interpolation)
+{
+    CurveMap map = load_csv(BATTERY_MODEL_CSV);
+    ASSERT_EQ(4u, map.size());
+    BatteryDischargeTable table;
+    ASSERT_TRUE(table.build(to_curves(map), 0, 4.0));
+
+    double max_error = 0;
+    for (const auto& [t, data] : map) {
+        for (double c = 0; c <= 4.0; c += 0.001) {
+            double expected = reference_voltage(map, t, c);
+            max_error = std::max(max_error, std::abs(table.lookup(t, c) - expected));
+        }
+    }
+    EXPECT_LT(max_error, 1e-9);
+}
+
+/*
+ * CSV の温度の間は、前後の温度の折れ線を線形補間すること
+ */
+TEST_F(BatteryDischargeTableTest, interpolates_between_temperatures)
+{
+    CurveMap map = load_csv(BATTERY_MODEL_CSV);
+    BatteryDischargeTable table;
+    ASSERT_TRUE(table.build(to_curves(map), 0, 4.0));
+
+    for (double c = 0; c <= 4.0; c += 0.05) {
+        double v0 = reference_voltage(map, 0, c);
+        double v20 = reference_voltage(map, 20, c);
+        EXPECT_NEAR(0.5 * (v0 + v20), table.lookup(10, c), 1e-9);
+        EXPECT_NEAR(0.75 * v0 + 0.25 * v20, table.lookup(5, c), 1e-9);
+        /* 温度のヒントを使わずに行を切り替えても同じ値 */
+        EXPECT_NEAR(v0, table.lookup(0, c), 1e-9);
+    }
+}
+
+/*
+ * 範囲外の温度・放電容量は端の値に丸めること
+ */
+TEST_F(BatteryDischargeTableTest, clamps_out_of_range)
+{
+    CurveMap map = load_csv(BATTERY_MODEL_CSV);
+    BatteryDischargeTable table;
+    ASSERT_TRUE(table.build(to_curves(map), 0, 4.0));
+
+    EXPECT_NEAR(reference_voltage(map, -10, 2.0), table.lookup(-40, 2.0), 1e-9);
+    EXPECT_NEAR(reference_voltage(map, 45, 2.0), table.lookup(80, 2.0), 1e-9);
+    EXPECT_NEAR(reference_voltage(map, 20, 0.0), table.lookup(20, -1.0), 1e-9);
+    EXPECT_NEAR(reference_voltage(map, 20, 5.0), table.lookup(20, 10.0), 1e-9);
+}
+
+/*
+ * CSV の点が格子上にない場合も、CSV の温度での誤差は格子の刻み幅の範囲に収まること
+ */
+TEST_F(BatteryDischargeTableTest, irregular_points_accuracy)
+{
+    CurveMap map;
+    const double points[] = { 0.0, 0.07, 0.31, 0.5, 1.13, 1.9, 2.71, 3.05, 3.33, 3.9 };
+    for (double t : { -7.0, 3.0, 31.0 }) {
+        for (double c : points) {
+            map[t].push_back({ c, 16.0 - 0.3 * c * c - 0.01 * t * c });
+        }
+    }
+    BatteryDischargeTable table;
+    ASSERT_TRUE(table.build(to_curves(map), 0, 3.9));
+    ASSERT_GT(table.get_capacity_num(), 2);
+
+    double max_error = 0;
+    for (const auto& [t, data] : map) {
+        for (double c = 0; c <= 3.9; c += 0.001) {
+            max_error = std::max(max_error, std::abs(table.lookup(t, c) - reference_voltage(map, t, c)));
+        }
+    }
+    EXPECT_LT(max_error, 5e-3);
+}
+
+/*
+ * 温度方向も線形補間した CSV の折れ線(格子を作るときの元の値)
+ */
+static double blended_voltage(const CurveMap& map, double temperature, double capacity)
+{
+    auto upper = map.lower_bound(temperature);
+    if (upper == map.begin()) {
+        return BatteryDischargeTable::interpolate_curve(upper->second, capacity);
+    }
+    if (upper == map.end()) {
+        return BatteryDischargeTable::interpolate_curve(std::prev(upper)->second, capacity);
+    }
+    auto lower = std::prev(upper);
+    double w = (temperature - lower->first) / (upper->first - lower->first);
+    double v0 = BatteryDischargeTable::interpolate_curve(lower->second, capacity);
+    double v1 = BatteryDischargeTable::interpolate_curve(upper->second, capacity);
+    return v0 + w * (v1 - v0);
+}
+
+/*
+ * CSV の点が格子上にない場合、誤差は get_error_bound() 以下であること
+ * (温度・放電容量とも CSV の点の間も含めて調べる)
+ */
+TEST_F(BatteryDischargeTableTest, error_bound_off_grid)
+{
+    CurveMap map;
+    const double points[] = { 0.0, 0.07, 0.31, 0.5, 1.13, 1.9, 2.71, 3.05, 3.33, 3.9 };
+    for (double t : { -7.0, 3.0, 31.0 }) {
+        for (double c : points) {
+            map[t].push_back({ c, 16.0 - 0.3 * c * c - 0.01 * t * c - 0.002 * t * t });
+        }
+    }
+    BatteryDischargeTable table;
+    ASSERT_TRUE(table.build(to_curves(map), 0, 3.9));
+    double bound = table.get_error_bound();
+    EXPECT_GT(bound, 0.0);
+
+    double max_error = 0;
+    for (double t = -7.0; t <= 31.0; t += 0.125) {
+        for (double c = 0; c <= 3.9; c += 0.001) {
+            max_error = std::max(max_error, std::abs(table.lookup(t, c) - blended_voltage(map, t, c)));
+        }
+    }
+    EXPECT_GT(max_error, 1e-6);
+    EXPECT_LE(max_error, bound + 1e-12);
+}
+
+TEST_F(BatteryDischargeTableTest, insufficient_data)
+{
+    std::vector<DischargeData> one = { { 0.0, 14.8 } };
+    BatteryDischargeTable table;
+    EXPECT_FALSE(table.build({ { 20.0, &one } }, 0, 4.0));
+    EXPECT_FALSE(table.is_ready());
+}
+
+namespace {
+class ConstantCurrent : public hako::assets::drone::ICurrentDynamics {
+public:
+    double current = 0;
+    double get_current() override
+    {
+        return current;
+    }
+};
+}
+
+/*
+ * BatteryDynamics の電圧が、放電容量に対する変更前の計算と一致すること
+ */
+TEST_F(BatteryDischargeTableTest, battery_dynamics_voltage)
+{
+    CurveMap map = load_csv(BATTERY_MODEL_CSV);
+    const double dt = 0.001;
+    hako::assets::drone::BatteryDynamics battery(dt);
+    ConstantCurrent device;
+    device.current = 3600.0; /* 1ステップで 0.001 Ah */
+    battery.add_device(device);
+    hako::assets::drone::BatteryModelParameters params = {};
+    params.model = "custom";
+    params.BatteryModelCsvFilePath = BATTERY_MODEL_CSV;
+    params.NominalCapacity = 4.0;
+    params.NominalVoltage = 14.8;
+    battery.set_params(params);
+    battery.set_current_factor({ 20.0 });
+    battery.reset();
+
+    for (int i = 1; i <= 4500; i++) {
+        battery.run();
+        double capacity = std::min(i * 3600.0 * dt / 3600.0, 4.0);
+        ASSERT_NEAR(reference_voltage(map, 20.0, capacity), battery.get_vbat(), 1e-6) << "step " << i;
+    }
+}
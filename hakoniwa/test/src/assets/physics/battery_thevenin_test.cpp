@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+#include <iostream>
+#include <cmath>
+#include "battery/battery_dynamics.hpp"
+
+class BatteryTheveninTest : public ::testing::Test {
+protected:
+    static void SetUpTestCase()
+    {
+    }
+    static void TearDownTestCase()
+    {
+    }
+    virtual void SetUp()
+    {
+        params = {};
+        params.model = "thevenin";
+        params.NominalVoltage = 14.8;
+        params.NominalCapacity = 4.0;
+        params.VoltageLevelGreen = 12.1;
+        params.VoltageLevelYellow = 11.1;
+        params.CapacityLevelYellow = 3.0;
+        params.EODVoltage = 3.0;
+        params.InternalResistance = 0.05;
+        params.PolarizationResistance = 0.02;
+        params.PolarizationCapacitance = 500.0;
+        params.ReferenceTemperature = 25.0;
+    }
+    virtual void TearDown()
+    {
+    }
+    hako::assets::drone::BatteryModelParameters params;
+
+    /* linear モデルの電圧(開放電圧) */
+    double ocv(double capacity)
+    {
+        capacity = std::min(capacity, params.NominalCapacity);
+        if (capacity < params.CapacityLevelYellow) {
+            double slope = (params.NominalVoltage - params.VoltageLevelGreen) / params.CapacityLevelYellow;
+            return params.NominalVoltage - slope * capacity;
+        }
+        double slope = (params.VoltageLevelGreen - params.EODVoltage) / (params.NominalCapacity - params.CapacityLevelYellow);
+        return params.VoltageLevelGreen - slope * (capacity - params.CapacityLevelYellow);
+    }
+};
+
+namespace {
+class ConstantCurrent : public hako::assets::drone::ICurrentDynamics {
+public:
+    double current = 0;
+    double get_current() override
+    {
+        return current;
+    }
+};
+}
+
+static const double DT = 0.001;
+
+/*
+ * 一定電流で、内部抵抗の電圧降下と分極電圧の指数応答が厳密解と一致すること
+ */
+TEST_F(BatteryTheveninTest, step_response)
+{
+    hako::assets::drone::BatteryDynamics battery(DT);
+    ConstantCurrent device;
+    battery.add_device(device);
+    battery.set_params(params);
+    battery.set_current_factor({ 25.0 });
+    battery.reset();
+
+    const double current = 10.0;
+    const double tau = params.PolarizationResistance * params.PolarizationCapacitance;
+    device.current = current;
+    for (int n = 1; n <= 20000; n++) {
+        battery.run();
+        double capacity = n * current * DT / 3600.0;
+        double expected = ocv(capacity) - params.InternalResistance * current
+                        - params.PolarizationResistance * current * (1.0 - std::exp(-n * DT / tau));
+        ASSERT_NEAR(expected, battery.get_vbat(), 1e-9) << "step " << n;
+    }
+}
+
+/*
+ * 電流がなくなると、分極電圧が減衰して開放電圧に回復すること
+ */
+TEST_F(BatteryTheveninTest, recovery)
+{
+    hako::assets::drone::BatteryDynamics battery(DT);
+    ConstantCurrent device;
+    battery.add_device(device);
+    battery.set_params(params);
+    battery.set_current_factor({ 25.0 });
+    battery.reset();
+
+    const double tau = params.PolarizationResistance * params.PolarizationCapacitance;
+    device.current = 20.0;
+    for (int n = 0; n < 10000; n++) {
+        battery.run();
+    }
+    double loaded = battery.get_vbat();
+    double capacity = 10000 * 20.0 * DT / 3600.0;
+    double v1 = params.PolarizationResistance * 20.0 * (1.0 - std::exp(-10000 * DT / tau));
+
+    device.current = 0;
+    battery.run();
+    /* 内部抵抗の分は即座に回復する */
+    EXPECT_NEAR(ocv(capacity) - v1 * std::exp(-DT / tau), battery.get_vbat(), 1e-9);
+    EXPECT_GT(battery.get_vbat(), loaded + params.InternalResistance * 20.0 - 1e-6);
+    for (int n = 1; n < 100000; n++) {
+        battery.run();
+    }
+    EXPECT_NEAR(ocv(capacity), battery.get_vbat(), 1e-3);
+}
+
+/*
+ * 低温では実効容量が減り、同じ放電容量でも電圧が低いこと
+ */
+TEST_F(BatteryTheveninTest, temperature_capacity)
+{
+    params.InternalResistance = 0;
+    params.PolarizationResistance = 0;
+    params.CapacityTemperatureCoefficient = 0.01;
+    hako::assets::drone::BatteryDynamics warm(DT);
+    hako::assets::drone::BatteryDynamics cold(DT);
+    ConstantCurrent device;
+    device.current = 3600.0;
+    warm.add_device(device);
+    cold.add_device(device);
+    warm.set_params(params);
+    cold.set_params(params);
+    warm.set_current_factor({ 25.0 });
+    cold.set_current_factor({ -15.0 });
+    warm.reset();
+    cold.reset();
+
+    for (int n = 1; n <= 2000; n++) {
+        warm.run();
+        cold.run();
+        double capacity = n * DT;
+        ASSERT_NEAR(ocv(capacity), warm.get_vbat(), 1e-9);
+        ASSERT_NEAR(ocv(capacity / 0.6), cold.get_vbat(), 1e-9);
+    }
+    EXPECT_LT(cold.get_vbat(), warm.get_vbat());
+}
+
+/*
+ * CSV のテーブルを使う場合、温度はテーブルの参照だけで反映し、
+ * 容量の温度係数は重ねて適用しないこと(抵抗が 0 なら custom モデルと同じ電圧)
+ */
+TEST_F(BatteryTheveninTest, csv_table_temperature)
+{
+    params.InternalResistance = 0;
+    params.PolarizationResistance = 0;
+    params.CapacityTemperatureCoefficient = 0.01;
+    params.BatteryModelCsvFilePath = HAKO_TEST_CONFIG_DIR "/battery_model.csv";
+    hako::assets::drone::BatteryModelParameters custom_params = params;
+    custom_params.model = "custom";
+    hako::assets::drone::BatteryDynamics thevenin(DT);
+    hako::assets::drone::BatteryDynamics custom(DT);
+    ConstantCurrent device;
+    device.current = 3600.0;
+    thevenin.add_device(device);
+    custom.add_device(device);
+    thevenin.set_params(params);
+    custom.set_params(custom_params);
+    for (double temperature : { -10.0, 5.0, 25.0 }) {
+        thevenin.set_current_factor({ temperature });
+        custom.set_current_factor({ temperature });
+        thevenin.reset();
+        custom.reset();
+        for (int n = 1; n <= 3000; n++) {
+            thevenin.run();
+            custom.run();
+            ASSERT_NEAR(custom.get_vbat(), thevenin.get_vbat(), 1e-9) << "temperature " << temperature << " step " << n;
+        }
+    }
+}
+
+/*
+ * 分極容量が 0 の場合は、分極抵抗を内部抵抗と同様に扱うこと
+ */
+TEST_F(BatteryTheveninTest, no_capacitance)
+{
+    params.PolarizationCapacitance = 0;
+    hako::assets::drone::BatteryDynamics battery(DT);
+    ConstantCurrent device;
+    device.current = 10.0;
+    battery.add_device(device);
+    battery.set_params(params);
+    battery.set_current_factor({ 25.0 });
+    battery.reset();
+
+    battery.run();
+    double expected = ocv(10.0 * DT / 3600.0) - (params.InternalResistance + params.PolarizationResistance) * 10.0;
+    EXPECT_NEAR(expected, battery.get_vbat(), 1e-9);
+}
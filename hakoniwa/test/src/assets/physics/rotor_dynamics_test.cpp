@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <iostream>
+#include <cmath>
 #include "utils/csv_logger.hpp"
 #include "rotor/rotor_dynamics.hpp"
 
@@ -45,3 +46,75 @@ TEST_F(RotorDynamicsTest, test_01)
     //std::cout << "2sec value: " << value.data << std::endl;
     EXPECT_GT(value.data, 0.4);
 }
+
+/*
+ * 1次遅れモデル: 時定数より大きい刻み幅でも厳密解と一致すること
+ */
+TEST_F(RotorDynamicsTest, first_order_exact)
+{
+    const double tr = 0.02;
+    const double kr = 3000.0;
+    for (double dt : { 0.001, 0.01, 0.05 }) {
+        RotorDynamics rotor(dt);
+        rotor.set_params(10000.0, tr, kr);
+        for (int n = 1; n * dt <= 0.5; n++) {
+            rotor.run(0.6);
+            double expected = kr * 0.6 * (1.0 - std::exp(-n * dt / tr));
+            ASSERT_NEAR(expected, rotor.get_rotor_speed().data, 1e-9 * kr) << "dt " << dt << " step " << n;
+        }
+    }
+}
+
+/*
+ * バッテリーモデル: 細かい刻み幅の RK4 と一致し、大きい刻み幅でも発散しないこと
+ */
+static double rk4_battery_omega(const hako::assets::drone::RotorBatteryModelConstants& c, double vbat, double duty, double omega, double dt, int steps)
+{
+    auto f = [&](double w) {
+        return hako::drone_physics::rotor_omega_acceleration(vbat, c.R, c.Cq, c.J, c.K, c.D, w, duty);
+    };
+    for (int i = 0; i < steps; i++) {
+        double k1 = f(omega);
+        double k2 = f(omega + 0.5 * dt * k1);
+        double k3 = f(omega + 0.5 * dt * k2);
+        double k4 = f(omega + dt * k3);
+        omega += dt * (k1 + 2 * k2 + 2 * k3 + k4) / 6.0;
+    }
+    return omega;
+}
+
+TEST_F(RotorDynamicsTest, battery_model_closed_form)
+{
+    hako::assets::drone::RotorBatteryModelConstants c = { 0.12, 3.0e-8, 3.28e-3, 1.0e-7, 8.12e-6 };
+    const double vbat = 14.8;
+    for (double dt : { 0.001, 0.005, 0.02 }) {
+        RotorDynamics rotor(dt);
+        rotor.set_params(100000.0, 0, 100000.0);
+        rotor.set_battery_dynamics_constants(c);
+        double reference = 0;
+        /* 加速してから減速する */
+        for (int n = 0; n * dt < 0.4; n++) {
+            double duty = (n * dt < 0.2) ? 0.8 : 0.3;
+            reference = rk4_battery_omega(c, vbat, duty, reference, 1e-6, static_cast<int>(dt / 1e-6 + 0.5));
+            rotor.run(duty, vbat);
+            ASSERT_NEAR(reference, rotor.get_rotor_speed().data, 1e-6 * std::max(reference, 1.0)) << "dt " << dt << " step " << n;
+        }
+        EXPECT_GT(rotor.get_current(), 0);
+    }
+}
+
+/*
+ * バッテリーモデル: Cq = 0 (線形)の場合も平衡点と一致すること
+ */
+TEST_F(RotorDynamicsTest, battery_model_linear_limit)
+{
+    hako::assets::drone::RotorBatteryModelConstants c = { 0.12, 0.0, 3.28e-3, 0.0, 8.12e-6 };
+    RotorDynamics rotor(0.01);
+    rotor.set_params(100000.0, 0, 100000.0);
+    rotor.set_battery_dynamics_constants(c);
+    for (int n = 0; n < 1000; n++) {
+        rotor.run(0.5, 10.0);
+    }
+    /* K * V * d = K^2 * ω */
+    EXPECT_NEAR(0.5 * 10.0 / c.K, rotor.get_rotor_speed().data, 1e-6);
+}
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <iostream>
+#include <cmath>
+#include "thruster/thrust_kernel.hpp"
+#include "thruster/thrust_kernel_simd.hpp"
+
+class ThrustKernelTest : public ::testing::Test {
+protected:
+    static void SetUpTestCase()
+    {
+    }
+    static void TearDownTestCase()
+    {
+    }
+    virtual void SetUp()
+    {
+    }
+    virtual void TearDown()
+    {
+    }
+
+};
+using hako::assets::drone::ThrustKernelParamType;
+using hako::assets::drone::ThrustKernelType;
+
+static void make_frame(int num, hako::drone_physics::VectorType* position, double* ccw, double* omega, double* omega_acc)
+{
+    for (int i = 0; i < num; i++) {
+        double angle = (M_PI / num) + (2.0 * M_PI * i / num);
+        position[i] = { 0.2 * std::cos(angle), 0.2 * std::sin(angle), 0.01 * i };
+        ccw[i] = (i % 2 == 0) ? 1 : -1;
+        omega[i] = 500.0 + 10.0 * i;
+        omega_acc[i] = 3.0 - i;
+    }
+}
+
+/*
+ * ロータ数ごとの特殊化が drone_physics の汎用版と一致すること
+ */
+TEST_F(ThrustKernelTest, specialization_matches_generic)
+{
+    for (int num : { 4, 5, 6, 8 }) {
+        hako::drone_physics::VectorType position[hako::assets::drone::ROTOR_NUM_MAX];
+        double ccw[hako::assets::drone::ROTOR_NUM_MAX];
+        double omega[hako::assets::drone::ROTOR_NUM_MAX];
+        double omega_acc[hako::assets::drone::ROTOR_NUM_MAX];
+        make_frame(num, position, ccw, omega, omega_acc);
+        const ThrustKernelParamType param = { 1.0e-5, 1.0e-7, 1.0e-4, num, position, ccw };
+        struct {
+            ThrustKernelType specialized;
+            ThrustKernelType generic;
+        } kernels[] = {
+            { hako::assets::drone::thrust_kernel_select_nonlinear(num), hako::assets::drone::thrust_kernel_nonlinear_generic },
+            { hako::assets::drone::thrust_kernel_select_linear(num), hako::assets::drone::thrust_kernel_linear_generic },
+        };
+        for (auto& k : kernels) {
+            double thrust_s, thrust_g;
+            hako::drone_physics::TorqueType torque_s, torque_g;
+            k.specialized(param, omega, omega_acc, thrust_s, torque_s);
+            k.generic(param, omega, omega_acc, thrust_g, torque_g);
+            EXPECT_DOUBLE_EQ(thrust_g, thrust_s);
+            EXPECT_DOUBLE_EQ(torque_g.x, torque_s.x);
+            EXPECT_DOUBLE_EQ(torque_g.y, torque_s.y);
+            EXPECT_DOUBLE_EQ(torque_g.z, torque_s.z);
+        }
+    }
+}
+
+TEST_F(ThrustKernelTest, select)
+{
+    EXPECT_EQ((ThrustKernelType)hako::assets::drone::thrust_kernel_nonlinear<4>, hako::assets::drone::thrust_kernel_select_nonlinear(4));
+    EXPECT_EQ((ThrustKernelType)hako::assets::drone::thrust_kernel_nonlinear<6>, hako::assets::drone::thrust_kernel_select_nonlinear(6));
+    EXPECT_EQ((ThrustKernelType)hako::assets::drone::thrust_kernel_nonlinear<8>, hako::assets::drone::thrust_kernel_select_nonlinear(8));
+    EXPECT_EQ((ThrustKernelType)hako::assets::drone::thrust_kernel_nonlinear_generic, hako::assets::drone::thrust_kernel_select_nonlinear(3));
+}
+
+#ifdef HAKO_THRUST_KERNEL_SIMD
+/*
+ * SIMD 版が drone_physics の汎用版(角加速度は前回との差分)と一致すること
+ */
+TEST_F(ThrustKernelTest, simd_matches_generic)
+{
+    const double dt = 0.001;
+    for (int num = 1; num <= hako::assets::drone::ROTOR_NUM_MAX; num++) {
+        hako::drone_physics::VectorType position[hako::assets::drone::ROTOR_NUM_MAX];
+        double ccw[hako::assets::drone::ROTOR_NUM_MAX];
+        double omega[hako::assets::drone::ROTOR_NUM_MAX];
+        double prev_omega[hako::assets::drone::ROTOR_NUM_MAX];
+        double omega_acc[hako::assets::drone::ROTOR_NUM_MAX];
+        make_frame(num, position, ccw, prev_omega, omega_acc);
+        const ThrustKernelParamType param = { 1.0e-5, 1.0e-7, 1.0e-4, num, position, ccw };
+
+        hako::assets::drone::ThrustKernelSimd simd;
+        simd.set_geometry(num, position, ccw);
+        EXPECT_EQ((num <= 4) ? 4 : 8, simd.get_lanes());
+        double thrust_s;
+        hako::drone_physics::TorqueType torque_s;
+        /* 1回目: 前回の角速度を設定する */
+        for (int i = 0; i < num; i++) {
+            simd.omega_lanes()[i] = prev_omega[i];
+        }
+        simd.run(param.Ct, param.Cq, param.J, 1.0 / dt, thrust_s, torque_s);
+
+        for (int i = 0; i < num; i++) {
+            omega[i] = prev_omega[i] + 0.5 * (i + 1);
+            omega_acc[i] = (omega[i] - prev_omega[i]) / dt;
+            simd.omega_lanes()[i] = omega[i];
+        }
+        simd.run(param.Ct, param.Cq, param.J, 1.0 / dt, thrust_s, torque_s);
+
+        double thrust_g;
+        hako::drone_physics::TorqueType torque_g;
+        hako::assets::drone::thrust_kernel_nonlinear_generic(param, omega, omega_acc, thrust_g, torque_g);
+        EXPECT_NEAR(thrust_g, thrust_s, 1e-12 * std::abs(thrust_g)) << num;
+        EXPECT_NEAR(torque_g.x, torque_s.x, 1e-12) << num;
+        EXPECT_NEAR(torque_g.y, torque_s.y, 1e-12) << num;
+        EXPECT_NEAR(torque_g.z, torque_s.z, 1e-12) << num;
+    }
+}
+#endif
@@ -0,0 +1,274 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include "comm/shm_ring.hpp"
+#include "comm/shm_connector.hpp"
+
+class ShmRingTest : public ::testing::Test {
+protected:
+    static void SetUpTestCase()
+    {
+    }
+    static void TearDownTestCase()
+    {
+    }
+    virtual void SetUp()
+    {
+    }
+    virtual void TearDown()
+    {
+    }
+
+};
+using namespace hako::px4::comm;
+using namespace hako::px4::comm::shm;
+
+namespace {
+std::unique_ptr<ShmRingType> create_ring()
+{
+    std::unique_ptr<ShmRingType> ring(new ShmRingType);
+    shm_ring_init(ring.get());
+    return ring;
+}
+std::vector<uint8_t> make_message(uint32_t len, uint32_t seed)
+{
+    std::vector<uint8_t> msg(len);
+    for (uint32_t i = 0; i < len; i++) {
+        msg[i] = static_cast<uint8_t>(seed * 31 + i);
+    }
+    return msg;
+}
+/*
+ * 他のテストや実行中の hako-px4sim とセグメント名が重ならないポート番号
+ */
+int unique_portno(int offset)
+{
+    return 50000 + (getpid() % 5000) * 4 + offset;
+}
+}
+
+/*
+ * 空のリングは読めず、close 後の pop は 0 を返すこと
+ */
+TEST_F(ShmRingTest, empty_and_close)
+{
+    auto ring = create_ring();
+    uint8_t buf[16];
+    uint32_t len = 0;
+    std::thread closer([&ring]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        shm_ring_close(ring.get());
+    });
+    /* データが無いので close されるまで待つ */
+    EXPECT_EQ(0, shm_ring_pop(ring.get(), buf, sizeof(buf), &len));
+    closer.join();
+    EXPECT_FALSE(shm_ring_push(ring.get(), buf, HAKO_SHM_COMM_RING_SIZE));
+}
+
+/*
+ * リング境界と 32bit の位置カウンタの桁あふれをまたいでも、内容が壊れないこと
+ */
+TEST_F(ShmRingTest, wraparound)
+{
+    auto ring = create_ring();
+    /* カウンタを桁あふれ直前から始める */
+    const uint32_t start = UINT32_MAX - 1000;
+    ring->head.store(start);
+    ring->tail.store(start);
+
+    std::vector<uint8_t> buf(2048);
+    for (uint32_t i = 0; i < 200; i++) {
+        auto msg = make_message(997 + (i % 5), i);
+        ASSERT_TRUE(shm_ring_push(ring.get(), msg.data(), static_cast<uint32_t>(msg.size())));
+        uint32_t len = 0;
+        ASSERT_EQ(1, shm_ring_pop(ring.get(), buf.data(), static_cast<uint32_t>(buf.size()), &len));
+        ASSERT_EQ(msg.size(), len);
+        ASSERT_EQ(0, memcmp(msg.data(), buf.data(), len)) << "message " << i;
+    }
+    /* 200 * 1000 byte 書いたので、リングを何周もしてカウンタも 0 を越えている */
+    EXPECT_LT(ring->head.load(), start);
+    EXPECT_EQ(ring->head.load(), ring->tail.load());
+}
+
+/*
+ * 満杯のときは consumer が読むまで push が待ち、順番どおりに取り出せること
+ */
+TEST_F(ShmRingTest, full_blocks_until_pop)
+{
+    auto ring = create_ring();
+    const uint32_t msg_len = 1020; /* 長さ 4byte を含めて 1KB */
+    const uint32_t capacity = HAKO_SHM_COMM_RING_SIZE / (msg_len + sizeof(uint32_t));
+    for (uint32_t i = 0; i < capacity; i++) {
+        auto msg = make_message(msg_len, i);
+        ASSERT_TRUE(shm_ring_push(ring.get(), msg.data(), msg_len));
+    }
+    EXPECT_EQ(static_cast<uint32_t>(HAKO_SHM_COMM_RING_SIZE), ring->head.load() - ring->tail.load());
+
+    std::atomic<bool> pushed { false };
+    std::thread producer([&ring, &pushed, capacity]() {
+        auto msg = make_message(msg_len, capacity);
+        EXPECT_TRUE(shm_ring_push(ring.get(), msg.data(), msg_len));
+        pushed.store(true);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(pushed.load());
+
+    std::vector<uint8_t> buf(msg_len);
+    for (uint32_t i = 0; i <= capacity; i++) {
+        uint32_t len = 0;
+        ASSERT_EQ(1, shm_ring_pop(ring.get(), buf.data(), msg_len, &len));
+        ASSERT_EQ(make_message(msg_len, i), buf) << "message " << i;
+    }
+    producer.join();
+    EXPECT_TRUE(pushed.load());
+}
+
+/*
+ * 受信バッファより大きいメッセージは -1 で読み捨てられ、次のメッセージを読めること
+ */
+TEST_F(ShmRingTest, recv_buffer_too_small)
+{
+    auto ring = create_ring();
+    auto large = make_message(64, 1);
+    auto msg = make_message(16, 2);
+    ASSERT_TRUE(shm_ring_push(ring.get(), large.data(), 64));
+    ASSERT_TRUE(shm_ring_push(ring.get(), msg.data(), 16));
+    uint8_t small[32];
+    uint32_t len = 0;
+    EXPECT_EQ(-1, shm_ring_pop(ring.get(), small, sizeof(small), &len));
+    EXPECT_EQ(64u, len);
+    std::vector<uint8_t> buf(16);
+    EXPECT_EQ(1, shm_ring_pop(ring.get(), buf.data(), 16, &len));
+    EXPECT_EQ(16u, len);
+    EXPECT_EQ(msg, buf);
+    EXPECT_EQ(ring->head.load(), ring->tail.load());
+}
+
+/*
+ * ShmCommIO::recv は大きすぎるメッセージを読み捨てて次のメッセージを返し、
+ * 接続は切らないこと
+ */
+TEST_F(ShmRingTest, comm_io_drops_too_large_message)
+{
+    int portno = unique_portno(3);
+    ShmSegmentType* server_seg = shm_segment_create(portno);
+    ASSERT_NE(nullptr, server_seg);
+    ShmSegmentType* client_seg = shm_segment_attach(portno);
+    ASSERT_NE(nullptr, client_seg);
+    ShmCommIO server(server_seg, portno, true);
+    ShmCommIO client(client_seg, portno, false);
+
+    auto large = make_message(64, 1);
+    auto msg = make_message(16, 2);
+    int len = 0;
+    ASSERT_TRUE(client.send(reinterpret_cast<const char*>(large.data()), 64, &len));
+    ASSERT_TRUE(client.send(reinterpret_cast<const char*>(msg.data()), 16, &len));
+    std::vector<uint8_t> buf(32);
+    ASSERT_TRUE(server.recv(reinterpret_cast<char*>(buf.data()), 32, &len));
+    ASSERT_EQ(16, len);
+    buf.resize(16);
+    EXPECT_EQ(msg, buf);
+
+    /* 接続は維持されている */
+    ASSERT_TRUE(server.send(reinterpret_cast<const char*>(msg.data()), 16, &len));
+    std::vector<uint8_t> reply(16);
+    ASSERT_TRUE(client.recv(reinterpret_cast<char*>(reply.data()), 16, &len));
+    EXPECT_EQ(msg, reply);
+
+    client.close();
+    server.close();
+}
+
+/*
+ * 別プロセスの client と接続し、双方向に送受信して close を相手が検出できること
+ */
+TEST_F(ShmRingTest, two_process_open_close)
+{
+    IcommEndpointType endpoint = { "127.0.0.1", unique_portno(0) };
+    ShmServer server(10);
+    ASSERT_TRUE(server.server_bind(&endpoint));
+
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        /* client: 受け取った値に 1 を足して返し、close する */
+        ShmClient client;
+        ICommIO* io = client.client_open(nullptr, &endpoint);
+        if (io == nullptr) {
+            _exit(1);
+        }
+        int status = 0;
+        for (int i = 0; i < 100; i++) {
+            uint32_t value = 0;
+            int len = 0;
+            if (!io->recv(reinterpret_cast<char*>(&value), sizeof(value), &len) || len != sizeof(value)) {
+                status = 2;
+                break;
+            }
+            value++;
+            if (!io->send(reinterpret_cast<const char*>(&value), sizeof(value), &len)) {
+                status = 3;
+                break;
+            }
+        }
+        io->close();
+        delete io;
+        _exit(status);
+    }
+    ICommIO* io = server.server_open(&endpoint);
+    ASSERT_NE(nullptr, io);
+    for (uint32_t i = 0; i < 100; i++) {
+        uint32_t value = i * 10;
+        int len = 0;
+        ASSERT_TRUE(io->send(reinterpret_cast<const char*>(&value), sizeof(value), &len));
+        ASSERT_TRUE(io->recv(reinterpret_cast<char*>(&value), sizeof(value), &len));
+        ASSERT_EQ(i * 10 + 1, value);
+    }
+    /* client が close したら recv は false で戻る */
+    uint32_t value = 0;
+    int len = 0;
+    EXPECT_FALSE(io->recv(reinterpret_cast<char*>(&value), sizeof(value), &len));
+    int status = -1;
+    ASSERT_EQ(pid, waitpid(pid, &status, 0));
+    EXPECT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(0, WEXITSTATUS(status));
+    io->close();
+    delete io;
+
+    /* server の close でセグメントは削除され、以後 attach できない */
+    EXPECT_EQ(nullptr, shm_segment_attach(endpoint.portno));
+}
+
+/*
+ * client が来ない場合は accept timeout で nullptr を返すこと
+ */
+TEST_F(ShmRingTest, server_open_timeout)
+{
+    IcommEndpointType endpoint = { "127.0.0.1", unique_portno(1) };
+    ShmServer server(1);
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(nullptr, server.server_open(&endpoint));
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_GE(elapsed, std::chrono::seconds(1));
+    EXPECT_LT(elapsed, std::chrono::seconds(3));
+    EXPECT_EQ(nullptr, shm_segment_attach(endpoint.portno));
+}
+
+/*
+ * 接続待ち中に stop() すると nullptr で戻ること
+ */
+TEST_F(ShmRingTest, server_open_stop)
+{
+    IcommEndpointType endpoint = { "127.0.0.1", unique_portno(2) };
+    ShmServer server(0);
+    std::thread stopper([&server]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        server.stop();
+    });
+    EXPECT_EQ(nullptr, server.server_open(&endpoint));
+    stopper.join();
+}
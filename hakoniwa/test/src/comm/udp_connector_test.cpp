@@ -0,0 +1,239 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include "comm/udp_connector.hpp"
+
+class UdpConnectorTest : public ::testing::Test {
+protected:
+    static void SetUpTestCase()
+    {
+    }
+    static void TearDownTestCase()
+    {
+    }
+    virtual void SetUp()
+    {
+    }
+    virtual void TearDown()
+    {
+    }
+
+};
+using namespace hako::px4::comm;
+
+namespace {
+/*
+ * PX4 SITL の UDP モードと同じく、4560 + i 相当のポートを bind して待つソケット
+ */
+class FakePx4Socket {
+public:
+    int sockfd = -1;
+    int portno = -1;
+    struct sockaddr_in sim_addr = {};
+
+    bool open(int port)
+    {
+        sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+        if (sockfd < 0) {
+            return false;
+        }
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+        if (bind(sockfd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+            close();
+            return false;
+        }
+        struct timeval tv = { 2, 0 };
+        setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        portno = port;
+        return true;
+    }
+    void close()
+    {
+        if (sockfd >= 0) {
+            ::close(sockfd);
+            sockfd = -1;
+        }
+    }
+    ~FakePx4Socket()
+    {
+        close();
+    }
+    /* シミュレータから受信し、返信先を覚える */
+    int recv(std::vector<uint8_t>& buf)
+    {
+        buf.resize(2048);
+        socklen_t len = sizeof(sim_addr);
+        int n = recvfrom(sockfd, buf.data(), buf.size(), 0, (struct sockaddr*)&sim_addr, &len);
+        buf.resize(n > 0 ? n : 0);
+        return n;
+    }
+    bool send(const std::vector<uint8_t>& data)
+    {
+        return sendto(sockfd, data.data(), data.size(), 0, (struct sockaddr*)&sim_addr, sizeof(sim_addr)) == (ssize_t)data.size();
+    }
+};
+
+/*
+ * MAVLink v2 のヘッダだけ持つパケット(振り分けに使うのは sysid のみ)
+ */
+std::vector<uint8_t> make_packet(uint8_t sysid, uint8_t tag, size_t len = 16)
+{
+    std::vector<uint8_t> pkt(len, tag);
+    pkt[0] = 0xFD;
+    pkt[1] = static_cast<uint8_t>(len - 12);
+    pkt[5] = sysid;
+    return pkt;
+}
+
+bool recv_with_timeout(UdpMuxServer& server, ICommIO* io, std::vector<uint8_t>& buf)
+{
+    buf.resize(UDP_COMM_DATAGRAM_MAX);
+    auto result = std::async(std::launch::async, [io, &buf]() {
+        int len = 0;
+        bool ret = io->recv(reinterpret_cast<char*>(buf.data()), (int)buf.size(), &len);
+        buf.resize(ret ? len : 0);
+        return ret;
+    });
+    if (result.wait_for(std::chrono::seconds(2)) != std::future_status::ready) {
+        /* close() で recv() を起こしてテストを失敗させる */
+        server.close();
+        result.wait();
+        return false;
+    }
+    return result.get();
+}
+
+/*
+ * 連続した2ポートを bind できる基準ポートを探す
+ */
+int open_fake_px4(FakePx4Socket px4[2])
+{
+    for (int base = 41000 + (getpid() % 1000) * 8; base < 60000; base += 8000) {
+        if (px4[0].open(base) && px4[1].open(base + 1)) {
+            return base;
+        }
+        px4[0].close();
+        px4[1].close();
+    }
+    return -1;
+}
+}
+
+/*
+ * PX4 から何も受信していなくても、機体ごとの PX4 のポートへ先に送信できること
+ */
+TEST_F(UdpConnectorTest, sim_sends_first)
+{
+    FakePx4Socket px4[2];
+    int base = open_fake_px4(px4);
+    ASSERT_GT(base, 0);
+
+    UdpMuxServer server;
+    IcommEndpointType endpoints[2] = { { "127.0.0.1", base }, { "127.0.0.1", base + 1 } };
+    ASSERT_TRUE(server.server_bind(&endpoints[0]));
+    ASSERT_TRUE(server.server_bind(&endpoints[1]));
+    /* PX4 の基準ポートとぶつからないこと */
+    EXPECT_NE(base, server.get_local_portno());
+    std::unique_ptr<ICommIO> io0(server.server_open(&endpoints[0]));
+    std::unique_ptr<ICommIO> io1(server.server_open(&endpoints[1]));
+    ASSERT_NE(nullptr, io0);
+    ASSERT_NE(nullptr, io1);
+
+    auto pkt0 = make_packet(1, 0xA0);
+    auto pkt1 = make_packet(2, 0xA1);
+    int len = 0;
+    ASSERT_TRUE(io0->send(reinterpret_cast<const char*>(pkt0.data()), (int)pkt0.size(), &len));
+    ASSERT_TRUE(io1->send(reinterpret_cast<const char*>(pkt1.data()), (int)pkt1.size(), &len));
+    ASSERT_TRUE(io0->flush());
+
+    std::vector<uint8_t> buf;
+    ASSERT_EQ((int)pkt0.size(), px4[0].recv(buf));
+    EXPECT_EQ(pkt0, buf);
+    ASSERT_EQ((int)pkt1.size(), px4[1].recv(buf));
+    EXPECT_EQ(pkt1, buf);
+    EXPECT_EQ(server.get_local_portno(), ntohs(px4[0].sim_addr.sin_port));
+    server.close();
+}
+
+/*
+ * PX4 からの受信は送信元のポートで機体に振り分けられること(sysid が同じでもよい)
+ */
+TEST_F(UdpConnectorTest, per_vehicle_routing)
+{
+    FakePx4Socket px4[2];
+    int base = open_fake_px4(px4);
+    ASSERT_GT(base, 0);
+
+    UdpMuxServer server;
+    IcommEndpointType endpoints[2] = { { "127.0.0.1", base }, { "127.0.0.1", base + 1 } };
+    ASSERT_TRUE(server.server_bind(&endpoints[0]));
+    ASSERT_TRUE(server.server_bind(&endpoints[1]));
+    std::unique_ptr<ICommIO> io0(server.server_open(&endpoints[0]));
+    std::unique_ptr<ICommIO> io1(server.server_open(&endpoints[1]));
+
+    int len = 0;
+    auto hello = make_packet(1, 0x00);
+    ASSERT_TRUE(io0->send(reinterpret_cast<const char*>(hello.data()), (int)hello.size(), &len));
+    ASSERT_TRUE(io1->send(reinterpret_cast<const char*>(hello.data()), (int)hello.size(), &len));
+    ASSERT_TRUE(server.flush());
+    std::vector<uint8_t> buf;
+    ASSERT_GT(px4[0].recv(buf), 0);
+    ASSERT_GT(px4[1].recv(buf), 0);
+
+    /* 機体1も MAV_SYS_ID=1 のまま送ってくる */
+    auto reply1 = make_packet(1, 0xB1);
+    auto reply0 = make_packet(1, 0xB0);
+    ASSERT_TRUE(px4[1].send(reply1));
+    ASSERT_TRUE(px4[0].send(reply0));
+    ASSERT_TRUE(recv_with_timeout(server, io1.get(), buf));
+    EXPECT_EQ(reply1, buf);
+    ASSERT_TRUE(recv_with_timeout(server, io0.get(), buf));
+    EXPECT_EQ(reply0, buf);
+    server.close();
+}
+
+/*
+ * UDP_COMM_DATAGRAM_MAX を超えるデータグラムは数えて捨て、後続は受信できること
+ */
+TEST_F(UdpConnectorTest, oversize_datagram)
+{
+    FakePx4Socket px4[2];
+    int base = open_fake_px4(px4);
+    ASSERT_GT(base, 0);
+
+    UdpMuxServer server;
+    IcommEndpointType endpoint = { "127.0.0.1", base };
+    std::unique_ptr<ICommIO> io0(server.server_open(&endpoint));
+    ASSERT_NE(nullptr, io0);
+
+    int len = 0;
+    auto hello = make_packet(1, 0x00);
+    ASSERT_TRUE(io0->send(reinterpret_cast<const char*>(hello.data()), (int)hello.size(), &len));
+    ASSERT_TRUE(io0->flush());
+    std::vector<uint8_t> buf;
+    ASSERT_GT(px4[0].recv(buf), 0);
+
+    auto big = make_packet(1, 0xCC, UDP_COMM_DATAGRAM_MAX + 200);
+    auto next = make_packet(1, 0xC1);
+    ASSERT_TRUE(px4[0].send(big));
+    ASSERT_TRUE(px4[0].send(next));
+    ASSERT_TRUE(recv_with_timeout(server, io0.get(), buf));
+    EXPECT_EQ(next, buf);
+
+    UdpMuxChannelStatsType stats;
+    ASSERT_TRUE(server.get_channel_stats(0, stats));
+    EXPECT_EQ(1u, stats.oversize);
+    EXPECT_EQ(0u, stats.dropped);
+
+    /* 送信側も大きすぎるデータは受け付けない */
+    EXPECT_FALSE(io0->send(reinterpret_cast<const char*>(big.data()), (int)big.size(), &len));
+    server.close();
+}
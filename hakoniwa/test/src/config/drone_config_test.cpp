@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <fstream>
+#include <cstdio>
+#include "config/drone_config.hpp"
+
+#define DRONE_CONFIG_TEST_JSON "./drone_config_test.json"
+
+class DroneConfigTest : public ::testing::Test {
+protected:
+    static void SetUpTestCase()
+    {
+    }
+    static void TearDownTestCase()
+    {
+    }
+    virtual void SetUp()
+    {
+        std::ifstream src(std::string(HAKO_TEST_CONFIG_DIR) + "/rc/drone_config_0.json");
+        ASSERT_TRUE(src.is_open());
+        src >> base;
+    }
+    virtual void TearDown()
+    {
+        std::remove(DRONE_CONFIG_TEST_JSON);
+    }
+    nlohmann::json base;
+
+    std::shared_ptr<const DroneConfigData> parse(const nlohmann::json& j)
+    {
+        std::ofstream f(DRONE_CONFIG_TEST_JSON);
+        f << j.dump();
+        f.close();
+        return drone_config_data_parse(DRONE_CONFIG_TEST_JSON);
+    }
+};
+
+TEST_F(DroneConfigTest, ParseTyped)
+{
+    auto data = parse(base);
+    ASSERT_NE(nullptr, data);
+    DroneConfig config(data);
+    EXPECT_EQ("DroneTransporter", config.getRoboName());
+    EXPECT_DOUBLE_EQ(0.001, config.getSimTimeStep());
+    EXPECT_TRUE(config.getSimLockStep());
+    EXPECT_DOUBLE_EQ(0.71, config.getCompDroneDynamicsMass());
+    EXPECT_EQ(3u, config.getCompDroneDynamicsInertia().size());
+    EXPECT_EQ(4u, config.getCompThrusterRotorPositions().size());
+    EXPECT_DOUBLE_EQ(8.3E-07, config.getCompThrusterParameter("Ct"));
+    EXPECT_DOUBLE_EQ(0.0, config.getCompThrusterParameter("unknown"));
+    EXPECT_DOUBLE_EQ(0.03, config.getCompSensorNoise("acc"));
+    EXPECT_DOUBLE_EQ(1, config.getCompSensorSampleCount("gps"));
+    EXPECT_EQ("", config.getCompSensorVendor("gyro"));
+    EXPECT_EQ(3, config.getSimMavlinkTransmissionPeriod("hil_sensor"));
+    EXPECT_EQ("BatteryModel", config.getCompRotorVendor());
+    EXPECT_DOUBLE_EQ(0.12, config.getCompDroneDynamicsRotorDynamicsConstants().R);
+    EXPECT_EQ("None", config.getComDroneDynamicsBattery().vendor);
+    EXPECT_EQ("constant", config.getComDroneDynamicsBattery().model);
+    EXPECT_EQ("../drone_control/cmake-build/workspace/RadioController/libRadioController" SHARED_LIB_EXT,
+              config.getControllerModuleFilePath());
+    DroneConfig::MixerInfo info {};
+    EXPECT_TRUE(config.getControllerMixerInfo(info));
+    EXPECT_FALSE(config.getCompDroneDynamicsOutOfBoundsReset().has_value());
+
+    // コピーは解析済みデータを共有する
+    DroneConfig copy = config;
+    EXPECT_EQ(&config.getData(), &copy.getData());
+}
+
+TEST_F(DroneConfigTest, ParsePid)
+{
+    base["controller"] = {
+        { "pid", { { "position", { { "z", { { "Kp", 1.0 }, { "Ki", 0.1 }, { "Kd", 50.0 }, { "setpoint", -10 } } } } } } }
+    };
+    auto data = parse(base);
+    ASSERT_NE(nullptr, data);
+    DroneConfig config(data);
+    EXPECT_TRUE(config.isExistController("pid"));
+    EXPECT_DOUBLE_EQ(50.0, config.getControllerPid("position", "z", "Kd"));
+    EXPECT_DOUBLE_EQ(-10.0, config.getControllerPid("position", "z", "setpoint"));
+    EXPECT_EQ("DroneTransporter", config.getControllerModuleName());
+}
+
+TEST_F(DroneConfigTest, SchemaErrors)
+{
+    base["simulation"].erase("timeStep");
+    base["components"]["droneDynamics"]["mass_kg"] = "heavy";
+    base["components"]["droneDynamics"]["inertia"] = { 1.0, 2.0 };
+    base["components"]["rotor"].erase("dynamics_constants");
+    EXPECT_EQ(nullptr, parse(base));
+}
+
+TEST_F(DroneConfigTest, ParseBatteryThevenin)
+{
+    auto& battery = base["components"]["battery"];
+    battery["model"] = "thevenin";
+    battery["InternalResistance"] = 0.05;
+    battery["PolarizationResistance"] = 0.02;
+    battery["PolarizationCapacitance"] = 500.0;
+    auto data = parse(base);
+    ASSERT_NE(nullptr, data);
+    DroneConfig config(data);
+    const auto& params = config.getComDroneDynamicsBattery();
+    EXPECT_EQ("thevenin", params.model);
+    EXPECT_DOUBLE_EQ(0.05, params.InternalResistance);
+    EXPECT_DOUBLE_EQ(500.0, params.PolarizationCapacitance);
+    EXPECT_DOUBLE_EQ(0.0, params.CapacityTemperatureCoefficient);
+    EXPECT_DOUBLE_EQ(25.0, params.ReferenceTemperature);
+
+    battery["PolarizationResistance"] = -0.02;
+    EXPECT_EQ(nullptr, parse(base));
+}
+
+TEST_F(DroneConfigTest, ShippedConfigs)
+{
+    for (const char* name : { "/drone_config_0.json", "/rc/drone_config_0.json", "/api_sample/drone_config_0.json" }) {
+        EXPECT_NE(nullptr, drone_config_data_parse(std::string(HAKO_TEST_CONFIG_DIR) + name)) << name;
+    }
+}
@@ -0,0 +1,255 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "tools/hako_capture_analyzer.hpp"
+#include "mavlink/mavlink_capture.hpp"
+#include "mavlink/mavlink_capture_replay.hpp"
+#include "mavlink/mavlink_encoder.hpp"
+
+#define CAPTURE_TEST_FILE   "./hako_capture_tool_test.bin"
+#define CAPTURE_TEST_DIR    "./hako_capture_tool_test_out"
+
+class HakoCaptureToolTest : public ::testing::Test {
+protected:
+    static void SetUpTestCase()
+    {
+    }
+    static void TearDownTestCase()
+    {
+    }
+    virtual void SetUp()
+    {
+        std::filesystem::remove_all(CAPTURE_TEST_DIR);
+        std::filesystem::create_directory(CAPTURE_TEST_DIR);
+    }
+    virtual void TearDown()
+    {
+        std::remove(CAPTURE_TEST_FILE);
+        std::filesystem::remove_all(CAPTURE_TEST_DIR);
+    }
+};
+
+namespace {
+const uint64_t capture_start_usec = 1700000000000000ULL;
+
+bool append_message(MavlinkCaptureControllerType& controller, uint32_t owner, uint64_t time_usec, const MavlinkDecodedMessage& message)
+{
+    mavlink_message_t msg;
+    if (!mavlink_encode_message(&msg, &message)) {
+        return false;
+    }
+    char packet[MAVLINK_MAX_PACKET_LEN];
+    int len = mavlink_get_packet(packet, sizeof(packet), &msg);
+    if (len <= 0) {
+        return false;
+    }
+    return mavlink_capture_append_data_at(controller, owner, time_usec, len, (const uint8_t*)packet);
+}
+MavlinkDecodedMessage make_sensor(int i)
+{
+    MavlinkDecodedMessage m = {};
+    m.type = MAVLINK_MSG_TYPE_HIL_SENSOR;
+    m.data.sensor.time_usec = 1000 + i;
+    m.data.sensor.xacc = 0.25f * i;
+    m.data.sensor.yacc = -0.5f;
+    m.data.sensor.zacc = -9.75f;
+    m.data.sensor.xgyro = 0.125f;
+    m.data.sensor.abs_pressure = 1013.25f;
+    m.data.sensor.temperature = 20.5f + i;
+    return m;
+}
+MavlinkDecodedMessage make_actuator(int i)
+{
+    MavlinkDecodedMessage m = {};
+    m.type = MAVLINK_MSG_TYPE_HIL_ACTUATOR_CONTROLS;
+    m.data.hil_actuator_controls.time_usec = 2000 + i;
+    m.data.hil_actuator_controls.mode = 129;
+    m.data.hil_actuator_controls.flags = 1;
+    for (int k = 0; k < 4; k++) {
+        m.data.hil_actuator_controls.controls[k] = 0.5f + 0.125f * k + 0.0625f * i;
+    }
+    return m;
+}
+MavlinkDecodedMessage make_gps()
+{
+    MavlinkDecodedMessage m = {};
+    m.type = MAVLINK_MSG_TYPE_HIL_GPS;
+    m.data.hil_gps.lat = 356000000;
+    m.data.hil_gps.lon = 1397000000;
+    m.data.hil_gps.alt = 12000;
+    m.data.hil_gps.vn = -25;
+    m.data.hil_gps.satellites_visible = 10;
+    return m;
+}
+/*
+ * センサ3件(physics), アクチュエータ2件(control), GPS 1件と、壊れたパケット1件
+ */
+void write_fixture()
+{
+    MavlinkCaptureControllerType controller;
+    memset(&controller, 0, sizeof(controller));
+    ASSERT_TRUE(mavlink_capture_create_controller(controller, CAPTURE_TEST_FILE));
+    for (int i = 0; i < 3; i++) {
+        ASSERT_TRUE(append_message(controller, MAVLINK_CAPTURE_DATA_OWNER_PHYSICS, capture_start_usec + 4000 * i, make_sensor(i)));
+        if (i < 2) {
+            ASSERT_TRUE(append_message(controller, MAVLINK_CAPTURE_DATA_OWNER_CONTROL, capture_start_usec + 4000 * i + 1000, make_actuator(i)));
+        }
+    }
+    ASSERT_TRUE(append_message(controller, MAVLINK_CAPTURE_DATA_OWNER_PHYSICS, capture_start_usec + 10000, make_gps()));
+    const uint8_t garbage[] = { 0x01, 0x02, 0x03, 0x04, 0x05 };
+    ASSERT_TRUE(mavlink_capture_append_data_at(controller, MAVLINK_CAPTURE_DATA_OWNER_PHYSICS, capture_start_usec + 11000, sizeof(garbage), garbage));
+    ASSERT_TRUE(mavlink_capture_save(controller));
+    close(controller.save_file);
+    free(controller.data);
+}
+void load_fixture(std::vector<ChunkResult>& chunks, size_t& record_num)
+{
+    MavlinkCaptureControllerType controller;
+    memset(&controller, 0, sizeof(controller));
+    ASSERT_TRUE(mavlink_capture_load_controller(controller, CAPTURE_TEST_FILE));
+    std::vector<CaptureRecordRefType> index;
+    ASSERT_TRUE(capture_build_index(controller, index));
+    record_num = index.size();
+    capture_decode(controller, index, 3, chunks);
+    close(controller.save_file);
+    free(controller.data);
+}
+std::vector<std::vector<std::string>> read_csv(const std::string& path)
+{
+    std::vector<std::vector<std::string>> rows;
+    std::ifstream ifs(path);
+    std::string line;
+    while (std::getline(ifs, line)) {
+        std::vector<std::string> cols;
+        std::stringstream ss(line);
+        std::string col;
+        while (std::getline(ss, col, ',')) {
+            cols.push_back(col);
+        }
+        rows.push_back(cols);
+    }
+    return rows;
+}
+}
+
+/*
+ * 記録順にデコードし、壊れたパケットは数えて読み飛ばすこと
+ */
+TEST_F(HakoCaptureToolTest, decode_fixture)
+{
+    write_fixture();
+    std::vector<ChunkResult> chunks;
+    size_t record_num = 0;
+    load_fixture(chunks, record_num);
+    EXPECT_EQ(7u, record_num);
+
+    std::vector<CaptureDecodedRecordType> records;
+    uint64_t decode_errors = 0;
+    for (const auto& chunk : chunks) {
+        decode_errors += chunk.decode_errors;
+        records.insert(records.end(), chunk.records.begin(), chunk.records.end());
+    }
+    EXPECT_EQ(1u, decode_errors);
+    ASSERT_EQ(6u, records.size());
+    const MavlinkMsgType types[] = {
+        MAVLINK_MSG_TYPE_HIL_SENSOR, MAVLINK_MSG_TYPE_HIL_ACTUATOR_CONTROLS,
+        MAVLINK_MSG_TYPE_HIL_SENSOR, MAVLINK_MSG_TYPE_HIL_ACTUATOR_CONTROLS,
+        MAVLINK_MSG_TYPE_HIL_SENSOR, MAVLINK_MSG_TYPE_HIL_GPS
+    };
+    const uint64_t timestamps[] = { 0, 1000, 4000, 5000, 8000, 10000 };
+    for (size_t i = 0; i < records.size(); i++) {
+        EXPECT_EQ(types[i], records[i].message.type) << i;
+        EXPECT_EQ(timestamps[i], records[i].timestamp) << i;
+    }
+    EXPECT_EQ((uint32_t)MAVLINK_CAPTURE_DATA_OWNER_CONTROL, records[1].owner);
+    EXPECT_EQ((uint32_t)MAVLINK_CAPTURE_DATA_OWNER_PHYSICS, records[2].owner);
+}
+
+/*
+ * CSV に変換して読み戻し、元のメッセージと同じ値になること
+ */
+TEST_F(HakoCaptureToolTest, csv_round_trip)
+{
+    write_fixture();
+    std::vector<ChunkResult> chunks;
+    size_t record_num = 0;
+    load_fixture(chunks, record_num);
+    ASSERT_TRUE(capture_write_outputs(chunks, CAPTURE_TEST_DIR, true, 2));
+
+    auto sensor = read_csv(std::string(CAPTURE_TEST_DIR) + "/HIL_SENSOR_physics.csv");
+    ASSERT_EQ(4u, sensor.size());
+    EXPECT_EQ("timestamp", sensor[0][0]);
+    EXPECT_EQ("xacc", sensor[0][1]);
+    for (int i = 0; i < 3; i++) {
+        const auto& row = sensor[i + 1];
+        const mavlink_hil_sensor_t expected = make_sensor(i).data.sensor;
+        ASSERT_EQ(14u, row.size());
+        EXPECT_EQ(4000u * i, std::stoull(row[0]));
+        EXPECT_NEAR(expected.xacc, std::stod(row[1]), 1e-6);
+        EXPECT_NEAR(expected.yacc, std::stod(row[2]), 1e-6);
+        EXPECT_NEAR(expected.zacc, std::stod(row[3]), 1e-6);
+        EXPECT_NEAR(expected.xgyro, std::stod(row[4]), 1e-6);
+        EXPECT_NEAR(expected.abs_pressure, std::stod(row[10]), 1e-4);
+        EXPECT_NEAR(expected.temperature, std::stod(row[13]), 1e-6);
+    }
+
+    auto actuator = read_csv(std::string(CAPTURE_TEST_DIR) + "/HIL_ACTUATOR_CONTROLS_control.csv");
+    ASSERT_EQ(3u, actuator.size());
+    for (int i = 0; i < 2; i++) {
+        const auto& row = actuator[i + 1];
+        const mavlink_hil_actuator_controls_t expected = make_actuator(i).data.hil_actuator_controls;
+        ASSERT_EQ(19u, row.size());
+        EXPECT_EQ(4000u * i + 1000, std::stoull(row[0]));
+        EXPECT_EQ(expected.mode, std::stoul(row[1]));
+        EXPECT_EQ(expected.flags, std::stoull(row[2]));
+        for (int k = 0; k < 16; k++) {
+            EXPECT_NEAR(expected.controls[k], std::stod(row[3 + k]), 1e-6);
+        }
+    }
+
+    auto gps = read_csv(std::string(CAPTURE_TEST_DIR) + "/HIL_GPS_physics.csv");
+    ASSERT_EQ(2u, gps.size());
+    EXPECT_EQ(356000000, std::stoi(gps[1][1]));
+    EXPECT_EQ(1397000000, std::stoi(gps[1][2]));
+    EXPECT_EQ(-25, std::stoi(gps[1][7]));
+    EXPECT_EQ(10, std::stoi(gps[1][11]));
+}
+
+/*
+ * バイナリに変換して読み戻し、デコードしたメッセージとバイト単位で一致すること
+ */
+TEST_F(HakoCaptureToolTest, binary_round_trip)
+{
+    write_fixture();
+    std::vector<ChunkResult> chunks;
+    size_t record_num = 0;
+    load_fixture(chunks, record_num);
+    ASSERT_TRUE(capture_write_outputs(chunks, CAPTURE_TEST_DIR, false, 1));
+
+    std::ifstream ifs(std::string(CAPTURE_TEST_DIR) + "/HIL_SENSOR_physics.bin", std::ios::binary);
+    ASSERT_TRUE(ifs.is_open());
+    const size_t record_size = sizeof(CaptureBinaryRecordHeaderType) + sizeof(MavlinkDecodedMessage::data);
+    std::vector<char> buf((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    ASSERT_EQ(3 * record_size, buf.size());
+    for (int i = 0; i < 3; i++) {
+        CaptureBinaryRecordHeaderType hdr;
+        MavlinkDecodedMessage message = {};
+        memcpy(&hdr, &buf[i * record_size], sizeof(hdr));
+        memcpy(&message.data, &buf[i * record_size + sizeof(hdr)], sizeof(message.data));
+        EXPECT_EQ(4000u * i, hdr.timestamp);
+        EXPECT_EQ((uint32_t)MAVLINK_CAPTURE_DATA_OWNER_PHYSICS, hdr.owner);
+        EXPECT_EQ((uint32_t)MAVLINK_MSG_TYPE_HIL_SENSOR, hdr.type);
+        const mavlink_hil_sensor_t expected = make_sensor(i).data.sensor;
+        EXPECT_EQ(expected.time_usec, message.data.sensor.time_usec);
+        EXPECT_EQ(expected.xacc, message.data.sensor.xacc);
+        EXPECT_EQ(expected.temperature, message.data.sensor.temperature);
+    }
+    EXPECT_FALSE(std::filesystem::exists(std::string(CAPTURE_TEST_DIR) + "/HIL_SENSOR_control.bin"));
+}
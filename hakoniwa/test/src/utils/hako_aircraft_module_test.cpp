@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include <iostream>
+#include <utility>
+#include <vector>
+#include "utils/hako_aircraft_module.hpp"
+
+class HakoAircraftModuleTest : public ::testing::Test {
+protected:
+    static void SetUpTestCase()
+    {
+    }
+    static void TearDownTestCase()
+    {
+    }
+    virtual void SetUp()
+    {
+    }
+    virtual void TearDown()
+    {
+    }
+
+};
+
+namespace {
+int run_count = 0;
+std::vector<int> batch_sizes;
+/* 呼ばれた run_batch の種類('A', 'B')と機体数 */
+std::vector<std::pair<char, int>> batch_calls;
+
+mi_drone_control_out_t fake_run(mi_drone_control_in_t *in)
+{
+    run_count++;
+    mi_drone_control_out_t out = {};
+    out.thrust = in->mass;
+    return out;
+}
+void fake_run_batch(const mi_drone_control_in_t *ins, mi_drone_control_out_t *outs, int n)
+{
+    batch_sizes.push_back(n);
+    for (int i = 0; i < n; i++) {
+        outs[i] = {};
+        outs[i].thrust = ins[i].mass * 10;
+    }
+}
+void fake_run_batch_a(const mi_drone_control_in_t *ins, mi_drone_control_out_t *outs, int n)
+{
+    batch_calls.push_back({ 'A', n });
+    fake_run_batch(ins, outs, n);
+}
+void fake_run_batch_b(const mi_drone_control_in_t *ins, mi_drone_control_out_t *outs, int n)
+{
+    batch_calls.push_back({ 'B', n });
+    for (int i = 0; i < n; i++) {
+        outs[i] = {};
+        outs[i].thrust = ins[i].mass * 100;
+    }
+}
+HakoModuleDroneControllerType fake_controller = { nullptr, nullptr, nullptr, fake_run };
+
+AirCraftModule make_module(bool v2)
+{
+    AirCraftModule module;
+    module.control_module.controller = &fake_controller;
+    module.control_module.run_batch = v2 ? fake_run_batch : nullptr;
+    return module;
+}
+}
+
+/*
+ * 連続した v2 モジュールの機体はまとめて run_batch を呼び、
+ * v1 モジュールの機体と制御しない機体で区切られること
+ */
+TEST_F(HakoAircraftModuleTest, controller_batch_grouping)
+{
+    std::vector<AirCraftModule> modules = {
+        make_module(true), make_module(true), make_module(false), make_module(true), make_module(true), make_module(true)
+    };
+    std::vector<bool> active = { true, true, true, false, true, true };
+    std::vector<mi_drone_control_in_t> ins(modules.size());
+    for (size_t i = 0; i < ins.size(); i++) {
+        ins[i] = {};
+        ins[i].mass = i + 1;
+    }
+    std::vector<mi_drone_control_out_t> outs(modules.size());
+    for (auto& out : outs) {
+        out = {};
+        out.thrust = -1;
+    }
+    run_count = 0;
+    batch_sizes.clear();
+
+    AirCraftControllerBatch batch;
+    batch.resize(modules.size());
+    batch.run(modules, active, [&](int index) -> mi_drone_control_in_t& {
+        return ins[index];
+    }, outs);
+
+    EXPECT_EQ(1, run_count);
+    ASSERT_EQ(2u, batch_sizes.size());
+    EXPECT_EQ(2, batch_sizes[0]);
+    /* 制御しない機体は飛ばして、同じモジュールの機体をまとめる */
+    EXPECT_EQ(2, batch_sizes[1]);
+    EXPECT_DOUBLE_EQ(10, outs[0].thrust);
+    EXPECT_DOUBLE_EQ(20, outs[1].thrust);
+    EXPECT_DOUBLE_EQ(3, outs[2].thrust);
+    EXPECT_DOUBLE_EQ(-1, outs[3].thrust);
+    EXPECT_DOUBLE_EQ(50, outs[4].thrust);
+    EXPECT_DOUBLE_EQ(60, outs[5].thrust);
+}
+
+/*
+ * 異なる v2 モジュールと v1 モジュールが混在する場合、モジュールが変わるところで
+ * バッチを区切り、各機体の出力が自分のモジュールの結果になること
+ */
+TEST_F(HakoAircraftModuleTest, controller_batch_v1_v2_mix)
+{
+    /* A A B v1 B A (A: 制御しない) A */
+    const char kinds[] = { 'A', 'A', 'B', '1', 'B', 'A', 'A', 'A' };
+    const size_t num = sizeof(kinds);
+    std::vector<AirCraftModule> modules;
+    for (size_t i = 0; i < num; i++) {
+        AirCraftModule module = make_module(false);
+        if (kinds[i] == 'A') {
+            module.control_module.run_batch = fake_run_batch_a;
+        }
+        else if (kinds[i] == 'B') {
+            module.control_module.run_batch = fake_run_batch_b;
+        }
+        modules.push_back(module);
+    }
+    std::vector<bool> active(num, true);
+    active[6] = false;
+    std::vector<mi_drone_control_in_t> ins(num);
+    for (size_t i = 0; i < num; i++) {
+        ins[i] = {};
+        ins[i].mass = i + 1;
+    }
+    std::vector<mi_drone_control_out_t> outs(num);
+    for (auto& out : outs) {
+        out = {};
+        out.thrust = -1;
+    }
+    run_count = 0;
+    batch_calls.clear();
+
+    AirCraftControllerBatch batch;
+    batch.resize(num);
+    /* 2回目も同じ作業領域で同じ結果になること */
+    for (int loop = 0; loop < 2; loop++) {
+        batch.run(modules, active, [&](int index) -> mi_drone_control_in_t& {
+            return ins[index];
+        }, outs);
+    }
+
+    EXPECT_EQ(2, run_count);
+    const std::vector<std::pair<char, int>> expected_calls = {
+        { 'A', 2 }, { 'B', 1 }, { 'B', 1 }, { 'A', 2 },
+        { 'A', 2 }, { 'B', 1 }, { 'B', 1 }, { 'A', 2 },
+    };
+    EXPECT_EQ(expected_calls, batch_calls);
+    const double expected_thrust[] = { 10, 20, 300, 4, 500, 60, -1, 80 };
+    for (size_t i = 0; i < num; i++) {
+        EXPECT_DOUBLE_EQ(expected_thrust[i], outs[i].thrust) << "vehicle " << i;
+    }
+}
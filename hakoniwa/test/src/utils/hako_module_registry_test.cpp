@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include "utils/hako_aircraft_module.hpp"
+
+class HakoModuleRegistryTest : public ::testing::Test {
+protected:
+    static void SetUpTestCase()
+    {
+    }
+    static void TearDownTestCase()
+    {
+    }
+    virtual void SetUp()
+    {
+        std::filesystem::create_directories(registry_test_dir + "/sub");
+    }
+    virtual void TearDown()
+    {
+        std::filesystem::remove_all(registry_test_dir);
+    }
+    static const std::string registry_test_dir;
+};
+const std::string HakoModuleRegistryTest::registry_test_dir = "./hako_module_registry_test";
+
+/*
+ * 別のパス表記(相対パス, "..", シンボリックリンク)でも同じファイルなら
+ * 1回だけロードし、同じシンボルテーブルを返すこと
+ */
+TEST_F(HakoModuleRegistryTest, same_file_shares_handle)
+{
+    std::string module_path = registry_test_dir + "/controller.so";
+    std::filesystem::copy_file(HAKO_TEST_CONTROLLER_MODULE, module_path);
+    std::string link_path = registry_test_dir + "/sub/link.so";
+    std::filesystem::create_symlink(std::filesystem::absolute(module_path), link_path);
+
+    HakoControllerModuleRegistry registry;
+    const AircraftControlModuleType* m0 = registry.load(module_path);
+    const AircraftControlModuleType* m1 = registry.load(registry_test_dir + "/sub/../controller.so");
+    const AircraftControlModuleType* m2 = registry.load(link_path);
+    const AircraftControlModuleType* m3 = registry.load(std::filesystem::absolute(module_path).string());
+    ASSERT_NE(nullptr, m0);
+    EXPECT_EQ(m0, m1);
+    EXPECT_EQ(m0, m2);
+    EXPECT_EQ(m0, m3);
+    EXPECT_EQ(1u, registry.size());
+    EXPECT_NE(nullptr, m0->handle);
+    EXPECT_NE(nullptr, m0->controller);
+    /* v1 モジュールなので拡張エントリはない */
+    EXPECT_EQ(nullptr, m0->run_batch);
+    EXPECT_EQ(nullptr, m0->get_state_size);
+
+    /* 別のファイルは別のエントリ */
+    std::string other_path = registry_test_dir + "/other.so";
+    std::filesystem::copy_file(HAKO_TEST_CONTROLLER_MODULE, other_path);
+    EXPECT_NE(nullptr, registry.load(other_path));
+    EXPECT_EQ(2u, registry.size());
+}
+
+/*
+ * ロードに失敗したファイルは記録し、後から正しいモジュールに置き換えても
+ * 機体ごとにロードし直さないこと
+ */
+TEST_F(HakoModuleRegistryTest, failed_load_is_cached)
+{
+    std::string module_path = registry_test_dir + "/broken.so";
+    {
+        std::ofstream ofs(module_path);
+        ofs << "not a shared object" << std::endl;
+    }
+    HakoControllerModuleRegistry registry;
+    EXPECT_EQ(nullptr, registry.load(module_path));
+    EXPECT_EQ(1u, registry.size());
+
+    std::filesystem::copy_file(HAKO_TEST_CONTROLLER_MODULE, module_path, std::filesystem::copy_options::overwrite_existing);
+    for (int vehicle = 1; vehicle < 4; vehicle++) {
+        EXPECT_EQ(nullptr, registry.load(module_path)) << "vehicle " << vehicle;
+    }
+    EXPECT_EQ(1u, registry.size());
+
+    /* 新しいレジストリでは正しくロードできる */
+    HakoControllerModuleRegistry retry;
+    EXPECT_NE(nullptr, retry.load(module_path));
+}
+
+/*
+ * 制御モジュールもフォールバックの PID もない機体は、制御出力が 0 になること
+ */
+TEST_F(HakoModuleRegistryTest, no_controller_zero_output)
+{
+    std::string module_path = registry_test_dir + "/controller.so";
+    std::filesystem::copy_file(HAKO_TEST_CONTROLLER_MODULE, module_path);
+    HakoControllerModuleRegistry registry;
+    const AircraftControlModuleType* module = registry.load(module_path);
+    ASSERT_NE(nullptr, module);
+
+    std::vector<AirCraftModule> modules(2);
+    ASSERT_TRUE(modules[0].load_controller(*module, nullptr));
+    EXPECT_TRUE(modules[0].has_controller());
+    EXPECT_FALSE(modules[1].has_controller());
+
+    std::vector<mi_drone_control_in_t> ins(2);
+    for (auto& in : ins) {
+        in = {};
+        in.mass = 1.0;
+    }
+    std::vector<mi_drone_control_out_t> outs(2);
+    for (auto& out : outs) {
+        out = {};
+        out.thrust = -1;
+        out.torque_x = -1;
+    }
+    AirCraftControllerBatch batch;
+    batch.resize(modules.size());
+    batch.run(modules, { true, true }, [&](int index) -> mi_drone_control_in_t& {
+        return ins[index];
+    }, outs);
+    EXPECT_DOUBLE_EQ(1.5, outs[0].thrust);
+    EXPECT_DOUBLE_EQ(0, outs[1].thrust);
+    EXPECT_DOUBLE_EQ(0, outs[1].torque_x);
+    EXPECT_DOUBLE_EQ(0, outs[1].torque_y);
+    EXPECT_DOUBLE_EQ(0, outs[1].torque_z);
+}
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include "utils/hako_profiler.hpp"
+
+class HakoProfilerTest : public ::testing::Test {
+protected:
+    static void SetUpTestCase()
+    {
+    }
+    static void TearDownTestCase()
+    {
+    }
+    virtual void SetUp()
+    {
+    }
+    virtual void TearDown()
+    {
+    }
+};
+
+TEST_F(HakoProfilerTest, HistogramBucket)
+{
+    // バケットの上限値は値より大きく、相対誤差は 1/16 以内
+    for (uint64_t v : { 0ULL, 1ULL, 15ULL, 16ULL, 17ULL, 31ULL, 32ULL, 1000ULL, 123456ULL, 999999999ULL }) {
+        int index = HakoProfHistogram::bucket_index(v);
+        uint64_t upper = HakoProfHistogram::bucket_upper(index);
+        EXPECT_GT(upper, v);
+        if (v >= HAKO_PROF_HIST_SUB_NUM) {
+            EXPECT_LE(static_cast<double>(upper - v), static_cast<double>(v) / HAKO_PROF_HIST_SUB_NUM + 1.0);
+        }
+        if (index > 0) {
+            EXPECT_LE(HakoProfHistogram::bucket_upper(index - 1), v);
+        }
+    }
+    // 範囲外はすべて最後のバケット
+    EXPECT_EQ(HAKO_PROF_HIST_BUCKET_NUM - 1, HakoProfHistogram::bucket_index(~0ULL));
+}
+
+TEST_F(HakoProfilerTest, HistogramQuantile)
+{
+    HakoProfHistogram hist;
+    for (uint64_t v = 1; v <= 1000; v++) {
+        hist.record(v * 1000);  // 1usec - 1msec
+    }
+    EXPECT_EQ(1000u, hist.get_count());
+    EXPECT_EQ(1000000u, hist.get_max_ns());
+    std::vector<uint64_t> buckets;
+    hist.snapshot(buckets);
+    uint64_t p50 = HakoProfHistogram::quantile(buckets, 0.5);
+    uint64_t p99 = HakoProfHistogram::quantile(buckets, 0.99);
+    EXPECT_NEAR(500000.0, static_cast<double>(p50), 500000.0 / 16);
+    EXPECT_NEAR(990000.0, static_cast<double>(p99), 990000.0 / 16);
+}
+
+TEST_F(HakoProfilerTest, PrometheusText)
+{
+    std::string path = ::testing::TempDir() + "hako_profile_test.prom";
+    setenv("HAKO_PROFILER_OUTPUT", path.c_str(), 1);
+    setenv("HAKO_PROFILER_INTERVAL_MSEC", "10", 1);
+    HakoProfiler profiler;
+    profiler.start(2, 1000000);
+    profiler.record(HAKO_PROF_THRUST, 1, profiler.now());
+    profiler.record(HAKO_PROF_STEP, -1, 0);   // 予算超過
+    std::string text = profiler.to_prometheus();
+    EXPECT_NE(std::string::npos, text.find("# TYPE hako_step_stage_duration_seconds histogram"));
+    EXPECT_NE(std::string::npos, text.find("hako_step_stage_duration_seconds_count{thread=\"0\",aircraft=\"1\",stage=\"thrust\"} 1"));
+    EXPECT_NE(std::string::npos, text.find("hako_step_stage_duration_seconds_bucket{thread=\"0\",aircraft=\"all\",stage=\"step\",le=\"+Inf\"} 1"));
+    EXPECT_NE(std::string::npos, text.find("hako_step_budget_overrun_total{thread=\"0\"} 1"));
+    EXPECT_EQ(std::string::npos, text.find("stage=\"gyro\""));
+
+    // 出力スレッドがファイルに書き出す
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    profiler.stop();
+    std::ifstream ifs(path);
+    ASSERT_TRUE(ifs.is_open());
+    std::stringstream ss;
+    ss << ifs.rdbuf();
+    EXPECT_NE(std::string::npos, ss.str().find("stage=\"thrust\""));
+    unsetenv("HAKO_PROFILER_OUTPUT");
+    unsetenv("HAKO_PROFILER_INTERVAL_MSEC");
+}
@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include "utils/hako_replayer.hpp"
+
+#define REPLAY_TEST_CSV "./hako_replayer_test.csv"
+
+class HakoReplayerTest : public ::testing::Test {
+protected:
+    static void SetUpTestCase()
+    {
+    }
+    static void TearDownTestCase()
+    {
+    }
+    virtual void SetUp()
+    {
+        // 10ms 周期で記録されたログ(3行目は欠落)
+        std::ofstream f(REPLAY_TEST_CSV);
+        f << "timestamp,X,Y,Z,Rx,Ry,Rz,Vx,Vy,Vz,VRx,VRy,VRz,Thrust,Tx,Ty,Tz\n";
+        f << "0,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0\n";
+        f << "10000,1,2,3,0,0,0.2,0,0,0,0,0,0,2,0,0,0\n";
+        f << "30000,3,6,9,0,0,0.6,0,0,0,0,0,0,4,0,0,0\n";
+        f << "40000,4,8,12,0,0,0.8,0,0,0,0,0,0,5,0,0,0\n";
+        f << "40000,4,8,12,0,0,0.8,0,0,0,0,0,0,5,0,0,0\n";
+    }
+    virtual void TearDown()
+    {
+        std::remove(REPLAY_TEST_CSV);
+    }
+};
+
+TEST_F(HakoReplayerTest, interpolate_gap_001)
+{
+    HakoReplayer replayer;
+    replayer.add_vehicle("drone", REPLAY_TEST_CSV);
+    HakoReplaySample sample;
+
+    // 5ms 刻みで再生すると、欠落区間(10ms-30ms)も補間される
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(replayer.next("drone", 5000, sample));
+    }
+    EXPECT_EQ(20000u, sample.timestamp_usec);
+    EXPECT_NEAR(2.0, sample.pos[0], 1e-9);
+    EXPECT_NEAR(4.0, sample.pos[1], 1e-9);
+    EXPECT_NEAR(6.0, sample.pos[2], 1e-9);
+    EXPECT_NEAR(3.0, sample.thrust, 1e-9);
+    EXPECT_NEAR(0.4, sample.euler[2], 1e-9);
+}
+
+TEST_F(HakoReplayerTest, seek_pause_rate_001)
+{
+    HakoReplayer replayer;
+    replayer.add_vehicle("drone", REPLAY_TEST_CSV);
+    HakoReplaySample sample;
+
+    HakoReplayControl ctrl = { true, 1.0, 1, 0.035 };
+    replayer.apply_control("drone", ctrl);
+    EXPECT_TRUE(replayer.next("drone", 5000, sample));
+    EXPECT_NEAR(3.5, sample.pos[0], 1e-9);
+    // 一時停止中は時刻が進まない
+    EXPECT_TRUE(replayer.next("drone", 5000, sample));
+    EXPECT_NEAR(3.5, sample.pos[0], 1e-9);
+
+    // 同じ要求番号ではシークしない
+    ctrl = { false, 0.5, 1, 0.0 };
+    replayer.apply_control("drone", ctrl);
+    EXPECT_TRUE(replayer.next("drone", 2000, sample));
+    EXPECT_NEAR(3.6, sample.pos[0], 1e-9);
+
+    // 終端を越えると false
+    EXPECT_FALSE(replayer.next("drone", 100000, sample));
+}
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include "utils/hako_rtf_monitor.hpp"
+
+class HakoRtfMonitorTest : public ::testing::Test {
+protected:
+    static void SetUpTestCase()
+    {
+    }
+    static void TearDownTestCase()
+    {
+    }
+    virtual void SetUp()
+    {
+    }
+    virtual void TearDown()
+    {
+    }
+};
+
+TEST_F(HakoRtfMonitorTest, RealTimeFactor)
+{
+    HakoRtfMonitor monitor;
+    monitor.init(1000);
+    uint64_t now = 5000000;
+    EXPECT_TRUE(monitor.step(now));     // 最初のステップは基準のみ
+    for (int i = 0; i < 100; i++) {
+        now += 2000;                    // 実時間の半分の速さ
+        EXPECT_TRUE(monitor.step(now));
+    }
+    EXPECT_EQ(100u, monitor.get_steps());
+    EXPECT_DOUBLE_EQ(0.5, monitor.get_rtf());
+    EXPECT_EQ(100u, monitor.get_misses());
+    EXPECT_EQ(100u, monitor.get_miss_streak_max());
+    EXPECT_EQ(2000u, monitor.get_period_max_usec());
+}
+
+TEST_F(HakoRtfMonitorTest, DeadlineMiss)
+{
+    HakoRtfMonitor monitor;
+    monitor.init(1000);
+    uint64_t now = 0;
+    monitor.step(now);
+    for (int i = 0; i < 10; i++) {
+        // 3 ステップ連続の遅れを 1 回だけ入れる
+        now += (i >= 4 && i < 7) ? 1500 : 1000;
+        monitor.step(now);
+    }
+    EXPECT_EQ(3u, monitor.get_misses());
+    EXPECT_EQ(3u, monitor.get_miss_streak_max());
+    EXPECT_DOUBLE_EQ(0.3, monitor.get_miss_rate());
+
+    // デッドラインを緩めると超過しない
+    monitor.stop();
+    EXPECT_EQ(0u, monitor.get_steps());
+    monitor.set_deadline_usec(2000);
+    monitor.step(now);
+    now += 1500;
+    monitor.step(now);
+    EXPECT_EQ(0u, monitor.get_misses());
+}
+
+TEST_F(HakoRtfMonitorTest, MissRateThreshold)
+{
+    HakoRtfMonitor monitor;
+    monitor.init(1000);
+    monitor.set_miss_rate_max(0.1, 10);
+    uint64_t now = 0;
+    monitor.step(now);
+    // 最小ステップ数までは判定しない
+    for (int i = 0; i < 9; i++) {
+        now += 5000;
+        EXPECT_TRUE(monitor.step(now));
+    }
+    // 超過率 10/10
+    now += 5000;
+    EXPECT_FALSE(monitor.step(now));
+    EXPECT_TRUE(monitor.is_failed());
+    // 一度失敗したら戻らない
+    now += 1000;
+    EXPECT_FALSE(monitor.step(now));
+}
+
+TEST_F(HakoRtfMonitorTest, Skew)
+{
+    HakoRtfMonitor monitor;
+    monitor.init(1000);
+    EXPECT_EQ(0u, monitor.get_skew_count());
+    EXPECT_EQ(0, monitor.get_skew_min_usec());
+    monitor.record_skew(-300);
+    monitor.record_skew(100);
+    monitor.record_skew(500);
+    EXPECT_EQ(3u, monitor.get_skew_count());
+    EXPECT_EQ(-300, monitor.get_skew_min_usec());
+    EXPECT_EQ(500, monitor.get_skew_max_usec());
+    EXPECT_DOUBLE_EQ(100.0, monitor.get_skew_mean_usec());
+    EXPECT_NE(std::string::npos, monitor.summary(0).find("px4_skew_usec(last/min/max/mean)=500/-300/500/100"));
+}
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include "utils/hako_spsc_queue.hpp"
+
+class HakoSpscQueueTest : public ::testing::Test {
+protected:
+    static void SetUpTestCase()
+    {
+    }
+    static void TearDownTestCase()
+    {
+    }
+    virtual void SetUp()
+    {
+    }
+    virtual void TearDown()
+    {
+    }
+};
+
+TEST_F(HakoSpscQueueTest, PushPopFull)
+{
+    hako::utils::SpscQueue<int, 4> queue;
+    int value = -1;
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.try_pop(value));
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.try_push(i));
+    }
+    // 満杯なら push は失敗する
+    EXPECT_FALSE(queue.try_push(4));
+    EXPECT_EQ(4u, queue.size());
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.try_pop(value));
+        EXPECT_EQ(i, value);
+    }
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST_F(HakoSpscQueueTest, ReserveCommit)
+{
+    hako::utils::SpscQueue<int, 2> queue;
+    int* slot = queue.reserve();
+    ASSERT_NE(nullptr, slot);
+    *slot = 10;
+    // commit 前は consumer から見えない
+    EXPECT_EQ(nullptr, queue.front());
+    queue.commit();
+    ASSERT_NE(nullptr, queue.front());
+    EXPECT_EQ(10, *queue.front());
+    queue.release();
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST_F(HakoSpscQueueTest, TwoThreadsKeepOrder)
+{
+    static hako::utils::SpscQueue<uint64_t, 64> queue;
+    const uint64_t num = 10000;
+    std::thread producer([&]() {
+        for (uint64_t i = 0; i < num; i++) {
+            while (!queue.try_push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    uint64_t expected = 0;
+    while (expected < num) {
+        uint64_t value;
+        if (queue.try_pop(value)) {
+            ASSERT_EQ(expected, value);
+            expected++;
+        }
+    }
+    producer.join();
+    EXPECT_TRUE(queue.empty());
+}
@@ -0,0 +1,233 @@
+#include <gtest/gtest.h>
+#include <iostream>
+#include <vector>
+#include "utils/hako_state_snapshot.hpp"
+#include "aircraft/aricraft.hpp"
+#include "body_frame/drone_dynamics_body_frame.hpp"
+#include "rotor/rotor_dynamics.hpp"
+#include "thruster/thrust_dynamics_nonlinear.hpp"
+#include "battery/battery_dynamics.hpp"
+#include "sensors/acc/sensor_acceleration.hpp"
+#include "sensors/baro/sensor_baro.hpp"
+#include "sensors/gps/sensor_gps.hpp"
+#include "sensors/gyro/sensor_gyro.hpp"
+#include "sensors/mag/sensor_mag.hpp"
+#include "utils/sensor_noise.hpp"
+
+class HakoStateSnapshotTest : public ::testing::Test {
+protected:
+    static void SetUpTestCase()
+    {
+    }
+    static void TearDownTestCase()
+    {
+    }
+    virtual void SetUp()
+    {
+    }
+    virtual void TearDown()
+    {
+    }
+
+};
+using namespace hako::assets::drone;
+
+namespace {
+const double snapshot_dt = 0.001;
+
+/*
+ * aircraft_factory と同じ構成の機体(ログなし)
+ */
+AirCraft* create_snapshot_aircraft()
+{
+    auto drone = new AirCraft();
+    auto dynamics = new DroneDynamicsBodyFrame(snapshot_dt);
+    dynamics->set_mass(0.1);
+    dynamics->set_torque_constants(0.001, 0.001, 0.001);
+    dynamics->set_drag(0.01, 0);
+    DronePositionType pos;
+    pos.data = { 0, 0, -10 };
+    dynamics->set_pos(pos);
+    DroneEulerType angle;
+    angle.data = { 0, 0, 0 };
+    dynamics->set_angle(angle);
+    drone->set_drone_dynamics(dynamics);
+
+    BatteryModelParameters battery_params = {};
+    battery_params.model = "thevenin";
+    battery_params.NominalVoltage = 14.8;
+    battery_params.NominalCapacity = 4.0;
+    battery_params.VoltageLevelGreen = 12.1;
+    battery_params.VoltageLevelYellow = 11.1;
+    battery_params.CapacityLevelYellow = 3.0;
+    battery_params.EODVoltage = 3.0;
+    battery_params.InternalResistance = 0.05;
+    battery_params.PolarizationResistance = 0.02;
+    battery_params.PolarizationCapacitance = 500.0;
+    battery_params.ReferenceTemperature = 25.0;
+    auto battery = new BatteryDynamics(snapshot_dt);
+    battery->set_params(battery_params);
+    drone->set_battery_dynamics(battery);
+
+    RotorBatteryModelConstants constants = {};
+    constants.R = 0.1;
+    constants.K = 0.01;
+    constants.D = 0.0001;
+    constants.J = 0.0001;
+    constants.Cq = 1e-9;
+    IRotorDynamics* rotors[ROTOR_NUM_MAX];
+    for (int i = 0; i < ROTOR_NUM; i++) {
+        auto rotor = new RotorDynamics(snapshot_dt);
+        rotor->set_battery_dynamics_constants(constants);
+        rotor->set_params(2000, 0, 2000);
+        battery->add_device(*rotor);
+        rotors[i] = rotor;
+    }
+    drone->set_rotor_dynamics(rotors, ROTOR_NUM);
+
+    auto thrust = new ThrustDynamicsNonLinear(snapshot_dt);
+    thrust->set_params(1e-7, 1e-9, 1e-6);
+    drone->set_thrus_dynamics(thrust);
+
+    auto acc = new SensorAcceleration(snapshot_dt, 3);
+    acc->set_noise(new SensorNoise(0.03, 0, 0));
+    drone->set_acc(acc);
+    auto gyro = new SensorGyro(snapshot_dt, 3);
+    gyro->set_noise(new SensorNoise(0.01, 0, 1));
+    drone->set_gyro(gyro);
+    auto mag = new SensorMag(snapshot_dt, 3);
+    mag->set_params(1000, 0.5, 0.1);
+    drone->set_mag(mag);
+    auto baro = new SensorBaro(snapshot_dt, 3);
+    baro->init_pos(35, 139, 0);
+    baro->set_noise(new SensorNoise(0.1, 0, 3));
+    drone->set_baro(baro);
+    auto gps = new SensorGps(snapshot_dt, 3);
+    gps->init_pos(35, 139, 0);
+    drone->set_gps(gps);
+    drone->reset();
+    return drone;
+}
+/*
+ * 1ステップ進めて、観測値(位置, 姿勢, ロータ, 電圧, ノイズ付きのセンサ値)を返す
+ */
+std::vector<double> step_snapshot_aircraft(AirCraft& drone, int step)
+{
+    DroneDynamicsInputType input = {};
+    input.no_use_actuator = false;
+    for (int i = 0; i < ROTOR_NUM; i++) {
+        input.controls[i] = 0.6 + 0.1 * ((step + i) % 3);
+    }
+    input.disturbance.values.d_temp.value = 25.0;
+    drone.run(input);
+    auto pos = drone.get_drone_dynamics().get_pos();
+    auto angle = drone.get_drone_dynamics().get_angle();
+    auto acc = drone.get_acc().sensor_value();
+    auto gyro = drone.get_gyro().sensor_value();
+    return {
+        pos.data.x, pos.data.y, pos.data.z, angle.data.x, angle.data.y, angle.data.z,
+        drone.get_battery_dynamics()->get_vbat(),
+        acc.data.x, acc.data.y, acc.data.z, gyro.data.x, gyro.data.y, gyro.data.z,
+        drone.get_baro().sensor_value().abs_pressure
+    };
+}
+}
+
+/*
+ * 隣り合う領域はまとめ、保存・復元は登録順のバイト列で行うこと
+ */
+TEST_F(HakoStateSnapshotTest, regions_save_restore)
+{
+    struct {
+        double a;
+        double b[3];
+        int c;
+    } state = { 1, { 2, 3, 4 }, 5 };
+    double other = 6;
+
+    HakoStateRegions regions;
+    regions.add(state.a);
+    regions.add(state.b);
+    regions.add(other);
+    regions.add(state.c);
+    EXPECT_EQ(sizeof(double) * 5 + sizeof(int), regions.size());
+    EXPECT_EQ(3u, regions.region_num());
+
+    std::vector<uint8_t> buf(regions.size());
+    regions.save(buf.data());
+    state = { -1, { -2, -3, -4 }, -5 };
+    other = -6;
+    regions.restore(buf.data());
+    EXPECT_EQ(1, state.a);
+    EXPECT_EQ(4, state.b[2]);
+    EXPECT_EQ(6, other);
+    EXPECT_EQ(5, state.c);
+}
+
+/*
+ * 移動平均の窓とノイズの乱数系列も復元し、同じ値を再現すること
+ */
+TEST_F(HakoStateSnapshotTest, sensor_window_and_noise)
+{
+    SensorDataAssembler assembler(3);
+    SensorNoise noise(0.1, 1, 2);
+    HakoStateRegions regions;
+    assembler.add_state_regions(regions);
+    noise.add_state_regions(regions);
+
+    assembler.add_data(1);
+    assembler.add_data(2);
+    std::vector<uint8_t> buf(regions.size());
+    regions.save(buf.data());
+    assembler.add_data(6);
+    assembler.add_data(7);
+    double value = assembler.get_calculated_value();
+    double n0 = noise.add_random_noise(0);
+    double n1 = noise.add_random_noise(0);
+    EXPECT_EQ(5, value);
+
+    regions.restore(buf.data());
+    EXPECT_EQ(2, assembler.size());
+    EXPECT_EQ(1.5, assembler.get_calculated_value());
+    assembler.add_data(6);
+    assembler.add_data(7);
+    EXPECT_EQ(value, assembler.get_calculated_value());
+    EXPECT_EQ(n0, noise.add_random_noise(0));
+    EXPECT_EQ(n1, noise.add_random_noise(0));
+}
+
+/*
+ * 機体の途中の状態から分岐したとき、何度復元しても同じ軌跡になること
+ */
+TEST_F(HakoStateSnapshotTest, aircraft_branch)
+{
+    AirCraft* drone = create_snapshot_aircraft();
+    for (int step = 0; step < 500; step++) {
+        step_snapshot_aircraft(*drone, step);
+    }
+    std::vector<uint8_t> snapshot(drone->get_state_size());
+    drone->save_state(snapshot.data());
+
+    std::vector<std::vector<double>> expected;
+    for (int step = 500; step < 700; step++) {
+        expected.push_back(step_snapshot_aircraft(*drone, step));
+    }
+    EXPECT_NE(expected.front()[2], expected.back()[2]);
+
+    for (int branch = 0; branch < 3; branch++) {
+        drone->restore_state(snapshot.data());
+        for (int step = 500; step < 700; step++) {
+            auto obs = step_snapshot_aircraft(*drone, step);
+            ASSERT_EQ(expected[step - 500], obs) << "branch " << branch << " step " << step;
+        }
+    }
+    /* 同じ構成の別の機体にも復元できる */
+    AirCraft* other = create_snapshot_aircraft();
+    ASSERT_EQ(drone->get_state_size(), other->get_state_size());
+    other->restore_state(snapshot.data());
+    for (int step = 500; step < 700; step++) {
+        ASSERT_EQ(expected[step - 500], step_snapshot_aircraft(*other, step));
+    }
+    delete other;
+    delete drone;
+}
@@ -0,0 +1,54 @@
+/*
+ * Minimal v1 drone controller module for the module registry tests.
+ * run() returns a fixed thrust so that the caller can tell the module ran.
+ */
+#include "utils/hako_module_header.h"
+#include "hako_module_drone_controller.h"
+
+#define HAKO_TEST_CONTROLLER_THRUST 1.5
+
+static const char* hako_test_controller_get_type(void)
+{
+    return "hako_module_drone_controller";
+}
+static const char* hako_test_controller_get_name(void)
+{
+    return "TestController";
+}
+static int hako_test_controller_context;
+static void* hako_test_controller_create_context(void* arguments)
+{
+    (void)arguments;
+    return &hako_test_controller_context;
+}
+static int hako_test_controller_is_operation_doing(void* context)
+{
+    (void)context;
+    return 1;
+}
+static int hako_test_controller_init(void* context)
+{
+    (void)context;
+    return 0;
+}
+static mi_drone_control_out_t hako_test_controller_run(mi_drone_control_in_t* in)
+{
+    mi_drone_control_out_t out = { 0 };
+    (void)in;
+    out.thrust = HAKO_TEST_CONTROLLER_THRUST;
+    return out;
+}
+
+HakoModuleHeaderType hako_module_header = {
+    .magicno = HAKO_MODULE_MAGICNO,
+    .version = HAKO_MODULE_VERSION_1,
+    .get_type = hako_test_controller_get_type,
+    .get_name = hako_test_controller_get_name
+};
+
+HakoModuleDroneControllerType hako_module_drone_controller = {
+    .create_context = hako_test_controller_create_context,
+    .is_operation_doing = hako_test_controller_is_operation_doing,
+    .init = hako_test_controller_init,
+    .run = hako_test_controller_run
+};
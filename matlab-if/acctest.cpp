@@ -2,6 +2,8 @@
 #include <stdio.h>
 #include <assert.h>
 #include <math.h>
+#include <thread>
+#include <vector>
 #include "drone_physics_osdep.h"
 
 #include "drone_physics_matlab.h"
@@ -131,9 +133,94 @@ void round_test()
 
 }
 
+static mi_drone_acceleration_in_t vehicle_input(int vehicle, int step)
+{
+    mi_drone_acceleration_in_t in;
+    in.phi = 0.01 * vehicle;    in.theta = 0.02 * step;    in.psi = 0.03 * (vehicle + step);
+    in.u = 1.0 + vehicle;    in.v = 2.0 - step;    in.w = 3.0;
+    in.p = 0.1 * step;    in.q = 0.2;    in.r = 0.3 * vehicle;
+    in.thrust = 10.0 + step;
+    in.torque_x = 1.0;    in.torque_y = 2.0 * vehicle;    in.torque_z = 3.0;
+    in.mass = 1.0 + vehicle;
+    in.Ixx = 2.0;    in.Iyy = 5.0;    in.Izz = 8.0;
+    in.gravity = 9.81;
+    in.drag = 0.1;
+    return in;
+}
+
+static void assert_same_out(const mi_drone_acceleration_out_t& a, const mi_drone_acceleration_out_t& b)
+{
+    assert_almost_equal(a.du, b.du);
+    assert_almost_equal(a.dv, b.dv);
+    assert_almost_equal(a.dw, b.dw);
+    assert_almost_equal(a.dp, b.dp);
+    assert_almost_equal(a.dq, b.dq);
+    assert_almost_equal(a.dr, b.dr);
+}
+
+/* instance step and batch step give the same result as mi_drone_acceleration() */
+static void model_batch_test()
+{
+    const int N = 16;
+    std::vector<mi_drone_model_t*> models(N);
+    for (int i = 0; i < N; i++) {
+        models[i] = mi_drone_model_create();
+        assert(models[i] != NULL);
+    }
+    std::vector<mi_drone_acceleration_in_t> in(N);
+    std::vector<mi_drone_acceleration_out_t> out(N);
+    for (int step = 0; step < 10; step++) {
+        for (int i = 0; i < N; i++) {
+            in[i] = vehicle_input(i, step);
+        }
+        mi_drone_model_step_batch(models.data(), in.data(), out.data(), N);
+        for (int i = 0; i < N; i++) {
+            mi_drone_acceleration_out_t single;
+            mi_drone_model_step(models[i], &in[i], &single);
+            assert_same_out(out[i], mi_drone_acceleration(&in[i]));
+            assert_same_out(out[i], single);
+        }
+    }
+    for (int i = 0; i < N; i++) {
+        mi_drone_model_destroy(models[i]);
+    }
+}
+
+/* instances stepped concurrently on separate threads */
+static void model_thread_test()
+{
+    const int THREADS = 4;
+    const int STEPS = 1000;
+    std::vector<std::thread> threads;
+    std::vector<int> errors(THREADS, 0);
+    for (int t = 0; t < THREADS; t++) {
+        threads.emplace_back([t, &errors]() {
+            mi_drone_model_t* model = mi_drone_model_create();
+            for (int step = 0; step < STEPS; step++) {
+                mi_drone_acceleration_in_t in = vehicle_input(t, step);
+                mi_drone_acceleration_out_t out;
+                mi_drone_model_step(model, &in, &out);
+                mi_drone_acceleration_out_t expected = drone_acceleration_by_physics(&in);
+                if (fabs(out.du - expected.du) > 0.0001 || fabs(out.dp - expected.dp) > 0.0001) {
+                    errors[t]++;
+                }
+            }
+            mi_drone_model_destroy(model);
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    for (int t = 0; t < THREADS; t++) {
+        assert(errors[t] == 0);
+    }
+}
+
 int main() {
     T(test_first_case);
     T(round_test);
+    T(model_batch_test);
+    T(model_thread_test);
     return 0;
 }
 
@@ -66,6 +66,34 @@ static inline mi_drone_acceleration_out_t mi_drone_acceleration(
 }
 #endif
 void mi_drone_acceleration_initialize(void);
+
+/**
+ * Instance-based interface (drone_physics_matlab_model.c).
+ *
+ * Each vehicle owns one model instance, but an instance holds no state of its own:
+ * all instances step the same mi_drone_acceleration().
+ * - sample build: the model has no state, so instances can be stepped
+ *   concurrently from different threads.
+ * - MATLAB build (HAKONIWA_MATLAB_BUILD): the generated code keeps its state in
+ *   globals, so the library is built with MI_DRONE_MODEL_NOT_REENTRANT and every
+ *   step of every instance is serialized on one process-wide lock. This path is not
+ *   reentrant; a batch only saves the per-vehicle locking.
+ *
+ * mi_drone_model_create() calls mi_drone_acceleration_initialize() once per process.
+ */
+typedef struct mi_drone_model mi_drone_model_t;
+
+mi_drone_model_t* mi_drone_model_create(void);   /* NULL on failure */
+void mi_drone_model_destroy(mi_drone_model_t* model);
+
+/* one step of one vehicle */
+void mi_drone_model_step(mi_drone_model_t* model,
+    const mi_drone_acceleration_in_t* in, mi_drone_acceleration_out_t* out);
+
+/* one step of n vehicles: models[i] is stepped with in[i] and writes out[i] */
+void mi_drone_model_step_batch(mi_drone_model_t* const* models,
+    const mi_drone_acceleration_in_t* in, mi_drone_acceleration_out_t* out, int n);
+
 /***
 The Original function signatures are:
 
@@ -0,0 +1,82 @@
+/*
+ * Instance-based wrapper of mi_drone_acceleration().
+ *
+ * An instance holds no model state: every instance calls the same
+ * mi_drone_acceleration(), and the model keeps whatever state it has itself.
+ * The sample (drone_physics_matlab_sample.c) has no state, so instances are stepped
+ * without a lock. The MATLAB build (HAKONIWA_MATLAB_BUILD) defines
+ * MI_DRONE_MODEL_NOT_REENTRANT, because its generated code keeps the model and
+ * its I/O in globals; there all steps of all instances go through one
+ * process-wide lock, and a batch takes it only once.
+ */
+#include <stdlib.h>
+
+#include "drone_physics_matlab.h"
+
+#ifdef _WIN32
+#include <windows.h>
+static SRWLOCK mi_drone_model_lock = SRWLOCK_INIT;
+#define MI_DRONE_MODEL_LOCK()   AcquireSRWLockExclusive(&mi_drone_model_lock)
+#define MI_DRONE_MODEL_UNLOCK() ReleaseSRWLockExclusive(&mi_drone_model_lock)
+#else
+#include <pthread.h>
+static pthread_mutex_t mi_drone_model_lock = PTHREAD_MUTEX_INITIALIZER;
+#define MI_DRONE_MODEL_LOCK()   pthread_mutex_lock(&mi_drone_model_lock)
+#define MI_DRONE_MODEL_UNLOCK() pthread_mutex_unlock(&mi_drone_model_lock)
+#endif
+
+#ifdef MI_DRONE_MODEL_NOT_REENTRANT
+#define MI_DRONE_MODEL_STEP_LOCK()   MI_DRONE_MODEL_LOCK()
+#define MI_DRONE_MODEL_STEP_UNLOCK() MI_DRONE_MODEL_UNLOCK()
+#else
+#define MI_DRONE_MODEL_STEP_LOCK()
+#define MI_DRONE_MODEL_STEP_UNLOCK()
+#endif
+
+struct mi_drone_model {
+    /* no per-instance state (see above) */
+    int reserved;
+};
+
+static int mi_drone_model_initialized = 0;
+
+mi_drone_model_t* mi_drone_model_create(void)
+{
+    mi_drone_model_t* model = (mi_drone_model_t*)calloc(1, sizeof(mi_drone_model_t));
+    if (model == NULL) {
+        return NULL;
+    }
+    MI_DRONE_MODEL_LOCK();
+    if (!mi_drone_model_initialized) {
+        mi_drone_acceleration_initialize();
+        mi_drone_model_initialized = 1;
+    }
+    MI_DRONE_MODEL_UNLOCK();
+    return model;
+}
+
+void mi_drone_model_destroy(mi_drone_model_t* model)
+{
+    free(model);
+}
+
+void mi_drone_model_step(mi_drone_model_t* model,
+    const mi_drone_acceleration_in_t* in, mi_drone_acceleration_out_t* out)
+{
+    MI_DRONE_MODEL_STEP_LOCK();
+    *out = mi_drone_acceleration(in);
+    MI_DRONE_MODEL_STEP_UNLOCK();
+    (void)model;
+}
+
+void mi_drone_model_step_batch(mi_drone_model_t* const* models,
+    const mi_drone_acceleration_in_t* in, mi_drone_acceleration_out_t* out, int n)
+{
+    int i;
+    MI_DRONE_MODEL_STEP_LOCK();
+    for (i = 0; i < n; i++) {
+        out[i] = mi_drone_acceleration(&in[i]);
+    }
+    MI_DRONE_MODEL_STEP_UNLOCK();
+    (void)models;
+}